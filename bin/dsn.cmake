@@ -488,6 +488,18 @@ function(dsn_setup_packages)
         set(DSN_SYSTEM_LIBS ${DSN_SYSTEM_LIBS} ${DSN_LIB_UTIL})
     endif()
 
+    # lz4 is built by thirdparty/build-thirdparty.sh, and linked statically into dsn_runtime users
+    if(DSN_BUILD_RUNTIME)
+        set(DSN_LZ4_LIB_DIR ${CMAKE_SOURCE_DIR}/thirdparty/output/lib)
+    else()
+        set(DSN_LZ4_LIB_DIR ${DSN_THIRDPARTY_ROOT}/lib)
+    endif()
+    find_library(DSN_LIB_LZ4 NAMES liblz4.a lz4 PATHS ${DSN_LZ4_LIB_DIR} NO_DEFAULT_PATH)
+    if(DSN_LIB_LZ4 STREQUAL "DSN_LIB_LZ4-NOTFOUND")
+        message(FATAL_ERROR "Cannot find library lz4, please run thirdparty/build-thirdparty.sh")
+    endif()
+    set(DSN_SYSTEM_LIBS ${DSN_SYSTEM_LIBS} ${DSN_LIB_LZ4})
+
     set(DSN_SYSTEM_LIBS
         ${DSN_SYSTEM_LIBS}
         ${CMAKE_THREAD_LIBS_INIT}
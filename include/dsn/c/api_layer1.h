@@ -109,6 +109,14 @@ checkpointing)
   ; is already greater than its timeout value
   rpc_request_dropped_before_execution_when_timeout = false
 
+  ; compress the message body when it is not smaller than this size and the peer can
+  ; decompress it (negotiated in the dsn message parser), 0 for never
+  rpc_message_compress_min_bytes = 0
+
+  ; whether the rpc handler never blocks, so that it may run to completion on the network
+  ; thread which parsed the request, within the [network] inline_execution_* budget
+  rpc_request_is_non_blocking = false
+
   ; for how long (ms) the request will be resent if no response
   ; is received yet, 0 for disable this feature
   rpc_request_resend_timeout_milliseconds = 0
@@ -158,6 +166,10 @@ dsn_threadpool_code_register.
   ; what CPU cores are assigned to this pool, 0 for all
   worker_affinity_mask = 0
 
+  ; what CPU cores are assigned to this pool as a list like 0-23,48-71,
+  ; which overrides worker_affinity_mask and is not limited to 64 cores
+  worker_cpu_list =
+
   ; task aspects names, usually for tooling purpose
   worker_aspects =
 
@@ -167,12 +179,30 @@ dsn_threadpool_code_register.
   ; task worker provider name
   worker_factory_name =
 
+  ; whether memory allocated by a worker prefers the NUMA node it is placed on
+  worker_numa_local_memory = false
+
+  ; what NUMA nodes (as a list like 0,1) this pool is pinned to, empty for all
+  worker_numa_nodes =
+
+  ; whether worker i is placed on NUMA node i % #nodes; partitioned pools whose
+  ; worker_count is a multiple of #nodes then keep the same hash (e.g., gpid) on
+  ; the same socket across pools
+  worker_numa_spread = false
+
   ; thread priority
   worker_priority = THREAD_xPRIORITY_NORMAL
 
   ; whether the threads share all assigned cores
   worker_share_core = true
 
+  ; max times an idle worker spins with cpu pause before parking, which adapts
+  ; to whether spinning found work recently; 0 for parking immediately
+  worker_spin_count = 0
+
+  ; how many times an idle worker yields its cpu after spinning and before parking
+  worker_yield_count = 0
+
   [threadpool.THREAD_POOL_DEFAULT]
   ; override default options in [threadpool..default]
   dequeue_batch_size = 5
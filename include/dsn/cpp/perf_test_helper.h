@@ -38,7 +38,9 @@
 #include <dsn/service_api_cpp.h>
 #include <dsn/utility/utils.h>
 #include <sstream>
+#include <chrono>
 #include <atomic>
+#include <random>
 #include <vector>
 
 #define INVALID_DURATION_US 0xdeadbeefdeadbeefULL
@@ -57,6 +59,12 @@ struct perf_test_opts
     std::vector<int> perf_test_payload_bytes;
     std::vector<int> perf_test_timeouts_ms;
     std::vector<int> perf_test_hybrid_request_ratio; // e.g., 1,1,1
+    // perf_test_qps:
+    //   - if empty, test cases are closed-loop ones on perf_test_concurrency.
+    //   - otherwise, test cases are open-loop ones which send requests at these rates,
+    //     regardless of how fast the responses come back.
+    std::vector<int> perf_test_qps;
+    std::string perf_test_arrival; // constant or poisson, for open-loop tests
 };
 
 CONFIG_BEGIN(perf_test_opts)
@@ -71,8 +79,86 @@ CONFIG_FLD_INT_LIST(perf_test_hybrid_request_ratio,
                     "hybrid request ratio, e.g., 1,2,1 - the "
                     "numbers are ordered by the task code appeared "
                     "in task code registration")
+CONFIG_FLD_INT_LIST(perf_test_qps,
+                    "target qps list: requests are sent at these rates (open-loop) if "
+                    "specified, instead of on perf_test_concurrency (closed-loop)")
+CONFIG_FLD_STRING(perf_test_arrival,
+                  "constant",
+                  "arrival of the requests in open-loop tests: constant or poisson")
 CONFIG_END
 
+//
+// latency histogram with log-linear buckets: values are grouped by their highest bit, and
+// each group is split into SUB_BUCKET_COUNT buckets, so the relative error of a recorded
+// value is under 1 / SUB_BUCKET_COUNT.
+//
+// thread safe for add().
+//
+class latency_histogram
+{
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    latency_histogram() { reset(); }
+    latency_histogram(const latency_histogram &r) { *this = r; }
+    latency_histogram &operator=(const latency_histogram &r);
+
+    void reset();
+    void add(uint64_t value);
+
+    uint64_t count() const;
+    // the highest value which is in the same bucket as the value at 'percentile' (0 ~ 100)
+    uint64_t percentile(double percentile) const;
+
+    // the highest value of each bucket, and how many values are recorded in the bucket
+    void get_buckets(/*out*/ std::vector<std::pair<uint64_t, uint64_t>> &buckets) const;
+
+    static int bucket_index(uint64_t value);
+    static uint64_t bucket_highest_value(int index);
+
+private:
+    std::atomic<uint64_t> _buckets[BUCKET_COUNT];
+};
+
+//
+// arrival times of the requests of an open-loop test case, at the target rate with constant
+// or poisson intervals between them
+//
+class open_loop_schedule
+{
+public:
+    open_loop_schedule() : _qps(0), _poisson_arrival(false), _next_ts_ns(0), _end_ts_ns(0) {}
+
+    // requests are scheduled in [start_ts_ns, end_ts_ns)
+    void
+    start(uint64_t start_ts_ns, uint64_t end_ts_ns, int qps, bool poisson_arrival, uint64_t seed);
+
+    bool finished() const { return _next_ts_ns >= _end_ts_ns; }
+    // whether the next request is scheduled before ts_ns
+    bool has_next_before(uint64_t ts_ns) const { return !finished() && _next_ts_ns < ts_ns; }
+    uint64_t next_ts_ns() const { return _next_ts_ns; }
+    // returns the scheduled time of the next request, and moves on to the one after it
+    uint64_t pop();
+
+    // how long to wait from now_ns for the next request, rounded down to the milliseconds of
+    // the timers, so that the wait never ends after the request is due
+    std::chrono::milliseconds delay_to_next(uint64_t now_ns) const;
+    // how long to delay from now_ns the sending of a request scheduled at ts_ns, rounded up
+    // to the milliseconds of the timers, so that the request is never sent before it's due
+    static std::chrono::milliseconds delay_to(uint64_t ts_ns, uint64_t now_ns);
+
+    uint64_t next_interval_ns();
+
+private:
+    int _qps;
+    bool _poisson_arrival;
+    uint64_t _next_ts_ns;
+    uint64_t _end_ts_ns;
+    std::mt19937_64 _rng;
+};
+
 class perf_client_helper
 {
 public:
@@ -81,6 +167,10 @@ public:
 protected:
     perf_client_helper();
 
+    // must be called by send_one() when a request is sent, and the result is the context
+    // for end_send_one(). latencies are measured from here, except in open-loop tests, where
+    // they are measured from the scheduled time of the request, so a request sent late is
+    // not taken as a fast one; how late it is sent is also recorded as the send lag.
     void *prepare_send_one();
     void end_send_one(void *context, error_code err);
 
@@ -95,6 +185,8 @@ private:
         int payload_bytes;
         int key_space_size;
         int concurrency;
+        int qps; // > 0 for open-loop tests
+        bool poisson_arrival;
         int timeout_ms;
         std::vector<double> ratios;
 
@@ -105,6 +197,8 @@ private:
         std::atomic<uint64_t> succ_rounds_sum_ns;
         std::atomic<uint64_t> min_latency_ns;
         std::atomic<uint64_t> max_latency_ns;
+        latency_histogram latency_ns;
+        latency_histogram send_lag_ns; // for open-loop tests
         double succ_latency_avg_ns;
         double succ_qps;
         double succ_throughput_MB_s;
@@ -117,6 +211,8 @@ private:
             key_space_size = r.key_space_size;
             timeout_ms = r.timeout_ms;
             concurrency = r.concurrency;
+            qps = r.qps;
+            poisson_arrival = r.poisson_arrival;
             ratios = r.ratios;
 
             timeout_rounds.store(r.timeout_rounds.load());
@@ -125,6 +221,8 @@ private:
             succ_rounds_sum_ns.store(r.succ_rounds_sum_ns.load());
             min_latency_ns.store(r.min_latency_ns.load());
             max_latency_ns.store(r.max_latency_ns.load());
+            latency_ns = r.latency_ns;
+            send_lag_ns = r.send_lag_ns;
 
             succ_latency_avg_ns = r.succ_latency_avg_ns;
             succ_qps = r.succ_qps;
@@ -141,6 +239,8 @@ private:
               payload_bytes(0),
               key_space_size(1000),
               concurrency(0),
+              qps(0),
+              poisson_arrival(false),
               timeout_ms(0),
               timeout_rounds(0),
               error_rounds(0),
@@ -168,6 +268,13 @@ private:
 
     void start_next_case();
 
+    // schedule a timer for each of the requests due in the coming tick, and the next tick
+    void open_loop_tick();
+    // send the request scheduled at scheduled_ts_ns, run by the timer set by open_loop_tick()
+    void send_scheduled_one(uint64_t scheduled_ts_ns);
+
+    std::string case_to_json(const std::string &suit_name, const perf_test_case &cs);
+
 private:
     perf_client_helper(const perf_client_helper &) = delete;
 
@@ -184,6 +291,12 @@ private:
     uint64_t _case_start_ts_ns;
     uint64_t _case_end_ts_ns;
 
+    // for open-loop tests, which is only accessed by open_loop_tick()
+    open_loop_schedule _schedule;
+
+    // results of the test cases are appended to this file as json lines
+    std::string _json_result_file;
+
     std::vector<perf_test_suite> _suits;
     int _current_suit_index;
     int _current_case_index;
@@ -10,6 +10,10 @@ namespace dsn {
     GENERATED_TYPE_SERIALIZATION(partition_configuration, THRIFT)
     GENERATED_TYPE_SERIALIZATION(configuration_query_by_index_request, THRIFT)
     GENERATED_TYPE_SERIALIZATION(configuration_query_by_index_response, THRIFT)
+    GENERATED_TYPE_SERIALIZATION(configuration_subscribe_request, THRIFT)
+    GENERATED_TYPE_SERIALIZATION(configuration_subscribe_response, THRIFT)
+    GENERATED_TYPE_SERIALIZATION(configuration_query_routing_request, THRIFT)
+    GENERATED_TYPE_SERIALIZATION(configuration_query_routing_response, THRIFT)
     GENERATED_TYPE_SERIALIZATION(app_info, THRIFT)
 
 } 
\ No newline at end of file
@@ -41,6 +41,14 @@ class configuration_query_by_index_request;
 
 class configuration_query_by_index_response;
 
+class configuration_subscribe_request;
+
+class configuration_subscribe_response;
+
+class configuration_query_routing_request;
+
+class configuration_query_routing_response;
+
 class app_info;
 
 typedef struct _partition_configuration__isset {
@@ -259,6 +267,300 @@ inline std::ostream& operator<<(std::ostream& out, const configuration_query_by_
   return out;
 }
 
+typedef struct _configuration_subscribe_request__isset {
+  _configuration_subscribe_request__isset() : app_name(false), epoch(false), known_version(false), hold_ms(false) {}
+  bool app_name :1;
+  bool epoch :1;
+  bool known_version :1;
+  bool hold_ms :1;
+} _configuration_subscribe_request__isset;
+
+class configuration_subscribe_request {
+ public:
+
+  configuration_subscribe_request(const configuration_subscribe_request&);
+  configuration_subscribe_request(configuration_subscribe_request&&);
+  configuration_subscribe_request& operator=(const configuration_subscribe_request&);
+  configuration_subscribe_request& operator=(configuration_subscribe_request&&);
+  configuration_subscribe_request() : app_name(), epoch(0), known_version(0), hold_ms(0) {
+  }
+
+  virtual ~configuration_subscribe_request() throw();
+  std::string app_name;
+  int64_t epoch;
+  int64_t known_version;
+  int32_t hold_ms;
+
+  _configuration_subscribe_request__isset __isset;
+
+  void __set_app_name(const std::string& val);
+
+  void __set_epoch(const int64_t val);
+
+  void __set_known_version(const int64_t val);
+
+  void __set_hold_ms(const int32_t val);
+
+  bool operator == (const configuration_subscribe_request & rhs) const
+  {
+    if (!(app_name == rhs.app_name))
+      return false;
+    if (!(epoch == rhs.epoch))
+      return false;
+    if (!(known_version == rhs.known_version))
+      return false;
+    if (!(hold_ms == rhs.hold_ms))
+      return false;
+    return true;
+  }
+  bool operator != (const configuration_subscribe_request &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const configuration_subscribe_request & ) const;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+  virtual void printTo(std::ostream& out) const;
+};
+
+void swap(configuration_subscribe_request &a, configuration_subscribe_request &b);
+
+inline std::ostream& operator<<(std::ostream& out, const configuration_subscribe_request& obj)
+{
+  obj.printTo(out);
+  return out;
+}
+
+typedef struct _configuration_subscribe_response__isset {
+  _configuration_subscribe_response__isset() : err(false), app_id(false), partition_count(false), is_stateful(false), epoch(false), version(false), partitions(false) {}
+  bool err :1;
+  bool app_id :1;
+  bool partition_count :1;
+  bool is_stateful :1;
+  bool epoch :1;
+  bool version :1;
+  bool partitions :1;
+} _configuration_subscribe_response__isset;
+
+class configuration_subscribe_response {
+ public:
+
+  configuration_subscribe_response(const configuration_subscribe_response&);
+  configuration_subscribe_response(configuration_subscribe_response&&);
+  configuration_subscribe_response& operator=(const configuration_subscribe_response&);
+  configuration_subscribe_response& operator=(configuration_subscribe_response&&);
+  configuration_subscribe_response() : app_id(0), partition_count(0), is_stateful(0), epoch(0), version(0) {
+  }
+
+  virtual ~configuration_subscribe_response() throw();
+   ::dsn::error_code err;
+  int32_t app_id;
+  int32_t partition_count;
+  bool is_stateful;
+  int64_t epoch;
+  int64_t version;
+  std::vector<partition_configuration>  partitions;
+
+  _configuration_subscribe_response__isset __isset;
+
+  void __set_err(const  ::dsn::error_code& val);
+
+  void __set_app_id(const int32_t val);
+
+  void __set_partition_count(const int32_t val);
+
+  void __set_is_stateful(const bool val);
+
+  void __set_epoch(const int64_t val);
+
+  void __set_version(const int64_t val);
+
+  void __set_partitions(const std::vector<partition_configuration> & val);
+
+  bool operator == (const configuration_subscribe_response & rhs) const
+  {
+    if (!(err == rhs.err))
+      return false;
+    if (!(app_id == rhs.app_id))
+      return false;
+    if (!(partition_count == rhs.partition_count))
+      return false;
+    if (!(is_stateful == rhs.is_stateful))
+      return false;
+    if (!(epoch == rhs.epoch))
+      return false;
+    if (!(version == rhs.version))
+      return false;
+    if (!(partitions == rhs.partitions))
+      return false;
+    return true;
+  }
+  bool operator != (const configuration_subscribe_response &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const configuration_subscribe_response & ) const;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+  virtual void printTo(std::ostream& out) const;
+};
+
+void swap(configuration_subscribe_response &a, configuration_subscribe_response &b);
+
+inline std::ostream& operator<<(std::ostream& out, const configuration_subscribe_response& obj)
+{
+  obj.printTo(out);
+  return out;
+}
+
+typedef struct _configuration_query_routing_request__isset {
+  _configuration_query_routing_request__isset() : app_name(false), epoch(false), known_version(false) {}
+  bool app_name :1;
+  bool epoch :1;
+  bool known_version :1;
+} _configuration_query_routing_request__isset;
+
+class configuration_query_routing_request {
+ public:
+
+  configuration_query_routing_request(const configuration_query_routing_request&);
+  configuration_query_routing_request(configuration_query_routing_request&&);
+  configuration_query_routing_request& operator=(const configuration_query_routing_request&);
+  configuration_query_routing_request& operator=(configuration_query_routing_request&&);
+  configuration_query_routing_request() : app_name(), epoch(0), known_version(0) {
+  }
+
+  virtual ~configuration_query_routing_request() throw();
+  std::string app_name;
+  int64_t epoch;
+  int64_t known_version;
+
+  _configuration_query_routing_request__isset __isset;
+
+  void __set_app_name(const std::string& val);
+
+  void __set_epoch(const int64_t val);
+
+  void __set_known_version(const int64_t val);
+
+  bool operator == (const configuration_query_routing_request & rhs) const
+  {
+    if (!(app_name == rhs.app_name))
+      return false;
+    if (!(epoch == rhs.epoch))
+      return false;
+    if (!(known_version == rhs.known_version))
+      return false;
+    return true;
+  }
+  bool operator != (const configuration_query_routing_request &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const configuration_query_routing_request & ) const;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+  virtual void printTo(std::ostream& out) const;
+};
+
+void swap(configuration_query_routing_request &a, configuration_query_routing_request &b);
+
+inline std::ostream& operator<<(std::ostream& out, const configuration_query_routing_request& obj)
+{
+  obj.printTo(out);
+  return out;
+}
+
+typedef struct _configuration_query_routing_response__isset {
+  _configuration_query_routing_response__isset() : err(false), app_id(false), partition_count(false), is_stateful(false), epoch(false), version(false), routes(false) {}
+  bool err :1;
+  bool app_id :1;
+  bool partition_count :1;
+  bool is_stateful :1;
+  bool epoch :1;
+  bool version :1;
+  bool routes :1;
+} _configuration_query_routing_response__isset;
+
+class configuration_query_routing_response {
+ public:
+
+  configuration_query_routing_response(const configuration_query_routing_response&);
+  configuration_query_routing_response(configuration_query_routing_response&&);
+  configuration_query_routing_response& operator=(const configuration_query_routing_response&);
+  configuration_query_routing_response& operator=(configuration_query_routing_response&&);
+  configuration_query_routing_response() : app_id(0), partition_count(0), is_stateful(0), epoch(0), version(0) {
+  }
+
+  virtual ~configuration_query_routing_response() throw();
+   ::dsn::error_code err;
+  int32_t app_id;
+  int32_t partition_count;
+  bool is_stateful;
+  int64_t epoch;
+  int64_t version;
+   ::dsn::blob routes;
+
+  _configuration_query_routing_response__isset __isset;
+
+  void __set_err(const  ::dsn::error_code& val);
+
+  void __set_app_id(const int32_t val);
+
+  void __set_partition_count(const int32_t val);
+
+  void __set_is_stateful(const bool val);
+
+  void __set_epoch(const int64_t val);
+
+  void __set_version(const int64_t val);
+
+  void __set_routes(const  ::dsn::blob& val);
+
+  bool operator == (const configuration_query_routing_response & rhs) const
+  {
+    if (!(err == rhs.err))
+      return false;
+    if (!(app_id == rhs.app_id))
+      return false;
+    if (!(partition_count == rhs.partition_count))
+      return false;
+    if (!(is_stateful == rhs.is_stateful))
+      return false;
+    if (!(epoch == rhs.epoch))
+      return false;
+    if (!(version == rhs.version))
+      return false;
+    if (!(routes == rhs.routes))
+      return false;
+    return true;
+  }
+  bool operator != (const configuration_query_routing_response &rhs) const {
+    return !(*this == rhs);
+  }
+
+  bool operator < (const configuration_query_routing_response & ) const;
+
+  uint32_t read(::apache::thrift::protocol::TProtocol* iprot);
+  uint32_t write(::apache::thrift::protocol::TProtocol* oprot) const;
+
+  virtual void printTo(std::ostream& out) const;
+};
+
+void swap(configuration_query_routing_response &a, configuration_query_routing_response &b);
+
+inline std::ostream& operator<<(std::ostream& out, const configuration_query_routing_response& obj)
+{
+  obj.printTo(out);
+  return out;
+}
+
 typedef struct _app_info__isset {
   _app_info__isset() : status(true), app_type(false), app_name(false), app_id(false), partition_count(false), envs(false), is_stateful(false), max_replica_count(false), expire_second(false) {}
   bool status :1;
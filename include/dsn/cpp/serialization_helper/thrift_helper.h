@@ -41,11 +41,13 @@
 
 #include <thrift/Thrift.h>
 #include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
 #include <thrift/protocol/TJSONProtocol.h>
 #include <thrift/protocol/TVirtualProtocol.h>
 #include <thrift/transport/TVirtualTransport.h>
 #include <thrift/TApplicationException.h>
 #include <type_traits>
+#include <typeinfo>
 
 using namespace ::apache::thrift::transport;
 namespace dsn {
@@ -229,12 +231,70 @@ public:
     char &operator[](int pos) { return const_cast<char *>(_buffer.data())[pos]; }
 };
 
+// the dsn types below are serialized as plain values in both the binary and the compact
+// protocol, and as structs in the json protocol.
+// an exact type check is used as it is much cheaper than dynamic_cast on the hot paths.
+inline bool is_compact_protocol(::apache::thrift::protocol::TProtocol *proto)
+{
+    return typeid(*proto) == typeid(::apache::thrift::protocol::TCompactProtocol);
+}
+
+// write a string in the compact protocol (varint length followed by the bytes) without copying
+// it into a std::string first
+inline uint32_t
+write_compact_string(::apache::thrift::protocol::TProtocol *oprot, const char *data, uint32_t size)
+{
+    uint8_t header[5];
+    uint32_t header_size = 0;
+    uint32_t n = size;
+    while (n > 0x7f) {
+        header[header_size++] = (uint8_t)((n & 0x7f) | 0x80);
+        n >>= 7;
+    }
+    header[header_size++] = (uint8_t)n;
+
+    auto trans = oprot->getTransport();
+    trans->write(header, header_size);
+    if (size > 0) {
+        trans->write((const uint8_t *)data, size);
+    }
+    return header_size + size;
+}
+
+// read a string written in the compact protocol directly into 'str'
+template <typename TString>
+inline uint32_t read_compact_string(::apache::thrift::protocol::TProtocol *iprot, TString &str)
+{
+    auto trans = iprot->getTransport();
+    uint32_t size = 0;
+    uint32_t rsize = 0;
+    for (int shift = 0;; shift += 7) {
+        if (shift > 28) {
+            throw ::apache::thrift::protocol::TProtocolException(
+                ::apache::thrift::protocol::TProtocolException::INVALID_DATA,
+                "variable-length int over 5 bytes");
+        }
+        uint8_t byte;
+        rsize += trans->readAll(&byte, 1);
+        size |= (uint32_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+
+    str.resize(size);
+    if (size > 0) {
+        rsize += trans->readAll((uint8_t *)&str[0], size);
+    }
+    return rsize;
+}
+
 inline uint32_t rpc_address::read(apache::thrift::protocol::TProtocol *iprot)
 {
     apache::thrift::protocol::TBinaryProtocol *binary_proto =
         dynamic_cast<apache::thrift::protocol::TBinaryProtocol *>(iprot);
-    if (binary_proto != nullptr) {
-        // the protocol is binary protocol
+    if (binary_proto != nullptr || is_compact_protocol(iprot)) {
+        // the protocol is binary or compact protocol
         auto r = iprot->readI64(reinterpret_cast<int64_t &>(_addr.u.value));
         dassert(_addr.u.v4.type == HOST_TYPE_INVALID || _addr.u.v4.type == HOST_TYPE_IPV4,
                 "only invalid or ipv4 can be deserialized from binary");
@@ -293,8 +353,8 @@ inline uint32_t rpc_address::write(apache::thrift::protocol::TProtocol *oprot) c
 {
     apache::thrift::protocol::TBinaryProtocol *binary_proto =
         dynamic_cast<apache::thrift::protocol::TBinaryProtocol *>(oprot);
-    if (binary_proto != nullptr) {
-        // the protocol is binary protocol
+    if (binary_proto != nullptr || is_compact_protocol(oprot)) {
+        // the protocol is binary or compact protocol
         dassert(_addr.u.v4.type == HOST_TYPE_INVALID || _addr.u.v4.type == HOST_TYPE_IPV4,
                 "only invalid or ipv4 can be serialized to binary");
         return oprot->writeI64((int64_t)_addr.u.value);
@@ -330,8 +390,8 @@ inline uint32_t gpid::read(apache::thrift::protocol::TProtocol *iprot)
 {
     apache::thrift::protocol::TBinaryProtocol *binary_proto =
         dynamic_cast<apache::thrift::protocol::TBinaryProtocol *>(iprot);
-    if (binary_proto != nullptr) {
-        // the protocol is binary protocol
+    if (binary_proto != nullptr || is_compact_protocol(iprot)) {
+        // the protocol is binary or compact protocol
         return iprot->readI64(reinterpret_cast<int64_t &>(_value.value));
     } else {
         // the protocol is json protocol
@@ -374,8 +434,8 @@ inline uint32_t gpid::write(apache::thrift::protocol::TProtocol *oprot) const
 {
     apache::thrift::protocol::TBinaryProtocol *binary_proto =
         dynamic_cast<apache::thrift::protocol::TBinaryProtocol *>(oprot);
-    if (binary_proto != nullptr) {
-        // the protocol is binary protocol
+    if (binary_proto != nullptr || is_compact_protocol(oprot)) {
+        // the protocol is binary or compact protocol
         return oprot->writeI64((int64_t)_value.value);
     } else {
         // the protocol is json protocol
@@ -399,8 +459,8 @@ inline uint32_t task_code::read(apache::thrift::protocol::TProtocol *iprot)
     uint32_t xfer = 0;
     apache::thrift::protocol::TBinaryProtocol *binary_proto =
         dynamic_cast<apache::thrift::protocol::TBinaryProtocol *>(iprot);
-    if (binary_proto != nullptr) {
-        // the protocol is binary protocol
+    if (binary_proto != nullptr || is_compact_protocol(iprot)) {
+        // the protocol is binary or compact protocol
         xfer += iprot->readString(task_code_string);
     } else {
         // the protocol is json protocol
@@ -446,6 +506,9 @@ inline uint32_t task_code::write(apache::thrift::protocol::TProtocol *oprot) con
     if (binary_proto != nullptr) {
         // the protocol is binary protocol
         return binary_proto->writeString<char_ptr>(char_ptr(name, static_cast<int>(strlen(name))));
+    } else if (is_compact_protocol(oprot)) {
+        // the protocol is compact protocol
+        return write_compact_string(oprot, name, static_cast<uint32_t>(strlen(name)));
     } else {
         // the protocol is json protocol
         uint32_t xfer = 0;
@@ -463,15 +526,23 @@ inline uint32_t task_code::write(apache::thrift::protocol::TProtocol *oprot) con
 
 inline uint32_t blob::read(apache::thrift::protocol::TProtocol *iprot)
 {
-    // for optimization, it is dangerous if the oprot is not a binary proto
+    blob_string str(*this);
+    if (is_compact_protocol(iprot)) {
+        return read_compact_string<blob_string>(iprot, str);
+    }
+
+    // for optimization, it is dangerous if the iprot is neither a binary nor a compact proto
     apache::thrift::protocol::TBinaryProtocol *binary_proto =
         static_cast<apache::thrift::protocol::TBinaryProtocol *>(iprot);
-    blob_string str(*this);
     return binary_proto->readString<blob_string>(str);
 }
 
 inline uint32_t blob::write(apache::thrift::protocol::TProtocol *oprot) const
 {
+    if (is_compact_protocol(oprot)) {
+        return write_compact_string(oprot, data(), static_cast<uint32_t>(length()));
+    }
+
     apache::thrift::protocol::TBinaryProtocol *binary_proto =
         static_cast<apache::thrift::protocol::TBinaryProtocol *>(oprot);
     return binary_proto->writeString<blob_string>(blob_string(const_cast<blob &>(*this)));
@@ -483,8 +554,8 @@ inline uint32_t error_code::read(apache::thrift::protocol::TProtocol *iprot)
     apache::thrift::protocol::TBinaryProtocol *binary_proto =
         dynamic_cast<apache::thrift::protocol::TBinaryProtocol *>(iprot);
     uint32_t xfer = 0;
-    if (binary_proto != nullptr) {
-        // the protocol is binary protocol
+    if (binary_proto != nullptr || is_compact_protocol(iprot)) {
+        // the protocol is binary or compact protocol
         xfer += iprot->readString(ec_string);
     } else {
         // the protocol is json protocol
@@ -530,6 +601,9 @@ inline uint32_t error_code::write(apache::thrift::protocol::TProtocol *oprot) co
     if (binary_proto != nullptr) {
         // the protocol is binary protocol
         return binary_proto->writeString<char_ptr>(char_ptr(name, static_cast<int>(strlen(name))));
+    } else if (is_compact_protocol(oprot)) {
+        // the protocol is compact protocol
+        return write_compact_string(oprot, name, static_cast<uint32_t>(strlen(name)));
     } else {
         // the protocol is json protocol
         uint32_t xfer = 0;
@@ -656,8 +730,14 @@ inline void marshall_thrift_internal(const T &val, ::apache::thrift::protocol::T
     /*
      * we treat every element as a whole struct
      */
+    ::apache::thrift::protocol::TType type = get_thrift_type(val);
+    if (type == ::apache::thrift::protocol::T_U64 && is_compact_protocol(proto)) {
+        // T_U64 is unknown to the compact protocol, and uint64 is written as i64 anyway
+        type = ::apache::thrift::protocol::T_I64;
+    }
+
     proto->writeStructBegin("thrift_rpc_result");
-    proto->writeFieldBegin("success", get_thrift_type(val), 0);
+    proto->writeFieldBegin("success", type, 0);
     marshall_base<T>(proto, val);
     proto->writeFieldEnd();
     proto->writeFieldStop();
@@ -705,6 +785,17 @@ inline void marshall_thrift_json(binary_writer &writer, const T &val)
     proto.getTransport()->flush();
 }
 
+template <typename T>
+inline void marshall_thrift_compact(binary_writer &writer, const T &val)
+{
+    ::dsn::binary_writer_transport trans(writer);
+    boost::shared_ptr<::dsn::binary_writer_transport> transport(
+        &trans, [](::dsn::binary_writer_transport *) {});
+    ::apache::thrift::protocol::TCompactProtocol proto(transport);
+    marshall_thrift_internal(val, &proto);
+    proto.getTransport()->flush();
+}
+
 template <typename T>
 inline void unmarshall_thrift_binary(binary_reader &reader, T &val)
 {
@@ -715,6 +806,16 @@ inline void unmarshall_thrift_binary(binary_reader &reader, T &val)
     unmarshall_thrift_internal(val, &proto);
 }
 
+template <typename T>
+inline void unmarshall_thrift_compact(binary_reader &reader, T &val)
+{
+    ::dsn::binary_reader_transport trans(reader);
+    boost::shared_ptr<::dsn::binary_reader_transport> transport(
+        &trans, [](::dsn::binary_reader_transport *) {});
+    ::apache::thrift::protocol::TCompactProtocol proto(transport);
+    unmarshall_thrift_internal(val, &proto);
+}
+
 template <typename T>
 inline void unmarshall_thrift_json(binary_reader &reader, T &val)
 {
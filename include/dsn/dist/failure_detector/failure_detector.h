@@ -65,6 +65,8 @@
 #include <dsn/dist/failure_detector/fd.client.h>
 #include <dsn/dist/failure_detector/fd.server.h>
 #include <dsn/cpp/perf_counter_wrapper.h>
+#include <dsn/utility/synchronize.h>
+#include <atomic>
 
 namespace dsn {
 namespace fd {
@@ -72,6 +74,7 @@ namespace fd {
 DEFINE_THREAD_POOL_CODE(THREAD_POOL_FD)
 DEFINE_TASK_CODE(LPC_BEACON_CHECK, TASK_PRIORITY_HIGH, THREAD_POOL_FD)
 DEFINE_TASK_CODE(LPC_BEACON_SEND, TASK_PRIORITY_HIGH, THREAD_POOL_FD)
+DEFINE_TASK_CODE(LPC_BEACON_DEFERRED_PING, TASK_PRIORITY_HIGH, THREAD_POOL_FD)
 
 class failure_detector_callback
 {
@@ -143,6 +146,17 @@ public:
 protected:
     void on_ping_internal(const beacon_msg &beacon, /*out*/ beacon_ack &ack);
 
+    // the part of on_ping_internal without _lock: return true if the beacon is from an alive
+    // worker, whose lease is renewed and 'ack' is filled
+    bool on_ping_fast(const beacon_msg &beacon, /*out*/ beacon_ack &ack);
+
+    // beacons are non-blocking requests, so they may run inline on network threads, where
+    // on_ping must not take _lock or call into on_worker_connected and alike
+    static bool is_running_inline();
+
+    // run on_ping for the beacon again in the fd pool, with the reply taken from 'reply'
+    void defer_ping(const beacon_msg &beacon, ::dsn::rpc_replier<beacon_ack> &reply);
+
     // return false when the ack is not applicable
     bool end_ping_internal(::dsn::error_code err, const beacon_ack &ack);
 
@@ -153,6 +167,22 @@ protected:
 private:
     void check_all_records();
 
+    class worker_record;
+    struct worker_shard;
+
+    worker_shard &get_worker_shard(::dsn::rpc_address node);
+
+    // the following are called under _lock
+    worker_record &add_worker_record(const worker_record &record);
+    void remove_worker_record(::dsn::rpc_address node);
+    void clear_worker_records();
+    void schedule_worker_check(worker_record &record);
+    void check_worker_records(uint64_t now, /*out*/ std::vector<::dsn::rpc_address> &expire);
+
+    // renew the lease of an alive worker without _lock, return false if the beacon
+    // must take the slow path (new or dead worker)
+    bool renew_worker_lease(::dsn::rpc_address node, uint64_t now);
+
 private:
     class master_record
     {
@@ -178,19 +208,40 @@ private:
     {
     public:
         ::dsn::rpc_address node;
-        uint64_t last_beacon_recv_time;
-        bool is_alive;
+        // renewed by beacons without _lock, see renew_worker_lease
+        std::atomic<uint64_t> last_beacon_recv_time;
+        std::atomic<bool> is_alive;
+        // the check tick this record is scheduled at in _worker_wheel, under _lock
+        uint64_t wheel_tick;
 
         // workers are always considered *connected* initially which is ok even when workers think
         // master is disconnected
         worker_record(::dsn::rpc_address node, uint64_t last_beacon_recv_time)
+            : node(node),
+              last_beacon_recv_time(last_beacon_recv_time),
+              is_alive(true),
+              wheel_tick(0)
+        {
+        }
+
+        worker_record(const worker_record &other)
+            : node(other.node),
+              last_beacon_recv_time(other.last_beacon_recv_time.load()),
+              is_alive(other.is_alive.load()),
+              wheel_tick(other.wheel_tick)
         {
-            this->node = node;
-            this->last_beacon_recv_time = last_beacon_recv_time;
-            is_alive = true;
         }
     };
 
+    // alive workers are looked up through these shards by beacons, so that renewing a lease
+    // takes no global lock; the shards point into _workers and change together with it
+    struct worker_shard
+    {
+        ::dsn::utils::rw_lock_nr lock;
+        std::unordered_map<::dsn::rpc_address, worker_record *> records;
+    };
+    static const int WORKER_SHARD_COUNT = 16;
+
 private:
     typedef std::unordered_map<::dsn::rpc_address, master_record> master_map;
     typedef std::unordered_map<::dsn::rpc_address, worker_record> worker_map;
@@ -200,6 +251,13 @@ private:
 
     master_map _masters;
     worker_map _workers;
+    worker_shard _worker_shards[WORKER_SHARD_COUNT];
+
+    // a lazy timing wheel of worker lease deadlines with one slot per check interval, so that
+    // check_all_records only visits the workers whose deadline may have passed; renewals do
+    // not move records, which are re-scheduled when their (stale) slot comes up instead
+    std::vector<std::vector<std::pair<::dsn::rpc_address, uint64_t>>> _worker_wheel;
+    uint64_t _worker_wheel_tick; // the last tick checked
 
     uint32_t _check_interval_milliseconds;
     uint32_t _beacon_interval_milliseconds;
@@ -0,0 +1,67 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     compact encoding of the partition configurations of a whole table, used
+ *     by the meta server to serve routing snapshots and by client resolvers
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#pragma once
+
+#include <dsn/service_api_cpp.h>
+
+namespace dsn {
+namespace dist {
+
+// A routing table is laid out as a node dictionary followed by one entry per
+// partition, where the primary, secondaries and last drops are small indices
+// into the dictionary and all integers are varints:
+//
+//   u8      format version
+//   varint  node count, then (u32 ip, u16 port) per node
+//   varint  partition count, then per partition:
+//           ballot (zigzag), max_replica_count, partition_flags,
+//           primary, secondary count + secondaries, drop count + last drops
+//
+// a node reference of 0 means an invalid address, otherwise it is index + 1.
+// last_committed_decree is not part of the routing information and is not
+// carried.
+class partition_routing_table
+{
+public:
+    static blob encode(const std::vector<partition_configuration> &configs);
+
+    // returns false if the buffer is corrupted
+    static bool
+    decode(const blob &data, int32_t app_id, /*out*/ std::vector<partition_configuration> &configs);
+};
+}
+}
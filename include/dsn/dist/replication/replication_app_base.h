@@ -210,6 +210,15 @@ public:
                                           dsn_message_t *requests,
                                           int request_length);
 
+    // for batch_write of updates which come without client requests (on secondaries and during
+    // log replay), the base class fakes a received request for each update and calls
+    // on_batched_write_requests(). storage engine may override this function to apply the
+    // updates directly without constructing request messages
+    virtual int on_batched_write_updates(int64_t decree,
+                                         int64_t timestamp,
+                                         const mutation_update *updates,
+                                         int update_count);
+
     // do full compaction manually.
     virtual void manual_compact() = 0;
 
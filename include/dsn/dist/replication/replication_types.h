@@ -2757,7 +2757,7 @@ inline std::ostream& operator<<(std::ostream& out, const query_replica_decree_re
 }
 
 typedef struct _replica_info__isset {
-  _replica_info__isset() : pid(false), ballot(false), status(false), last_committed_decree(false), last_prepared_decree(false), last_durable_decree(false), app_type(false), disk_tag(false) {}
+  _replica_info__isset() : pid(false), ballot(false), status(false), last_committed_decree(false), last_prepared_decree(false), last_durable_decree(false), app_type(false), disk_tag(false), read_qps(false), write_qps(false), read_bytes_per_second(false), write_bytes_per_second(false), storage_mb(false) {}
   bool pid :1;
   bool ballot :1;
   bool status :1;
@@ -2766,6 +2766,11 @@ typedef struct _replica_info__isset {
   bool last_durable_decree :1;
   bool app_type :1;
   bool disk_tag :1;
+  bool read_qps :1;
+  bool write_qps :1;
+  bool read_bytes_per_second :1;
+  bool write_bytes_per_second :1;
+  bool storage_mb :1;
 } _replica_info__isset;
 
 class replica_info {
@@ -2775,7 +2780,7 @@ class replica_info {
   replica_info(replica_info&&);
   replica_info& operator=(const replica_info&);
   replica_info& operator=(replica_info&&);
-  replica_info() : ballot(0), status((partition_status::type)0), last_committed_decree(0), last_prepared_decree(0), last_durable_decree(0), app_type(), disk_tag() {
+  replica_info() : ballot(0), status((partition_status::type)0), last_committed_decree(0), last_prepared_decree(0), last_durable_decree(0), app_type(), disk_tag(), read_qps(0), write_qps(0), read_bytes_per_second(0), write_bytes_per_second(0), storage_mb(0) {
   }
 
   virtual ~replica_info() throw();
@@ -2787,6 +2792,11 @@ class replica_info {
   int64_t last_durable_decree;
   std::string app_type;
   std::string disk_tag;
+  int64_t read_qps;
+  int64_t write_qps;
+  int64_t read_bytes_per_second;
+  int64_t write_bytes_per_second;
+  int64_t storage_mb;
 
   _replica_info__isset __isset;
 
@@ -2806,6 +2816,16 @@ class replica_info {
 
   void __set_disk_tag(const std::string& val);
 
+  void __set_read_qps(const int64_t val);
+
+  void __set_write_qps(const int64_t val);
+
+  void __set_read_bytes_per_second(const int64_t val);
+
+  void __set_write_bytes_per_second(const int64_t val);
+
+  void __set_storage_mb(const int64_t val);
+
   bool operator == (const replica_info & rhs) const
   {
     if (!(pid == rhs.pid))
@@ -2824,6 +2844,26 @@ class replica_info {
       return false;
     if (!(disk_tag == rhs.disk_tag))
       return false;
+    if (__isset.read_qps != rhs.__isset.read_qps)
+      return false;
+    else if (__isset.read_qps && !(read_qps == rhs.read_qps))
+      return false;
+    if (__isset.write_qps != rhs.__isset.write_qps)
+      return false;
+    else if (__isset.write_qps && !(write_qps == rhs.write_qps))
+      return false;
+    if (__isset.read_bytes_per_second != rhs.__isset.read_bytes_per_second)
+      return false;
+    else if (__isset.read_bytes_per_second && !(read_bytes_per_second == rhs.read_bytes_per_second))
+      return false;
+    if (__isset.write_bytes_per_second != rhs.__isset.write_bytes_per_second)
+      return false;
+    else if (__isset.write_bytes_per_second && !(write_bytes_per_second == rhs.write_bytes_per_second))
+      return false;
+    if (__isset.storage_mb != rhs.__isset.storage_mb)
+      return false;
+    else if (__isset.storage_mb && !(storage_mb == rhs.storage_mb))
+      return false;
     return true;
   }
   bool operator != (const replica_info &rhs) const {
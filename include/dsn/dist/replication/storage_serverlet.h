@@ -16,6 +16,11 @@ protected:
     static std::unordered_map<std::string, rpc_handler> _handlers;
     static std::vector<rpc_handler> _vhandlers;
 
+    // applies a write update without a request message, see handle_update()
+    typedef std::function<void(T *, const blob &data, dsn_msg_serialize_format fmt)>
+        update_handler;
+    static std::vector<update_handler> _vupdate_handlers;
+
     template <typename TReq, typename TResp>
     static bool
     register_async_rpc_handler(dsn::task_code rpc_code,
@@ -28,7 +33,16 @@ protected:
             rpc_replier<TResp> replier(dsn_msg_create_response(r));
             handler(p, req, replier);
         };
+        update_handler uh = [handler](T *p, const blob &data, dsn_msg_serialize_format fmt) {
+            TReq req;
+            ::dsn::binary_reader reader(data);
+            ::dsn::unmarshall(reader, req, fmt);
+            // nobody waits for the response of an update
+            rpc_replier<TResp> replier(nullptr);
+            handler(p, req, replier);
+        };
 
+        register_update_handler(rpc_code, uh);
         return register_async_rpc_handler(rpc_code, name, h);
     }
 
@@ -42,7 +56,14 @@ protected:
             ::dsn::unmarshall(r, req);
             handler(p, req);
         };
+        update_handler uh = [handler](T *p, const blob &data, dsn_msg_serialize_format fmt) {
+            TReq req;
+            ::dsn::binary_reader reader(data);
+            ::dsn::unmarshall(reader, req, fmt);
+            handler(p, req);
+        };
 
+        register_update_handler(rpc_code, uh);
         return register_async_rpc_handler(rpc_code, name, h);
     }
 
@@ -62,6 +83,13 @@ protected:
         return true;
     }
 
+    static void register_update_handler(dsn::task_code rpc_code, const update_handler &h)
+    {
+        if (rpc_code >= _vupdate_handlers.size())
+            _vupdate_handlers.resize(rpc_code + 1);
+        _vupdate_handlers[rpc_code] = h;
+    }
+
     static const rpc_handler *find_handler(dsn::task_code rpc_code)
     {
         if (rpc_code < _vhandlers.size() && _vhandlers[rpc_code] != nullptr)
@@ -88,6 +116,24 @@ protected:
         }
         return 0;
     }
+
+    // apply a write update of a mutation which comes without its client request, e.g., on
+    // secondaries and during log replay, by unmarshalling the update data in place instead of
+    // faking a received request message for it
+    int handle_update(dsn::task_code rpc_code, dsn_msg_serialize_format fmt, const blob &data)
+    {
+        if (rpc_code < _vupdate_handlers.size() && _vupdate_handlers[rpc_code] != nullptr) {
+            _vupdate_handlers[rpc_code](static_cast<T *>(this), data, fmt);
+            return 0;
+        }
+
+        // handlers registered with raw messages still need a request
+        dsn_message_t request =
+            dsn_msg_create_received_request(rpc_code, fmt, (void *)data.data(), data.length());
+        int err = handle_request(request);
+        dsn_msg_release_ref(request);
+        return err;
+    }
 };
 
 template <typename T>
@@ -96,5 +142,8 @@ std::unordered_map<std::string, typename storage_serverlet<T>::rpc_handler>
 
 template <typename T>
 std::vector<typename storage_serverlet<T>::rpc_handler> storage_serverlet<T>::_vhandlers;
+
+template <typename T>
+std::vector<typename storage_serverlet<T>::update_handler> storage_serverlet<T>::_vupdate_handlers;
 }
 }
@@ -102,6 +102,11 @@ public:
     // reset the parser
     virtual void reset() {}
 
+    // called once the parser is dedicated to a single connection (see rpc_session), so that it
+    // may keep per-connection state across messages, e.g., a header format negotiated with
+    // the peer. parsers shared by connectionless networks (e.g., udp) are never attached.
+    virtual void on_attached_to_session() {}
+
     // after read, see if we can compose a message
     // if read_next returns -1, indicated the the message is corrupted
     virtual message_ex *get_message_on_receive(message_reader *reader, /*out*/ int &read_next) = 0;
@@ -137,6 +142,11 @@ public:
     // may be invoked for mutiple times if the message is reused for resending.
     virtual int get_buffers_on_send(message_ex *msg, /*out*/ send_buf *buffers) = 0;
 
+    // called in the session lock when the buffers got by get_buffers_on_send() are no longer
+    // used, i.e., they have been sent, or the sending queue has been cleared; the parser may
+    // release the buffers it built for sending then.
+    virtual void on_buffers_sent() {}
+
 public:
     DSN_API static network_header_format
     get_header_type(const char *bytes); // buffer size >= sizeof(uint32_t)
@@ -117,6 +117,11 @@ public:
     //
     DSN_API void on_recv_request(message_ex *msg, int delay_ms);
 
+    //
+    // called when network received a batch of complete request messages, e.g., from one read
+    //
+    DSN_API void on_recv_requests(message_ex **msgs, int count, int delay_ms);
+
     //
     // called when network received a complete reply message or network failed,
     // if network failed, the 'msg' will be nullptr
@@ -227,6 +232,8 @@ public:
     DSN_API bool cancel(message_ex *request);
     void delay_recv(int delay_ms);
     DSN_API bool on_recv_message(message_ex *msg, int delay_ms);
+    // requests in msgs are dispatched in bulk, replies are dispatched one by one
+    DSN_API bool on_recv_messages(message_ex **msgs, int count, int delay_ms);
 
     // for client session
 public:
@@ -269,6 +276,9 @@ private:
     // return whether there are messages for sending; should always be called in lock
     DSN_API bool unlink_message_for_send();
     DSN_API void clear_send_queue(bool resend_msgs);
+    // resolve the local rpc code of a received request by the code the remote
+    // process gave it, so that rpc_name is hashed only once per connection
+    void resolve_rpc_code(message_ex *msg);
 
 protected:
     // constant info
@@ -304,6 +314,16 @@ private:
     // ]
 
     std::atomic_int _delay_server_receive_ms;
+
+    // remote rpc code => (remote hash, local rpc code), only accessed by the reading thread;
+    // an entry is used only if the hash matches, as the codes of the remote process are
+    // meaningful only together with its hash
+    struct remote_rpc_code
+    {
+        uint32_t remote_hash;
+        int local_code;
+    };
+    std::vector<remote_rpc_code> _remote_rpc_codes;
 };
 
 // --------- inline implementation --------------
@@ -74,6 +74,15 @@ public:
     static std::string get_counter_value(const std::vector<std::string> &args);
     static std::string get_counter_sample(const std::vector<std::string> &args);
 
+    // render all counters for monitor scrapers, each named by its section and name with the
+    // app as a label; profiler counters share one metric per measure, labeled by task code
+    std::string export_prometheus();
+    std::string export_json();
+
+    // serve export_prometheus/export_json as RPC_HTTP_METRICS/RPC_HTTP_METRICS_JSON,
+    // which the http parser maps from "GET /metrics" and "GET /metrics/json"
+    void start_http_metrics();
+
 private:
     // full_name = perf_counter::build_full_name(...);
     perf_counter_ptr get_counter(const char *full_name);
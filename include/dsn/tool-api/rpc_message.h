@@ -116,6 +116,7 @@ public:
     dsn::task_code local_rpc_code;
     network_header_format hdr_format;
     int send_retry_count;
+    blob lz_body; // body compressed by the message parser for the next sending, if any
 
     // by message queuing
     dlink dl;
@@ -224,50 +224,63 @@ private:
 
 //----------------- rpc task -------------------------------------------------------
 
+// rpc handlers are looked up by rpc_server_dispatcher without locking or ref
+// counting, so an unregistered handler is only marked here and then retired to
+// the rpc_handler_reclaimer of its service_node, which deletes it once the
+// requests that may have looked it up are done
 struct rpc_handler_info
 {
     dsn::task_code code;
     std::string name;
-    bool unregistered;
-    std::atomic<int> running_count;
+    std::atomic<bool> unregistered;
     dsn_rpc_request_handler_t c_handler;
     void *parameter;
 
     explicit rpc_handler_info(dsn::task_code code)
-        : code(code), unregistered(false), running_count(0), c_handler(nullptr), parameter(nullptr)
+        : code(code), unregistered(false), c_handler(nullptr), parameter(nullptr)
     {
     }
     ~rpc_handler_info() {}
 
-    void add_ref() { running_count.fetch_add(1, std::memory_order_relaxed); }
-
-    int release_ref() { return running_count.fetch_sub(1, std::memory_order_release); }
-
     void run(dsn_message_t req)
     {
-        if (!unregistered) {
+        if (!unregistered.load(std::memory_order_relaxed)) {
             c_handler(req, parameter);
         }
-
-        if (1 == release_ref()) {
-            delete this;
-        }
     }
 
-    void unregister() { unregistered = true; }
+    void unregister() { unregistered.store(true, std::memory_order_relaxed); }
 };
 
 class service_node;
+class rpc_handler_reclaimer;
 class rpc_request_task : public task, public transient_object
 {
 public:
-    rpc_request_task(message_ex *request, rpc_handler_info *h, service_node *node);
+    // reclaimer and reclaim_token are from the rpc_handler_reclaimer::enter() before 'h' is
+    // looked up, and are left when the task is destroyed
+    rpc_request_task(message_ex *request,
+                     rpc_handler_info *h,
+                     service_node *node,
+                     rpc_handler_reclaimer *reclaimer = nullptr,
+                     uint32_t reclaim_token = 0);
     ~rpc_request_task();
 
     message_ex *get_request() const { return _request; }
 
     DSN_API void enqueue() override;
 
+    // enqueue the requests parsed from one network read together, where the tasks going
+    // to the same task queue are pushed with one task_queue::enqueue_bulk
+    DSN_API static void enqueue_bulk(rpc_request_task **tasks, int count);
+
+    // run to completion on the current (usually network) thread instead of enqueuing,
+    // for handlers declared rpc_request_is_non_blocking.
+    // like enqueue(), it expects on_rpc_request_enqueue, the enqueue join point of requests,
+    // to have been executed by rpc_engine, so that on_task_begin/on_task_end of the inline
+    // run are paired with it as on the queued path
+    DSN_API void run_inline();
+
     void exec() override
     {
         if (0 == _enqueue_ts_ns ||
@@ -286,6 +299,8 @@ protected:
     message_ex *_request;
     rpc_handler_info *_handler;
     uint64_t _enqueue_ts_ns;
+    rpc_handler_reclaimer *_reclaimer;
+    uint32_t _reclaim_token;
 };
 
 typedef void (*dsn_rpc_response_handler_replace_t)(dsn_rpc_response_handler_t callback,
@@ -68,6 +68,9 @@ public:
     DSN_API virtual ~task_queue();
 
     virtual void enqueue(task *task) = 0;
+    // enqueue a batch of tasks with as few lock acquisitions and wakeups as possible,
+    // the default implementation enqueues them one by one
+    DSN_API virtual void enqueue_bulk(task **tasks, int count);
     // dequeue may return more than 1 tasks, but there is a configured
     // best batch size for each worker so that load among workers
     // are balanced,
@@ -87,6 +90,8 @@ public:
     }
     const std::string &get_name() { return _name; }
     task_worker_pool *pool() const { return _pool; }
+    const threadpool_spec &pool_spec() const { return *_spec; }
+    DSN_API service_node *node() const;
     bool is_shared() const { return _worker_count > 1; }
     int worker_count() const { return _worker_count; }
     task_worker *owner_worker() const { return _owner_worker; } // when not is_shared()
@@ -100,6 +105,8 @@ private:
     friend class task_worker_pool;
     void set_owner_worker(task_worker *worker) { _owner_worker = worker; }
     void enqueue_internal(task *task);
+    void enqueue_internal_bulk(task **tasks, int count);
+    bool admit(task *task);
 
 private:
     task_worker_pool *_pool;
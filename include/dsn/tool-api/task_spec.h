@@ -201,12 +201,14 @@ public:
     dsn_msg_serialize_format rpc_msg_payload_serialize_default_format;
     rpc_channel rpc_call_channel;
     bool rpc_message_crc_required;
+    int32_t rpc_message_compress_min_bytes; // 0 for never compressing the message body
 
     int32_t rpc_timeout_milliseconds;
     int32_t rpc_request_resend_timeout_milliseconds;  // 0 for no auto-resend
     throttling_mode_t rpc_request_throttling_mode;    //
     std::vector<int> rpc_request_delays_milliseconds; // see exp_delay for delaying recving
     bool rpc_request_dropped_before_execution_when_timeout;
+    bool rpc_request_is_non_blocking; // may run to completion on the network thread
 
     // layer 2 configurations
     bool rpc_request_layer2_handler_required; // need layer 2 handler
@@ -315,6 +317,12 @@ CONFIG_FLD(bool,
            rpc_message_crc_required,
            false,
            "whether to calculate the crc checksum when send request/response")
+CONFIG_FLD(int32_t,
+           uint64,
+           rpc_message_compress_min_bytes,
+           0,
+           "compress the message body when it is not smaller than this size and the peer can "
+           "decompress it (negotiated in the dsn message parser), 0 for never")
 CONFIG_FLD(int32_t,
            uint64,
            rpc_timeout_milliseconds,
@@ -346,6 +354,12 @@ CONFIG_FLD(bool,
            false,
            "whether to drop a request right before execution when its queueing time is already "
            "greater than its timeout value")
+CONFIG_FLD(bool,
+           bool,
+           rpc_request_is_non_blocking,
+           false,
+           "whether the rpc handler never blocks, so that it may run to completion on the network "
+           "thread which parsed the request, within the [network] inline_execution_* budget")
 
 // layer 2 configurations
 CONFIG_FLD(bool,
@@ -379,7 +393,13 @@ struct threadpool_spec
     worker_priority_t worker_priority;
     bool worker_share_core;
     uint64_t worker_affinity_mask;
+    std::string worker_cpu_list;
+    std::string worker_numa_nodes;
+    bool worker_numa_spread;
+    bool worker_numa_local_memory;
     int dequeue_batch_size;
+    int worker_spin_count;
+    int worker_yield_count;
     bool partitioned; // false by default
     std::string queue_factory_name;
     std::string worker_factory_name;
@@ -406,6 +426,17 @@ CONFIG_FLD(int,
            5,
            "how many tasks (if available) should be returned "
            "for one dequeue call for best batching performance")
+CONFIG_FLD(int,
+           uint64,
+           worker_spin_count,
+           0,
+           "max times an idle worker spins with cpu pause before parking, which adapts "
+           "to whether spinning found work recently; 0 for parking immediately")
+CONFIG_FLD(int,
+           uint64,
+           worker_yield_count,
+           0,
+           "how many times an idle worker yields its cpu after spinning and before parking")
 CONFIG_FLD_ENUM(worker_priority_t,
                 worker_priority,
                 THREAD_xPRIORITY_NORMAL,
@@ -418,6 +449,25 @@ CONFIG_FLD(uint64_t,
            worker_affinity_mask,
            0,
            "what CPU cores are assigned to this pool, 0 for all")
+CONFIG_FLD_STRING(worker_cpu_list,
+                  "",
+                  "what CPU cores are assigned to this pool as a list like 0-23,48-71, "
+                  "which overrides worker_affinity_mask and is not limited to 64 cores")
+CONFIG_FLD_STRING(worker_numa_nodes,
+                  "",
+                  "what NUMA nodes (as a list like 0,1) this pool is pinned to, empty for all")
+CONFIG_FLD(bool,
+           bool,
+           worker_numa_spread,
+           false,
+           "whether worker i is placed on NUMA node i % #nodes; partitioned pools whose "
+           "worker_count is a multiple of #nodes then keep the same hash (e.g., gpid) on "
+           "the same socket across pools")
+CONFIG_FLD(bool,
+           bool,
+           worker_numa_local_memory,
+           false,
+           "whether memory allocated by a worker prefers the NUMA node it is placed on")
 CONFIG_FLD(bool,
            bool,
            partitioned,
@@ -40,7 +40,9 @@
 #include <dsn/utility/synchronize.h>
 #include <dsn/utility/dlib.h>
 #include <dsn/tool-api/perf_counter.h>
+#include <map>
 #include <thread>
+#include <vector>
 
 namespace dsn {
 
@@ -98,9 +100,25 @@ public:
     DSN_API static void set_name(const char *name);
     DSN_API static void set_priority(worker_priority_t pri);
     DSN_API static void set_affinity(uint64_t affinity);
+    DSN_API static void set_affinity(const std::vector<int> &cpus);
+    DSN_API static void set_numa_memory_policy(int node);
+
+    // numa node id => cpus on the node
+    typedef std::map<int, std::vector<int>> numa_topology;
+
+    DSN_API static std::vector<int> affinity_mask_to_cpus(uint64_t affinity);
+
+    // get the cpus and numa nodes which the index-th worker of the pool is placed on, with the
+    // given numa topology; 'cpus' is empty if the worker is not bound to any cpu
+    DSN_API static void get_placement(const threadpool_spec &spec,
+                                      int index,
+                                      const numa_topology &topology,
+                                      /*out*/ std::vector<int> &cpus,
+                                      /*out*/ std::vector<int> &nodes);
 
 private:
     void run_internal();
+    void set_placement();
 
 public:
     /*!
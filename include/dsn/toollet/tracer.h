@@ -98,6 +98,14 @@ tracer::on_task_wait_pre = true
 [task.RPC_PING]
 is_trace = false
 
+[tools.tracer]
+; record spans for one in every this many trace ids, 0 to disable; sampled spans
+; are dumped in chrome trace format by command "tracer.spans"
+span_sample_ratio = 0
+
+; max span events kept per thread
+span_ring_size = 8192
+
 </PRE>
 */
 namespace dsn {
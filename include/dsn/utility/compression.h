@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <dsn/utility/blob.h>
+
+namespace dsn {
+namespace utils {
+
+//
+// compression of scattered buffers with the lz4 block api (thirdparty lz4)
+//
+// the compressed stream is a sequence of chunks of at most 64KB raw bytes:
+//      <raw_size(varint)> <stored_size(varint)> <data>
+// where data is an lz4 block if stored_size < raw_size, or the raw bytes otherwise.
+// a chunk never spans two input buffers, so scattered buffers (e.g., the buffers of a
+// message) are compressed one by one without being copied into a contiguous one first.
+//
+
+// compress the concatenation of 'inputs'
+// returns false if the result is not smaller than the input, and 'output' is untouched then
+bool lz_compress(const blob *inputs, int count, /*out*/ blob &output);
+
+// decompress the stream of 'size' bytes into 'output', which must hold exactly 'raw_size'
+// bytes after decompression
+// returns false if the stream is corrupted
+bool lz_decompress(const char *data, size_t size, /*out*/ char *output, size_t raw_size);
+}
+}
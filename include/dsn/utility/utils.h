@@ -37,6 +37,8 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #define TIME_MS_MAX 0xffffffff
 
@@ -88,5 +90,22 @@ inline int get_invalid_tid() { return -1; }
 // read it's stdout to output
 // and return the retcode of command
 int pipe_execute(const char *command, std::ostream &output);
+
+// parse a cpu (or numa node) list such as "0-3,8,10-11", which is also the
+// format of /sys/devices/system/node/nodeN/cpulist; ids are sorted and unique
+bool parse_cpu_list(const std::string &str, /*out*/ std::vector<int> &cpus);
+
+// number of cpus configured on this machine (including the offline ones), which
+// bounds the cpu ids
+int get_cpu_count();
+
+// numa topology of this machine; when the os does not expose it, there is
+// a single node 0 which owns all the cpus.
+// node ids may have holes, so iterate the ones by get_numa_nodes()
+int get_numa_node_count();
+void get_numa_nodes(/*out*/ std::vector<int> &nodes);
+
+// append the cpus on the given numa node to cpus
+void get_numa_node_cpus(int node, /*inout*/ std::vector<int> &cpus);
 }
 }
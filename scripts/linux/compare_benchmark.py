@@ -0,0 +1,58 @@
+#!/usr/bin/env python
+#
+# This script is to compare the benchmark results dumped by dsn.core.perf.tests
+# (run with --gtest_filter=core.benchmark_*) against a baseline.
+#
+# A benchmark is reported as regressed if its median time per operation grows by
+# more than the threshold (10% by default), and the growth is also beyond the noise
+# of both runs, i.e., larger than twice of their combined standard error.
+#
+# USAGE: python compare_benchmark.py <baseline.json> <current.json> [threshold]
+#
+# Exits with 1 if any benchmark regresses, or has no baseline (record one with
+# "run_benchmark.sh --update-baseline" on the reference machine).
+#
+
+import json, math, sys
+if len(sys.argv) < 3:
+  print("USAGE: " + sys.argv[0] + " <baseline.json> <current.json> [threshold]")
+  sys.exit(1)
+threshold = float(sys.argv[3]) if len(sys.argv) > 3 else 0.1
+
+def load(path):
+  with open(path) as f:
+    return dict((b['name'], b) for b in json.load(f)['benchmarks'])
+
+def std_error(b):
+  n = len(b['samples'])
+  return b['ns_per_op']['stddev'] / math.sqrt(n) if n > 0 else 0.0
+
+baseline = load(sys.argv[1])
+current = load(sys.argv[2])
+regressed = 0
+missing = 0
+print("%-50s %12s %12s %8s  %s" % ('name', 'baseline', 'current', 'change', 'status'))
+for name in sorted(set(baseline.keys()) | set(current.keys())):
+  if name not in baseline:
+    print("%-50s %12s %12s %8s  %s" % (name, '-', '-', '-', 'NO BASELINE'))
+    missing += 1
+    continue
+  if name not in current:
+    print("%-50s %12s %12s %8s  %s" % (name, '-', '-', '-', 'only in baseline'))
+    continue
+  b = baseline[name]
+  c = current[name]
+  bm = b['ns_per_op']['median']
+  cm = c['ns_per_op']['median']
+  change = (cm - bm) / bm if bm > 0 else 0.0
+  noise = 2 * math.sqrt(std_error(b) ** 2 + std_error(c) ** 2)
+  status = 'ok'
+  if change > threshold and cm - bm > noise:
+    status = 'REGRESSED'
+    regressed += 1
+  elif change < -threshold and bm - cm > noise:
+    status = 'improved'
+  print("%-50s %12.2f %12.2f %+7.1f%%  %s" % (name, bm, cm, change * 100, status))
+
+print("%d regressed, %d without baseline, threshold = %.1f%%" % (regressed, missing, threshold * 100))
+sys.exit(1 if regressed > 0 or missing > 0 else 0)
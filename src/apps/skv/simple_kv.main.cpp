@@ -36,6 +36,7 @@
 // apps
 #include "simple_kv.app.example.h"
 #include "simple_kv.server.impl.h"
+#include "simple_kv.server.sharded_impl.h"
 
 // framework specific tools
 #include <dsn/dist/replication/meta_service_app.h>
@@ -45,6 +46,7 @@
 static void dsn_app_registration_simple_kv()
 {
     dsn::replication::application::simple_kv_service_impl::register_service();
+    dsn::replication::application::simple_kv_sharded_service_impl::register_service();
 
     dsn_meta_server_bridge(0, nullptr);
     dsn_layer2_stateful_type1_bridge(0, nullptr);
@@ -0,0 +1,635 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     simple_kv storage engine on a sharded open-addressing hash table
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#include "simple_kv.server.sharded_impl.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <dsn/utility/filesystem.h>
+
+using namespace ::dsn::service;
+
+namespace dsn {
+namespace replication {
+namespace application {
+
+static const size_t ARENA_CHUNK_SIZE = 1024 * 1024;
+static const size_t SHARD_INITIAL_CAPACITY = 16;
+// the same file format as simple_kv_service_impl
+static const uint32_t CHECKPOINT_MAGIC = 0xdeadbeef;
+
+char *kv_arena::allocate(size_t size)
+{
+    if (size > _remain || _cursor == nullptr) {
+        // large ones get their own chunks, so that the rest of the current chunk is not wasted
+        if (size > _chunk_size / 4) {
+            _chunks.emplace_back(new char[size]);
+            return _chunks.back().get();
+        }
+        _chunks.emplace_back(new char[_chunk_size]);
+        _cursor = _chunks.back().get();
+        _remain = _chunk_size;
+    }
+
+    char *p = _cursor;
+    _cursor += size;
+    _remain -= size;
+    return p;
+}
+
+kv_shard::kv_shard() : _shared(false), _live_bytes(0), _garbage_bytes(0)
+{
+    _table = new_table(SHARD_INITIAL_CAPACITY, std::make_shared<kv_arena>(ARENA_CHUNK_SIZE));
+}
+
+/*static*/ uint64_t kv_shard::hash(const std::string &key)
+{
+    // fnv-1a, with the finalizer of murmur3 to spread the bits for the shard selection
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h == 0 ? 1 : h;
+}
+
+/*static*/ std::shared_ptr<kv_shard::table> kv_shard::new_table(size_t capacity,
+                                                                std::shared_ptr<kv_arena> arena)
+{
+    std::shared_ptr<table> t = std::make_shared<table>();
+    t->slots.resize(capacity, slot{0, nullptr, 0, 0});
+    t->count = 0;
+    t->arena = std::move(arena);
+    return t;
+}
+
+/*static*/ size_t kv_shard::find(const table &t, uint64_t hash, const std::string &key)
+{
+    // there is always an empty slot as the load factor is kept under 3/4
+    size_t mask = t.slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const slot &s = t.slots[i];
+        if (s.hash == 0)
+            return i;
+        if (s.hash == hash && s.key_length == key.length() &&
+            memcmp(s.data, key.data(), key.length()) == 0)
+            return i;
+    }
+}
+
+bool kv_shard::get(uint64_t hash, const std::string &key, /*out*/ std::string &value)
+{
+    zauto_read_lock l(_lock);
+    const slot &s = _table->slots[find(*_table, hash, key)];
+    if (s.hash == 0)
+        return false;
+    value.assign(s.data + s.key_length, s.value_length);
+    return true;
+}
+
+void kv_shard::put(uint64_t hash, const std::string &key, const std::string &value)
+{
+    zauto_write_lock l(_lock);
+    prepare_write();
+    size_t index = find(*_table, hash, key);
+    set(index, hash, key, value.data(), value.length(), nullptr, 0);
+}
+
+void kv_shard::append(uint64_t hash, const std::string &key, const std::string &value)
+{
+    zauto_write_lock l(_lock);
+    prepare_write();
+    size_t index = find(*_table, hash, key);
+    const slot &s = _table->slots[index];
+    if (s.hash == 0) {
+        set(index, hash, key, value.data(), value.length(), nullptr, 0);
+    } else {
+        // the old value stays in the arena, so it can be copied from directly
+        set(index,
+            hash,
+            key,
+            s.data + s.key_length,
+            s.value_length,
+            value.data(),
+            value.length());
+    }
+}
+
+void kv_shard::clear()
+{
+    zauto_write_lock l(_lock);
+    _table = new_table(SHARD_INITIAL_CAPACITY, std::make_shared<kv_arena>(ARENA_CHUNK_SIZE));
+    _shared = false;
+    _live_bytes = 0;
+    _garbage_bytes = 0;
+}
+
+std::shared_ptr<const kv_shard::table> kv_shard::snapshot()
+{
+    zauto_write_lock l(_lock);
+    _shared = true;
+    return _table;
+}
+
+void kv_shard::prepare_write()
+{
+    size_t capacity = _table->slots.size();
+    if ((_table->count + 1) * 4 > capacity * 3) {
+        rebuild(capacity * 2, _garbage_bytes > _live_bytes);
+    } else if (_garbage_bytes > _live_bytes && _garbage_bytes > ARENA_CHUNK_SIZE) {
+        // most of the arena is taken by overwritten values
+        rebuild(capacity, true);
+    } else if (_shared) {
+        _table = std::make_shared<table>(*_table);
+    }
+    _shared = false;
+}
+
+void kv_shard::rebuild(size_t capacity, bool compact)
+{
+    // the old table is left untouched for the snapshots which may refer to it
+    std::shared_ptr<table> t =
+        new_table(capacity, compact ? std::make_shared<kv_arena>(ARENA_CHUNK_SIZE) : _table->arena);
+    size_t mask = capacity - 1;
+    for (const slot &s : _table->slots) {
+        if (s.hash == 0)
+            continue;
+
+        size_t i = s.hash & mask;
+        while (t->slots[i].hash != 0)
+            i = (i + 1) & mask;
+
+        slot &n = t->slots[i];
+        n = s;
+        if (compact) {
+            size_t size = s.key_length + s.value_length;
+            char *data = t->arena->allocate(size);
+            memcpy(data, s.data, size);
+            n.data = data;
+        }
+    }
+    t->count = _table->count;
+
+    _table = std::move(t);
+    if (compact)
+        _garbage_bytes = 0;
+}
+
+void kv_shard::set(size_t index,
+                   uint64_t hash,
+                   const std::string &key,
+                   const char *v1,
+                   size_t v1_length,
+                   const char *v2,
+                   size_t v2_length)
+{
+    // never write into the old bytes, which may still be read by snapshots
+    size_t size = key.length() + v1_length + v2_length;
+    char *data = _table->arena->allocate(size);
+    memcpy(data, key.data(), key.length());
+    if (v1_length > 0)
+        memcpy(data + key.length(), v1, v1_length);
+    if (v2_length > 0)
+        memcpy(data + key.length() + v1_length, v2, v2_length);
+
+    slot &s = _table->slots[index];
+    if (s.hash == 0) {
+        _table->count++;
+    } else {
+        size_t old_size = s.key_length + s.value_length;
+        _live_bytes -= old_size;
+        _garbage_bytes += old_size;
+    }
+    _live_bytes += size;
+
+    s.hash = hash;
+    s.data = data;
+    s.key_length = static_cast<uint32_t>(key.length());
+    s.value_length = static_cast<uint32_t>(v1_length + v2_length);
+}
+
+static std::string checkpoint_file(const std::string &dir, int64_t decree)
+{
+    char name[64];
+    sprintf(name, "checkpoint.%" PRId64, decree);
+    return utils::filesystem::path_combine(dir, name);
+}
+
+// returns false if it's not the name of a checkpoint file
+static bool parse_checkpoint_file(const std::string &name, /*out*/ int64_t &decree)
+{
+    static const size_t prefix_length = strlen("checkpoint.");
+    if (name.length() <= prefix_length || name.compare(0, prefix_length, "checkpoint.") != 0)
+        return false;
+    for (size_t i = prefix_length; i < name.length(); i++) {
+        if (name[i] < '0' || name[i] > '9')
+            return false;
+    }
+    decree = static_cast<int64_t>(atoll(name.c_str() + prefix_length));
+    return true;
+}
+
+simple_kv_sharded_service_impl::simple_kv_sharded_service_impl(replica *r)
+    : simple_kv_service(r), _applied_decree(0), _last_durable_decree(0)
+{
+    uint64_t shard_count = dsn_config_get_value_uint64(
+        "simple_kv_sharded", "shard_count", 16, "shard count of the hash table of each replica");
+    dassert(shard_count > 0, "shard_count must be positive");
+    for (uint64_t i = 0; i < shard_count; i++)
+        _shards.emplace_back(new kv_shard());
+
+    ddebug("simple_kv_sharded_service_impl inited, shard_count = %" PRIu64, shard_count);
+}
+
+// RPC_SIMPLE_KV_READ
+void simple_kv_sharded_service_impl::on_read(const std::string &key,
+                                             ::dsn::rpc_replier<std::string> &reply)
+{
+    std::string r;
+    uint64_t h = kv_shard::hash(key);
+    shard_of(h).get(h, key, r);
+
+    dinfo("read %s", r.c_str());
+    reply(r);
+}
+
+// RPC_SIMPLE_KV_WRITE
+void simple_kv_sharded_service_impl::on_write(const kv_pair &pr,
+                                              ::dsn::rpc_replier<int32_t> &reply)
+{
+    uint64_t h = kv_shard::hash(pr.key);
+    shard_of(h).put(h, pr.key, pr.value);
+
+    dinfo("write %s", pr.key.c_str());
+    reply(0);
+}
+
+// RPC_SIMPLE_KV_APPEND
+void simple_kv_sharded_service_impl::on_append(const kv_pair &pr,
+                                               ::dsn::rpc_replier<int32_t> &reply)
+{
+    uint64_t h = kv_shard::hash(pr.key);
+    shard_of(h).append(h, pr.key, pr.value);
+
+    dinfo("append %s", pr.key.c_str());
+    reply(0);
+}
+
+int simple_kv_sharded_service_impl::on_batched_write_requests(int64_t decree,
+                                                              int64_t timestamp,
+                                                              dsn_message_t *requests,
+                                                              int request_length)
+{
+    zauto_lock l(_apply_lock);
+    int err = simple_kv_service::on_batched_write_requests(
+        decree, timestamp, requests, request_length);
+    _applied_decree = decree;
+    return err;
+}
+
+int simple_kv_sharded_service_impl::on_batched_write_updates(int64_t decree,
+                                                             int64_t timestamp,
+                                                             const mutation_update *updates,
+                                                             int update_count)
+{
+    zauto_lock l(_apply_lock);
+    int err =
+        simple_kv_service::on_batched_write_updates(decree, timestamp, updates, update_count);
+    _applied_decree = decree;
+    return err;
+}
+
+::dsn::error_code simple_kv_sharded_service_impl::start(int argc, char **argv)
+{
+    zauto_lock l(_checkpoint_lock);
+    recover();
+    return ERR_OK;
+}
+
+::dsn::error_code simple_kv_sharded_service_impl::stop(bool clear_state)
+{
+    if (clear_state) {
+        zauto_lock l(_checkpoint_lock);
+        if (!dsn::utils::filesystem::remove_path(_dir_data)) {
+            dassert(false, "Fail to delete directory %s.", _dir_data.c_str());
+        }
+        clear_shards();
+        _last_durable_decree.store(0);
+    }
+    return ERR_OK;
+}
+
+void simple_kv_sharded_service_impl::clear_shards()
+{
+    zauto_lock l(_apply_lock);
+    for (auto &s : _shards)
+        s->clear();
+    _applied_decree = 0;
+}
+
+int64_t simple_kv_sharded_service_impl::take_snapshot(/*out*/ snapshot_tables &tables)
+{
+    // writes are paused only for taking the table pointers of the shards
+    zauto_lock l(_apply_lock);
+    tables.reserve(_shards.size());
+    for (auto &s : _shards)
+        tables.push_back(s->snapshot());
+    return _applied_decree;
+}
+
+error_code simple_kv_sharded_service_impl::write_checkpoint(const std::string &dir,
+                                                            int64_t decree,
+                                                            const snapshot_tables &tables)
+{
+    std::string name = checkpoint_file(dir, decree);
+    std::string tmp_name = name + ".tmp";
+
+    std::ofstream os(tmp_name.c_str(), std::ios::binary);
+    if (!os.is_open()) {
+        derror("open checkpoint file %s failed", tmp_name.c_str());
+        return ERR_FILE_OPERATION_FAILED;
+    }
+
+    uint64_t count = 0;
+    for (auto &t : tables)
+        count += t->count;
+    os.write((const char *)&count, sizeof(count));
+    os.write((const char *)&CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+
+    for (auto &t : tables) {
+        for (const kv_shard::slot &s : t->slots) {
+            if (s.hash == 0)
+                continue;
+            os.write((const char *)&s.key_length, sizeof(s.key_length));
+            os.write(s.data, s.key_length);
+            os.write((const char *)&s.value_length, sizeof(s.value_length));
+            os.write(s.data + s.key_length, s.value_length);
+        }
+    }
+
+    os.close();
+    if (os.fail()) {
+        derror("write checkpoint file %s failed", tmp_name.c_str());
+        utils::filesystem::remove_path(tmp_name);
+        return ERR_FILE_OPERATION_FAILED;
+    }
+
+    if (!utils::filesystem::rename_path(tmp_name, name)) {
+        derror("rename %s to %s failed", tmp_name.c_str(), name.c_str());
+        utils::filesystem::remove_path(tmp_name);
+        return ERR_FILE_OPERATION_FAILED;
+    }
+
+    ddebug("checkpoint %s written, count = %" PRIu64, name.c_str(), count);
+    return ERR_OK;
+}
+
+error_code simple_kv_sharded_service_impl::checkpoint()
+{
+    snapshot_tables tables;
+    int64_t decree = take_snapshot(tables);
+    if (decree == last_durable_decree())
+        return ERR_NO_NEED_OPERATE;
+
+    error_code err = write_checkpoint(_dir_data, decree, tables);
+    if (err == ERR_OK) {
+        _last_durable_decree.store(decree);
+        gc_checkpoints();
+    }
+    return err;
+}
+
+void simple_kv_sharded_service_impl::gc_checkpoints()
+{
+    // keep the previous checkpoint too, as a learner may still be copying it
+    std::vector<std::string> sub_list;
+    if (!dsn::utils::filesystem::get_subfiles(_dir_data, sub_list, false)) {
+        derror("Fail to get subfiles in %s.", _dir_data.c_str());
+        return;
+    }
+
+    std::vector<int64_t> decrees;
+    for (auto &fpath : sub_list) {
+        int64_t decree;
+        if (parse_checkpoint_file(dsn::utils::filesystem::get_file_name(fpath), decree))
+            decrees.push_back(decree);
+    }
+    if (decrees.size() <= 2)
+        return;
+
+    std::sort(decrees.begin(), decrees.end());
+    for (size_t i = 0; i + 2 < decrees.size(); i++) {
+        std::string name = checkpoint_file(_dir_data, decrees[i]);
+        if (!dsn::utils::filesystem::remove_path(name))
+            dwarn("remove old checkpoint %s failed", name.c_str());
+    }
+}
+
+::dsn::error_code simple_kv_sharded_service_impl::sync_checkpoint()
+{
+    zauto_lock l(_checkpoint_lock);
+    error_code err = checkpoint();
+    return err == ERR_NO_NEED_OPERATE ? ERR_OK : err;
+}
+
+::dsn::error_code simple_kv_sharded_service_impl::async_checkpoint(bool is_emergency)
+{
+    if (!_checkpoint_lock.try_lock())
+        return ERR_WRONG_TIMING;
+    error_code err = checkpoint();
+    _checkpoint_lock.unlock();
+    return err;
+}
+
+::dsn::error_code simple_kv_sharded_service_impl::copy_checkpoint_to_dir(const char *checkpoint_dir,
+                                                                         int64_t *last_decree)
+{
+    // a new checkpoint of the current state, which is as cheap as copying the last one
+    snapshot_tables tables;
+    int64_t decree = take_snapshot(tables);
+
+    if (!utils::filesystem::directory_exists(checkpoint_dir) &&
+        !utils::filesystem::create_directory(checkpoint_dir)) {
+        derror("create checkpoint dir %s failed", checkpoint_dir);
+        return ERR_FILE_OPERATION_FAILED;
+    }
+
+    error_code err = write_checkpoint(checkpoint_dir, decree, tables);
+    if (err == ERR_OK && last_decree != nullptr)
+        *last_decree = decree;
+    return err;
+}
+
+// helper routines to accelerate learning
+::dsn::error_code simple_kv_sharded_service_impl::get_checkpoint(int64_t learn_start,
+                                                                 const dsn::blob &learn_request,
+                                                                 /*out*/ learn_state &state)
+{
+    int64_t decree = last_durable_decree();
+    state.from_decree_excluded = 0;
+    if (decree > 0) {
+        state.to_decree_included = decree;
+        state.files.push_back(checkpoint_file(_dir_data, decree));
+        return ERR_OK;
+    } else {
+        state.to_decree_included = 0;
+        return ERR_OBJECT_NOT_FOUND;
+    }
+}
+
+::dsn::error_code
+simple_kv_sharded_service_impl::storage_apply_checkpoint(chkpt_apply_mode mode,
+                                                         const learn_state &state)
+{
+    zauto_lock l(_checkpoint_lock);
+    std::string name = checkpoint_file(_dir_data, state.to_decree_included);
+
+    if (mode == chkpt_apply_mode::learn) {
+        error_code err = recover(state.files[0]);
+        if (err != ERR_OK)
+            return err;
+        {
+            zauto_lock l2(_apply_lock);
+            _applied_decree = state.to_decree_included;
+        }
+
+        // the learned file becomes the durable checkpoint if it can be linked, or the state
+        // is persisted by the next checkpoint otherwise
+        if (utils::filesystem::file_exists(name) ||
+            utils::filesystem::link_file(state.files[0], name)) {
+            _last_durable_decree.store(state.to_decree_included);
+            gc_checkpoints();
+        }
+        return ERR_OK;
+    } else {
+        dassert(chkpt_apply_mode::copy == mode, "invalid mode %d", (int)mode);
+        dassert(state.to_decree_included > last_durable_decree(),
+                "checkpoint's decree is smaller than current");
+
+        if (!utils::filesystem::rename_path(state.files[0], name))
+            return ERR_CHECKPOINT_FAILED;
+
+        _last_durable_decree.store(state.to_decree_included);
+        gc_checkpoints();
+        return ERR_OK;
+    }
+}
+
+// checkpoint related
+void simple_kv_sharded_service_impl::recover()
+{
+    clear_shards();
+    _last_durable_decree.store(0);
+
+    std::vector<std::string> sub_list;
+    if (!dsn::utils::filesystem::get_subfiles(_dir_data, sub_list, false)) {
+        dassert(false, "Fail to get subfiles in %s.", _dir_data.c_str());
+    }
+
+    int64_t max_decree = 0;
+    for (auto &fpath : sub_list) {
+        auto &&s = dsn::utils::filesystem::get_file_name(fpath);
+        int64_t decree;
+        if (parse_checkpoint_file(s, decree)) {
+            max_decree = std::max(max_decree, decree);
+        } else if (s.length() > 4 && s.compare(s.length() - 4, 4, ".tmp") == 0) {
+            // left by an unfinished checkpoint
+            dsn::utils::filesystem::remove_path(fpath);
+        }
+    }
+
+    if (max_decree > 0) {
+        error_code err = recover(checkpoint_file(_dir_data, max_decree));
+        dassert(err == ERR_OK,
+                "recover from checkpoint %" PRId64 " failed, err = %s",
+                max_decree,
+                err.to_string());
+
+        zauto_lock l(_apply_lock);
+        _applied_decree = max_decree;
+        _last_durable_decree.store(max_decree);
+    }
+}
+
+error_code simple_kv_sharded_service_impl::recover(const std::string &name)
+{
+    std::ifstream is(name.c_str(), std::ios::binary);
+    if (!is.is_open()) {
+        derror("open checkpoint file %s failed", name.c_str());
+        return ERR_FILE_OPERATION_FAILED;
+    }
+
+    uint64_t count;
+    uint32_t magic;
+    is.read((char *)&count, sizeof(count));
+    is.read((char *)&magic, sizeof(magic));
+    if (!is || magic != CHECKPOINT_MAGIC) {
+        derror("invalid checkpoint file %s", name.c_str());
+        return ERR_INVALID_DATA;
+    }
+
+    clear_shards();
+
+    std::string key;
+    std::string value;
+    for (uint64_t i = 0; i < count; i++) {
+        uint32_t sz;
+        is.read((char *)&sz, sizeof(sz));
+        key.resize(sz);
+        is.read(&key[0], sz);
+
+        is.read((char *)&sz, sizeof(sz));
+        value.resize(sz);
+        is.read(&value[0], sz);
+
+        if (!is) {
+            derror("checkpoint file %s is truncated at entry %" PRIu64, name.c_str(), i);
+            clear_shards();
+            return ERR_INVALID_DATA;
+        }
+
+        uint64_t h = kv_shard::hash(key);
+        shard_of(h).put(h, key, value);
+    }
+    return ERR_OK;
+}
+}
+}
+} // namespace
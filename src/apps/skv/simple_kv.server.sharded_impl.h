@@ -0,0 +1,225 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     simple_kv storage engine on a sharded open-addressing hash table, whose
+ *     checkpoints are written from copy-on-write snapshots without blocking writes
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#pragma once
+
+#include "simple_kv.server.h"
+#include <dist/replication/lib/replica.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class replication_service_test_app;
+
+namespace dsn {
+namespace replication {
+namespace application {
+
+//
+// append-only memory for keys and values
+//
+// bytes once allocated are never modified or freed until the arena itself is destroyed, so
+// snapshots may keep reading them while the owner shard goes on allocating.
+//
+class kv_arena
+{
+public:
+    explicit kv_arena(size_t chunk_size) : _chunk_size(chunk_size), _cursor(nullptr), _remain(0)
+    {
+    }
+
+    char *allocate(size_t size);
+
+private:
+    size_t _chunk_size;
+    std::vector<std::unique_ptr<char[]>> _chunks;
+    char *_cursor;
+    size_t _remain;
+};
+
+//
+// one shard of the store: an open-addressing hash table with linear probing
+//
+// the table (slots plus the arena they point into) is shared with snapshots through
+// shared_ptr, and cloned by the first write after a snapshot is taken (copy-on-write).
+// as arena bytes are immutable, a clone copies the slots only.
+//
+class kv_shard
+{
+public:
+    struct slot
+    {
+        uint64_t hash;    // 0 for empty slots
+        const char *data; // key followed by value in the arena
+        uint32_t key_length;
+        uint32_t value_length;
+    };
+
+    struct table
+    {
+        std::vector<slot> slots; // size is a power of 2
+        size_t count;
+        std::shared_ptr<kv_arena> arena;
+    };
+
+    kv_shard();
+
+    static uint64_t hash(const std::string &key);
+
+    bool get(uint64_t hash, const std::string &key, /*out*/ std::string &value);
+    void put(uint64_t hash, const std::string &key, const std::string &value);
+    void append(uint64_t hash, const std::string &key, const std::string &value);
+    void clear();
+
+    // the returned table is never modified by the shard afterwards
+    std::shared_ptr<const table> snapshot();
+
+private:
+    static std::shared_ptr<table> new_table(size_t capacity, std::shared_ptr<kv_arena> arena);
+    // index of the slot of the key, or of the empty slot where it should be inserted
+    static size_t find(const table &t, uint64_t hash, const std::string &key);
+    // prepare _table for modification, with room for one more entry
+    void prepare_write();
+    // move the entries into a new table, and into a new arena too if 'compact'
+    void rebuild(size_t capacity, bool compact);
+    // set the value of slots[index] to the concatenation of v1 and v2
+    void set(size_t index,
+             uint64_t hash,
+             const std::string &key,
+             const char *v1,
+             size_t v1_length,
+             const char *v2,
+             size_t v2_length);
+
+private:
+    ::dsn::service::zrwlock_nr _lock;
+    std::shared_ptr<table> _table;
+    bool _shared;          // _table is referenced by some snapshot
+    size_t _live_bytes;    // bytes of the current keys and values in the arena
+    size_t _garbage_bytes; // bytes of the overwritten ones
+};
+
+class simple_kv_sharded_service_impl : public simple_kv_service
+{
+public:
+    // register after simple_kv_service_impl::register_service(), which registers the rpc
+    // handlers shared by both engines
+    static void register_service()
+    {
+        replication_app_base::register_storage_engine(
+            "simple_kv_sharded", replication_app_base::create<simple_kv_sharded_service_impl>);
+    }
+    simple_kv_sharded_service_impl(replica *r);
+
+    // RPC_SIMPLE_KV_READ
+    virtual void on_read(const std::string &key, ::dsn::rpc_replier<std::string> &reply) override;
+    // RPC_SIMPLE_KV_WRITE
+    virtual void on_write(const kv_pair &pr, ::dsn::rpc_replier<int32_t> &reply) override;
+    // RPC_SIMPLE_KV_APPEND
+    virtual void on_append(const kv_pair &pr, ::dsn::rpc_replier<int32_t> &reply) override;
+
+    virtual int on_batched_write_requests(int64_t decree,
+                                          int64_t timestamp,
+                                          dsn_message_t *requests,
+                                          int request_length) override;
+
+    virtual int on_batched_write_updates(int64_t decree,
+                                         int64_t timestamp,
+                                         const mutation_update *updates,
+                                         int update_count) override;
+
+    virtual ::dsn::error_code start(int argc, char **argv) override;
+
+    virtual ::dsn::error_code stop(bool clear_state) override;
+
+    virtual int64_t last_durable_decree() const override { return _last_durable_decree.load(); }
+
+    virtual ::dsn::error_code sync_checkpoint() override;
+
+    virtual ::dsn::error_code async_checkpoint(bool is_emergency) override;
+
+    virtual ::dsn::error_code copy_checkpoint_to_dir(const char *checkpoint_dir,
+                                                     int64_t *last_decree) override;
+
+    virtual ::dsn::error_code prepare_get_checkpoint(blob &learn_req) override
+    {
+        return dsn::ERR_OK;
+    }
+
+    virtual ::dsn::error_code get_checkpoint(int64_t learn_start,
+                                             const dsn::blob &learn_request,
+                                             /*out*/ learn_state &state) override;
+
+    virtual ::dsn::error_code storage_apply_checkpoint(chkpt_apply_mode mode,
+                                                       const learn_state &state) override;
+
+    virtual void manual_compact() override {}
+
+private:
+    friend class ::replication_service_test_app;
+
+    typedef std::vector<std::shared_ptr<const kv_shard::table>> snapshot_tables;
+
+    // the low bits of the hash are used inside the shard
+    kv_shard &shard_of(uint64_t hash) { return *_shards[(hash >> 32) % _shards.size()]; }
+
+    // take snapshots of all shards, consistent at the returned decree
+    int64_t take_snapshot(/*out*/ snapshot_tables &tables);
+    error_code
+    write_checkpoint(const std::string &dir, int64_t decree, const snapshot_tables &tables);
+    // write a checkpoint if there are new commits, with _checkpoint_lock held
+    error_code checkpoint();
+    void gc_checkpoints();
+
+    void recover();
+    error_code recover(const std::string &name);
+    void clear_shards();
+
+private:
+    std::vector<std::unique_ptr<kv_shard>> _shards;
+
+    // held while applying a batch of writes, so that snapshots of all shards can be taken at
+    // the same decree
+    zlock _apply_lock;
+    int64_t _applied_decree;
+
+    // only one checkpoint is written at a time
+    zlock _checkpoint_lock;
+    std::atomic<int64_t> _last_durable_decree;
+};
+}
+}
+} // namespace
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cstring>
+#include <lz4.h>
+#include <dsn/utility/compression.h>
+#include <dsn/utility/utils.h>
+
+namespace dsn {
+namespace utils {
+
+// chunks are small enough for the sizes to fit in int, as the lz4 block api requires
+static const size_t CHUNK_SIZE = 64 * 1024;
+// max size of the two varints before each chunk, as chunks are not larger than CHUNK_SIZE
+static const size_t CHUNK_HEADER_MAX_SIZE = 6;
+
+static inline uint8_t *write_varint(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = static_cast<uint8_t>((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(v);
+    return p;
+}
+
+static inline bool read_varint(const uint8_t *&p, const uint8_t *end, /*out*/ uint64_t &v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool lz_compress(const blob *inputs, int count, /*out*/ blob &output)
+{
+    size_t total = 0;
+    for (int i = 0; i < count; i++)
+        total += inputs[i].length();
+    if (total == 0)
+        return false;
+
+    std::shared_ptr<char> buffer(make_shared_array<char>(total));
+    uint8_t *out = reinterpret_cast<uint8_t *>(buffer.get());
+    uint8_t *op = out;
+    uint8_t *oend = out + total;
+
+    for (int i = 0; i < count; i++) {
+        const char *src = inputs[i].data();
+        size_t remain = inputs[i].length();
+        while (remain > 0) {
+            size_t raw_size = std::min(remain, CHUNK_SIZE);
+            if (static_cast<size_t>(oend - op) <= CHUNK_HEADER_MAX_SIZE)
+                return false;
+
+            // compress behind the room of the chunk header, and move the data forward after
+            // the header is written; LZ4_compress_default returns 0 if the data doesn't fit
+            char *data = reinterpret_cast<char *>(op + CHUNK_HEADER_MAX_SIZE);
+            size_t capacity = std::min(raw_size - 1, static_cast<size_t>(oend - op) -
+                                                         CHUNK_HEADER_MAX_SIZE);
+            size_t stored_size = 0;
+            if (capacity > 0) {
+                int ret = LZ4_compress_default(
+                    src, data, static_cast<int>(raw_size), static_cast<int>(capacity));
+                stored_size = ret > 0 ? static_cast<size_t>(ret) : 0;
+            }
+            if (stored_size == 0) {
+                if (static_cast<size_t>(oend - op) - CHUNK_HEADER_MAX_SIZE < raw_size)
+                    return false;
+                memcpy(data, src, raw_size);
+                stored_size = raw_size;
+            }
+
+            op = write_varint(op, raw_size);
+            op = write_varint(op, stored_size);
+            memmove(op, data, stored_size);
+            op += stored_size;
+
+            src += raw_size;
+            remain -= raw_size;
+        }
+    }
+
+    if (op >= oend)
+        return false;
+    output = blob(std::move(buffer), static_cast<unsigned int>(op - out));
+    return true;
+}
+
+bool lz_decompress(const char *data, size_t size, /*out*/ char *output, size_t raw_size)
+{
+    const uint8_t *ip = reinterpret_cast<const uint8_t *>(data);
+    const uint8_t *iend = ip + size;
+    char *op = output;
+    size_t remain = raw_size;
+
+    while (ip < iend) {
+        uint64_t chunk_raw_size, stored_size;
+        if (!read_varint(ip, iend, chunk_raw_size) || !read_varint(ip, iend, stored_size))
+            return false;
+        if (chunk_raw_size > remain || chunk_raw_size > CHUNK_SIZE ||
+            stored_size > chunk_raw_size || stored_size > static_cast<uint64_t>(iend - ip))
+            return false;
+
+        if (stored_size == chunk_raw_size) {
+            memcpy(op, ip, stored_size);
+        } else if (LZ4_decompress_safe(reinterpret_cast<const char *>(ip),
+                                       op,
+                                       static_cast<int>(stored_size),
+                                       static_cast<int>(chunk_raw_size)) !=
+                   static_cast<int>(chunk_raw_size)) {
+            return false;
+        }
+
+        ip += stored_size;
+        op += chunk_raw_size;
+        remain -= chunk_raw_size;
+    }
+    return remain == 0;
+}
+}
+}
@@ -121,6 +121,8 @@ void rpc_session::clear_send_queue(bool resend_msgs)
         utils::auto_lock<utils::ex_lock_nr> l(_lock);
         _sending_msgs.swap(swapped_sending_msgs);
         _sending_buffers.clear();
+        if (_parser)
+            _parser->on_buffers_sent();
     }
 
     // resend pending messages if need
@@ -251,6 +253,7 @@ int rpc_session::prepare_parser()
         }
     }
     _parser = _net.new_message_parser(hdr_format);
+    _parser->on_attached_to_session();
     dinfo("message parser created, remote_client = %s, header_format = %s",
           _remote_addr.to_string(),
           hdr_format.to_string());
@@ -328,6 +331,7 @@ void rpc_session::on_send_completed(uint64_t signature)
             }
             _sending_msgs.clear();
             _sending_buffers.clear();
+            _parser->on_buffers_sent();
         }
 
         if (!_is_sending_next) {
@@ -366,6 +370,9 @@ rpc_session::rpc_session(connection_oriented_network &net,
       _message_sent(0),
       _delay_server_receive_ms(0)
 {
+    if (_parser) {
+        _parser->on_attached_to_session();
+    }
     if (!is_client) {
         on_rpc_session_connected.execute(this);
     }
@@ -394,6 +401,42 @@ bool rpc_session::on_disconnected(bool is_write)
     return ret;
 }
 
+bool rpc_session::on_recv_messages(message_ex **msgs, int count, int delay_ms)
+{
+    bool ret = true;
+    int request_count = 0;
+    for (int i = 0; i < count; i++) {
+        message_ex *msg = msgs[i];
+        if (!msg->header->context.u.is_request) {
+            ret = on_recv_message(msg, delay_ms) && ret;
+            continue;
+        }
+
+        if (msg->header->from_address.is_invalid())
+            msg->header->from_address = _remote_addr;
+        msg->to_address = _net.address();
+        msg->io_session = this;
+
+        // see on_recv_message for self connection
+        if (is_client() && msg->header->from_address == _net.engine()->primary_address()) {
+            derror("self connection detected, address = %s", msg->header->from_address.to_string());
+            dassert(msg->get_count() == 0, "message should not be referenced by anybody so far");
+            delete msg;
+            ret = false;
+            continue;
+        }
+
+        dbg_dassert(!is_client(), "only rpc server session can recv rpc requests");
+        resolve_rpc_code(msg);
+        msgs[request_count++] = msg;
+    }
+
+    if (request_count > 0) {
+        _net.on_recv_requests(msgs, request_count, delay_ms);
+    }
+    return ret;
+}
+
 bool rpc_session::on_recv_message(message_ex *msg, int delay_ms)
 {
     if (msg->header->from_address.is_invalid())
@@ -423,6 +466,7 @@ bool rpc_session::on_recv_message(message_ex *msg, int delay_ms)
         }
 
         dbg_dassert(!is_client(), "only rpc server session can recv rpc requests");
+        resolve_rpc_code(msg);
         _net.on_recv_request(msg, delay_ms);
     }
 
@@ -436,6 +480,37 @@ bool rpc_session::on_recv_message(message_ex *msg, int delay_ms)
     return true;
 }
 
+void rpc_session::resolve_rpc_code(message_ex *msg)
+{
+    // only the dsn header carries the remote code, and codes are directly usable
+    // when both processes register them in the same order (see message_ex::rpc_code)
+    auto &code = msg->header->rpc_code;
+    if (msg->hdr_format != NET_HDR_DSN || msg->local_rpc_code != TASK_CODE_INVALID ||
+        code.local_hash == 0 || code.local_hash == message_ex::s_local_hash ||
+        code.local_code == 0 || code.local_code > 0xffff) {
+        return;
+    }
+
+    uint32_t remote_hash = code.local_hash;
+    uint32_t remote_code = code.local_code;
+    if (remote_code < _remote_rpc_codes.size() &&
+        _remote_rpc_codes[remote_code].remote_hash == remote_hash) {
+        // rewrite the header as message_ex::rpc_code() does on resolving
+        msg->local_rpc_code = task_code(_remote_rpc_codes[remote_code].local_code);
+        code.local_hash = message_ex::s_local_hash;
+        code.local_code = msg->local_rpc_code.code();
+        return;
+    }
+
+    task_code local_code = msg->rpc_code();
+    if (local_code != TASK_CODE_INVALID) {
+        if (remote_code >= _remote_rpc_codes.size())
+            _remote_rpc_codes.resize(remote_code + 1, remote_rpc_code{0, TASK_CODE_INVALID});
+        _remote_rpc_codes[remote_code].remote_hash = remote_hash;
+        _remote_rpc_codes[remote_code].local_code = local_code;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 network::network(rpc_engine *srv, network *inner_provider)
     : _engine(srv), _client_hdr_format(NET_HDR_DSN), _unknown_msg_header_format(NET_HDR_INVALID)
@@ -471,6 +546,11 @@ void network::on_recv_request(message_ex *msg, int delay_ms)
     return _engine->on_recv_request(this, msg, delay_ms);
 }
 
+void network::on_recv_requests(message_ex **msgs, int count, int delay_ms)
+{
+    return _engine->on_recv_requests(this, msgs, count, delay_ms);
+}
+
 void network::on_recv_reply(uint64_t id, message_ex *msg, int delay_ms)
 {
     _engine->matcher()->on_recv_reply(this, id, msg, delay_ms);
@@ -34,6 +34,7 @@
 */
 
 #include "partition_resolver_simple.h"
+#include <dsn/dist/partition_routing_table.h>
 #include <dsn/utility/utils.h>
 
 namespace dsn {
@@ -45,9 +46,18 @@ partition_resolver_simple::partition_resolver_simple(rpc_address meta_server, co
     : partition_resolver(meta_server, app_path),
       _app_id(-1),
       _app_partition_count(-1),
-      _app_is_stateful(true)
+      _app_is_stateful(true),
+      _config_epoch(0),
+      _config_version(0),
+      _query_routing_table(true)
 {
     dassert(meta_server.type() != HOST_TYPE_URI, "can not use uri address here");
+    _subscribe_hold_ms = (int)dsn_config_get_value_uint64(
+        "core",
+        "partition_config_subscribe_hold_ms",
+        0,
+        "how long the meta server may hold a configuration subscription of the client "
+        "partition resolver, 0 for not subscribing and only refreshing on access failure");
 }
 
 void partition_resolver_simple::resolve(uint64_t partition_hash,
@@ -99,7 +109,19 @@ void partition_resolver_simple::on_access_failure(int partition_index, error_cod
     }
 }
 
-partition_resolver_simple::~partition_resolver_simple() { clear_all_pending_requests(); }
+partition_resolver_simple::~partition_resolver_simple()
+{
+    task_ptr subscribe_task;
+    {
+        zauto_lock l(_requests_lock);
+        subscribe_task = _subscribe_task;
+        _subscribe_task = nullptr;
+    }
+    if (subscribe_task != nullptr) {
+        subscribe_task->cancel(false);
+    }
+    clear_all_pending_requests();
+}
 
 void partition_resolver_simple::clear_all_pending_requests()
 {
@@ -228,6 +250,11 @@ DEFINE_TASK_CODE_RPC(RPC_CM_QUERY_PARTITION_CONFIG_BY_INDEX,
 
 task_ptr partition_resolver_simple::query_config(int partition_index)
 {
+    // a cold client fetches the whole table in one compact snapshot
+    if (partition_index == -1 && _query_routing_table) {
+        return query_routing_table();
+    }
+
     dinfo(
         "%s.client: start query config, gpid = %d.%d", _app_path.c_str(), _app_id, partition_index);
     auto msg = dsn_msg_create_request(RPC_CM_QUERY_PARTITION_CONFIG_BY_INDEX);
@@ -252,14 +279,89 @@ void partition_resolver_simple::query_config_reply(error_code err,
                                                    dsn_message_t request,
                                                    dsn_message_t response,
                                                    int partition_index)
+{
+    configuration_query_by_index_response resp;
+    if (err == ERR_OK) {
+        unmarshall(response, resp);
+    }
+    on_query_config_response(err, resp, partition_index);
+}
+
+DEFINE_TASK_CODE_RPC(RPC_CM_QUERY_ROUTING_TABLE, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+
+task_ptr partition_resolver_simple::query_routing_table()
+{
+    dinfo("%s.client: start query routing table", _app_path.c_str());
+    auto msg = dsn_msg_create_request(RPC_CM_QUERY_ROUTING_TABLE);
+
+    configuration_query_routing_request req;
+    req.app_name = _app_path;
+    {
+        zauto_read_lock l(_config_lock);
+        req.epoch = _config_epoch;
+        req.known_version = _config_version;
+    }
+    marshall(msg, req);
+
+    return rpc::call(
+        _meta_server, msg, this, [this](error_code err, dsn_message_t req, dsn_message_t resp) {
+            query_routing_table_reply(err, req, resp);
+        });
+}
+
+void partition_resolver_simple::query_routing_table_reply(error_code err,
+                                                          dsn_message_t request,
+                                                          dsn_message_t response)
+{
+    if (err == ERR_HANDLER_NOT_FOUND) {
+        dwarn("%s.client: routing table query is not supported by meta server, "
+              "fall back to query all partitions",
+              _app_path.c_str());
+        _query_routing_table = false;
+        zauto_lock l(_requests_lock);
+        _query_config_task = query_config(-1);
+        return;
+    }
+
+    // translate into the per-partition response so that the pending requests are
+    // handled in one place
+    configuration_query_by_index_response resp;
+    if (err == ERR_OK) {
+        configuration_query_routing_response rt;
+        unmarshall(response, rt);
+        resp.err = rt.err;
+        resp.app_id = rt.app_id;
+        resp.partition_count = rt.partition_count;
+        resp.is_stateful = rt.is_stateful;
+        if (rt.err == ERR_OK && rt.routes.length() > 0 &&
+            !partition_routing_table::decode(rt.routes, rt.app_id, resp.partitions)) {
+            derror("%s.client: corrupted routing table, size = %u",
+                   _app_path.c_str(),
+                   rt.routes.length());
+            resp.err = ERR_INVALID_DATA;
+        }
+        if (resp.err == ERR_OK) {
+            // the subscription continues from this snapshot
+            zauto_write_lock l(_config_lock);
+            if (_config_epoch != rt.epoch || _config_version < rt.version) {
+                _config_epoch = rt.epoch;
+                _config_version = rt.version;
+            }
+        }
+    }
+    on_query_config_response(err, resp, -1);
+}
+
+void partition_resolver_simple::on_query_config_response(
+    error_code err, const configuration_query_by_index_response &resp, int partition_index)
 {
     auto client_err = ERR_OK;
+    bool start_subscribe = false;
 
     if (err == ERR_OK) {
-        configuration_query_by_index_response resp;
-        unmarshall(response, resp);
         if (resp.err == ERR_OK) {
             zauto_write_lock l(_config_lock);
+            start_subscribe = (_subscribe_hold_ms > 0 && _app_id == -1);
 
             if (_app_id != -1 && _app_id != resp.app_id) {
                 dassert(false,
@@ -279,33 +381,7 @@ void partition_resolver_simple::query_config_reply(error_code err,
             _app_partition_count = resp.partition_count;
             _app_is_stateful = resp.is_stateful;
 
-            for (auto it = resp.partitions.begin(); it != resp.partitions.end(); ++it) {
-                auto &new_config = *it;
-
-                dinfo("%s.client: query config reply, gpid = %d.%d, ballot = %" PRId64
-                      ", primary = %s",
-                      _app_path.c_str(),
-                      new_config.pid.get_app_id(),
-                      new_config.pid.get_partition_index(),
-                      new_config.ballot,
-                      new_config.primary.to_string());
-
-                auto it2 = _config_cache.find(new_config.pid.get_partition_index());
-                if (it2 == _config_cache.end()) {
-                    std::unique_ptr<partition_info> pi(new partition_info);
-                    pi->timeout_count = 0;
-                    pi->config = new_config;
-                    _config_cache.emplace(new_config.pid.get_partition_index(), std::move(pi));
-                } else if (_app_is_stateful && it2->second->config.ballot < new_config.ballot) {
-                    it2->second->timeout_count = 0;
-                    it2->second->config = new_config;
-                } else if (!_app_is_stateful) {
-                    it2->second->timeout_count = 0;
-                    it2->second->config = new_config;
-                } else {
-                    // nothing to do
-                }
-            }
+            update_config_cache(resp.partitions);
         } else if (resp.err == ERR_OBJECT_NOT_FOUND) {
             derror("%s.client: query config reply, gpid = %d.%d, err = %s",
                    _app_path.c_str(),
@@ -331,6 +407,10 @@ void partition_resolver_simple::query_config_reply(error_code err,
                err.to_string());
     }
 
+    if (start_subscribe) {
+        subscribe_config();
+    }
+
     // get specific or all partition update
     if (partition_index != -1) {
         partition_context *pc = nullptr;
@@ -381,6 +461,120 @@ void partition_resolver_simple::query_config_reply(error_code err,
     }
 }
 
+void partition_resolver_simple::update_config_cache(
+    const std::vector<partition_configuration> &configs)
+{
+    for (auto it = configs.begin(); it != configs.end(); ++it) {
+        auto &new_config = *it;
+
+        dinfo("%s.client: update config cache, gpid = %d.%d, ballot = %" PRId64
+              ", primary = %s",
+              _app_path.c_str(),
+              new_config.pid.get_app_id(),
+              new_config.pid.get_partition_index(),
+              new_config.ballot,
+              new_config.primary.to_string());
+
+        auto it2 = _config_cache.find(new_config.pid.get_partition_index());
+        if (it2 == _config_cache.end()) {
+            std::unique_ptr<partition_info> pi(new partition_info);
+            pi->timeout_count = 0;
+            pi->config = new_config;
+            _config_cache.emplace(new_config.pid.get_partition_index(), std::move(pi));
+        } else if (_app_is_stateful && it2->second->config.ballot < new_config.ballot) {
+            it2->second->timeout_count = 0;
+            it2->second->config = new_config;
+        } else if (!_app_is_stateful) {
+            it2->second->timeout_count = 0;
+            it2->second->config = new_config;
+        } else {
+            // nothing to do
+        }
+    }
+}
+
+DEFINE_TASK_CODE_RPC(RPC_CM_SUBSCRIBE_PARTITION_CONFIG, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+
+void partition_resolver_simple::subscribe_config()
+{
+    configuration_subscribe_request req;
+    req.app_name = _app_path;
+    req.hold_ms = _subscribe_hold_ms;
+    {
+        zauto_read_lock l(_config_lock);
+        req.epoch = _config_epoch;
+        req.known_version = _config_version;
+    }
+
+    dinfo("%s.client: subscribe config, app_id = %d, version = %" PRId64,
+          _app_path.c_str(),
+          _app_id,
+          req.known_version);
+
+    // leave the meta server some time to reply before the request times out
+    auto msg = dsn_msg_create_request(RPC_CM_SUBSCRIBE_PARTITION_CONFIG, _subscribe_hold_ms + 5000);
+    marshall(msg, req);
+
+    zauto_lock l(_requests_lock);
+    _subscribe_task = rpc::call(
+        _meta_server, msg, this, [this](error_code err, dsn_message_t req, dsn_message_t resp) {
+            subscribe_config_reply(err, req, resp);
+        });
+}
+
+void partition_resolver_simple::subscribe_config_reply(error_code err,
+                                                       dsn_message_t request,
+                                                       dsn_message_t response)
+{
+    if (err == ERR_OK) {
+        configuration_subscribe_response resp;
+        unmarshall(response, resp);
+        if (resp.err == ERR_OK) {
+            zauto_write_lock l(_config_lock);
+            if (resp.app_id != _app_id) {
+                derror("%s.client: app id is changed on config subscription, local Vs remote: %d "
+                       "vs %d, stop subscribing",
+                       _app_path.c_str(),
+                       _app_id,
+                       resp.app_id);
+                return;
+            }
+
+            dinfo("%s.client: subscribe config reply, version = %" PRId64 ", changed = %d",
+                  _app_path.c_str(),
+                  resp.version,
+                  (int)resp.partitions.size());
+            update_config_cache(resp.partitions);
+            _config_epoch = resp.epoch;
+            _config_version = resp.version;
+        } else if (resp.err == ERR_OBJECT_NOT_FOUND) {
+            derror("%s.client: subscribe config reply, err = %s, stop subscribing",
+                   _app_path.c_str(),
+                   resp.err.to_string());
+            return;
+        } else {
+            err = resp.err;
+        }
+    }
+
+    if (err == ERR_OK) {
+        subscribe_config();
+    } else if (err == ERR_HANDLER_NOT_FOUND) {
+        dwarn("%s.client: config subscription is not supported by meta server",
+              _app_path.c_str());
+    } else {
+        dwarn("%s.client: subscribe config reply, err = %s, retry later",
+              _app_path.c_str(),
+              err.to_string());
+        zauto_lock l(_requests_lock);
+        _subscribe_task = tasking::enqueue(LPC_REPLICATION_DELAY_QUERY_CONFIG,
+                                           this,
+                                           [this]() { subscribe_config(); },
+                                           0,
+                                           std::chrono::seconds(1));
+    }
+}
+
 void partition_resolver_simple::handle_pending_requests(std::deque<request_context_ptr> &reqs,
                                                         error_code err)
 {
@@ -71,6 +71,15 @@ private:
     int _app_partition_count;
     bool _app_is_stateful;
 
+    // configuration subscription, see subscribe_config
+    int _subscribe_hold_ms; // 0 for disabled
+    int64_t _config_epoch;
+    int64_t _config_version;
+    task_ptr _subscribe_task;
+
+    // false if the meta server doesn't serve RPC_CM_QUERY_ROUTING_TABLE
+    std::atomic<bool> _query_routing_table;
+
     typedef std::function<void(resolve_result &&)> callback_t;
     struct request_context : ref_counter, transient_object
     {
@@ -122,6 +131,19 @@ private:
                             dsn_message_t request,
                             dsn_message_t response,
                             int partition_index);
+    void on_query_config_response(error_code err,
+                                  const configuration_query_by_index_response &resp,
+                                  int partition_index);
+    task_ptr query_routing_table();
+    void query_routing_table_reply(error_code err, dsn_message_t request, dsn_message_t response);
+
+    // must be called with _config_lock held
+    void update_config_cache(const std::vector<partition_configuration> &configs);
+
+    // long-poll the meta server for configuration changes of this app, so that
+    // primary switches are learned before requests fail on the stale primary
+    void subscribe_config();
+    void subscribe_config_reply(error_code err, dsn_message_t request, dsn_message_t response);
 };
 #pragma pack(pop)
 }
@@ -0,0 +1,184 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <dsn/dist/partition_routing_table.h>
+#include <dsn/utility/utils.h>
+#include <unordered_map>
+
+namespace dsn {
+namespace dist {
+
+static const uint8_t ROUTING_TABLE_FORMAT_VERSION = 1;
+
+static void write_varint(std::string &out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+static bool read_varint(const char *&p, const char *end, /*out*/ uint64_t &v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static uint64_t zigzag_encode(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ (v >> 63); }
+
+static int64_t zigzag_decode(uint64_t v)
+{
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+blob partition_routing_table::encode(const std::vector<partition_configuration> &configs)
+{
+    std::vector<rpc_address> nodes;
+    std::unordered_map<uint64_t, uint64_t> node_refs;
+    auto ref = [&nodes, &node_refs](const rpc_address &addr) -> uint64_t {
+        if (addr.is_invalid())
+            return 0;
+        dassert(addr.type() == HOST_TYPE_IPV4,
+                "only ipv4 address is allowed in partition configuration, address = %s",
+                addr.to_string());
+        auto it = node_refs.emplace(addr.c_addr().u.value, nodes.size() + 1);
+        if (it.second)
+            nodes.push_back(addr);
+        return it.first->second;
+    };
+
+    // encode the partitions first to build the node dictionary
+    std::string body;
+    body.reserve(configs.size() * 16);
+    write_varint(body, configs.size());
+    for (const partition_configuration &pc : configs) {
+        write_varint(body, zigzag_encode(pc.ballot));
+        write_varint(body, static_cast<uint64_t>(pc.max_replica_count));
+        write_varint(body, static_cast<uint32_t>(pc.partition_flags));
+        write_varint(body, ref(pc.primary));
+        write_varint(body, pc.secondaries.size());
+        for (const rpc_address &addr : pc.secondaries)
+            write_varint(body, ref(addr));
+        write_varint(body, pc.last_drops.size());
+        for (const rpc_address &addr : pc.last_drops)
+            write_varint(body, ref(addr));
+    }
+
+    std::string header;
+    header.reserve(1 + 5 + nodes.size() * 6);
+    header.push_back(static_cast<char>(ROUTING_TABLE_FORMAT_VERSION));
+    write_varint(header, nodes.size());
+    for (const rpc_address &addr : nodes) {
+        uint32_t ip = addr.ip();
+        uint16_t port = addr.port();
+        header.append(reinterpret_cast<const char *>(&ip), sizeof(ip));
+        header.append(reinterpret_cast<const char *>(&port), sizeof(port));
+    }
+
+    unsigned int length = static_cast<unsigned int>(header.size() + body.size());
+    std::shared_ptr<char> buffer(utils::make_shared_array<char>(length));
+    memcpy(buffer.get(), header.data(), header.size());
+    memcpy(buffer.get() + header.size(), body.data(), body.size());
+    return blob(std::move(buffer), length);
+}
+
+bool partition_routing_table::decode(const blob &data,
+                                     int32_t app_id,
+                                     /*out*/ std::vector<partition_configuration> &configs)
+{
+    const char *p = data.data();
+    const char *end = p + data.length();
+    uint64_t v;
+
+    if (p == end || static_cast<uint8_t>(*p++) != ROUTING_TABLE_FORMAT_VERSION)
+        return false;
+
+    if (!read_varint(p, end, v) || v > static_cast<uint64_t>(end - p) / 6)
+        return false;
+    std::vector<rpc_address> nodes(v);
+    for (rpc_address &addr : nodes) {
+        uint32_t ip;
+        uint16_t port;
+        memcpy(&ip, p, sizeof(ip));
+        memcpy(&port, p + sizeof(ip), sizeof(port));
+        p += sizeof(ip) + sizeof(port);
+        addr.assign_ipv4(ip, port);
+    }
+
+    auto deref = [&nodes](uint64_t ref, /*out*/ rpc_address &addr) {
+        if (ref > nodes.size())
+            return false;
+        if (ref == 0)
+            addr.set_invalid();
+        else
+            addr = nodes[ref - 1];
+        return true;
+    };
+    auto read_list = [&](/*out*/ std::vector<rpc_address> &list) {
+        uint64_t count, ref;
+        if (!read_varint(p, end, count) || count > static_cast<uint64_t>(end - p))
+            return false;
+        list.resize(count);
+        for (rpc_address &addr : list) {
+            if (!read_varint(p, end, ref) || !deref(ref, addr))
+                return false;
+        }
+        return true;
+    };
+
+    if (!read_varint(p, end, v) || v > static_cast<uint64_t>(end - p))
+        return false;
+    configs.resize(v);
+    for (int32_t i = 0; i < static_cast<int32_t>(configs.size()); ++i) {
+        partition_configuration &pc = configs[i];
+        pc.pid = gpid(app_id, i);
+        pc.last_committed_decree = 0;
+
+        if (!read_varint(p, end, v))
+            return false;
+        pc.ballot = zigzag_decode(v);
+        if (!read_varint(p, end, v))
+            return false;
+        pc.max_replica_count = static_cast<int32_t>(v);
+        if (!read_varint(p, end, v))
+            return false;
+        pc.partition_flags = static_cast<int32_t>(v);
+        if (!read_varint(p, end, v) || !deref(v, pc.primary))
+            return false;
+        if (!read_list(pc.secondaries) || !read_list(pc.last_drops))
+            return false;
+    }
+    return p == end;
+}
+}
+}
@@ -43,6 +43,9 @@
 
 namespace dsn {
 
+DEFINE_TASK_CODE_RPC(RPC_HTTP_METRICS, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+DEFINE_TASK_CODE_RPC(RPC_HTTP_METRICS_JSON, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+
 perf_counters::perf_counters(void)
 {
     ::dsn::command_manager::instance().register_command(
@@ -260,6 +263,211 @@ std::string perf_counters::get_counter_sample(const std::vector<std::string> &ar
     return ss.str();
 }
 
+typedef std::vector<std::pair<std::string, std::string>> counter_labels;
+
+// keep [a-zA-Z0-9_] and fold everything else into single '_', e.g., "queue(ns)" -> "queue_ns"
+static std::string sanitize_metric_name(const char *name)
+{
+    std::string result;
+    for (const char *p = name; *p != '\0'; ++p) {
+        if (isalnum(*p) || *p == '_') {
+            result.push_back(*p);
+        } else if (!result.empty() && result.back() != '_') {
+            result.push_back('_');
+        }
+    }
+    while (!result.empty() && result.back() == '_')
+        result.pop_back();
+    return result;
+}
+
+// profiler counters are named as "zion*profiler*<task_code>.<metric>", where the task code
+// is turned into a label so that all task codes share the same metric name; other counters
+// are exported as dsn_<section>_<name>{app}, e.g., "app*eon.replica_stub*replica(Count)" ->
+// dsn_eon_replica_stub_replica_Count{app="app"}
+static void get_counter_labels(const perf_counter_ptr &c,
+                               /*out*/ std::string &metric_name,
+                               /*out*/ counter_labels &labels)
+{
+    labels.clear();
+    labels.emplace_back("app", c->app());
+    const char *dot = strchr(c->name(), '.');
+    if (strcmp(c->section(), "profiler") == 0 && dot != nullptr && dot != c->name()) {
+        metric_name = std::string("dsn_task_") + sanitize_metric_name(dot + 1);
+        labels.emplace_back("task_code", std::string(c->name(), dot - c->name()));
+    } else {
+        metric_name = std::string("dsn_") + sanitize_metric_name(c->section()) + "_" +
+                      sanitize_metric_name(c->name());
+    }
+}
+
+static void write_prometheus_labels(std::stringstream &ss,
+                                    const counter_labels &labels,
+                                    const char *quantile)
+{
+    ss << "{";
+    bool first = true;
+    for (auto &l : labels) {
+        if (!first)
+            ss << ",";
+        first = false;
+        ss << l.first << "=\"";
+        for (char ch : l.second) {
+            if (ch == '\\' || ch == '"')
+                ss << '\\' << ch;
+            else if (ch == '\n')
+                ss << "\\n";
+            else
+                ss << ch;
+        }
+        ss << "\"";
+    }
+    if (quantile != nullptr) {
+        if (!first)
+            ss << ",";
+        ss << "quantile=\"" << quantile << "\"";
+    }
+    ss << "}";
+}
+
+static const char *s_quantile_names[] = {"0.5", "0.9", "0.95", "0.99", "0.999"};
+static_assert(sizeof(s_quantile_names) / sizeof(s_quantile_names[0]) == COUNTER_PERCENTILE_COUNT,
+              "quantile names mismatch with dsn_perf_counter_percentile_type_t");
+
+// the HELP text is a single line, in which only '\\' and '\n' are escaped
+static void write_prometheus_help(std::stringstream &ss, const std::string &help)
+{
+    for (char ch : help) {
+        if (ch == '\\')
+            ss << "\\\\";
+        else if (ch == '\n')
+            ss << "\\n";
+        else
+            ss << ch;
+    }
+}
+
+std::string perf_counters::export_prometheus()
+{
+    std::vector<perf_counter_ptr> counters;
+    get_all_counters(&counters);
+
+    // samples of the same metric must be grouped together in prometheus text format, after
+    // the HELP and TYPE of the metric, which are taken from its first counter
+    struct metric_family
+    {
+        std::string help;
+        const char *type = nullptr;
+        std::stringstream samples;
+    };
+    std::map<std::string, metric_family> families;
+    std::string metric_name;
+    counter_labels labels;
+    for (auto &c : counters) {
+        get_counter_labels(c, metric_name, labels);
+        metric_family &f = families[metric_name];
+        if (f.type == nullptr) {
+            f.help = c->dsptr()[0] != '\0' ? c->dsptr() : c->name();
+            f.type = c->type() == COUNTER_TYPE_NUMBER_PERCENTILES ? "summary" : "gauge";
+        }
+        std::stringstream &ss = f.samples;
+        if (c->type() == COUNTER_TYPE_NUMBER_PERCENTILES) {
+            for (int i = 0; i < COUNTER_PERCENTILE_COUNT; i++) {
+                ss << metric_name;
+                write_prometheus_labels(ss, labels, s_quantile_names[i]);
+                ss << " " << c->get_percentile((dsn_perf_counter_percentile_type_t)i) << "\n";
+            }
+        } else {
+            ss << metric_name;
+            write_prometheus_labels(ss, labels, nullptr);
+            ss << " " << c->get_value() << "\n";
+        }
+    }
+
+    std::stringstream out;
+    for (auto &f : families) {
+        out << "# HELP " << f.first << " ";
+        write_prometheus_help(out, f.second.help);
+        out << "\n";
+        out << "# TYPE " << f.first << " " << f.second.type << "\n";
+        out << f.second.samples.str();
+    }
+    return out.str();
+}
+
+struct metric_value
+{
+    std::string metric;
+    std::map<std::string, std::string> labels;
+    std::string type;
+    double value;
+    std::map<std::string, double> percentiles;
+    DEFINE_JSON_SERIALIZATION(metric, labels, type, value, percentiles)
+};
+
+std::string perf_counters::export_json()
+{
+    std::vector<perf_counter_ptr> counters;
+    get_all_counters(&counters);
+
+    std::vector<metric_value> values;
+    values.reserve(counters.size());
+    counter_labels labels;
+    for (auto &c : counters) {
+        values.emplace_back();
+        metric_value &v = values.back();
+        get_counter_labels(c, v.metric, labels);
+        v.labels.insert(labels.begin(), labels.end());
+        v.type = enum_to_string(c->type());
+        v.value = 0;
+        if (c->type() == COUNTER_TYPE_NUMBER_PERCENTILES) {
+            for (int i = 0; i < COUNTER_PERCENTILE_COUNT; i++) {
+                v.percentiles[s_quantile_names[i]] =
+                    c->get_percentile((dsn_perf_counter_percentile_type_t)i);
+            }
+        } else {
+            v.value = c->get_value();
+        }
+    }
+
+    std::stringstream ss;
+    dsn::json::json_encode(ss, values);
+    return ss.str();
+}
+
+// the http parser sends the response body as it is, so the text is written raw instead of
+// being marshalled in the request's serialize format
+static void reply_http_metrics(dsn_message_t req, const std::string &body)
+{
+    auto resp = dsn_msg_create_response(req);
+    if (!body.empty()) {
+        void *ptr;
+        size_t size;
+        dsn_msg_write_next(resp, &ptr, &size, body.length());
+        memcpy(ptr, body.data(), body.length());
+        dsn_msg_write_commit(resp, body.length());
+    }
+    dsn_rpc_reply(resp);
+}
+
+static void http_metrics_handler(dsn_message_t req, void *)
+{
+    reply_http_metrics(req, perf_counters::instance().export_prometheus());
+}
+
+static void http_metrics_json_handler(dsn_message_t req, void *)
+{
+    reply_http_metrics(req, perf_counters::instance().export_json());
+}
+
+void perf_counters::start_http_metrics()
+{
+    ::dsn::service_engine::fast_instance().register_system_rpc_handler(
+        RPC_HTTP_METRICS, "dsn.metrics", http_metrics_handler, nullptr);
+    ::dsn::service_engine::fast_instance().register_system_rpc_handler(
+        RPC_HTTP_METRICS_JSON, "dsn.metrics.json", http_metrics_json_handler, nullptr);
+}
+
 perf_counter_ptr perf_counters::get_counter(const char *full_name)
 {
     utils::auto_read_lock l(_lock);
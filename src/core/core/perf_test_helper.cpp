@@ -34,13 +34,148 @@
  */
 #include <dsn/cpp/perf_test_helper.h>
 #include <dsn/utility/filesystem.h>
+#include <cmath>
 #include <fstream>
+#include <thread>
 
 #define INVALID_DURATION_US 0xdeadbeefdeadbeefULL
 
 namespace dsn {
 namespace service {
 
+DEFINE_TASK_CODE(LPC_PERF_TEST_OPEN_LOOP_TICK, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+DEFINE_TASK_CODE(LPC_PERF_TEST_OPEN_LOOP_SEND, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+
+// how long each open-loop tick covers, the requests in it are sent by timers of their own
+static const uint64_t OPEN_LOOP_TICK_NS = 10000000;
+
+// scheduled time of the open-loop request being sent on this thread, set for the send_one()
+// called by perf_client_helper::send_scheduled_one()
+static __thread uint64_t s_scheduled_send_ts_ns = 0;
+
+latency_histogram &latency_histogram::operator=(const latency_histogram &r)
+{
+    for (int i = 0; i < BUCKET_COUNT; i++)
+        _buckets[i].store(r._buckets[i].load());
+    return *this;
+}
+
+void latency_histogram::reset()
+{
+    for (int i = 0; i < BUCKET_COUNT; i++)
+        _buckets[i].store(0);
+}
+
+void latency_histogram::add(uint64_t value)
+{
+    _buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t latency_histogram::count() const
+{
+    uint64_t c = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+        c += _buckets[i].load();
+    return c;
+}
+
+uint64_t latency_histogram::percentile(double percentile) const
+{
+    uint64_t total = count();
+    if (total == 0)
+        return 0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * total));
+    rank = std::max(rank, (uint64_t)1);
+    uint64_t c = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        c += _buckets[i].load();
+        if (c >= rank)
+            return bucket_highest_value(i);
+    }
+    return bucket_highest_value(BUCKET_COUNT - 1);
+}
+
+void latency_histogram::get_buckets(
+    /*out*/ std::vector<std::pair<uint64_t, uint64_t>> &buckets) const
+{
+    buckets.clear();
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        uint64_t c = _buckets[i].load();
+        if (c > 0)
+            buckets.emplace_back(bucket_highest_value(i), c);
+    }
+}
+
+/*static*/ int latency_histogram::bucket_index(uint64_t value)
+{
+    if (value < SUB_BUCKET_COUNT)
+        return static_cast<int>(value);
+
+    int highest_bit = 0;
+    for (int shift = 32; shift > 0; shift /= 2) {
+        if (value >> (highest_bit + shift))
+            highest_bit += shift;
+    }
+
+    int shift = highest_bit - SUB_BUCKET_BITS;
+    int sub = static_cast<int>((value >> shift) & (SUB_BUCKET_COUNT - 1));
+    return (shift + 1) * SUB_BUCKET_COUNT + sub;
+}
+
+/*static*/ uint64_t latency_histogram::bucket_highest_value(int index)
+{
+    if (index < SUB_BUCKET_COUNT)
+        return static_cast<uint64_t>(index);
+
+    int shift = index / SUB_BUCKET_COUNT - 1;
+    int sub = index % SUB_BUCKET_COUNT;
+    uint64_t lowest = static_cast<uint64_t>(SUB_BUCKET_COUNT + sub) << shift;
+    return lowest + ((uint64_t)1 << shift) - 1;
+}
+
+void open_loop_schedule::start(
+    uint64_t start_ts_ns, uint64_t end_ts_ns, int qps, bool poisson_arrival, uint64_t seed)
+{
+    dassert(qps > 0, "qps must be positive");
+    _qps = qps;
+    _poisson_arrival = poisson_arrival;
+    _next_ts_ns = start_ts_ns;
+    _end_ts_ns = end_ts_ns;
+    _rng.seed(seed);
+}
+
+uint64_t open_loop_schedule::pop()
+{
+    uint64_t ts = _next_ts_ns;
+    _next_ts_ns += next_interval_ns();
+    return ts;
+}
+
+std::chrono::milliseconds open_loop_schedule::delay_to_next(uint64_t now_ns) const
+{
+    if (_next_ts_ns <= now_ns)
+        return std::chrono::milliseconds(0);
+    return std::chrono::milliseconds((_next_ts_ns - now_ns) / 1000000);
+}
+
+std::chrono::milliseconds open_loop_schedule::delay_to(uint64_t ts_ns, uint64_t now_ns)
+{
+    if (ts_ns <= now_ns)
+        return std::chrono::milliseconds(0);
+    return std::chrono::milliseconds((ts_ns - now_ns + 999999) / 1000000);
+}
+
+uint64_t open_loop_schedule::next_interval_ns()
+{
+    double mean_ns = 1000000000.0 / _qps;
+    if (!_poisson_arrival)
+        return std::max((uint64_t)(mean_ns), (uint64_t)1);
+
+    std::exponential_distribution<double> dist(1.0 / mean_ns);
+    return std::max((uint64_t)(dist(_rng)), (uint64_t)1);
+}
+
 perf_client_helper::perf_client_helper()
 {
     _case_count = 0;
@@ -108,18 +243,33 @@ void perf_client_helper::load_suite_config(perf_test_suite &s,
         ratio_sum += (double)r;
     }
 
+    dassert(opt.perf_test_arrival == "constant" || opt.perf_test_arrival == "poisson",
+            "invalid perf_test_arrival %s in section [%s]",
+            opt.perf_test_arrival.c_str(),
+            s.config_section);
+
+    // for open-loop tests, the load is the target qps instead of the concurrency
+    bool open_loop = (opt.perf_test_qps.size() > 0);
+    const std::vector<int> &loads = open_loop ? opt.perf_test_qps : opt.perf_test_concurrency;
+
     s.cases.clear();
     for (auto &bytes : opt.perf_test_payload_bytes) {
         int last_index = static_cast<int>(opt.perf_test_timeouts_ms.size()) - 1;
         for (int i = last_index; i >= 0; i--) {
-            for (auto &cc : opt.perf_test_concurrency) {
+            for (auto &load : loads) {
                 perf_test_case c;
                 c.id = ++_case_count;
                 c.seconds = opt.perf_test_seconds;
                 c.payload_bytes = bytes;
                 c.key_space_size = opt.perf_test_key_space_size;
                 c.timeout_ms = opt.perf_test_timeouts_ms[i];
-                c.concurrency = cc;
+                if (open_loop) {
+                    dassert(load > 0, "perf_test_qps must be positive");
+                    c.qps = load;
+                    c.poisson_arrival = (opt.perf_test_arrival == "poisson");
+                } else {
+                    c.concurrency = load;
+                }
                 c.ratios.resize(max_request_kind_count_for_hybrid_test, 0.0);
 
                 double ratio = 0.0;
@@ -138,6 +288,11 @@ void perf_client_helper::load_suite_config(perf_test_suite &s,
 
 void perf_client_helper::start(const std::vector<perf_test_suite> &suits)
 {
+    std::string data_dir(service_app::current_service_app_info().data_dir);
+    std::stringstream fns;
+    fns << "perf-result-" << dsn_now_ns() << ".json";
+    _json_result_file = ::dsn::utils::filesystem::path_combine(data_dir, fns.str());
+
     _suits = suits;
     _current_suit_index = -1;
     _current_case_index = 0xffffff;
@@ -148,8 +303,13 @@ void perf_client_helper::start(const std::vector<perf_test_suite> &suits)
 void *perf_client_helper::prepare_send_one()
 {
     uint64_t nts_ns = ::dsn_now_ns();
+    uint64_t start_ts_ns = nts_ns;
+    if (_current_case->qps > 0) {
+        start_ts_ns = s_scheduled_send_ts_ns;
+        _current_case->send_lag_ns.add(nts_ns > start_ts_ns ? nts_ns - start_ts_ns : 0);
+    }
     ++_live_rpc_count;
-    return (void *)(size_t)(nts_ns);
+    return (void *)(size_t)(start_ts_ns);
 }
 
 void perf_client_helper::end_send_one(void *context, error_code err)
@@ -167,12 +327,21 @@ void perf_client_helper::end_send_one(void *context, error_code err)
 
         auto d = nts_ns - start_ts;
         _current_case->succ_rounds_sum_ns += d;
+        _current_case->latency_ns.add(d);
         if (d < _current_case->min_latency_ns)
             _current_case->min_latency_ns = d;
         if (d > _current_case->max_latency_ns)
             _current_case->max_latency_ns = d;
     }
 
+    // open-loop tests are driven by open_loop_tick(), which holds a live count until the end
+    // of the case
+    if (_current_case->qps > 0) {
+        if (--_live_rpc_count == 0)
+            finalize_case();
+        return;
+    }
+
     // if completed
     if (_quiting_current_case) {
         if (--_live_rpc_count == 0)
@@ -203,6 +372,88 @@ void perf_client_helper::end_send_one(void *context, error_code err)
     }
 }
 
+void perf_client_helper::open_loop_tick()
+{
+    // each request due in the coming tick is sent by a timer of its own rather than in a burst,
+    // and never by blocking the thread pool, which also runs the callbacks of the responses.
+    // requests already overdue (e.g., when the tick fires late) are sent at once
+    uint64_t nts = dsn_now_ns();
+    while (_schedule.has_next_before(nts + OPEN_LOOP_TICK_NS)) {
+        uint64_t ts = _schedule.pop();
+        ++_live_rpc_count; // released in send_scheduled_one()
+        tasking::enqueue(LPC_PERF_TEST_OPEN_LOOP_SEND,
+                         nullptr,
+                         [this, ts]() { send_scheduled_one(ts); },
+                         0,
+                         open_loop_schedule::delay_to(ts, nts));
+    }
+
+    if (_schedule.finished() || nts >= _case_end_ts_ns) {
+        _quiting_current_case = true;
+        if (--_live_rpc_count == 0)
+            finalize_case();
+        return;
+    }
+
+    // wake up no later than the next request is due
+    tasking::enqueue(LPC_PERF_TEST_OPEN_LOOP_TICK,
+                     nullptr,
+                     [this]() { open_loop_tick(); },
+                     0,
+                     _schedule.delay_to_next(nts));
+}
+
+void perf_client_helper::send_scheduled_one(uint64_t scheduled_ts_ns)
+{
+    s_scheduled_send_ts_ns = scheduled_ts_ns;
+    send_one(_current_case->payload_bytes, _current_case->key_space_size, _current_case->ratios);
+    if (--_live_rpc_count == 0)
+        finalize_case();
+}
+
+std::string perf_client_helper::case_to_json(const std::string &suit_name,
+                                             const perf_test_case &cs)
+{
+    std::stringstream ss;
+    ss << "{\"suite\":\"" << suit_name << "\""
+       << ",\"id\":" << cs.id << ",\"mode\":\"" << (cs.qps > 0 ? "open" : "closed") << "\"";
+    if (cs.qps > 0) {
+        ss << ",\"target_qps\":" << cs.qps << ",\"arrival\":\""
+           << (cs.poisson_arrival ? "poisson" : "constant") << "\"";
+        // how late the requests are sent after they're scheduled, which is also in latency_ns
+        ss << ",\"send_lag_ns\":{\"p50\":" << cs.send_lag_ns.percentile(50)
+           << ",\"p99\":" << cs.send_lag_ns.percentile(99)
+           << ",\"p999\":" << cs.send_lag_ns.percentile(99.9)
+           << ",\"max\":" << cs.send_lag_ns.percentile(100) << "}";
+    } else {
+        ss << ",\"concurrency\":" << cs.concurrency;
+    }
+    ss << ",\"seconds\":" << cs.seconds << ",\"timeout_ms\":" << cs.timeout_ms
+       << ",\"payload_bytes\":" << cs.payload_bytes << ",\"timeout_rounds\":" << cs.timeout_rounds
+       << ",\"error_rounds\":" << cs.error_rounds << ",\"succ_rounds\":" << cs.succ_rounds
+       << ",\"succ_qps\":" << cs.succ_qps
+       << ",\"succ_throughput_MB_s\":" << cs.succ_throughput_MB_s;
+
+    bool has_succ = (cs.succ_rounds > 0);
+    ss << ",\"latency_ns\":{\"avg\":" << (has_succ ? cs.succ_latency_avg_ns : 0.0)
+       << ",\"min\":" << (has_succ ? cs.min_latency_ns.load() : 0)
+       << ",\"max\":" << cs.max_latency_ns << ",\"p50\":" << cs.latency_ns.percentile(50)
+       << ",\"p90\":" << cs.latency_ns.percentile(90)
+       << ",\"p99\":" << cs.latency_ns.percentile(99)
+       << ",\"p999\":" << cs.latency_ns.percentile(99.9)
+       << ",\"p9999\":" << cs.latency_ns.percentile(99.99) << "}";
+
+    // [highest latency of the bucket, count]
+    std::vector<std::pair<uint64_t, uint64_t>> buckets;
+    cs.latency_ns.get_buckets(buckets);
+    ss << ",\"histogram\":[";
+    for (size_t i = 0; i < buckets.size(); i++) {
+        ss << (i == 0 ? "" : ",") << "[" << buckets[i].first << "," << buckets[i].second << "]";
+    }
+    ss << "]}";
+    return ss.str();
+}
+
 void perf_client_helper::finalize_case()
 {
     dassert(_live_rpc_count == 0, "all live requests must be completed");
@@ -219,16 +470,23 @@ void perf_client_helper::finalize_case()
 
     std::stringstream ss;
     ss << "TEST " << _name << "(" << cs.id << "/" << _case_count << ")::"
-       << "  concurency: " << cs.concurrency << ", timeout(ms): " << cs.timeout_ms
-       << ", payload(byte): " << cs.payload_bytes << ", tmo/err/suc(#): " << cs.timeout_rounds
-       << "/" << cs.error_rounds << "/" << cs.succ_rounds
-       << ", latency(ns): " << cs.succ_latency_avg_ns << "(avg), " << cs.min_latency_ns << "(min), "
-       << cs.max_latency_ns << "(max)"
+       << "  concurency: " << cs.concurrency << ", target qps: " << cs.qps
+       << ", timeout(ms): " << cs.timeout_ms << ", payload(byte): " << cs.payload_bytes
+       << ", tmo/err/suc(#): " << cs.timeout_rounds << "/" << cs.error_rounds << "/"
+       << cs.succ_rounds << ", latency(ns): " << cs.succ_latency_avg_ns << "(avg), "
+       << cs.min_latency_ns << "(min), " << cs.max_latency_ns << "(max), "
+       << cs.latency_ns.percentile(99) << "(p99), " << cs.latency_ns.percentile(99.9) << "(p999)"
        << ", qps: " << cs.succ_qps << "#/s"
        << ", thp: " << cs.succ_throughput_MB_s << "MB/s";
+    if (cs.qps > 0)
+        ss << ", send lag(ns): " << cs.send_lag_ns.percentile(99) << "(p99)";
 
     dwarn(ss.str().c_str());
 
+    std::ofstream json_f(_json_result_file.c_str(), std::ios::out | std::ios::app);
+    json_f << case_to_json(suit.name, cs) << std::endl;
+    json_f.close();
+
     start_next_case();
 }
 
@@ -252,11 +510,14 @@ void perf_client_helper::start_next_case()
             for (auto &s : _suits) {
                 for (auto &cs : s.cases) {
                     ss << "TEST " << s.name << "(" << cs.id << "/" << _case_count << ")::"
-                       << "  concurency: " << cs.concurrency << ", timeout(ms): " << cs.timeout_ms
+                       << "  concurency: " << cs.concurrency << ", target qps: " << cs.qps
+                       << ", timeout(ms): " << cs.timeout_ms
                        << ", payload(byte): " << cs.payload_bytes
                        << ", tmo/err/suc(#): " << cs.timeout_rounds << "/" << cs.error_rounds << "/"
                        << cs.succ_rounds << ", latency(ns): " << cs.succ_latency_avg_ns << "(avg), "
-                       << cs.min_latency_ns << "(min), " << cs.max_latency_ns << "(max)"
+                       << cs.min_latency_ns << "(min), " << cs.max_latency_ns << "(max), "
+                       << cs.latency_ns.percentile(99) << "(p99), "
+                       << cs.latency_ns.percentile(99.9) << "(p999)"
                        << ", qps: " << cs.succ_qps << "#/s"
                        << ", thp: " << cs.succ_throughput_MB_s << "MB/s" << std::endl;
                     ;
@@ -298,6 +559,8 @@ void perf_client_helper::start_next_case()
     cs.error_rounds = 0;
     cs.max_latency_ns = 0;
     cs.min_latency_ns = std::numeric_limits<uint64_t>::max();
+    cs.latency_ns.reset();
+    cs.send_lag_ns.reset();
 
     // setup for the case
     _current_case = &cs;
@@ -310,12 +573,25 @@ void perf_client_helper::start_next_case()
 
     std::stringstream ss;
     ss << "TEST " << _name << "(" << cs.id << "/" << _case_count << ")::"
-       << "  concurrency " << _current_case->concurrency << ", timeout(ms) "
-       << _current_case->timeout_ms << ", payload(byte) " << _current_case->payload_bytes;
+       << "  concurrency " << _current_case->concurrency << ", target qps "
+       << _current_case->qps << ", timeout(ms) " << _current_case->timeout_ms
+       << ", payload(byte) " << _current_case->payload_bytes;
     dwarn(ss.str().c_str());
 
     // start
-    send_one(_current_case->payload_bytes, _current_case->key_space_size, _current_case->ratios);
+    if (_current_case->qps > 0) {
+        // the live count held by open_loop_tick() until the end of the case
+        ++_live_rpc_count;
+        _schedule.start(_case_start_ts_ns,
+                        _case_end_ts_ns,
+                        _current_case->qps,
+                        _current_case->poisson_arrival,
+                        _case_start_ts_ns);
+        open_loop_tick();
+    } else {
+        send_one(
+            _current_case->payload_bytes, _current_case->key_space_size, _current_case->ratios);
+    }
 }
 }
 }
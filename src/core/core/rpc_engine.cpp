@@ -341,22 +341,84 @@ void rpc_client_matcher::on_call(message_ex *request, rpc_response_task *call)
     call->add_ref(); // released in on_rpc_timeout or on_recv_reply
 }
 
+//----------------------------------------------------------------------------------------------
+rpc_handler_reclaimer::rpc_handler_reclaimer() : _epoch(0)
+{
+    for (auto &s : _stripes) {
+        s.active[0].store(0, std::memory_order_relaxed);
+        s.active[1].store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t rpc_handler_reclaimer::enter()
+{
+    uint32_t index = static_cast<uint32_t>(utils::get_current_tid()) % STRIPE_COUNT;
+    uint32_t parity = static_cast<uint32_t>(_epoch.load() & 1);
+    // seq_cst, so that either the handler lookup after it misses a handler unregistered
+    // concurrently, or reclaim() sees the dispatch in flight
+    _stripes[index].active[parity].fetch_add(1);
+    return (index << 1) | parity;
+}
+
+void rpc_handler_reclaimer::leave(uint32_t token)
+{
+    _stripes[token >> 1].active[token & 1].fetch_sub(1, std::memory_order_release);
+}
+
+void rpc_handler_reclaimer::retire(rpc_handler_info *handler)
+{
+    utils::auto_lock<utils::ex_lock_nr> l(_lock);
+    _retired.emplace_back(_epoch.load(), std::unique_ptr<rpc_handler_info>(handler));
+    reclaim();
+}
+
+int rpc_handler_reclaimer::retired_count() const
+{
+    utils::auto_lock<utils::ex_lock_nr> l(_lock);
+    return static_cast<int>(_retired.size());
+}
+
+int64_t rpc_handler_reclaimer::active_count(int parity) const
+{
+    int64_t count = 0;
+    for (auto &s : _stripes) {
+        count += s.active[parity].load();
+    }
+    return count;
+}
+
+void rpc_handler_reclaimer::reclaim()
+{
+    // a dispatch which may have looked up a handler retired in epoch e entered before the
+    // retirement, in whichever parity, so it is done once the epoch advances from e to e + 2,
+    // each step waiting for the dispatches of the parity before to drain
+    for (int i = 0; i < 2 && !_retired.empty(); i++) {
+        uint64_t epoch = _epoch.load();
+        if (active_count(static_cast<int>((epoch + 1) & 1)) != 0) {
+            break;
+        }
+        _epoch.store(epoch + 1);
+    }
+
+    uint64_t epoch = _epoch.load();
+    while (!_retired.empty() && _retired.front().first + 2 <= epoch) {
+        _retired.pop_front();
+    }
+}
+
 //----------------------------------------------------------------------------------------------
 rpc_server_dispatcher::rpc_server_dispatcher()
+    : _vhandlers_count(dsn::task_code::max() + 1)
 {
-    _vhandlers.resize(dsn::task_code::max() + 1);
-    for (auto &h : _vhandlers) {
-        h = new std::pair<rpc_handler_info *, utils::rw_lock_nr>();
-        h->first = nullptr;
+    _vhandlers.reset(new std::atomic<rpc_handler_info *>[_vhandlers_count]);
+    for (int i = 0; i < _vhandlers_count; i++) {
+        _vhandlers[i].store(nullptr, std::memory_order_relaxed);
     }
 }
 
 rpc_server_dispatcher::~rpc_server_dispatcher()
 {
-    for (auto &h : _vhandlers) {
-        delete h;
-    }
-    _vhandlers.clear();
+    _vhandlers.reset();
 
     dassert(_handlers.size() == 0,
             "please make sure all rpc handlers are unregistered at this point");
@@ -372,11 +434,7 @@ bool rpc_server_dispatcher::register_rpc_handler(rpc_handler_info *handler)
     if (it == _handlers.end() && it2 == _handlers.end()) {
         _handlers[name] = handler;
         _handlers[handler->name] = handler;
-
-        {
-            utils::auto_write_lock l(_vhandlers[handler->code]->second);
-            _vhandlers[handler->code]->first = handler;
-        }
+        _vhandlers[handler->code].store(handler, std::memory_order_release);
         return true;
     } else {
         dassert(false, "rpc registration confliction for '%s'", name.c_str());
@@ -397,71 +455,61 @@ rpc_handler_info *rpc_server_dispatcher::unregister_rpc_handler(dsn::task_code r
         std::string name = it->second->name;
         _handlers.erase(it);
         _handlers.erase(name);
-
-        {
-            utils::auto_write_lock l(_vhandlers[rpc_code]->second);
-            _vhandlers[rpc_code]->first = nullptr;
-        }
+        // seq_cst, paired with rpc_handler_reclaimer::enter()
+        _vhandlers[rpc_code].store(nullptr);
     }
 
     ret->unregister();
     return ret;
 }
 
-rpc_request_task *rpc_server_dispatcher::on_request(message_ex *msg, service_node *node)
+rpc_handler_info *rpc_server_dispatcher::find_handler(message_ex *msg)
 {
-    rpc_handler_info *handler = nullptr;
-
     if (TASK_CODE_INVALID != msg->local_rpc_code) {
-        utils::auto_read_lock l(_vhandlers[msg->local_rpc_code]->second);
-        handler = _vhandlers[msg->local_rpc_code]->first;
-        if (nullptr != handler) {
-            handler->add_ref();
-        }
+        dbg_dassert(msg->local_rpc_code < _vhandlers_count,
+                    "invalid rpc code %d",
+                    msg->local_rpc_code.code());
+        // seq_cst, paired with rpc_handler_reclaimer::enter()
+        return _vhandlers[msg->local_rpc_code].load();
     } else {
         utils::auto_read_lock l(_handlers_lock);
         auto it = _handlers.find(msg->header->rpc_name);
         if (it != _handlers.end()) {
             msg->local_rpc_code = it->second->code;
-            handler = it->second;
-            handler->add_ref();
+            return it->second;
         }
+        return nullptr;
     }
+}
 
+rpc_request_task *rpc_server_dispatcher::on_request(message_ex *msg, service_node *node)
+{
+    rpc_handler_reclaimer *reclaimer = node ? node->handler_reclaimer() : nullptr;
+    uint32_t token = reclaimer ? reclaimer->enter() : 0;
+    rpc_handler_info *handler = find_handler(msg);
     if (handler) {
-        auto r = new rpc_request_task(msg, handler, node);
+        // the task leaves the reclaimer when destroyed
+        auto r = new rpc_request_task(msg, handler, node, reclaimer, token);
         r->spec().on_task_create.execute(task::get_current_task(), r);
         return r;
-    } else
+    } else {
+        if (reclaimer)
+            reclaimer->leave(token);
         return nullptr;
+    }
 }
 
 bool rpc_server_dispatcher::on_request_with_inline_execution(message_ex *msg, service_node *node)
 {
-    rpc_handler_info *handler = nullptr;
-
-    if (TASK_CODE_INVALID != msg->local_rpc_code) {
-        utils::auto_read_lock l(_vhandlers[msg->local_rpc_code]->second);
-        handler = _vhandlers[msg->local_rpc_code]->first;
-        if (nullptr != handler) {
-            handler->add_ref();
-        }
-    } else {
-        utils::auto_read_lock l(_handlers_lock);
-        auto it = _handlers.find(msg->header->rpc_name);
-        if (it != _handlers.end()) {
-            msg->local_rpc_code = it->second->code;
-            handler = it->second;
-            handler->add_ref();
-        }
-    }
-
+    rpc_handler_reclaimer *reclaimer = node ? node->handler_reclaimer() : nullptr;
+    uint32_t token = reclaimer ? reclaimer->enter() : 0;
+    rpc_handler_info *handler = find_handler(msg);
     if (handler) {
-        handler->c_handler(msg, handler->parameter);
-        return true;
-    } else {
-        return false;
+        handler->run(msg);
     }
+    if (reclaimer)
+        reclaimer->leave(token);
+    return handler != nullptr;
 }
 
 //----------------------------------------------------------------------------------------------
@@ -473,6 +521,39 @@ rpc_engine::rpc_engine(configuration_ptr config, service_node *node)
 
     _is_running = false;
     _is_serving = false;
+
+    _inline_window_ns =
+        dsn_config_get_value_uint64("network",
+                                    "inline_execution_window_us",
+                                    1000,
+                                    "window (us) over which a network thread's budget for "
+                                    "running non-blocking rpc handlers inline is accounted") *
+        1000;
+    _inline_max_time_ns =
+        dsn_config_get_value_uint64("network",
+                                    "inline_execution_max_time_us",
+                                    500,
+                                    "max time (us) a network thread spends on running "
+                                    "non-blocking rpc handlers inline per window") *
+        1000;
+    _inline_max_count = (int)dsn_config_get_value_uint64(
+        "network",
+        "inline_execution_max_count",
+        64,
+        "max count of non-blocking rpc handlers a network thread runs inline per window, "
+        "0 for always enqueuing them");
+
+    _inline_count.init_global_counter(_node->full_name(),
+                                      "engine",
+                                      "rpc.inline.count",
+                                      COUNTER_TYPE_RATE,
+                                      "non-blocking rpc requests run on network threads");
+    _inline_fallback_count.init_global_counter(
+        _node->full_name(),
+        "engine",
+        "rpc.inline.fallback.count",
+        COUNTER_TYPE_RATE,
+        "non-blocking rpc requests enqueued as the network thread ran out of inline budget");
 }
 
 //
@@ -627,6 +708,53 @@ rpc_handler_info *rpc_engine::unregister_rpc_handler(dsn::task_code rpc_code)
 }
 
 void rpc_engine::on_recv_request(network *net, message_ex *msg, int delay_ms)
+{
+    rpc_request_task *tsk = prepare_request_task(net, msg, delay_ms);
+    if (tsk != nullptr && !try_run_inline(tsk)) {
+        tsk->enqueue();
+    }
+}
+
+void rpc_engine::on_recv_requests(network *net, message_ex **msgs, int count, int delay_ms)
+{
+    std::vector<rpc_request_task *> tasks;
+    tasks.reserve(count);
+    for (int i = 0; i < count; i++) {
+        rpc_request_task *tsk = prepare_request_task(net, msgs[i], delay_ms);
+        if (tsk != nullptr && !try_run_inline(tsk)) {
+            tasks.push_back(tsk);
+        }
+    }
+
+    if (!tasks.empty()) {
+        rpc_request_task::enqueue_bulk(tasks.data(), (int)tasks.size());
+    }
+}
+
+static __thread inline_execution_budget s_inline_budget;
+
+bool rpc_engine::try_run_inline(rpc_request_task *tsk)
+{
+    if (!tsk->spec().rpc_request_is_non_blocking || tsk->delay_milliseconds() != 0)
+        return false;
+
+    inline_execution_budget &budget = s_inline_budget;
+    uint64_t start_ns = dsn_now_ns();
+
+    // the looper is backlogged with inline work, let the worker pool take the rest
+    if (!budget.try_acquire(start_ns, _inline_window_ns, _inline_max_time_ns, _inline_max_count)) {
+        _inline_fallback_count->increment();
+        return false;
+    }
+
+    tsk->run_inline();
+
+    budget.consume(dsn_now_ns() - start_ns);
+    _inline_count->increment();
+    return true;
+}
+
+rpc_request_task *rpc_engine::prepare_request_task(network *net, message_ex *msg, int delay_ms)
 {
     if (!_is_serving) {
         dwarn("recv message with rpc name %s from %s when rpc engine is not serving, trace_id = "
@@ -637,7 +765,7 @@ void rpc_engine::on_recv_request(network *net, message_ex *msg, int delay_ms)
 
         dassert(msg->get_count() == 0, "request should not be referenced by anybody so far");
         delete msg;
-        return;
+        return nullptr;
     }
 
     auto code = msg->rpc_code();
@@ -660,7 +788,7 @@ void rpc_engine::on_recv_request(network *net, message_ex *msg, int delay_ms)
                 // we set a default delay if it isn't generated by fault-injector
                 if (tsk->delay_milliseconds() == 0)
                     tsk->set_delay(delay_ms);
-                tsk->enqueue();
+                return tsk;
             }
 
             // release the task when necessary
@@ -695,14 +823,27 @@ void rpc_engine::on_recv_request(network *net, message_ex *msg, int delay_ms)
         dassert(msg->get_count() == 0, "request should not be referenced by anybody so far");
         delete msg;
     }
+
+    return nullptr;
 }
 
 void rpc_engine::call(message_ex *request, rpc_response_task *call)
 {
     auto &hdr = *request->header;
     hdr.from_address = primary_address();
-    hdr.trace_id = dsn_random64(std::numeric_limits<decltype(hdr.trace_id)>::min(),
-                                std::numeric_limits<decltype(hdr.trace_id)>::max());
+
+    // requests issued while handling another request inherit its trace id, so that
+    // a client => primary => secondary chain can be correlated (and sampled) as a whole
+    task *current = task::get_current_task();
+    if (current != nullptr && current->spec().type == TASK_TYPE_RPC_REQUEST) {
+        hdr.trace_id = static_cast<rpc_request_task *>(current)->get_request()->header->trace_id;
+    } else {
+        hdr.trace_id = 0;
+    }
+    if (hdr.trace_id == 0) {
+        hdr.trace_id = dsn_random64(std::numeric_limits<decltype(hdr.trace_id)>::min(),
+                                    std::numeric_limits<decltype(hdr.trace_id)>::max());
+    }
 
     call_address(request->server_address, request, call);
 }
@@ -35,11 +35,13 @@
 
 #pragma once
 
+#include <deque>
 #include <dsn/tool-api/task.h>
 #include <dsn/tool-api/network.h>
 #include <dsn/utility/synchronize.h>
 #include <dsn/tool-api/global_config.h>
 #include <dsn/utility/configuration.h>
+#include <dsn/cpp/perf_counter_wrapper.h>
 
 namespace dsn {
 
@@ -102,6 +104,48 @@ private:
     ::dsn::utils::ex_lock_nr_spin _requests_lock[MATCHER_BUCKET_NR];
 };
 
+// epoch based reclamation of the unregistered rpc handlers of a service node.
+// a dispatch enters the current epoch before looking up its handler and leaves it when the
+// handler is not used any more, and a retired handler is deleted after the epoch advances
+// twice, which it does only when no dispatch is left in the epoch before
+class rpc_handler_reclaimer
+{
+public:
+    rpc_handler_reclaimer();
+
+    // returns the token for leave()
+    uint32_t enter();
+    void leave(uint32_t token);
+
+    // take the ownership of an unregistered handler
+    void retire(rpc_handler_info *handler);
+
+    // handlers retired but not deleted yet
+    int retired_count() const;
+
+private:
+    // advance the epoch as far as possible and delete the handlers that no dispatch can
+    // reach any more, called under _lock
+    void reclaim();
+    int64_t active_count(int parity) const;
+
+private:
+    // dispatches in flight per epoch parity, striped by thread to keep network threads
+    // off a shared cache line
+    struct stripe
+    {
+        std::atomic<int64_t> active[2];
+        char padding[64 - 2 * sizeof(std::atomic<int64_t>)];
+    };
+    static const int STRIPE_COUNT = 16;
+    stripe _stripes[STRIPE_COUNT];
+    std::atomic<uint64_t> _epoch;
+
+    mutable utils::ex_lock_nr _lock;
+    // in the order of retirement, with the epoch when retired
+    std::deque<std::pair<uint64_t, std::unique_ptr<rpc_handler_info>>> _retired;
+};
+
 class rpc_server_dispatcher
 {
 public:
@@ -110,6 +154,7 @@ public:
 
     bool register_rpc_handler(rpc_handler_info *handler);
     rpc_handler_info *unregister_rpc_handler(dsn::task_code rpc_code);
+    // handlers are looked up under the rpc_handler_reclaimer of 'node' if not nullptr
     rpc_request_task *on_request(message_ex *msg, service_node *node);
     bool on_request_with_inline_execution(message_ex *msg, service_node *node);
     int handler_count() const
@@ -119,11 +164,46 @@ public:
     }
 
 private:
+    rpc_handler_info *find_handler(message_ex *msg);
+
+private:
+    // by code string and by name, only for registration and requests without a local code
     typedef std::unordered_map<std::string, rpc_handler_info *> rpc_handlers;
     rpc_handlers _handlers;
     mutable utils::rw_lock_nr _handlers_lock;
 
-    std::vector<std::pair<rpc_handler_info *, utils::rw_lock_nr> *> _vhandlers;
+    // indexed by local rpc code; written under _handlers_lock and read without any
+    // lock, handlers stay valid after unregistration (see rpc_handler_reclaimer)
+    std::unique_ptr<std::atomic<rpc_handler_info *>[]> _vhandlers;
+    int _vhandlers_count;
+};
+
+// budget of a network thread for running non-blocking rpc handlers inline, which is renewed
+// per window; kept in a thread local variable, so it must stay trivially constructible
+struct inline_execution_budget
+{
+    uint64_t window_start_ns;
+    uint64_t used_ns;
+    int count;
+
+    // whether one more handler may run inline at 'now_ns', i.e., neither 'max_count' nor
+    // 'max_time_ns' has been reached in the current window
+    bool try_acquire(uint64_t now_ns, uint64_t window_ns, uint64_t max_time_ns, int max_count)
+    {
+        if (now_ns - window_start_ns >= window_ns) {
+            window_start_ns = now_ns;
+            used_ns = 0;
+            count = 0;
+        }
+        return count < max_count && used_ns < max_time_ns;
+    }
+
+    // account a handler which has run inline for 'elapsed_ns'
+    void consume(uint64_t elapsed_ns)
+    {
+        count++;
+        used_ns += elapsed_ns;
+    }
 };
 
 class rpc_engine
@@ -148,6 +228,7 @@ public:
     //
     void call(message_ex *request, rpc_response_task *call);
     void on_recv_request(network *net, message_ex *msg, int delay_ms);
+    void on_recv_requests(network *net, message_ex **msgs, int count, int delay_ms);
     void reply(message_ex *response, error_code err = ERR_OK);
     void forward(message_ex *request, rpc_address address);
 
@@ -176,6 +257,14 @@ public:
     void call_address(rpc_address addr, message_ex *request, rpc_response_task *call);
 
 private:
+    // resolve the handler and run the enqueue join points for a received request, return
+    // the task to be enqueued, or nullptr if the request is dropped (and released)
+    rpc_request_task *prepare_request_task(network *net, message_ex *msg, int delay_ms);
+
+    // run a non-blocking request to completion on the current network thread when the
+    // thread still has inline budget left, return false if it should be enqueued instead
+    bool try_run_inline(rpc_request_task *tsk);
+
     network *create_network(const network_server_config &netcs,
                             bool client_only,
                             network_header_format client_hdr_format,
@@ -194,6 +283,13 @@ private:
 
     volatile bool _is_running;
     volatile bool _is_serving;
+
+    // inline execution budget per network thread and per window
+    uint64_t _inline_window_ns;
+    uint64_t _inline_max_time_ns;
+    int _inline_max_count;
+    perf_counter_wrapper _inline_count;
+    perf_counter_wrapper _inline_fallback_count;
 };
 
 // ------------------------ inline implementations --------------------
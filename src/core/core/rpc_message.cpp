@@ -357,12 +357,15 @@ message_ex *message_ex::copy_and_prepare_send(bool clone_content)
     auto copy = this->copy(clone_content, false);
 
     if (_is_read) {
-        // the message_header is hidden ahead of the buffer, expose it to buffer
-        dassert(buffers.size() == 1, "there must be only one buffer for read msg");
-        dassert((char *)header + sizeof(message_header) == (char *)buffers[0].data(),
-                "header and content must be contigous");
-
-        copy->buffers[0] = copy->buffers[0].range(-(int)sizeof(message_header));
+        // the message_header is either hidden ahead of the buffer, or already exposed in a
+        // standalone buffer (see create_receive_message_with_standalone_header)
+        if ((char *)header != (char *)buffers[0].data()) {
+            dassert(buffers.size() == 1, "there must be only one buffer for read msg");
+            dassert((char *)header + sizeof(message_header) == (char *)buffers[0].data(),
+                    "header and content must be contigous");
+
+            copy->buffers[0] = copy->buffers[0].range(-(int)sizeof(message_header));
+        }
 
         // switch the flag
         copy->_is_read = false;
@@ -50,6 +50,7 @@
 #include <dsn/utility/configuration.h>
 #include <dsn/utility/filesystem.h>
 #include <dsn/tool-api/command_manager.h>
+#include <dsn/tool-api/perf_counters.h>
 #include "service_engine.h"
 #include "rpc_engine.h"
 #include "disk_engine.h"
@@ -472,8 +473,6 @@ DSN_API bool dsn_rpc_register_handler(
     h->c_handler = cb;
     h->parameter = param;
 
-    h->add_ref();
-
     bool r = ::dsn::task::get_current_node()->rpc_register_handler(h, gpid);
     if (!r) {
         delete h;
@@ -483,16 +482,8 @@ DSN_API bool dsn_rpc_register_handler(
 
 DSN_API void *dsn_rpc_unregiser_handler(dsn::task_code code, dsn::gpid gpid)
 {
-    auto h = ::dsn::task::get_current_node()->rpc_unregister_handler(code, gpid);
-    void *param = nullptr;
-
-    if (nullptr != h) {
-        param = h->parameter;
-        if (1 == h->release_ref())
-            delete h;
-    }
-
-    return param;
+    // the handler itself is retired to the service node
+    return ::dsn::task::get_current_node()->rpc_unregister_handler(code, gpid);
 }
 
 DSN_API dsn_task_t dsn_rpc_create_response_task(dsn_message_t request,
@@ -1155,6 +1146,14 @@ bool run(const char *config_file,
         ::dsn::command_manager::instance().start_remote_cli();
     }
 
+    if (dsn_all.config->get_value<bool>(
+            "core",
+            "metrics_http",
+            true,
+            "whether to serve all perf counters over http (GET /metrics and /metrics/json)")) {
+        ::dsn::perf_counters::instance().start_http_metrics();
+    }
+
     // register local cli commands
     ::dsn::command_manager::instance().register_command({"config-dump"},
                                                         "config-dump - dump configuration",
@@ -68,7 +68,6 @@ service_node::service_node(service_app_spec &app_spec)
         ((service_node *)this_)->handle_intercepted_request(req2->header->gpid, false, req);
     };
     _intercepted_read.parameter = this;
-    _intercepted_read.add_ref(); // release in handler::run
 
     _intercepted_write.name = "RPC_L2_CLIENT_WRITE";
     _intercepted_write.c_handler = [](dsn_message_t req, void *this_) {
@@ -76,7 +75,6 @@ service_node::service_node(service_app_spec &app_spec)
         ((service_node *)this_)->handle_intercepted_request(req2->header->gpid, true, req);
     };
     _intercepted_write.parameter = this;
-    _intercepted_write.add_ref(); // release in handler::run
 }
 
 bool service_node::rpc_register_handler(rpc_handler_info *handler, dsn::gpid gpid)
@@ -95,7 +93,7 @@ bool service_node::rpc_register_handler(rpc_handler_info *handler, dsn::gpid gpi
     return true;
 }
 
-rpc_handler_info *service_node::rpc_unregister_handler(dsn::task_code rpc_code, dsn::gpid gpid)
+void *service_node::rpc_unregister_handler(dsn::task_code rpc_code, dsn::gpid gpid)
 {
     if (gpid.value() == 0) {
         rpc_handler_info *ret = nullptr;
@@ -111,7 +109,14 @@ rpc_handler_info *service_node::rpc_unregister_handler(dsn::task_code rpc_code,
             }
         }
 
-        return ret;
+        // requests dispatched before the unregistration may still run the handler, which is
+        // not to be touched after the retirement
+        void *param = nullptr;
+        if (ret != nullptr) {
+            param = ret->parameter;
+            _handler_reclaimer.retire(ret);
+        }
+        return param;
     } else {
         dassert(false, "");
         return nullptr;
@@ -420,10 +425,8 @@ rpc_request_task *service_node::generate_intercepted_request_task(message_ex *re
 {
     rpc_request_task *t;
     if (task_spec::get(req->local_rpc_code)->rpc_request_is_write_operation) {
-        _intercepted_write.add_ref(); // release in handler::run
         t = new rpc_request_task(req, &_intercepted_write, this);
     } else {
-        _intercepted_read.add_ref(); // release in handler::run
         t = new rpc_request_task(req, &_intercepted_read, this);
     }
     t->spec().on_task_create.execute(nullptr, t);
@@ -497,14 +500,14 @@ void service_engine::register_system_rpc_handler(dsn::task_code code,
     h->name = std::string(name);
     h->c_handler = cb;
     h->parameter = param;
-    h->add_ref();
 
+    // system handlers are never unregistered
+    bool registered = false;
     if (port == -1) {
         for (auto &n : _nodes_by_app_id) {
             for (auto &io : n.second->ios()) {
                 if (io.rpc) {
-                    h->add_ref();
-                    io.rpc->register_rpc_handler(h);
+                    registered = io.rpc->register_rpc_handler(h) || registered;
                 }
             }
         }
@@ -513,8 +516,7 @@ void service_engine::register_system_rpc_handler(dsn::task_code code,
         if (it != _nodes_by_app_port.end()) {
             for (auto &io : it->second->ios()) {
                 if (io.rpc) {
-                    h->add_ref();
-                    io.rpc->register_rpc_handler(h);
+                    registered = io.rpc->register_rpc_handler(h) || registered;
                 }
             }
         } else {
@@ -522,7 +524,7 @@ void service_engine::register_system_rpc_handler(dsn::task_code code,
         }
     }
 
-    if (1 == h->release_ref())
+    if (!registered)
         delete h;
 }
 
@@ -44,6 +44,7 @@
 #include <dsn/tool-api/auto_codes.h>
 #include <dsn/cpp/service_app.h>
 #include <dsn/utility/synchronize.h>
+#include "rpc_engine.h"
 
 namespace dsn {
 
@@ -111,7 +112,9 @@ public:
     const service_app_info &get_service_app_info() const { return _info; }
     const service_app *get_service_app() const { return _entity.get(); }
     bool rpc_register_handler(rpc_handler_info *handler, dsn::gpid gpid);
-    rpc_handler_info *rpc_unregister_handler(dsn::task_code rpc_code, dsn::gpid gpid);
+    // returns the parameter of the unregistered handler, which itself is retired
+    void *rpc_unregister_handler(dsn::task_code rpc_code, dsn::gpid gpid);
+    rpc_handler_reclaimer *handler_reclaimer() { return &_handler_reclaimer; }
 
     void handle_intercepted_request(dsn::gpid gpid, bool is_write, dsn_message_t req);
     rpc_request_task *generate_intercepted_request_task(message_ex *req);
@@ -130,6 +133,9 @@ private:
     rpc_handler_info _intercepted_read;
     rpc_handler_info _intercepted_write;
 
+    // unregistered handlers, kept alive as the dispatcher doesn't ref count them
+    rpc_handler_reclaimer _handler_reclaimer;
+
 private:
     // the service entity is initialized after the engine
     // is initialized, so this should be call in start()
@@ -484,7 +484,11 @@ void timer_task::exec()
     }
 }
 
-rpc_request_task::rpc_request_task(message_ex *request, rpc_handler_info *h, service_node *node)
+rpc_request_task::rpc_request_task(message_ex *request,
+                                   rpc_handler_info *h,
+                                   service_node *node,
+                                   rpc_handler_reclaimer *reclaimer,
+                                   uint32_t reclaim_token)
     : task(dsn::task_code(h->code), // it is possible that request->local_rpc_code != h->code when
                                     // it is handled in frameworks
            nullptr,
@@ -493,7 +497,9 @@ rpc_request_task::rpc_request_task(message_ex *request, rpc_handler_info *h, ser
            node),
       _request(request),
       _handler(h),
-      _enqueue_ts_ns(0)
+      _enqueue_ts_ns(0),
+      _reclaimer(reclaimer),
+      _reclaim_token(reclaim_token)
 {
     dbg_dassert(
         TASK_TYPE_RPC_REQUEST == spec().type,
@@ -506,6 +512,10 @@ rpc_request_task::rpc_request_task(message_ex *request, rpc_handler_info *h, ser
 rpc_request_task::~rpc_request_task()
 {
     _request->release_ref(); // added in ctor
+
+    if (_reclaimer != nullptr) {
+        _reclaimer->leave(_reclaim_token); // entered in rpc_server_dispatcher::on_request
+    }
 }
 
 void rpc_request_task::enqueue()
@@ -516,6 +526,57 @@ void rpc_request_task::enqueue()
     task::enqueue(node()->computation()->get_pool(spec().pool_code));
 }
 
+void rpc_request_task::run_inline()
+{
+    dassert(delay_milliseconds() == 0, "delayed request %s cannot run inline", spec().name.c_str());
+
+    add_ref(); // released in exec_internal
+    if (node() != get_current_node()) {
+        tools::node_scoper ns(node());
+        exec_internal();
+    } else {
+        exec_internal();
+    }
+}
+
+void rpc_request_task::enqueue_bulk(rpc_request_task **tasks, int count)
+{
+    // <pool, tasks>, usually there are only a few pools involved
+    std::vector<std::pair<task_worker_pool *, std::vector<task *>>> groups;
+    for (int i = 0; i < count; i++) {
+        rpc_request_task *t = tasks[i];
+        // delayed, inlined and empty tasks take the normal path
+        if (t->delay_milliseconds() != 0 || t->_is_null || t->spec().allow_inline) {
+            t->enqueue();
+            continue;
+        }
+
+        auto pool = t->node()->computation()->get_pool(t->spec().pool_code);
+        dassert(pool != nullptr,
+                "pool %s not ready for task %s",
+                t->spec().pool_code.to_string(),
+                t->spec().name.c_str());
+
+        if (t->spec().rpc_request_dropped_before_execution_when_timeout) {
+            t->_enqueue_ts_ns = dsn_now_ns();
+        }
+        t->add_ref(); // released in exec_internal (even when cancelled)
+
+        auto it = groups.begin();
+        while (it != groups.end() && it->first != pool)
+            ++it;
+        if (it == groups.end()) {
+            groups.emplace_back(pool, std::vector<task *>());
+            it = groups.end() - 1;
+        }
+        it->second.push_back(t);
+    }
+
+    for (auto &g : groups) {
+        g.first->enqueue_bulk(g.second.data(), (int)g.second.size());
+    }
+}
+
 rpc_response_task::rpc_response_task(message_ex *request,
                                      dsn_rpc_response_handler_t cb,
                                      void *context,
@@ -163,6 +163,29 @@ void task_worker_pool::enqueue(task *t)
     }
 }
 
+void task_worker_pool::enqueue_bulk(task **tasks, int count)
+{
+    dassert(_is_running, "worker pool %s must be started before enqueue tasks", spec().name.c_str());
+
+    if (!_spec.partitioned || _queues.size() == 1) {
+        _queues[0]->enqueue_internal_bulk(tasks, count);
+        return;
+    }
+
+    std::vector<std::vector<task *>> groups(_queues.size());
+    for (int i = 0; i < count; i++) {
+        dassert(tasks[i]->delay_milliseconds() == 0,
+                "task delayed should be dispatched to timer service first");
+        unsigned int idx =
+            static_cast<unsigned int>(tasks[i]->hash()) % static_cast<unsigned int>(_queues.size());
+        groups[idx].push_back(tasks[i]);
+    }
+    for (size_t idx = 0; idx < groups.size(); idx++) {
+        if (!groups[idx].empty())
+            _queues[idx]->enqueue_internal_bulk(groups[idx].data(), (int)groups[idx].size());
+    }
+}
+
 bool task_worker_pool::shared_same_worker_with_current_task(task *tsk) const
 {
     task *current = task::get_current_task();
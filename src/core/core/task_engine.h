@@ -63,6 +63,7 @@ public:
 
     // task procecessing
     void enqueue(task *task);
+    void enqueue_bulk(task **tasks, int count);
     void on_dequeue(int count);
 
     // cached timer service access
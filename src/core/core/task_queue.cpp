@@ -66,7 +66,17 @@ task_queue::~task_queue()
     perf_counters::instance().remove_counter(_queue_length_counter->full_name());
 }
 
-void task_queue::enqueue_internal(task *task)
+service_node *task_queue::node() const { return _pool->node(); }
+
+void task_queue::enqueue_bulk(task **tasks, int count)
+{
+    for (int i = 0; i < count; i++) {
+        enqueue(tasks[i]);
+    }
+}
+
+// return false if the task is rejected by throttling, which is then already released
+bool task_queue::admit(task *task)
 {
     auto &sp = task->spec();
     auto throttle_mode = sp.rpc_request_throttling_mode;
@@ -105,12 +115,33 @@ void task_queue::enqueue_internal(task *task)
                       rtask->get_request()->header->trace_id);
 
                 task->release_ref(); // added in task::enqueue(pool)
-                return;
+                return false;
             }
         }
     }
+    return true;
+}
+
+void task_queue::enqueue_internal(task *task)
+{
+    if (!admit(task))
+        return;
 
     tls_dsn.last_worker_queue_size = increase_count();
     enqueue(task);
 }
+
+void task_queue::enqueue_internal_bulk(task **tasks, int count)
+{
+    int admitted = 0;
+    for (int i = 0; i < count; i++) {
+        if (admit(tasks[i]))
+            tasks[admitted++] = tasks[i];
+    }
+    if (admitted == 0)
+        return;
+
+    tls_dsn.last_worker_queue_size = increase_count(admitted);
+    enqueue_bulk(tasks, admitted);
+}
 }
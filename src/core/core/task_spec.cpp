@@ -37,6 +37,7 @@
 #include <dsn/utility/singleton.h>
 #include <dsn/tool-api/perf_counter.h>
 #include <dsn/tool-api/command_manager.h>
+#include <dsn/utility/utils.h>
 #include <sstream>
 #include <vector>
 #include <thread>
@@ -112,6 +113,7 @@ task_spec::task_spec(int code,
       rpc_call_header_format(NET_HDR_DSN),
       rpc_call_channel(RPC_CHANNEL_TCP),
       rpc_message_crc_required(false),
+      rpc_message_compress_min_bytes(0),
       on_task_create((std::string(name) + std::string(".create")).c_str()),
       on_task_enqueue((std::string(name) + std::string(".enqueue")).c_str()),
       on_task_begin((std::string(name) + std::string(".begin")).c_str()),
@@ -264,8 +266,19 @@ bool threadpool_spec::init(/*out*/ std::vector<threadpool_spec> &specs)
         if ("" == spec.name)
             spec.name = code_name;
 
-        if (false == spec.worker_share_core && 0 == spec.worker_affinity_mask) {
-            spec.worker_affinity_mask = (1 << std::thread::hardware_concurrency()) - 1;
+        if (spec.worker_numa_spread && spec.partitioned) {
+            std::vector<int> nodes;
+            int node_count = (!spec.worker_numa_nodes.empty() &&
+                              utils::parse_cpu_list(spec.worker_numa_nodes, nodes))
+                                 ? static_cast<int>(nodes.size())
+                                 : utils::get_numa_node_count();
+            if (node_count > 0 && spec.worker_count % node_count != 0) {
+                dwarn("%s: worker_count %d is not a multiple of numa node count %d, the same "
+                      "hash may be placed on different nodes across pools",
+                      spec.name.c_str(),
+                      spec.worker_count,
+                      node_count);
+            }
         }
 
         specs.push_back(spec);
@@ -34,8 +34,11 @@
  */
 
 #include <dsn/tool-api/task_worker.h>
+#include <dsn/utility/utils.h>
 #include "task_engine.h"
 #include <sstream>
+#include <algorithm>
+#include <iterator>
 #include <errno.h>
 
 #ifdef _WIN32
@@ -43,6 +46,15 @@
 #else
 #include <pthread.h>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+#endif
+
 #ifdef __FreeBSD__
 #include <pthread_np.h>
 #endif
@@ -217,15 +229,44 @@ void task_worker::set_priority(worker_priority_t pri)
 void task_worker::set_affinity(uint64_t affinity)
 {
     dassert(affinity > 0, "affinity cannot be 0.");
+    set_affinity(affinity_mask_to_cpus(affinity));
+}
 
-    int nr_cpu = static_cast<int>(std::thread::hardware_concurrency());
-    if (nr_cpu < 64) {
-        dassert(affinity <= (((uint64_t)1 << nr_cpu) - 1),
-                "There are %d cpus in total, while setting thread affinity to a nonexistent one.",
-                nr_cpu);
+/*static*/ std::vector<int> task_worker::affinity_mask_to_cpus(uint64_t affinity)
+{
+    std::vector<int> cpus;
+    for (int i = 0; i < static_cast<int>(sizeof(affinity) * 8); i++) {
+        if ((affinity & ((uint64_t)1 << i)) != 0) {
+            cpus.push_back(i);
+        }
+    }
+    return cpus;
+}
+
+void task_worker::set_affinity(const std::vector<int> &cpus)
+{
+    dassert(!cpus.empty(), "affinity cannot be empty.");
+
+    // configured rather than online cpus, as the ids of online ones may have holes
+    int nr_cpu = utils::get_cpu_count();
+    for (int cpu : cpus) {
+        dassert(cpu >= 0 && cpu < nr_cpu,
+                "There are %d cpus in total, while setting thread affinity to a nonexistent one "
+                "(%d).",
+                nr_cpu,
+                cpu);
     }
 
     int err = 0;
+#if defined(_WIN32) || defined(__APPLE__)
+    uint64_t affinity = 0;
+    for (int cpu : cpus) {
+        if (cpu < 64) {
+            affinity |= ((uint64_t)1 << cpu);
+        }
+    }
+#endif
+
 #ifdef _WIN32
     if (::SetThreadAffinityMask(::GetCurrentThread(), static_cast<DWORD_PTR>(affinity)) == 0) {
         err = static_cast<int>(::GetLastError());
@@ -237,22 +278,28 @@ void task_worker::set_affinity(uint64_t affinity)
                                              THREAD_AFFINITY_POLICY,
                                              (thread_policy_t)&policy,
                                              THREAD_AFFINITY_POLICY_COUNT));
-#else
-#ifdef __FreeBSD__
+#elif defined(__FreeBSD__)
 #ifndef cpu_set_t
 #define cpu_set_t cpuset_t
-#endif
 #endif
     cpu_set_t cpuset;
-    int nr_bits = std::min(nr_cpu, static_cast<int>(sizeof(affinity) * 8));
 
     CPU_ZERO(&cpuset);
-    for (int i = 0; i < nr_bits; i++) {
-        if ((affinity & ((uint64_t)1 << i)) != 0) {
-            CPU_SET(i, &cpuset);
-        }
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &cpuset);
     }
     err = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+#else
+    // allocated by size so that machines with more than CPU_SETSIZE cpus work as well
+    cpu_set_t *cpuset = CPU_ALLOC(nr_cpu);
+    size_t size = CPU_ALLOC_SIZE(nr_cpu);
+
+    CPU_ZERO_S(size, cpuset);
+    for (int cpu : cpus) {
+        CPU_SET_S(cpu, size, cpuset);
+    }
+    err = pthread_setaffinity_np(pthread_self(), size, cpuset);
+    CPU_FREE(cpuset);
 #endif
 
     if (err != 0) {
@@ -260,6 +307,131 @@ void task_worker::set_affinity(uint64_t affinity)
     }
 }
 
+void task_worker::set_numa_memory_policy(int node)
+{
+#ifdef __linux__
+    const int bits = static_cast<int>(sizeof(unsigned long) * 8);
+    std::vector<unsigned long> mask(node / bits + 1, 0);
+    mask[node / bits] |= (1UL << (node % bits));
+
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), mask.size() * bits + 1) != 0) {
+        dwarn("Fail to set numa memory policy to node %d. err = %d", node, errno);
+    }
+#else
+    dwarn("numa memory policy is not supported on this platform, node = %d", node);
+#endif
+}
+
+// cpus come from worker_cpu_list (or worker_affinity_mask), narrowed to the numa
+// nodes this worker is placed on; a worker which does not share cores then
+// takes one cpu of them by its index
+/*static*/ void task_worker::get_placement(const threadpool_spec &spec,
+                                           int index,
+                                           const numa_topology &topology,
+                                           /*out*/ std::vector<int> &cpus,
+                                           /*out*/ std::vector<int> &nodes)
+{
+    cpus.clear();
+    nodes.clear();
+    if (!spec.worker_cpu_list.empty()) {
+        dassert(utils::parse_cpu_list(spec.worker_cpu_list, cpus),
+                "invalid worker_cpu_list '%s' for %s",
+                spec.worker_cpu_list.c_str(),
+                spec.name.c_str());
+    } else {
+        cpus = affinity_mask_to_cpus(spec.worker_affinity_mask);
+    }
+
+    if (!spec.worker_numa_nodes.empty()) {
+        dassert(utils::parse_cpu_list(spec.worker_numa_nodes, nodes),
+                "invalid worker_numa_nodes '%s' for %s",
+                spec.worker_numa_nodes.c_str(),
+                spec.name.c_str());
+    } else if (spec.worker_numa_spread) {
+        for (auto &kv : topology) {
+            nodes.push_back(kv.first);
+        }
+    }
+
+    int slot = index;
+    if (spec.worker_numa_spread && !nodes.empty()) {
+        int node = nodes[index % nodes.size()];
+        slot = index / static_cast<int>(nodes.size());
+        nodes.assign(1, node);
+    }
+
+    if (!nodes.empty()) {
+        std::vector<int> node_cpus;
+        for (int node : nodes) {
+            auto it = topology.find(node);
+            if (it != topology.end()) {
+                node_cpus.insert(node_cpus.end(), it->second.begin(), it->second.end());
+            }
+        }
+        std::sort(node_cpus.begin(), node_cpus.end());
+
+        if (cpus.empty()) {
+            cpus = node_cpus;
+        } else {
+            std::vector<int> both;
+            std::set_intersection(cpus.begin(),
+                                  cpus.end(),
+                                  node_cpus.begin(),
+                                  node_cpus.end(),
+                                  std::back_inserter(both));
+            if (both.empty()) {
+                dwarn("%s: none of the assigned cpus is on numa node(s) %s, use the nodes' cpus",
+                      spec.name.c_str(),
+                      spec.worker_numa_nodes.c_str());
+                both = node_cpus;
+            }
+            cpus.swap(both);
+        }
+    }
+
+    if (false == spec.worker_share_core) {
+        if (cpus.empty()) {
+            for (auto &kv : topology) {
+                cpus.insert(cpus.end(), kv.second.begin(), kv.second.end());
+            }
+            std::sort(cpus.begin(), cpus.end());
+        }
+        if (!cpus.empty()) {
+            cpus.assign(1, cpus[slot % cpus.size()]);
+        }
+    }
+}
+
+void task_worker::set_placement()
+{
+    const threadpool_spec &spec = pool_spec();
+
+    numa_topology topology;
+    std::vector<int> node_ids;
+    utils::get_numa_nodes(node_ids);
+    for (int node : node_ids) {
+        utils::get_numa_node_cpus(node, topology[node]);
+    }
+
+    std::vector<int> cpus;
+    std::vector<int> nodes;
+    get_placement(spec, _index, topology, cpus, nodes);
+
+    if (!cpus.empty()) {
+        set_affinity(cpus);
+    }
+
+    if (spec.worker_numa_local_memory) {
+        if (nodes.size() == 1) {
+            set_numa_memory_policy(nodes[0]);
+        } else {
+            dwarn("%s: worker_numa_local_memory needs the worker placed on a single numa node, "
+                  "set worker_numa_spread or a single worker_numa_nodes",
+                  name().c_str());
+        }
+    }
+}
+
 void task_worker::run_internal()
 {
     while (_thread == nullptr) {
@@ -272,28 +444,7 @@ void task_worker::run_internal()
     set_name(name().c_str());
     set_priority(pool_spec().worker_priority);
 
-    if (true == pool_spec().worker_share_core) {
-        if (pool_spec().worker_affinity_mask > 0) {
-            set_affinity(pool_spec().worker_affinity_mask);
-        }
-    } else {
-        uint64_t current_mask = pool_spec().worker_affinity_mask;
-        if (0 == current_mask) {
-            derror("mask for %s is set to 0x0, mostly due to that #core > 64, set to 64 now",
-                   pool_spec().name.c_str());
-
-            current_mask = ~((uint64_t)0);
-        }
-        for (int i = 0; i < _index; ++i) {
-            current_mask &= (current_mask - 1);
-            if (0 == current_mask) {
-                current_mask = pool_spec().worker_affinity_mask;
-            }
-        }
-        current_mask -= (current_mask & (current_mask - 1));
-
-        set_affinity(current_mask);
-    }
+    set_placement();
 
     _started.notify();
 
@@ -41,14 +41,19 @@
 #include <iostream>
 #include <memory>
 #include <array>
+#include <algorithm>
+#include <fstream>
+#include <thread>
 
 #if defined(__linux__)
 #include <sys/syscall.h>
 #include <unistd.h>
 #elif defined(__FreeBSD__)
 #include <sys/thr.h>
+#include <unistd.h>
 #elif defined(__APPLE__)
 #include <pthread.h>
+#include <unistd.h>
 #endif
 
 namespace dsn {
@@ -140,5 +145,95 @@ int pipe_execute(const char *command, std::ostream &output)
     }
     return retcode;
 }
+
+bool parse_cpu_list(const std::string &str, /*out*/ std::vector<int> &cpus)
+{
+    cpus.clear();
+
+    size_t pos = 0;
+    while (pos < str.length()) {
+        size_t end = str.find(',', pos);
+        if (end == std::string::npos)
+            end = str.length();
+
+        std::string item = str.substr(pos, end - pos);
+        pos = end + 1;
+
+        item.erase(0, item.find_first_not_of(" \t\r\n"));
+        item.erase(item.find_last_not_of(" \t\r\n") + 1);
+        if (item.empty())
+            continue;
+
+        char *p = nullptr;
+        long first = strtol(item.c_str(), &p, 10);
+        long last = first;
+        if (*p == '-')
+            last = strtol(p + 1, &p, 10);
+        if (p == item.c_str() || *p != '\0' || first < 0 || last < first)
+            return false;
+
+        for (long i = first; i <= last; i++)
+            cpus.push_back(static_cast<int>(i));
+    }
+
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return true;
+}
+
+#if defined(__linux__)
+static bool read_sys_list(const std::string &path, /*out*/ std::vector<int> &ids)
+{
+    std::ifstream in(path);
+    std::string line;
+    if (!in || !std::getline(in, line))
+        return false;
+    return parse_cpu_list(line, ids);
+}
+#endif
+
+int get_cpu_count()
+{
+#ifdef _WIN32
+    return static_cast<int>(std::thread::hardware_concurrency());
+#else
+    long count = sysconf(_SC_NPROCESSORS_CONF);
+    return count > 0 ? static_cast<int>(count)
+                     : static_cast<int>(std::thread::hardware_concurrency());
+#endif
+}
+
+int get_numa_node_count()
+{
+    std::vector<int> nodes;
+    get_numa_nodes(nodes);
+    return static_cast<int>(nodes.size());
+}
+
+void get_numa_nodes(/*out*/ std::vector<int> &nodes)
+{
+#if defined(__linux__)
+    if (read_sys_list("/sys/devices/system/node/online", nodes) && !nodes.empty())
+        return;
+#endif
+    nodes.assign(1, 0);
+}
+
+void get_numa_node_cpus(int node, /*inout*/ std::vector<int> &cpus)
+{
+#if defined(__linux__)
+    std::vector<int> node_cpus;
+    if (read_sys_list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist",
+                      node_cpus)) {
+        cpus.insert(cpus.end(), node_cpus.begin(), node_cpus.end());
+        return;
+    }
+#endif
+    if (node == 0) {
+        int nr_cpu = get_cpu_count();
+        for (int i = 0; i < nr_cpu; i++)
+            cpus.push_back(i);
+    }
+}
 }
 }
@@ -0,0 +1,148 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     a tiny harness for the benchmarks of the runtime primitives
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#include "benchmark.h"
+#include <gtest/gtest.h>
+#include <dsn/service_api_c.h>
+#include <dsn/utility/utils.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+static std::vector<benchmark_result> s_results;
+
+bool benchmark_enabled()
+{
+    static bool enabled =
+        dsn_config_get_value_bool(
+            "benchmark", "enabled", false, "whether to run the benchmarks in default runs") ||
+        ::testing::GTEST_FLAG(filter).find("benchmark") != std::string::npos;
+    return enabled;
+}
+
+static int warmup_rounds()
+{
+    static int rounds = (int)dsn_config_get_value_uint64(
+        "benchmark", "warmup_rounds", 2, "rounds run before the measured ones of a benchmark");
+    return rounds;
+}
+
+static int measured_rounds()
+{
+    static int rounds = (int)dsn_config_get_value_uint64(
+        "benchmark", "rounds", 10, "measured rounds of a benchmark");
+    return std::max(rounds, 1);
+}
+
+benchmark_result run_benchmark(const std::string &name,
+                               uint64_t ops_per_round,
+                               const benchmark_body &body)
+{
+    for (int i = 0; i < warmup_rounds(); i++)
+        body(ops_per_round);
+
+    benchmark_result r;
+    r.name = name;
+    r.ops_per_round = ops_per_round;
+    for (int i = 0; i < measured_rounds(); i++) {
+        auto start = std::chrono::steady_clock::now();
+        body(ops_per_round);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+        r.ns_per_op.push_back((double)ns / ops_per_round);
+    }
+
+    std::vector<double> sorted(r.ns_per_op);
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    r.min = sorted.front();
+    r.max = sorted.back();
+    r.median = (n % 2 == 1) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+
+    double sum = 0;
+    for (double v : sorted)
+        sum += v;
+    r.mean = sum / n;
+
+    double square_sum = 0;
+    for (double v : sorted)
+        square_sum += (v - r.mean) * (v - r.mean);
+    r.stddev = (n > 1) ? std::sqrt(square_sum / (n - 1)) : 0;
+
+    std::cout << "BENCHMARK " << name << ": " << r.median << " ns/op (median), " << r.mean
+              << " (mean), " << r.stddev << " (stddev), " << r.min << " (min), " << r.max
+              << " (max), " << ops_per_round << " ops x " << n << " rounds" << std::endl;
+
+    s_results.push_back(r);
+    return r;
+}
+
+bool dump_benchmark_results()
+{
+    if (s_results.empty())
+        return false;
+
+    std::string path = dsn_config_get_value_string(
+        "benchmark", "result_file", "benchmark-result.json", "json file of benchmark results");
+
+    char time_str[24];
+    ::dsn::utils::time_ms_to_string(dsn_now_ms(), time_str);
+
+    std::ofstream os(path.c_str(), std::ios::out | std::ios::trunc);
+    os << "{\"time\":\"" << time_str << "\",\"warmup_rounds\":" << warmup_rounds()
+       << ",\"rounds\":" << measured_rounds() << ",\"benchmarks\":[";
+    for (size_t i = 0; i < s_results.size(); i++) {
+        const benchmark_result &r = s_results[i];
+        os << (i == 0 ? "" : ",") << "\n{\"name\":\"" << r.name
+           << "\",\"ops_per_round\":" << r.ops_per_round << ",\"ns_per_op\":{\"mean\":" << r.mean
+           << ",\"stddev\":" << r.stddev << ",\"median\":" << r.median << ",\"min\":" << r.min
+           << ",\"max\":" << r.max << "},\"samples\":[";
+        for (size_t j = 0; j < r.ns_per_op.size(); j++)
+            os << (j == 0 ? "" : ",") << r.ns_per_op[j];
+        os << "]}";
+    }
+    os << "\n]}" << std::endl;
+    os.close();
+
+    if (os.fail()) {
+        std::cout << "write benchmark results to " << path << " failed" << std::endl;
+        return false;
+    }
+    std::cout << "benchmark results are written to " << path << std::endl;
+    return true;
+}
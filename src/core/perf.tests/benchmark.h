@@ -0,0 +1,117 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     a tiny harness for the benchmarks of the runtime primitives
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//
+// each benchmark runs [benchmark] warmup_rounds rounds first, and then [benchmark] rounds
+// measured rounds of the same number of operations. the statistics are of the time per
+// operation of the measured rounds.
+//
+// results of all the benchmarks run are dumped to [benchmark] result_file as json, which can
+// be compared with a baseline by scripts/linux/compare_benchmark.py.
+//
+struct benchmark_result
+{
+    std::string name;
+    uint64_t ops_per_round;
+    std::vector<double> ns_per_op; // of each measured round
+
+    double mean;
+    double stddev;
+    double median;
+    double min;
+    double max;
+};
+
+// benchmarks are skipped unless they are asked for, either by [benchmark] enabled = true, or by
+// a gtest filter naming them, e.g., --gtest_filter=core.benchmark_*
+bool benchmark_enabled();
+
+#define BENCHMARK_CHECK_ENABLED()                                                                  \
+    do {                                                                                           \
+        if (!benchmark_enabled()) {                                                                \
+            std::cout << "benchmark skipped, run it with --gtest_filter=core.benchmark_*"          \
+                      << std::endl;                                                                \
+            return;                                                                                \
+        }                                                                                          \
+    } while (0)
+
+// performs 'ops' operations, and returns after they are all done
+typedef std::function<void(uint64_t ops)> benchmark_body;
+
+benchmark_result run_benchmark(const std::string &name,
+                               uint64_t ops_per_round,
+                               const benchmark_body &body);
+
+// returns false if there is no result or the file cannot be written
+bool dump_benchmark_results();
+
+// for waiting asynchronous operations in the benchmark bodies
+class benchmark_countdown
+{
+public:
+    benchmark_countdown() : _remain(0) {}
+
+    void reset(uint64_t count) { _remain.store(count); }
+
+    void signal()
+    {
+        if (_remain.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> l(_lock);
+            _cond.notify_all();
+        }
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> l(_lock);
+        _cond.wait(l, [this]() { return _remain.load() == 0; });
+    }
+
+private:
+    std::atomic<uint64_t> _remain;
+    std::mutex _lock;
+    std::condition_variable _cond;
+};
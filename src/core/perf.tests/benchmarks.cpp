@@ -0,0 +1,312 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     benchmarks of the runtime primitives, run them with --gtest_filter=core.benchmark_*
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+#include <gtest/gtest.h>
+#include <dsn/service_api_cpp.h>
+#include <dsn/tool_api.h>
+#include <dsn/utility/binary_reader.h>
+#include <dsn/utility/binary_writer.h>
+#include <dsn/utility/crc.h>
+#include <dsn/cpp/serialization_helper/dsn.layer2_types.h>
+#include <iostream>
+#include <thread>
+
+#include "benchmark.h"
+#include "rpc_engine.h"
+#include "../tools/common/dsn_message_parser.h"
+#include "../tools/common/simple_logger.h"
+#include "../tools/common/simple_perf_counter.h"
+#include "../tools/common/simple_perf_counter_v2_atomic.h"
+#include "../tools/common/simple_perf_counter_v2_fast.h"
+#include "../tools/hpc/hpc_logger.h"
+#include "../tools/hpc/hpc_tail_logger.h"
+
+using namespace ::dsn;
+
+DEFINE_TASK_CODE(LPC_BENCHMARK_TASK, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+DEFINE_TASK_CODE_RPC(RPC_BENCHMARK, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+
+// keeps the results of the benchmarked computations from being optimized out
+static volatile uint64_t s_sink;
+
+TEST(core, benchmark_task_queue)
+{
+    BENCHMARK_CHECK_ENABLED();
+    benchmark_countdown done;
+    run_benchmark("task_queue.enqueue_and_run", 100000, [&done](uint64_t ops) {
+        done.reset(ops);
+        for (uint64_t i = 0; i < ops; i++)
+            tasking::enqueue(LPC_BENCHMARK_TASK, nullptr, [&done]() { done.signal(); });
+        done.wait();
+    });
+}
+
+TEST(core, benchmark_timer)
+{
+    BENCHMARK_CHECK_ENABLED();
+    // all timers are of 1ms, so the round time is mostly of inserting and firing them
+    benchmark_countdown done;
+    run_benchmark("timer.insert_and_fire", 100000, [&done](uint64_t ops) {
+        done.reset(ops);
+        for (uint64_t i = 0; i < ops; i++) {
+            tasking::enqueue(LPC_BENCHMARK_TASK,
+                             nullptr,
+                             [&done]() { done.signal(); },
+                             0,
+                             std::chrono::milliseconds(1));
+        }
+        done.wait();
+    });
+}
+
+static void benchmark_response_handler(error_code err,
+                                       dsn_message_t req,
+                                       dsn_message_t resp,
+                                       void *context)
+{
+    reinterpret_cast<benchmark_countdown *>(context)->signal();
+}
+
+TEST(core, benchmark_rpc_client_matcher)
+{
+    BENCHMARK_CHECK_ENABLED();
+    // each operation registers a call and then terminates it with an empty reply, which
+    // includes creating the request and running the response task
+    rpc_client_matcher *matcher = task::get_current_rpc()->matcher();
+    benchmark_countdown done;
+    run_benchmark("rpc_client_matcher.call_and_reply", 20000, [&](uint64_t ops) {
+        done.reset(ops);
+        for (uint64_t i = 0; i < ops; i++) {
+            message_ex *request = message_ex::create_request(RPC_BENCHMARK, 10000, 0);
+            rpc_response_task *call =
+                new rpc_response_task(request, benchmark_response_handler, &done, nullptr);
+            matcher->on_call(request, call);
+            matcher->on_recv_reply(nullptr, request->header->id, nullptr, 0);
+        }
+        done.wait();
+    });
+}
+
+TEST(core, benchmark_message_ex)
+{
+    BENCHMARK_CHECK_ENABLED();
+    std::string payload(128, 'x');
+    dsn_message_parser parser;
+    std::vector<message_parser::send_buf> buffers;
+
+    run_benchmark("message_ex.create_and_serialize", 100000, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) {
+            message_ex *msg = message_ex::create_request(RPC_BENCHMARK, 1000, 0);
+            msg->add_ref();
+            ::dsn::marshall(msg, payload);
+
+            parser.prepare_on_send(msg);
+            buffers.resize(parser.get_buffer_count_on_send(msg));
+            s_sink += parser.get_buffers_on_send(msg, buffers.data());
+            msg->release_ref();
+        }
+    });
+}
+
+TEST(core, benchmark_binary_writer)
+{
+    BENCHMARK_CHECK_ENABLED();
+    std::string value(64, 'x');
+    run_benchmark("binary_writer.write", 100000, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) {
+            binary_writer writer;
+            writer.write((int32_t)i);
+            writer.write((int64_t)i);
+            writer.write(value);
+            s_sink += writer.get_buffer().length();
+        }
+    });
+}
+
+template <typename T>
+static void benchmark_thrift(const std::string &name, const T &value)
+{
+    struct
+    {
+        const char *name;
+        dsn_msg_serialize_format fmt;
+    } formats[] = {{"binary", DSF_THRIFT_BINARY}, {"compact", DSF_THRIFT_COMPACT}};
+
+    for (auto &f : formats) {
+        binary_writer writer;
+        ::dsn::marshall(writer, value, f.fmt);
+        blob data = writer.get_buffer();
+        std::cout << "BENCHMARK thrift." << f.name << "." << name << ": " << data.length()
+                  << " bytes" << std::endl;
+
+        run_benchmark("thrift." + std::string(f.name) + ".marshall." + name,
+                      100000,
+                      [&value, &f](uint64_t ops) {
+                          for (uint64_t i = 0; i < ops; i++) {
+                              binary_writer writer;
+                              ::dsn::marshall(writer, value, f.fmt);
+                              s_sink += writer.get_buffer().length();
+                          }
+                      });
+        run_benchmark("thrift." + std::string(f.name) + ".unmarshall." + name,
+                      100000,
+                      [&data, &f](uint64_t ops) {
+                          for (uint64_t i = 0; i < ops; i++) {
+                              binary_reader reader(data);
+                              T v;
+                              ::dsn::unmarshall(reader, v, f.fmt);
+                              s_sink += reader.get_remaining_size();
+                          }
+                      });
+    }
+}
+
+TEST(core, benchmark_thrift_marshall)
+{
+    BENCHMARK_CHECK_ENABLED();
+    partition_configuration pc;
+    pc.pid = gpid(1, 2);
+    pc.ballot = 3;
+    pc.max_replica_count = 3;
+    pc.primary = rpc_address("127.0.0.1", 34801);
+    pc.secondaries.push_back(rpc_address("127.0.0.1", 34802));
+    pc.secondaries.push_back(rpc_address("127.0.0.1", 34803));
+    pc.last_committed_decree = 100;
+    benchmark_thrift("partition_configuration", pc);
+
+    // as replied to the config-sync and query-config requests
+    configuration_query_by_index_response resp;
+    resp.err = ERR_OK;
+    resp.app_id = 1;
+    resp.partition_count = 32;
+    resp.is_stateful = true;
+    for (int i = 0; i < resp.partition_count; i++) {
+        pc.pid = gpid(resp.app_id, i);
+        pc.last_committed_decree = 100000 + i;
+        resp.partitions.push_back(pc);
+    }
+    benchmark_thrift("configuration_query_by_index_response", resp);
+}
+
+TEST(core, benchmark_crc)
+{
+    BENCHMARK_CHECK_ENABLED();
+    std::vector<char> data(4096);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (char)(i * 7);
+
+    run_benchmark("crc32.4KB", 20000, [&](uint64_t ops) {
+        uint32_t crc = 0;
+        for (uint64_t i = 0; i < ops; i++)
+            crc = utils::crc32_calc(data.data(), data.size(), crc);
+        s_sink += crc;
+    });
+    run_benchmark("crc64.4KB", 20000, [&](uint64_t ops) {
+        uint64_t crc = 0;
+        for (uint64_t i = 0; i < ops; i++)
+            crc = utils::crc64_calc(data.data(), data.size(), crc);
+        s_sink += crc;
+    });
+}
+
+static void benchmark_logv(logging_provider *logger, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    logger->dsn_logv(__FILENAME__, __FUNCTION__, __LINE__, LOG_LEVEL_DEBUG, fmt, ap);
+    va_end(ap);
+}
+
+template <typename TLOGGER>
+static void benchmark_logger(const char *name)
+{
+    TLOGGER logger("./");
+    run_benchmark(name, 20000, [&logger](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++)
+            benchmark_logv(&logger, "this is a benchmark log %010d", (int)i);
+    });
+    logger.flush();
+}
+
+TEST(core, benchmark_logger)
+{
+    BENCHMARK_CHECK_ENABLED();
+    benchmark_logger<tools::simple_logger>("logger.simple_logger");
+    benchmark_logger<tools::hpc_logger>("logger.hpc_logger");
+    benchmark_logger<tools::hpc_tail_logger>("logger.hpc_tail_logger");
+}
+
+static void benchmark_perf_counter(const std::string &name, perf_counter::factory f)
+{
+    perf_counter_ptr number = f("", "", "", COUNTER_TYPE_NUMBER, "");
+    run_benchmark(name + ".number.increment", 1000000, [&number](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++)
+            number->increment();
+    });
+
+    const int thread_count = 4;
+    run_benchmark(name + ".number.increment.4_threads", 1000000, [&number](uint64_t ops) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; t++) {
+            threads.emplace_back([&number, ops]() {
+                for (uint64_t i = 0; i < ops / thread_count; i++)
+                    number->increment();
+            });
+        }
+        for (auto &t : threads)
+            t.join();
+    });
+
+    perf_counter_ptr rate = f("", "", "", COUNTER_TYPE_RATE, "");
+    run_benchmark(name + ".rate.increment", 1000000, [&rate](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++)
+            rate->increment();
+    });
+
+    perf_counter_ptr percentile = f("", "", "", COUNTER_TYPE_NUMBER_PERCENTILES, "");
+    run_benchmark(name + ".percentile.set", 1000000, [&percentile](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++)
+            percentile->set(i % 10000);
+    });
+}
+
+TEST(core, benchmark_perf_counter)
+{
+    BENCHMARK_CHECK_ENABLED();
+    benchmark_perf_counter("perf_counter.simple", tools::simple_perf_counter_factory);
+    benchmark_perf_counter("perf_counter.v2_atomic",
+                           tools::simple_perf_counter_v2_atomic_factory);
+    benchmark_perf_counter("perf_counter.v2_fast", tools::simple_perf_counter_v2_fast_factory);
+}
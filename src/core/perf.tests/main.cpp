@@ -36,6 +36,7 @@
 #include <iostream>
 #include "gtest/gtest.h"
 #include "test_utils.h"
+#include "benchmark.h"
 
 int g_test_count = 0;
 
@@ -54,6 +55,9 @@ GTEST_API_ int main(int argc, char **argv)
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 
+    // for comparing with a baseline by scripts/linux/compare_benchmark.py
+    dump_benchmark_results();
+
     // exit without any destruction
     dsn_exit(0);
 
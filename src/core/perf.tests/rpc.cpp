@@ -143,3 +143,44 @@ TEST(core, lpc_perf_test_sync)
     std::cout << "lpc-sync perf test: throughput = " << total_query_count * 1000000000llu / time_ns
               << " #/s, avg latency = " << time_ns / total_query_count << " ns" << std::endl;
 }
+
+TEST(core, rpc_perf_test_large_payload)
+{
+    rpc_address localhost("localhost", 20101);
+
+    // the same payload goes both ways, so reads and writes on one connection overlap
+    for (auto payload_size : {4 * 1024, 64 * 1024, 1024 * 1024}) {
+        std::string command = std::string("echo ") + std::string(payload_size, 'x');
+        std::atomic_int remain_concurrency;
+        auto concurrency = 10;
+        remain_concurrency = concurrency;
+        size_t total_query_count = 64 * 1024 * 1024 / payload_size * 16;
+        std::chrono::steady_clock clock;
+        auto tic = clock.now();
+        for (auto remain_query_count = total_query_count; remain_query_count--;) {
+            while (true) {
+                if (remain_concurrency.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+                    remain_concurrency.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    break;
+                }
+            }
+            rpc::call(localhost,
+                      RPC_TEST_STRING_COMMAND,
+                      command,
+                      nullptr,
+                      [&remain_concurrency](error_code ec, const std::string &) {
+                          remain_concurrency.fetch_add(1, std::memory_order_relaxed);
+                      });
+        }
+        while (remain_concurrency != concurrency) {
+            ;
+        }
+        auto toc = clock.now();
+        auto time_us = std::chrono::duration_cast<std::chrono::microseconds>(toc - tic).count();
+        std::cout << "rpc perf test: payload = " << payload_size << " bytes, throughput = "
+                  << total_query_count * 1000000llu / time_us << " call/sec, "
+                  << total_query_count * payload_size * 2 / time_us << " MB/s (both directions)"
+                  << std::endl;
+    }
+}
@@ -0,0 +1,55 @@
+#!/bin/bash
+#
+# Run the core benchmarks and compare them against benchmark-baseline.json.
+#
+# USAGE: ./run_benchmark.sh [threshold] [--update-baseline]
+#
+# With --update-baseline, the baseline in the source tree is replaced by the
+# results of this run, which should only be done on the reference machine. The
+# source tree is found by git from the build directory, or given by DSN_SOURCE_ROOT.
+#
+# A benchmark without baseline fails the comparison.
+#
+
+threshold="0.1"
+update_baseline="false"
+for arg in "$@"; do
+    if [ "${arg}" == "--update-baseline" ]; then
+        update_baseline="true"
+    else
+        threshold="${arg}"
+    fi
+done
+
+rm -f benchmark-result.json
+echo "============ run dsn.core.perf.tests with gtest_filter core.benchmark_* ============"
+GTEST_FILTER="core.benchmark_*" ./dsn.core.perf.tests config-test.ini
+if [ $? -ne 0 ] || [ ! -f benchmark-result.json ]; then
+    echo "run dsn.core.perf.tests benchmarks failed"
+    exit -1
+fi
+
+if [ "${update_baseline}" == "true" ]; then
+    src_root="${DSN_SOURCE_ROOT}"
+    if [ -z "${src_root}" ]; then
+        src_root=`git rev-parse --show-toplevel 2>/dev/null`
+    fi
+    src_baseline="${src_root}/src/core/perf.tests/benchmark-baseline.json"
+    if [ -z "${src_root}" ] || [ ! -f "${src_baseline}" ]; then
+        echo "can't find the source baseline, please set DSN_SOURCE_ROOT"
+        exit -1
+    fi
+    cp benchmark-result.json "${src_baseline}"
+    cp benchmark-result.json benchmark-baseline.json
+    echo "============ baseline updated, commit ${src_baseline} ============"
+    exit 0
+fi
+
+echo "============ compare with benchmark-baseline.json, threshold ${threshold} ============"
+python compare_benchmark.py benchmark-baseline.json benchmark-result.json ${threshold}
+if [ $? -ne 0 ]; then
+    echo "benchmark regression detected, or some benchmarks have no baseline"
+    exit -1
+fi
+
+echo "============ done ============"
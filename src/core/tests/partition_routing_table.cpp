@@ -0,0 +1,77 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <dsn/dist/partition_routing_table.h>
+
+#include <gtest/gtest.h>
+
+using namespace dsn;
+using namespace dsn::dist;
+
+TEST(core, partition_routing_table)
+{
+    std::vector<rpc_address> nodes;
+    for (int i = 0; i < 8; ++i)
+        nodes.emplace_back("127.0.0.1", 34801 + i);
+
+    std::vector<partition_configuration> configs(64);
+    for (int i = 0; i < static_cast<int>(configs.size()); ++i) {
+        partition_configuration &pc = configs[i];
+        pc.pid = gpid(3, i);
+        pc.ballot = i * 1000;
+        pc.max_replica_count = 3;
+        pc.partition_flags = i % 2;
+        pc.last_committed_decree = 0;
+        if (i % 7 != 0)
+            pc.primary = nodes[i % nodes.size()];
+        pc.secondaries = {nodes[(i + 1) % nodes.size()], nodes[(i + 2) % nodes.size()]};
+        if (i % 5 == 0)
+            pc.last_drops = {nodes[(i + 3) % nodes.size()]};
+    }
+    configs[0].ballot = -1;
+
+    blob data = partition_routing_table::encode(configs);
+    // the node dictionary keeps each entry within a few bytes
+    ASSERT_LT(data.length(), configs.size() * 16 + nodes.size() * 6);
+
+    std::vector<partition_configuration> decoded;
+    ASSERT_TRUE(partition_routing_table::decode(data, 3, decoded));
+    ASSERT_EQ(configs, decoded);
+
+    // truncated or unknown buffers are rejected
+    ASSERT_FALSE(partition_routing_table::decode(data.range(0, data.length() - 1), 3, decoded));
+    ASSERT_FALSE(partition_routing_table::decode(blob(), 3, decoded));
+    std::shared_ptr<char> buffer(utils::make_shared_array<char>(data.length()));
+    memcpy(buffer.get(), data.data(), data.length());
+    buffer.get()[0] = 0x7f;
+    ASSERT_FALSE(partition_routing_table::decode(blob(buffer, data.length()), 3, decoded));
+
+    // an empty table
+    configs.clear();
+    data = partition_routing_table::encode(configs);
+    ASSERT_TRUE(partition_routing_table::decode(data, 3, decoded));
+    ASSERT_TRUE(decoded.empty());
+}
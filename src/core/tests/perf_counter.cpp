@@ -38,7 +38,9 @@
 #include "../tools/common/simple_perf_counter_v2_fast.h"
 
 #include <dsn/tool_api.h>
+#include <dsn/cpp/perf_test_helper.h>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <thread>
 #include <cmath>
 #include <vector>
@@ -134,3 +136,168 @@ TEST(tools_common, simple_perf_counter_v2_fast)
 {
     test_perf_counter(simple_perf_counter_v2_fast_factory);
 }
+
+TEST(core, latency_histogram)
+{
+    using dsn::service::latency_histogram;
+
+    uint64_t values[] = {0, 1, 15, 16, 17, 31, 32, 33, 1000, 123456789, ~0ULL};
+    for (uint64_t v : values) {
+        int index = latency_histogram::bucket_index(v);
+        ASSERT_LT(index, latency_histogram::BUCKET_COUNT);
+
+        // v is in bucket 'index' and not in the previous one
+        uint64_t highest = latency_histogram::bucket_highest_value(index);
+        ASSERT_GE(highest, v);
+        if (index > 0)
+            ASSERT_LT(latency_histogram::bucket_highest_value(index - 1), v);
+        ASSERT_LE(highest - v, v / latency_histogram::SUB_BUCKET_COUNT);
+    }
+
+    latency_histogram h;
+    ASSERT_EQ(0u, h.percentile(99));
+    for (int i = 1; i <= 1000; i++)
+        h.add(i * 1000);
+    ASSERT_EQ(1000u, h.count());
+    ASSERT_GE(h.percentile(50), 500000u);
+    ASSERT_LT(h.percentile(50), 500000u * 17 / 16);
+    ASSERT_GE(h.percentile(99), 990000u);
+    ASSERT_GE(h.percentile(100), 1000000u);
+
+    std::vector<std::pair<uint64_t, uint64_t>> buckets;
+    h.get_buckets(buckets);
+    uint64_t total = 0;
+    for (auto &b : buckets)
+        total += b.second;
+    ASSERT_EQ(1000u, total);
+
+    latency_histogram h2(h);
+    ASSERT_EQ(h.percentile(90), h2.percentile(90));
+    h.reset();
+    ASSERT_EQ(0u, h.count());
+}
+
+TEST(core, open_loop_schedule)
+{
+    using dsn::service::open_loop_schedule;
+    const uint64_t ms = 1000000;
+    const uint64_t start = 5000 * ms;
+
+    // constant arrival: requests at a fixed interval, none at or after the end
+    open_loop_schedule s;
+    s.start(start, start + 1000 * ms, 2000, false, 0);
+    ASSERT_FALSE(s.has_next_before(start));
+    ASSERT_TRUE(s.has_next_before(start + 1));
+    int count = 0;
+    while (!s.finished()) {
+        ASSERT_EQ(start + count * 500000u, s.pop());
+        count++;
+    }
+    ASSERT_EQ(2000, count);
+    ASSERT_FALSE(s.has_next_before(~0ULL));
+
+    // the wait for the next request is rounded down to milliseconds
+    s.start(start, start + 1000 * ms, 100, false, 0);
+    ASSERT_EQ(0, s.delay_to_next(start).count());
+    ASSERT_EQ(0, s.delay_to_next(start + 3 * ms).count());
+    s.pop();
+    ASSERT_EQ(10, s.delay_to_next(start).count());
+    ASSERT_EQ(6, s.delay_to_next(start + 3 * ms + 1).count());
+    ASSERT_EQ(0, s.delay_to_next(start + 9 * ms + 1).count());
+    ASSERT_EQ(0, s.delay_to_next(start + 11 * ms).count());
+
+    // poisson arrival: the average rate is the target one, with varying intervals
+    s.start(start, start + 10000 * ms, 10000, true, 12345);
+    count = 0;
+    uint64_t last_ts = 0, min_interval = ~0ULL, max_interval = 0;
+    while (!s.finished()) {
+        uint64_t ts = s.pop();
+        if (count > 0) {
+            ASSERT_GT(ts, last_ts);
+            min_interval = std::min(min_interval, ts - last_ts);
+            max_interval = std::max(max_interval, ts - last_ts);
+        }
+        last_ts = ts;
+        count++;
+    }
+    ASSERT_GT(count, 97000);
+    ASSERT_LT(count, 103000);
+    ASSERT_LT(min_interval, 10000u);
+    ASSERT_GT(max_interval, 500000u);
+
+    // the delay of sending a request is rounded up to milliseconds
+    ASSERT_EQ(0, open_loop_schedule::delay_to(start, start).count());
+    ASSERT_EQ(0, open_loop_schedule::delay_to(start, start + 1).count());
+    ASSERT_EQ(1, open_loop_schedule::delay_to(start + 1, start).count());
+    ASSERT_EQ(1, open_loop_schedule::delay_to(start + ms, start).count());
+    ASSERT_EQ(3, open_loop_schedule::delay_to(start + 2 * ms + 1, start).count());
+}
+
+// sends no real requests, but completes each one at once
+class open_loop_test_client : public dsn::service::perf_client_helper
+{
+public:
+    struct send_record
+    {
+        uint64_t start_ts_ns; // from prepare_send_one()
+        uint64_t send_ts_ns;
+    };
+
+    void send_one(int payload_bytes, int key_space_size, const std::vector<double> &ratios)
+    {
+        send_record r;
+        r.send_ts_ns = dsn_now_ns();
+        void *ctx = prepare_send_one();
+        r.start_ts_ns = (uint64_t)(ctx);
+        {
+            dsn::utils::auto_lock<dsn::utils::ex_lock_nr> l(lock);
+            records.push_back(r);
+        }
+        end_send_one(ctx, dsn::ERR_OK);
+    }
+
+    int sent_count()
+    {
+        dsn::utils::auto_lock<dsn::utils::ex_lock_nr> l(lock);
+        return static_cast<int>(records.size());
+    }
+
+    dsn::utils::ex_lock_nr lock;
+    std::vector<send_record> records;
+};
+
+TEST(core, open_loop_tick)
+{
+    // [perf_test.open_loop] in config-test.ini: 500 qps for one second at constant arrival.
+    // left alive as the helper may still be finishing the case on the thread pool
+    auto client = new open_loop_test_client();
+    client->start_test("perf_test.open_loop", 1);
+    for (int i = 0; i < 200 && client->sent_count() < 500; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ASSERT_EQ(500, client->sent_count());
+
+    std::vector<uint64_t> lags;
+    {
+        dsn::utils::auto_lock<dsn::utils::ex_lock_nr> l(client->lock);
+        std::sort(client->records.begin(),
+                  client->records.end(),
+                  [](const open_loop_test_client::send_record &a,
+                     const open_loop_test_client::send_record &b) {
+                      return a.start_ts_ns < b.start_ts_ns;
+                  });
+        for (size_t i = 0; i < client->records.size(); i++) {
+            auto &r = client->records[i];
+            // latencies are measured from the scheduled time, which no request is sent before
+            ASSERT_LE(r.start_ts_ns, r.send_ts_ns);
+            if (i > 0) {
+                ASSERT_EQ(2000000u, r.start_ts_ns - client->records[i - 1].start_ts_ns);
+            }
+            lags.push_back(r.send_ts_ns - r.start_ts_ns);
+        }
+    }
+
+    // each request is sent by its own timer, rather than in a burst of a tick
+    std::sort(lags.begin(), lags.end());
+    ASSERT_LT(lags[lags.size() / 2], 5000000u);
+}
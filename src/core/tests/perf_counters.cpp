@@ -101,3 +101,31 @@ TEST(core, perf_counters)
     ASSERT_EQ(nullptr, p);
     ASSERT_FALSE(perf_counters::instance().remove_counter("app*test*unexist_counter"));
 }
+
+TEST(core, perf_counters_export)
+{
+    perf_counter_ptr number = perf_counters::instance().get_global_counter(
+        "app", "test", "export_counter", COUNTER_TYPE_NUMBER, "counter to export", true);
+    number->set(42);
+    perf_counter_ptr queue = perf_counters::instance().get_global_counter(
+        "zion", "profiler", "RPC_TEST_EXPORT.queue(ns)", COUNTER_TYPE_NUMBER, "", true);
+    queue->set(7);
+
+    std::string text = perf_counters::instance().export_prometheus();
+    ASSERT_NE(std::string::npos,
+              text.find("# HELP dsn_test_export_counter counter to export\n"
+                        "# TYPE dsn_test_export_counter gauge\n"
+                        "dsn_test_export_counter{app=\"app\"} 42\n"));
+    ASSERT_EQ(std::string::npos, text.find("dsn_counter"));
+    ASSERT_NE(std::string::npos, text.find("# TYPE dsn_task_queue_ns gauge\n"));
+    ASSERT_NE(std::string::npos,
+              text.find("dsn_task_queue_ns{app=\"zion\",task_code=\"RPC_TEST_EXPORT\"} 7\n"));
+
+    std::string json = perf_counters::instance().export_json();
+    ASSERT_NE(std::string::npos, json.find("\"task_code\":\"RPC_TEST_EXPORT\""));
+    ASSERT_NE(std::string::npos, json.find("\"metric\":\"dsn_test_export_counter\""));
+
+    ASSERT_TRUE(perf_counters::instance().remove_counter("app*test*export_counter"));
+    ASSERT_TRUE(
+        perf_counters::instance().remove_counter("zion*profiler*RPC_TEST_EXPORT.queue(ns)"));
+}
@@ -36,12 +36,14 @@
 #include <vector>
 #include <string>
 #include <queue>
+#include <thread>
 
 #include <dsn/tool-api/aio_provider.h>
 #include <gtest/gtest.h>
 #include <dsn/service_api_cpp.h>
 #include <dsn/utility/priority_queue.h>
 #include "../core/group_address.h"
+#include "../core/rpc_engine.h"
 #include "test_utils.h"
 #include <boost/lexical_cast.hpp>
 
@@ -259,3 +261,132 @@ TEST(core, send_to_invalid_address)
     send_message(group, std::string("echo hehehe"), 1, action_on_succeed, action_on_failure);
     destroy_group(group);
 }
+
+DEFINE_TASK_CODE_RPC(RPC_TEST_DISPATCHER, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+
+TEST(core, rpc_server_dispatcher)
+{
+    ::dsn::rpc_server_dispatcher dispatcher;
+    std::atomic<int> calls(0);
+
+    auto h = new ::dsn::rpc_handler_info(RPC_TEST_DISPATCHER);
+    h->name = "test_dispatcher";
+    h->c_handler = [](dsn_message_t, void *param) { ++*(std::atomic<int> *)param; };
+    h->parameter = &calls;
+    ASSERT_TRUE(dispatcher.register_rpc_handler(h));
+
+    // by local code and by name
+    auto msg = ::dsn::message_ex::create_request(RPC_TEST_DISPATCHER);
+    ASSERT_TRUE(dispatcher.on_request_with_inline_execution(msg, nullptr));
+    msg->local_rpc_code = ::dsn::TASK_CODE_INVALID;
+    strcpy(msg->header->rpc_name, "test_dispatcher");
+    ASSERT_TRUE(dispatcher.on_request_with_inline_execution(msg, nullptr));
+    ASSERT_EQ((int)RPC_TEST_DISPATCHER, msg->local_rpc_code);
+    ASSERT_EQ(2, calls.load());
+
+    // an unregistered handler is not found any more, but stays valid for the
+    // requests dispatched before
+    ASSERT_EQ(h, dispatcher.unregister_rpc_handler(RPC_TEST_DISPATCHER));
+    ASSERT_FALSE(dispatcher.on_request_with_inline_execution(msg, nullptr));
+    h->run(msg);
+    ASSERT_EQ(2, calls.load());
+
+    msg->add_ref();
+    msg->release_ref();
+    delete h;
+}
+
+TEST(core, rpc_handler_reclaimer)
+{
+    ::dsn::rpc_handler_reclaimer reclaimer;
+
+    // deleted at once without any dispatch in flight
+    reclaimer.retire(new ::dsn::rpc_handler_info(RPC_TEST_DISPATCHER));
+    ASSERT_EQ(0, reclaimer.retired_count());
+
+    // kept for the dispatch entered before the retirement
+    uint32_t token1 = reclaimer.enter();
+    reclaimer.retire(new ::dsn::rpc_handler_info(RPC_TEST_DISPATCHER));
+    ASSERT_EQ(1, reclaimer.retired_count());
+
+    // a dispatch entered after the retirement, on another thread, doesn't keep it
+    uint32_t token2 = 0;
+    std::thread t([&reclaimer, &token2]() { token2 = reclaimer.enter(); });
+    t.join();
+    reclaimer.leave(token1);
+    reclaimer.retire(new ::dsn::rpc_handler_info(RPC_TEST_DISPATCHER));
+    ASSERT_EQ(1, reclaimer.retired_count());
+
+    reclaimer.leave(token2);
+    reclaimer.retire(new ::dsn::rpc_handler_info(RPC_TEST_DISPATCHER));
+    ASSERT_EQ(0, reclaimer.retired_count());
+}
+
+TEST(core, inline_execution_budget)
+{
+    ::dsn::inline_execution_budget budget = {0, 0, 0};
+    const uint64_t window_ns = 1000000;
+    const uint64_t max_time_ns = 500000;
+    const int max_count = 3;
+
+    // the count limit, then the queue takes the rest of the window
+    uint64_t now = window_ns;
+    for (int i = 0; i < max_count; i++) {
+        ASSERT_TRUE(budget.try_acquire(now, window_ns, max_time_ns, max_count));
+        budget.consume(1000);
+    }
+    ASSERT_FALSE(budget.try_acquire(now + 1000, window_ns, max_time_ns, max_count));
+
+    // renewed in the next window
+    now += window_ns;
+    ASSERT_TRUE(budget.try_acquire(now, window_ns, max_time_ns, max_count));
+    ASSERT_EQ(0, budget.count);
+
+    // the time limit
+    budget.consume(max_time_ns);
+    ASSERT_FALSE(budget.try_acquire(now + 1, window_ns, max_time_ns, max_count));
+
+    // no inline run at all
+    now += window_ns;
+    ASSERT_FALSE(budget.try_acquire(now, window_ns, max_time_ns, 0));
+}
+
+static std::atomic<int> s_inline_test_enqueues(0);
+static std::atomic<int> s_inline_test_begins(0);
+static std::atomic<int> s_inline_test_inline_begins(0);
+
+TEST(core, rpc_inline_join_points)
+{
+    // whichever config the test runs with, the requests may run inline on the network thread
+    ::dsn::task_spec *spec = ::dsn::task_spec::get(RPC_TEST_STRING_COMMAND);
+    bool non_blocking = spec->rpc_request_is_non_blocking;
+    spec->rpc_request_is_non_blocking = true;
+    spec->on_rpc_request_enqueue.put_back(
+        [](::dsn::rpc_request_task *) { ++s_inline_test_enqueues; },
+        "test.inline");
+    spec->on_task_begin.put_back(
+        [](::dsn::task *) {
+            ++s_inline_test_begins;
+            if (::dsn::task::get_current_worker2() == nullptr)
+                ++s_inline_test_inline_begins;
+        },
+        "test.inline");
+
+    ::dsn::rpc_address server("localhost", TEST_PORT_BEGIN);
+    for (int i = 0; i < 10; i++) {
+        auto result = ::dsn::rpc::call_wait<std::string>(
+            server, RPC_TEST_STRING_COMMAND, std::string("echo inline"));
+        ASSERT_EQ(ERR_OK, result.first);
+        ASSERT_EQ("inline", result.second);
+    }
+
+    spec->on_rpc_request_enqueue.remove("test.inline");
+    spec->on_task_begin.remove("test.inline");
+    spec->rpc_request_is_non_blocking = non_blocking;
+
+    // every request, whether run inline or queued, passes the enqueue join point before
+    // it begins, so the profiler and the tracer see paired events
+    ASSERT_EQ(10, s_inline_test_enqueues.load());
+    ASSERT_EQ(10, s_inline_test_begins.load());
+    ASSERT_GT(s_inline_test_inline_begins.load(), 0);
+}
@@ -35,7 +35,10 @@
 
 #include <dsn/tool-api/rpc_message.h>
 #include <dsn/utility/crc.h>
+#include <dsn/cpp/serialization.h>
+#include <dsn/cpp/serialization_helper/dsn.layer2_types.h>
 #include <../core/transient_memory.h>
+#include "../tools/common/dsn_message_parser.h"
 #include <gtest/gtest.h>
 
 using namespace ::dsn;
@@ -244,3 +247,361 @@ TEST(core, message_ex)
         dsn_msg_release_ref(request);
     }
 }
+
+// send msg through parser as the network does, and put the bytes into reader
+static size_t send_through(message_parser_ptr &parser, message_ex *msg, message_reader &reader)
+{
+    parser->prepare_on_send(msg);
+    std::vector<message_parser::send_buf> bufs(parser->get_buffer_count_on_send(msg));
+    int count = parser->get_buffers_on_send(msg, bufs.data());
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        char *ptr = reader.read_buffer_ptr(bufs[i].sz);
+        memcpy(ptr, bufs[i].buf, bufs[i].sz);
+        reader.mark_read(bufs[i].sz);
+        total += bufs[i].sz;
+    }
+    parser->on_buffers_sent();
+    return total;
+}
+
+static std::string read_body(message_ex *msg)
+{
+    void *ptr;
+    size_t sz;
+    std::string body;
+    while (msg->read_next(&ptr, &sz)) {
+        body.append((const char *)ptr, sz);
+        msg->read_commit(sz);
+    }
+    return body;
+}
+
+TEST(core, dsn_message_parser)
+{
+    task_spec *request_spec = task_spec::get(RPC_CODE_FOR_TEST);
+    task_spec *response_spec = task_spec::get(RPC_CODE_FOR_TEST_ACK);
+    bool request_crc_required = request_spec->rpc_message_crc_required;
+    bool response_crc_required = response_spec->rpc_message_crc_required;
+    request_spec->rpc_message_crc_required = true;
+    response_spec->rpc_message_crc_required = true;
+
+    message_parser_ptr client(new dsn_message_parser());
+    message_parser_ptr server(new dsn_message_parser());
+    client->on_attached_to_session();
+    server->on_attached_to_session();
+    message_reader client_reader(4096), server_reader(4096);
+
+    const char *data = "adaoihfeuifgggggisdosghkbvjhzxvdafdiofgeof";
+    size_t data_size = strlen(data);
+    auto write_body = [&](message_ex *msg) {
+        void *ptr;
+        size_t sz;
+        msg->write_next(&ptr, &sz, data_size);
+        memcpy(ptr, data, data_size);
+        msg->write_commit(data_size);
+    };
+    auto create_request = [&]() {
+        message_ex *request = message_ex::create_request(RPC_CODE_FOR_TEST, 100, 1, 2);
+        request->header->gpid = dsn::gpid(3, 4);
+        request->header->from_address = rpc_address("127.0.0.1", 8080);
+        write_body(request);
+        request->add_ref();
+        return request;
+    };
+    int read_next;
+
+    // the first request has a full header, telling the server that compact ones can be sent
+    message_ex *request = create_request();
+    ASSERT_EQ(sizeof(message_header) + data_size, send_through(client, request, server_reader));
+    message_ex *received = server->get_message_on_receive(&server_reader, read_next);
+    ASSERT_NE(nullptr, received);
+    received->add_ref();
+    ASSERT_EQ(3u, received->header->hdr_version);
+    ASSERT_EQ((int)RPC_CODE_FOR_TEST, received->rpc_code());
+    ASSERT_EQ(std::string(data), read_body(received));
+
+    // the response has a compact header, without the error name
+    received->to_address = rpc_address("127.0.0.1", 9090);
+    message_ex *response = received->create_response();
+    response->add_ref();
+    write_body(response);
+    strncpy(response->header->server.error_name,
+            ERR_OK.to_string(),
+            sizeof(response->header->server.error_name));
+    size_t header_size = send_through(server, response, client_reader) - data_size;
+    ASSERT_LT(header_size * 4, sizeof(message_header));
+
+    message_ex *received_response = client->get_message_on_receive(&client_reader, read_next);
+    ASSERT_NE(nullptr, received_response);
+    received_response->add_ref();
+    {
+        message_header &h = *received_response->header;
+        ASSERT_EQ(request->header->id, h.id);
+        ASSERT_EQ(data_size, h.body_length);
+        ASSERT_STREQ(dsn::task_code(RPC_CODE_FOR_TEST_ACK).to_string(), h.rpc_name);
+        ASSERT_EQ((int)RPC_CODE_FOR_TEST_ACK, received_response->local_rpc_code);
+        ASSERT_FALSE(h.context.u.is_request);
+        ASSERT_EQ(dsn::gpid(3, 4), h.gpid);
+        ASSERT_EQ(rpc_address("127.0.0.1", 9090), h.from_address);
+        ASSERT_EQ(ERR_OK, received_response->error());
+        ASSERT_EQ(std::string(data), read_body(received_response));
+    }
+
+    // now the client sends compact headers too, and the rpc name only at the first time
+    message_ex *request2 = create_request();
+    message_ex *request3 = create_request();
+    size_t request2_size = send_through(client, request2, server_reader);
+    size_t request3_size = send_through(client, request3, server_reader);
+    ASSERT_LT(request3_size, request2_size);
+    for (message_ex *sent : {request2, request3}) {
+        message_ex *msg = server->get_message_on_receive(&server_reader, read_next);
+        ASSERT_NE(nullptr, msg);
+        msg->add_ref();
+        message_header &h = *msg->header;
+        ASSERT_EQ(sent->header->id, h.id);
+        ASSERT_STREQ(dsn::task_code(RPC_CODE_FOR_TEST).to_string(), h.rpc_name);
+        ASSERT_EQ((int)RPC_CODE_FOR_TEST, msg->local_rpc_code);
+        ASSERT_EQ(sent->header->context.context, h.context.context);
+        ASSERT_EQ(dsn::gpid(3, 4), h.gpid);
+        ASSERT_EQ(rpc_address("127.0.0.1", 8080), h.from_address);
+        ASSERT_EQ(100, h.client.timeout_ms);
+        ASSERT_EQ(1, h.client.thread_hash);
+        ASSERT_EQ(2u, h.client.partition_hash);
+        ASSERT_EQ(sent->header->body_crc32, h.body_crc32);
+        ASSERT_EQ(std::string(data), read_body(msg));
+        msg->release_ref();
+    }
+    ASSERT_EQ(0u, server_reader._buffer_occupied);
+
+    // a failed response carries the error name
+    message_ex *failed = received->create_response();
+    failed->add_ref();
+    strncpy(failed->header->server.error_name,
+            ERR_BUSY.to_string(),
+            sizeof(failed->header->server.error_name));
+    send_through(server, failed, client_reader);
+    message_ex *received_failed = client->get_message_on_receive(&client_reader, read_next);
+    ASSERT_NE(nullptr, received_failed);
+    received_failed->add_ref();
+    ASSERT_EQ(ERR_BUSY, received_failed->error());
+    ASSERT_EQ(0u, received_failed->header->body_length);
+
+    // a corrupted compact header is rejected
+    message_ex *request4 = create_request();
+    send_through(client, request4, server_reader);
+    const_cast<char *>(server_reader._buffer.data())[8]++;
+    ASSERT_EQ(nullptr, server->get_message_on_receive(&server_reader, read_next));
+    ASSERT_EQ(-1, read_next);
+
+    // so is a compact header with a wrong signature, which is checked even without header crc
+    message_reader bad_reader(4096);
+    message_ex *request5 = create_request();
+    send_through(client, request5, bad_reader);
+    const_cast<char *>(bad_reader._buffer.data())[0] = 'X';
+    message_parser_ptr server2(new dsn_message_parser());
+    server2->on_attached_to_session();
+    ASSERT_EQ(nullptr, server2->get_message_on_receive(&bad_reader, read_next));
+    ASSERT_EQ(-1, read_next);
+
+    for (message_ex *msg : {request,
+                            received,
+                            response,
+                            received_response,
+                            request2,
+                            request3,
+                            failed,
+                            received_failed,
+                            request4,
+                            request5}) {
+        msg->release_ref();
+    }
+    request_spec->rpc_message_crc_required = request_crc_required;
+    response_spec->rpc_message_crc_required = response_crc_required;
+}
+
+TEST(core, dsn_message_parser_compression)
+{
+    task_spec *request_spec = task_spec::get(RPC_CODE_FOR_TEST);
+    bool crc_required = request_spec->rpc_message_crc_required;
+    int32_t compress_min_bytes = request_spec->rpc_message_compress_min_bytes;
+    request_spec->rpc_message_crc_required = true;
+    request_spec->rpc_message_compress_min_bytes = 1024;
+
+    message_parser_ptr client(new dsn_message_parser());
+    message_parser_ptr server(new dsn_message_parser());
+    client->on_attached_to_session();
+    server->on_attached_to_session();
+    message_reader client_reader(4096), server_reader(4096);
+
+    std::string data;
+    for (int i = 0; data.size() < 8192; i++) {
+        data += "compressible payload " + std::to_string(i % 10) + ";";
+    }
+    auto create_request = [&](const std::string &body) {
+        message_ex *request = message_ex::create_request(RPC_CODE_FOR_TEST, 100, 1, 2);
+        void *ptr;
+        size_t sz;
+        request->write_next(&ptr, &sz, body.size());
+        memcpy(ptr, body.data(), body.size());
+        request->write_commit(body.size());
+        request->add_ref();
+        return request;
+    };
+    int read_next;
+
+    // the capabilities of the server are unknown for the first request
+    message_ex *request = create_request(data);
+    ASSERT_EQ(sizeof(message_header) + data.size(), send_through(client, request, server_reader));
+    message_ex *received = server->get_message_on_receive(&server_reader, read_next);
+    ASSERT_NE(nullptr, received);
+    received->add_ref();
+    ASSERT_EQ(data, read_body(received));
+
+    // the server tells them in the compact header of the response
+    received->to_address = rpc_address("127.0.0.1", 9090);
+    message_ex *response = received->create_response();
+    response->add_ref();
+    send_through(server, response, client_reader);
+    message_ex *received_response = client->get_message_on_receive(&client_reader, read_next);
+    ASSERT_NE(nullptr, received_response);
+    received_response->add_ref();
+
+    // then large bodies are compressed, and sent again in the same way on resending
+    message_ex *request2 = create_request(data);
+    size_t request2_size = send_through(client, request2, server_reader);
+    ASSERT_LT(request2_size * 4, data.size());
+    ASSERT_LT(send_through(client, request2, server_reader) * 4, data.size());
+    for (int i = 0; i < 2; i++) {
+        message_ex *msg = server->get_message_on_receive(&server_reader, read_next);
+        ASSERT_NE(nullptr, msg);
+        msg->add_ref();
+        ASSERT_EQ(data.size(), msg->header->body_length);
+        ASSERT_EQ(request2->header->body_crc32, msg->header->body_crc32);
+        ASSERT_EQ((int)RPC_CODE_FOR_TEST, msg->local_rpc_code);
+        ASSERT_EQ(data, read_body(msg));
+        msg->release_ref();
+    }
+
+    // preparing a message for resending keeps the buffers of its last sending untouched until
+    // they are sent
+    client->prepare_on_send(request2);
+    std::vector<message_parser::send_buf> bufs(client->get_buffer_count_on_send(request2));
+    int count = client->get_buffers_on_send(request2, bufs.data());
+    std::string in_flight;
+    for (int i = 0; i < count; i++) {
+        in_flight.append((const char *)bufs[i].buf, bufs[i].sz);
+    }
+    client->prepare_on_send(request2);
+    std::string still_in_flight;
+    for (int i = 0; i < count; i++) {
+        still_in_flight.append((const char *)bufs[i].buf, bufs[i].sz);
+    }
+    ASSERT_EQ(in_flight, still_in_flight);
+    client->on_buffers_sent();
+
+    // the compressed body is kept on the message until it is sent, and released with the
+    // message if it never is, e.g., when the sending is cancelled
+    ASSERT_LT(0u, request2->lz_body.length());
+    count = client->get_buffers_on_send(request2, bufs.data());
+    ASSERT_EQ(0u, request2->lz_body.length());
+    client->on_buffers_sent();
+    char *ptr = server_reader.read_buffer_ptr(in_flight.size());
+    memcpy(ptr, in_flight.data(), in_flight.size());
+    server_reader.mark_read(in_flight.size());
+    message_ex *resent = server->get_message_on_receive(&server_reader, read_next);
+    ASSERT_NE(nullptr, resent);
+    resent->add_ref();
+    ASSERT_EQ(data, read_body(resent));
+    resent->release_ref();
+
+    // while small ones are not
+    std::string small_data = data.substr(0, 100);
+    message_ex *request3 = create_request(small_data);
+    ASSERT_LT(small_data.size(), send_through(client, request3, server_reader));
+    message_ex *received3 = server->get_message_on_receive(&server_reader, read_next);
+    ASSERT_NE(nullptr, received3);
+    received3->add_ref();
+    ASSERT_EQ(small_data, read_body(received3));
+    ASSERT_EQ(0u, server_reader._buffer_occupied);
+
+    // nor the ones larger than the max raw size of a compressed body, which the receiver
+    // allocates from the header before decompressing
+    uint64_t max_body_mb = dsn_config_get_value_uint64(
+        "network", "max_compressed_message_body_mb", 64, "max raw size of a compressed body");
+    std::string large_data;
+    while (large_data.size() <= max_body_mb * 1024 * 1024) {
+        large_data += data;
+    }
+    message_ex *request4 = create_request(large_data);
+    ASSERT_LT(large_data.size(), send_through(client, request4, server_reader));
+    message_ex *received4 = server->get_message_on_receive(&server_reader, read_next);
+    ASSERT_NE(nullptr, received4);
+    received4->add_ref();
+    ASSERT_EQ(large_data, read_body(received4));
+
+    for (message_ex *msg : {request,
+                            received,
+                            response,
+                            received_response,
+                            request2,
+                            request3,
+                            received3,
+                            request4,
+                            received4}) {
+        msg->release_ref();
+    }
+    request_spec->rpc_message_crc_required = crc_required;
+    request_spec->rpc_message_compress_min_bytes = compress_min_bytes;
+}
+
+template <typename T>
+static blob marshall_to_blob(const T &value, dsn_msg_serialize_format fmt)
+{
+    binary_writer writer;
+    ::dsn::marshall(writer, value, fmt);
+    return writer.get_buffer();
+}
+
+TEST(core, thrift_compact_serialization)
+{
+    configuration_query_by_index_response resp;
+    resp.err = ERR_OBJECT_NOT_FOUND;
+    resp.app_id = 2;
+    resp.partition_count = 8;
+    resp.is_stateful = true;
+    for (int i = 0; i < resp.partition_count; i++) {
+        partition_configuration pc;
+        pc.pid = gpid(resp.app_id, i);
+        pc.ballot = 3 + i;
+        pc.max_replica_count = 3;
+        pc.primary = rpc_address("127.0.0.1", 34801);
+        pc.secondaries.push_back(rpc_address("127.0.0.1", 34802));
+        pc.secondaries.push_back(rpc_address("127.0.0.1", 34803));
+        pc.last_committed_decree = 1000 * i;
+        resp.partitions.push_back(pc);
+    }
+
+    blob compact = marshall_to_blob(resp, DSF_THRIFT_COMPACT);
+    blob binary = marshall_to_blob(resp, DSF_THRIFT_BINARY);
+    ASSERT_LT(compact.length(), binary.length());
+
+    binary_reader reader(compact);
+    configuration_query_by_index_response resp2;
+    ::dsn::unmarshall(reader, resp2, DSF_THRIFT_COMPACT);
+    ASSERT_TRUE(resp == resp2);
+    ASSERT_EQ(0, reader.get_remaining_size());
+
+    // the dsn types with hand-written serialization
+    std::string data(1000, 'x');
+    blob value(data.data(), 0, (unsigned int)data.size());
+    binary_reader value_reader(marshall_to_blob(value, DSF_THRIFT_COMPACT));
+    blob value2;
+    ::dsn::unmarshall(value_reader, value2, DSF_THRIFT_COMPACT);
+    ASSERT_EQ(data, std::string(value2.data(), value2.length()));
+
+    binary_reader code_reader(marshall_to_blob(RPC_CODE_FOR_TEST, DSF_THRIFT_COMPACT));
+    task_code code;
+    ::dsn::unmarshall(code_reader, code, DSF_THRIFT_COMPACT);
+    ASSERT_EQ(RPC_CODE_FOR_TEST, code);
+}
@@ -35,10 +35,15 @@
 
 #include "../core/task_engine.h"
 #include "test_utils.h"
+#include "../tools/hpc/hpc_task_queue.h"
 #include <dsn/tool_api.h>
 #include <gtest/gtest.h>
 #include <sstream>
 
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
 using namespace ::dsn;
 
 class admission_controller_for_test : public admission_controller
@@ -132,6 +137,161 @@ TEST(core, task_engine)
     ASSERT_EQ(nullptr, controllers2[1]);
 }
 
+DEFINE_TASK_CODE(LPC_TEST_ENQUEUE_BULK, TASK_PRIORITY_COMMON, THREAD_POOL_FOR_TEST_2)
+
+TEST(core, task_engine_enqueue_bulk)
+{
+    if (dsn::service_engine::fast_instance().spec().tool == "simulator")
+        return;
+
+    // THREAD_POOL_FOR_TEST_2 is partitioned, so the batch is split between its two queues
+    task_worker_pool *pool = task::get_current_node2()->computation()->get_pool(
+        THREAD_POOL_FOR_TEST_2);
+    ASSERT_NE(nullptr, pool);
+
+    std::atomic<int> count(0);
+    std::vector<dsn::ref_ptr<task>> tasks;
+    std::vector<task *> batch;
+    for (int i = 0; i < 16; i++) {
+        dsn::ref_ptr<task> t(new task_c(LPC_TEST_ENQUEUE_BULK,
+                                        [](void *c) { ++*(std::atomic<int> *)c; },
+                                        &count,
+                                        nullptr,
+                                        i));
+        t->add_ref(); // released in exec_internal, as task::enqueue does
+        tasks.push_back(t);
+        batch.push_back(t.get());
+    }
+
+    pool->enqueue_bulk(batch.data(), (int)batch.size());
+    for (auto &t : tasks) {
+        ASSERT_TRUE(t->wait());
+    }
+    ASSERT_EQ(16, count.load());
+}
+
+TEST(core, adaptive_waiter_spin_limit)
+{
+    using dsn::tools::adaptive_waiter;
+    std::atomic<int> park_streak(0);
+    const int max_spin = 1000;
+
+    // disabled spinning stays disabled
+    ASSERT_EQ(0, adaptive_waiter::next_spin_limit(true, 0, 0, park_streak));
+    ASSERT_EQ(0, adaptive_waiter::next_spin_limit(false, 0, 0, park_streak));
+
+    // parks halve the budget, but never below 1
+    int limit = max_spin;
+    for (int i = 0; i < 20; i++) {
+        int next = adaptive_waiter::next_spin_limit(false, limit, max_spin, park_streak);
+        ASSERT_EQ(std::max(1, limit / 2), next);
+        limit = next;
+    }
+    ASSERT_EQ(1, limit);
+
+    // so that a hit can grow it back to the full budget
+    for (int i = 0; i < 20; i++) {
+        int next = adaptive_waiter::next_spin_limit(true, limit, max_spin, park_streak);
+        ASSERT_EQ(std::min(max_spin, limit * 2 + 1), next);
+        limit = next;
+    }
+    ASSERT_EQ(max_spin, limit);
+
+    // after enough parks in a row the full budget is probed again
+    park_streak.store(0);
+    limit = 1;
+    for (int i = 1; i < adaptive_waiter::reprobe_parks; i++) {
+        limit = adaptive_waiter::next_spin_limit(false, limit, max_spin, park_streak);
+        ASSERT_EQ(1, limit);
+    }
+    ASSERT_EQ(max_spin, adaptive_waiter::next_spin_limit(false, limit, max_spin, park_streak));
+    ASSERT_EQ(0, park_streak.load());
+}
+
+TEST(core, task_worker_affinity)
+{
+    ASSERT_EQ(std::vector<int>({0, 2, 63}),
+              task_worker::affinity_mask_to_cpus(0x8000000000000005ULL));
+    ASSERT_TRUE(task_worker::affinity_mask_to_cpus(0).empty());
+
+#ifdef __linux__
+    // bind the current thread to one of the cpus it is allowed to run on, and restore it then
+    cpu_set_t old_set;
+    ASSERT_EQ(0, pthread_getaffinity_np(pthread_self(), sizeof(old_set), &old_set));
+    int cpu = 0;
+    while (!CPU_ISSET(cpu, &old_set)) {
+        cpu++;
+    }
+    ASSERT_LT(cpu, utils::get_cpu_count());
+    task_worker::set_affinity(std::vector<int>({cpu}));
+
+    cpu_set_t new_set;
+    ASSERT_EQ(0, pthread_getaffinity_np(pthread_self(), sizeof(new_set), &new_set));
+    ASSERT_EQ(1, CPU_COUNT(&new_set));
+    ASSERT_TRUE(CPU_ISSET(cpu, &new_set));
+    ASSERT_EQ(0, pthread_setaffinity_np(pthread_self(), sizeof(old_set), &old_set));
+#endif
+}
+
+TEST(core, task_worker_placement)
+{
+    // node ids may have holes
+    task_worker::numa_topology topology;
+    topology[0] = {0, 1, 2, 3};
+    topology[2] = {8, 9, 10, 11};
+
+    threadpool_spec spec(THREAD_POOL_DEFAULT);
+    spec.worker_share_core = true;
+    spec.worker_affinity_mask = 0;
+    spec.worker_numa_spread = false;
+    spec.worker_numa_local_memory = false;
+    std::vector<int> cpus, nodes;
+
+    // not bound by default
+    task_worker::get_placement(spec, 5, topology, cpus, nodes);
+    ASSERT_TRUE(cpus.empty());
+    ASSERT_TRUE(nodes.empty());
+
+    // a worker not sharing cores takes one of all the cpus by its index
+    spec.worker_share_core = false;
+    task_worker::get_placement(spec, 5, topology, cpus, nodes);
+    ASSERT_EQ(std::vector<int>({9}), cpus);
+
+    // or one of the cpus assigned to the pool
+    spec.worker_affinity_mask = 0x6;
+    task_worker::get_placement(spec, 3, topology, cpus, nodes);
+    ASSERT_EQ(std::vector<int>({2}), cpus);
+    spec.worker_affinity_mask = 0;
+
+    // workers are spread over the existing nodes round robin
+    spec.worker_numa_spread = true;
+    task_worker::get_placement(spec, 3, topology, cpus, nodes);
+    ASSERT_EQ(std::vector<int>({2}), nodes);
+    ASSERT_EQ(std::vector<int>({9}), cpus);
+
+    spec.worker_share_core = true;
+    for (int i = 0; i < 4; i++) {
+        task_worker::get_placement(spec, i, topology, cpus, nodes);
+        ASSERT_EQ(std::vector<int>({i % 2 == 0 ? 0 : 2}), nodes);
+        ASSERT_EQ(topology[nodes[0]], cpus);
+    }
+
+    // the assigned cpus are narrowed to the given nodes
+    spec.worker_numa_spread = false;
+    spec.worker_numa_nodes = "2";
+    spec.worker_cpu_list = "1-3,8-9";
+    task_worker::get_placement(spec, 0, topology, cpus, nodes);
+    ASSERT_EQ(std::vector<int>({2}), nodes);
+    ASSERT_EQ(std::vector<int>({8, 9}), cpus);
+
+    // unless none of them is on the nodes
+    spec.worker_numa_nodes = "0";
+    spec.worker_cpu_list = "8";
+    task_worker::get_placement(spec, 0, topology, cpus, nodes);
+    ASSERT_EQ(std::vector<int>({0}), nodes);
+    ASSERT_EQ(topology[0], cpus);
+}
+
 /*
 TEST(core, task_engine)
 {
@@ -39,6 +39,7 @@
 #include <dsn/utility/binary_writer.h>
 #include <dsn/utility/link.h>
 #include <dsn/utility/crc.h>
+#include <dsn/utility/compression.h>
 #include <dsn/utility/autoref_ptr.h>
 #include <dsn/c/api_layer1.h>
 #include <gtest/gtest.h>
@@ -69,6 +70,38 @@ TEST(core, crc)
     EXPECT_TRUE(c3 == c4);
 }
 
+TEST(core, lz_compress)
+{
+    // a compressible buffer larger than one chunk, followed by a random one
+    std::string text;
+    while (text.size() < 100 * 1024) {
+        text += "key_" + std::to_string(text.size() % 1000) + ",value;";
+    }
+    std::string random(1000, '\0');
+    for (auto &c : random) {
+        c = static_cast<char>(dsn_random32(0, 255));
+    }
+    dsn::blob inputs[] = {dsn::blob(text.data(), 0, text.size()),
+                          dsn::blob(random.data(), 0, random.size())};
+
+    dsn::blob output;
+    ASSERT_TRUE(dsn::utils::lz_compress(inputs, 2, output));
+    ASSERT_LT(output.length(), text.size() / 4);
+
+    std::string raw(text.size() + random.size(), '\0');
+    ASSERT_TRUE(dsn::utils::lz_decompress(output.data(), output.length(), &raw[0], raw.size()));
+    ASSERT_EQ(text + random, raw);
+
+    // wrong sizes and truncated streams are rejected
+    ASSERT_FALSE(
+        dsn::utils::lz_decompress(output.data(), output.length(), &raw[0], raw.size() - 1));
+    ASSERT_FALSE(
+        dsn::utils::lz_decompress(output.data(), output.length() - 1, &raw[0], raw.size()));
+
+    // incompressible data is left alone
+    ASSERT_FALSE(dsn::utils::lz_compress(inputs + 1, 1, output));
+}
+
 TEST(core, binary_io)
 {
     int value = 0xdeadbeef;
@@ -110,6 +143,33 @@ TEST(core, trim_string)
     EXPECT_EQ(std::string(r), "x x x x");
 }
 
+TEST(core, parse_cpu_list)
+{
+    std::vector<int> cpus;
+    EXPECT_TRUE(parse_cpu_list("0-3,8, 10-11\n", cpus));
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 8, 10, 11}), cpus);
+
+    EXPECT_TRUE(parse_cpu_list("5,1-2,2", cpus));
+    EXPECT_EQ(std::vector<int>({1, 2, 5}), cpus);
+
+    EXPECT_TRUE(parse_cpu_list("", cpus));
+    EXPECT_TRUE(cpus.empty());
+
+    EXPECT_FALSE(parse_cpu_list("3-1", cpus));
+    EXPECT_FALSE(parse_cpu_list("a", cpus));
+    EXPECT_FALSE(parse_cpu_list("1x", cpus));
+
+    EXPECT_GE(get_cpu_count(), 1);
+    std::vector<int> nodes;
+    get_numa_nodes(nodes);
+    EXPECT_EQ(get_numa_node_count(), (int)nodes.size());
+    ASSERT_FALSE(nodes.empty());
+    cpus.clear();
+    get_numa_node_cpus(nodes[0], cpus);
+    EXPECT_FALSE(cpus.empty());
+    EXPECT_LT(cpus.back(), get_cpu_count());
+}
+
 TEST(core, dlink)
 {
     dlink links[10];
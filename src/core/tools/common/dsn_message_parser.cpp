@@ -34,12 +34,146 @@
  */
 
 #include "dsn_message_parser.h"
+#include <algorithm>
 #include <dsn/service_api_c.h>
+#include <dsn/utility/compression.h>
 #include <dsn/utility/crc.h>
+#include <dsn/utility/utils.h>
 
 namespace dsn {
+
+// "RDSN" + version + hdr_length
+static const unsigned int COMPACT_HDR_PREFIX_LENGTH = 6;
+static const uint8_t COMPACT_HDR_VERSION = 2;
+// the version of a full header is a set of the capabilities of its sender:
+// compact headers can be sent back
+static const uint32_t FULL_HDR_VERSION_COMPACT_CAPABLE = 1;
+// compressed bodies can be sent back (in compact messages)
+static const uint32_t FULL_HDR_VERSION_LZ_CAPABLE = 2;
+// rpc codes above are sent by name only
+static const uint32_t COMPACT_HDR_MAX_RPC_CODE = 0xffff;
+
+enum compact_header_field
+{
+    CHF_HDR_CRC = 1 << 0,
+    CHF_BODY_CRC = 1 << 1,
+    CHF_TRACE_ID = 1 << 2,
+    CHF_GPID = 1 << 3,
+    CHF_FROM_ADDRESS = 1 << 4,
+    CHF_TIMEOUT = 1 << 5,
+    CHF_THREAD_HASH = 1 << 6,
+    CHF_PARTITION_HASH = 1 << 7,
+    CHF_RPC_NAME = 1 << 8,
+    CHF_ERROR_NAME = 1 << 9,
+    CHF_LZ_BODY = 1 << 10,    // the body is compressed by utils::lz_compress()
+    CHF_LZ_CAPABLE = 1 << 11, // the sender reads compressed bodies
+};
+
+static bool compact_header_enabled()
+{
+    static bool enabled = dsn_config_get_value_bool(
+        "network",
+        "compact_dsn_header",
+        true,
+        "whether to negotiate the compact dsn message header with peers of a connection");
+    return enabled;
+}
+
+// bodies are decompressed into buffers of their raw size, which is read from the peer, so it is
+// capped before allocating; larger bodies are sent uncompressed
+static uint32_t lz_body_max_raw_size()
+{
+    static uint32_t max_size = static_cast<uint32_t>(
+        std::min<uint64_t>(dsn_config_get_value_uint64("network",
+                                                       "max_compressed_message_body_mb",
+                                                       64,
+                                                       "max raw size of a compressed message "
+                                                       "body in MB, larger ones are sent "
+                                                       "uncompressed") *
+                               1024 * 1024,
+                           UINT32_MAX));
+    return max_size;
+}
+
+static char *write_varint(char *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = static_cast<char>((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<char>(v);
+    return p;
+}
+
+static bool read_varint(const char *&p, const char *end, /*out*/ uint64_t &v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static uint64_t zigzag_encode(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ (v >> 63); }
+
+static int64_t zigzag_decode(uint64_t v)
+{
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+template <typename T>
+static char *write_fixed(char *p, T v)
+{
+    memcpy(p, &v, sizeof(T));
+    return p + sizeof(T);
+}
+
+template <typename T>
+static bool read_fixed(const char *&p, const char *end, /*out*/ T &v)
+{
+    if (end - p < (ptrdiff_t)sizeof(T))
+        return false;
+    memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+static char *write_name(char *p, const char *name)
+{
+    size_t len = strnlen(name, DSN_MAX_TASK_CODE_NAME_LENGTH - 1);
+    *p++ = static_cast<char>(len);
+    memcpy(p, name, len);
+    return p + len;
+}
+
+static bool read_name(const char *&p, const char *end, /*out*/ char *name, size_t capacity)
+{
+    uint8_t len;
+    if (!read_fixed(p, end, len) || len >= capacity || end - p < len)
+        return false;
+    memcpy(name, p, len);
+    name[len] = '\0';
+    p += len;
+    return true;
+}
+
+dsn_message_parser::dsn_message_parser()
+    : _header_checked(false),
+      _attached(false),
+      _peer_reads_compact(false),
+      _peer_reads_lz(false),
+      _lz_capability_announced(false),
+      _compact_raw_body_length(0)
+{
+}
+
 void dsn_message_parser::reset() { _header_checked = false; }
 
+void dsn_message_parser::on_attached_to_session() { _attached = true; }
+
 message_ex *dsn_message_parser::get_message_on_receive(message_reader *reader,
                                                        /*out*/ int &read_next)
 {
@@ -49,6 +183,15 @@ message_ex *dsn_message_parser::get_message_on_receive(message_reader *reader,
     char *buf_ptr = (char *)buf.data();
     unsigned int buf_len = reader->_buffer_occupied;
 
+    if (buf_len < COMPACT_HDR_PREFIX_LENGTH) {
+        read_next = COMPACT_HDR_PREFIX_LENGTH - buf_len;
+        return nullptr;
+    }
+
+    if (static_cast<uint8_t>(buf_ptr[4]) == COMPACT_HDR_VERSION) {
+        return get_compact_message_on_receive(reader, read_next);
+    }
+
     if (buf_len >= sizeof(message_header)) {
         if (!_header_checked) {
             if (!is_right_header(buf_ptr)) {
@@ -77,12 +220,22 @@ message_ex *dsn_message_parser::get_message_on_receive(message_reader *reader,
                 read_next = -1;
                 return nullptr;
             } else {
+                if (_attached && compact_header_enabled()) {
+                    uint32_t capabilities = msg->header->hdr_version;
+                    if (capabilities & FULL_HDR_VERSION_LZ_CAPABLE) {
+                        _peer_reads_lz.store(true, std::memory_order_release);
+                    }
+                    if (capabilities & FULL_HDR_VERSION_COMPACT_CAPABLE) {
+                        _peer_reads_compact.store(true, std::memory_order_release);
+                    }
+                }
+
                 reader->_buffer = buf.range(msg_sz);
                 reader->_buffer_occupied -= msg_sz;
                 _header_checked = false;
-                read_next = (reader->_buffer_occupied >= sizeof(message_header)
+                read_next = (reader->_buffer_occupied >= COMPACT_HDR_PREFIX_LENGTH
                                  ? 0
-                                 : sizeof(message_header) - reader->_buffer_occupied);
+                                 : COMPACT_HDR_PREFIX_LENGTH - reader->_buffer_occupied);
                 msg->hdr_format = NET_HDR_DSN;
                 return msg;
             }
@@ -98,6 +251,323 @@ message_ex *dsn_message_parser::get_message_on_receive(message_reader *reader,
     }
 }
 
+message_ex *dsn_message_parser::get_compact_message_on_receive(message_reader *reader,
+                                                               /*out*/ int &read_next)
+{
+    dsn::blob &buf = reader->_buffer;
+    char *buf_ptr = (char *)buf.data();
+    unsigned int buf_len = reader->_buffer_occupied;
+    unsigned int hdr_length = static_cast<uint8_t>(buf_ptr[5]);
+
+    if (!_header_checked) {
+        // the header crc is only sent along with the body crc, so the signature is checked on
+        // every header to catch a corrupted or misaligned stream
+        if (memcmp(buf_ptr, "RDSN", 4) != 0) {
+            derror("invalid dsn compact message header signature '%s'",
+                   message_parser::get_debug_string(buf_ptr).c_str());
+            read_next = -1;
+            return nullptr;
+        }
+        if (hdr_length < COMPACT_HDR_PREFIX_LENGTH) {
+            derror("invalid dsn compact message header length %u", hdr_length);
+            read_next = -1;
+            return nullptr;
+        }
+        if (buf_len < hdr_length) {
+            read_next = hdr_length - buf_len;
+            return nullptr;
+        }
+        if (!parse_compact_header(buf_ptr, hdr_length)) {
+            derror("dsn compact message header check failed");
+            read_next = -1;
+            return nullptr;
+        }
+        _header_checked = true;
+    }
+
+    unsigned int msg_sz = hdr_length + _compact_header.body_length;
+    if (buf_len < msg_sz) {
+        read_next = msg_sz - buf_len;
+        return nullptr;
+    }
+
+    dsn::blob body = buf.range(hdr_length, _compact_header.body_length);
+    if (_compact_raw_body_length != 0) {
+        std::shared_ptr<char> raw_body(
+            dsn::utils::make_shared_array<char>(_compact_raw_body_length));
+        if (!dsn::utils::lz_decompress(
+                body.data(), body.length(), raw_body.get(), _compact_raw_body_length)) {
+            derror("dsn message body decompression failed, id = %" PRIu64 ", rpc_name = %s",
+                   _compact_header.id,
+                   _compact_header.rpc_name);
+            read_next = -1;
+            return nullptr;
+        }
+        body = blob(std::move(raw_body), _compact_raw_body_length);
+        _compact_header.body_length = _compact_raw_body_length;
+    }
+    if (_compact_header.body_crc32 != CRC_INVALID &&
+        _compact_header.body_crc32 != dsn::utils::crc32_calc(body.data(), body.length(), 0)) {
+        derror("dsn message body check failed, id = %" PRIu64 ", trace_id = %016" PRIx64
+               ", rpc_name = %s, from_addr = %s",
+               _compact_header.id,
+               _compact_header.trace_id,
+               _compact_header.rpc_name,
+               _compact_header.from_address.to_string());
+        read_next = -1;
+        return nullptr;
+    }
+
+    message_ex *msg = message_ex::create_receive_message_with_standalone_header(body);
+    *msg->header = _compact_header;
+    if (_compact_header.rpc_code.local_hash == message_ex::s_local_hash) {
+        msg->local_rpc_code = task_code(_compact_header.rpc_code.local_code);
+    }
+    msg->hdr_format = NET_HDR_DSN;
+
+    // only peers which have seen our full header of FULL_HDR_VERSION_COMPACT_CAPABLE send
+    // compact headers, and they can read them as well
+    if (_attached && compact_header_enabled()) {
+        _peer_reads_compact.store(true, std::memory_order_release);
+    }
+
+    reader->_buffer = buf.range(msg_sz);
+    reader->_buffer_occupied -= msg_sz;
+    _header_checked = false;
+    read_next = (reader->_buffer_occupied >= COMPACT_HDR_PREFIX_LENGTH
+                     ? 0
+                     : COMPACT_HDR_PREFIX_LENGTH - reader->_buffer_occupied);
+    return msg;
+}
+
+bool dsn_message_parser::parse_compact_header(const char *hdr, unsigned int hdr_length)
+{
+    const char *p = hdr + COMPACT_HDR_PREFIX_LENGTH;
+    const char *end = hdr + hdr_length;
+    uint64_t fields, v;
+    if (!read_varint(p, end, fields))
+        return false;
+
+    _compact_raw_body_length = 0;
+
+    message_header &h = _compact_header;
+    memset(&h, 0, sizeof(h));
+    h.hdr_type = *(uint32_t *)"RDSN";
+    h.hdr_version = COMPACT_HDR_VERSION;
+    h.hdr_length = sizeof(message_header);
+    h.hdr_crc32 = h.body_crc32 = CRC_INVALID;
+
+    const char *crc_ptr = nullptr;
+    uint32_t hdr_crc32 = 0;
+    if (fields & CHF_HDR_CRC) {
+        crc_ptr = p;
+        if (!read_fixed(p, end, hdr_crc32))
+            return false;
+    }
+
+    uint64_t rpc_code;
+    if (!read_varint(p, end, v) || v > UINT32_MAX)
+        return false;
+    h.body_length = static_cast<uint32_t>(v);
+    if (!read_varint(p, end, h.id) || !read_varint(p, end, rpc_code) ||
+        !read_varint(p, end, h.context.context))
+        return false;
+    if ((fields & CHF_BODY_CRC) && !read_fixed(p, end, h.body_crc32))
+        return false;
+    if ((fields & CHF_TRACE_ID) && !read_varint(p, end, h.trace_id))
+        return false;
+    if (fields & CHF_GPID) {
+        uint64_t app_id, partition_index;
+        if (!read_varint(p, end, app_id) || !read_varint(p, end, partition_index))
+            return false;
+        h.gpid.set_app_id(static_cast<int32_t>(app_id));
+        h.gpid.set_partition_index(static_cast<int32_t>(partition_index));
+    }
+    if (fields & CHF_FROM_ADDRESS) {
+        uint32_t ip;
+        uint16_t port;
+        if (!read_fixed(p, end, ip) || !read_fixed(p, end, port))
+            return false;
+        h.from_address.assign_ipv4(ip, port);
+    }
+    if (fields & CHF_TIMEOUT) {
+        if (!read_varint(p, end, v))
+            return false;
+        h.client.timeout_ms = static_cast<int32_t>(zigzag_decode(v));
+    }
+    if (fields & CHF_THREAD_HASH) {
+        if (!read_varint(p, end, v))
+            return false;
+        h.client.thread_hash = static_cast<int32_t>(zigzag_decode(v));
+    }
+    if ((fields & CHF_PARTITION_HASH) && !read_varint(p, end, h.client.partition_hash))
+        return false;
+    if ((fields & CHF_RPC_NAME) && !read_name(p, end, h.rpc_name, sizeof(h.rpc_name)))
+        return false;
+    if ((fields & CHF_ERROR_NAME) &&
+        !read_name(p, end, h.server.error_name, sizeof(h.server.error_name)))
+        return false;
+    if (fields & CHF_LZ_BODY) {
+        if (!read_varint(p, end, v) || v == 0 || v > UINT32_MAX)
+            return false;
+        if (v > lz_body_max_raw_size()) {
+            derror("dsn compact message claims a raw body of %" PRIu64 " bytes, larger than %u",
+                   v,
+                   lz_body_max_raw_size());
+            return false;
+        }
+        _compact_raw_body_length = static_cast<uint32_t>(v);
+    }
+    if (p != end)
+        return false;
+
+    if (crc_ptr != nullptr) {
+        // the crc is calculated with its own field filled by zero
+        static const char zero[sizeof(uint32_t)] = {0};
+        uint32_t crc = dsn::utils::crc32_calc(hdr, crc_ptr - hdr, 0);
+        crc = dsn::utils::crc32_calc(zero, sizeof(zero), crc);
+        const char *rest = crc_ptr + sizeof(uint32_t);
+        crc = dsn::utils::crc32_calc(rest, end - rest, crc);
+        if (crc != hdr_crc32) {
+            derror("dsn compact message header crc check failed");
+            return false;
+        }
+    }
+
+    if ((fields & CHF_LZ_CAPABLE) && compact_header_enabled()) {
+        _peer_reads_lz.store(true, std::memory_order_release);
+    }
+
+    // map the rpc code of the peer to ours
+    task_code local_code = TASK_CODE_INVALID;
+    if (fields & CHF_RPC_NAME) {
+        local_code = task_code::try_get(h.rpc_name, TASK_CODE_INVALID);
+        if (rpc_code != 0) {
+            if (rpc_code > COMPACT_HDR_MAX_RPC_CODE)
+                return false;
+            if (rpc_code >= _remote_rpc_codes.size())
+                _remote_rpc_codes.resize(rpc_code + 1);
+            _remote_rpc_codes[rpc_code].name = h.rpc_name;
+            _remote_rpc_codes[rpc_code].local_code = local_code;
+        }
+    } else {
+        if (rpc_code >= _remote_rpc_codes.size() || _remote_rpc_codes[rpc_code].name.empty()) {
+            derror("unknown rpc code %" PRIu64 " in dsn compact message header", rpc_code);
+            return false;
+        }
+        const remote_rpc_code &rc = _remote_rpc_codes[rpc_code];
+        strncpy(h.rpc_name, rc.name.c_str(), sizeof(h.rpc_name) - 1);
+        local_code = rc.local_code;
+    }
+    if (local_code != TASK_CODE_INVALID) {
+        h.rpc_code.local_code = local_code;
+        h.rpc_code.local_hash = message_ex::s_local_hash;
+    }
+
+    // the error name is omitted for successful responses
+    if (!(fields & CHF_ERROR_NAME) && !h.context.u.is_request) {
+        strncpy(h.server.error_name, ERR_OK.to_string(), sizeof(h.server.error_name) - 1);
+        h.server.error_code.local_code = ERR_OK;
+        h.server.error_code.local_hash = message_ex::s_local_hash;
+    }
+    return true;
+}
+
+blob dsn_message_parser::build_compact_header(message_ex *msg, const blob *lz_body)
+{
+    const message_header &h = *msg->header;
+
+    uint32_t rpc_code = 0;
+    if (h.rpc_code.local_hash == message_ex::s_local_hash && h.rpc_code.local_code != 0 &&
+        h.rpc_code.local_code <= COMPACT_HDR_MAX_RPC_CODE) {
+        rpc_code = h.rpc_code.local_code;
+    }
+
+    uint64_t fields = 0;
+    if (h.body_crc32 != CRC_INVALID)
+        fields |= (CHF_HDR_CRC | CHF_BODY_CRC);
+    if (h.trace_id != 0)
+        fields |= CHF_TRACE_ID;
+    if (h.gpid.value() != 0)
+        fields |= CHF_GPID;
+    if (h.from_address.type() == HOST_TYPE_IPV4)
+        fields |= CHF_FROM_ADDRESS;
+    if (h.client.timeout_ms != 0)
+        fields |= CHF_TIMEOUT;
+    if (h.client.thread_hash != 0)
+        fields |= CHF_THREAD_HASH;
+    if (h.client.partition_hash != 0)
+        fields |= CHF_PARTITION_HASH;
+    if (rpc_code == 0) {
+        fields |= CHF_RPC_NAME;
+    } else {
+        if (rpc_code >= _announced_rpc_codes.size())
+            _announced_rpc_codes.resize(rpc_code + 1, false);
+        if (!_announced_rpc_codes[rpc_code]) {
+            _announced_rpc_codes[rpc_code] = true;
+            fields |= CHF_RPC_NAME;
+        }
+    }
+    if (h.server.error_name[0] != '\0' && strcmp(h.server.error_name, ERR_OK.to_string()) != 0)
+        fields |= CHF_ERROR_NAME;
+    if (lz_body != nullptr)
+        fields |= CHF_LZ_BODY;
+    if (!_lz_capability_announced) {
+        _lz_capability_announced = true;
+        fields |= CHF_LZ_CAPABLE;
+    }
+
+    // large enough for all the fields, see dsn_message_parser.h
+    char hdr[256];
+    char *p = hdr;
+    p = write_fixed(p, *(uint32_t *)"RDSN");
+    p = write_fixed(p, COMPACT_HDR_VERSION);
+    p = write_fixed(p, static_cast<uint8_t>(0)); // hdr_length, set below
+    p = write_varint(p, fields);
+    char *crc_ptr = p;
+    if (fields & CHF_HDR_CRC)
+        p = write_fixed(p, static_cast<uint32_t>(0)); // hdr_crc32, set below
+    p = write_varint(p, lz_body != nullptr ? lz_body->length() : h.body_length);
+    p = write_varint(p, h.id);
+    p = write_varint(p, rpc_code);
+    p = write_varint(p, h.context.context);
+    if (fields & CHF_BODY_CRC)
+        p = write_fixed(p, h.body_crc32);
+    if (fields & CHF_TRACE_ID)
+        p = write_varint(p, h.trace_id);
+    if (fields & CHF_GPID) {
+        p = write_varint(p, static_cast<uint32_t>(h.gpid.get_app_id()));
+        p = write_varint(p, static_cast<uint32_t>(h.gpid.get_partition_index()));
+    }
+    if (fields & CHF_FROM_ADDRESS) {
+        p = write_fixed(p, h.from_address.ip());
+        p = write_fixed(p, h.from_address.port());
+    }
+    if (fields & CHF_TIMEOUT)
+        p = write_varint(p, zigzag_encode(h.client.timeout_ms));
+    if (fields & CHF_THREAD_HASH)
+        p = write_varint(p, zigzag_encode(h.client.thread_hash));
+    if (fields & CHF_PARTITION_HASH)
+        p = write_varint(p, h.client.partition_hash);
+    if (fields & CHF_RPC_NAME)
+        p = write_name(p, h.rpc_name);
+    if (fields & CHF_ERROR_NAME)
+        p = write_name(p, h.server.error_name);
+    if (fields & CHF_LZ_BODY)
+        p = write_varint(p, h.body_length);
+
+    size_t hdr_length = p - hdr;
+    dassert(hdr_length <= UINT8_MAX, "compact header too long: %d", (int)hdr_length);
+    hdr[5] = static_cast<char>(hdr_length);
+    if (fields & CHF_HDR_CRC) {
+        write_fixed(crc_ptr, dsn::utils::crc32_calc(hdr, hdr_length, 0));
+    }
+
+    std::shared_ptr<char> buffer(dsn::utils::make_shared_array<char>(hdr_length));
+    memcpy(buffer.get(), hdr, hdr_length);
+    return blob(std::move(buffer), static_cast<unsigned int>(hdr_length));
+}
+
 void dsn_message_parser::prepare_on_send(message_ex *msg)
 {
     auto &header = msg->header;
@@ -112,6 +582,10 @@ void dsn_message_parser::prepare_on_send(message_ex *msg)
     dassert(len == (size_t)header->body_length + sizeof(message_header), "data length is wrong");
 #endif
 
+    header->hdr_version = (_attached && compact_header_enabled())
+                              ? (FULL_HDR_VERSION_COMPACT_CAPABLE | FULL_HDR_VERSION_LZ_CAPABLE)
+                              : 0;
+
     if (task_spec::get(msg->local_rpc_code)->rpc_message_crc_required) {
         // compute data crc if necessary (only once for the first time)
         if (header->body_crc32 == CRC_INVALID) {
@@ -141,28 +615,102 @@ void dsn_message_parser::prepare_on_send(message_ex *msg)
             header->body_crc32 = crc32;
         }
 
-        // always compute header crc
+        // always compute header crc, unless a compact header is to be sent which carries its
+        // own crc (the peer never switches back to full headers)
         header->hdr_crc32 = CRC_INVALID;
-        header->hdr_crc32 = dsn::utils::crc32_calc(header, sizeof(message_header), 0);
+        if (!_peer_reads_compact.load(std::memory_order_acquire)) {
+            header->hdr_crc32 = dsn::utils::crc32_calc(header, sizeof(message_header), 0);
+        }
+    }
+
+    // compress the body here rather than in get_buffers_on_send(), which holds the session lock.
+    // a peer reading compressed bodies reads compact headers as well, which carry the raw size
+    blob lz_body;
+    uint32_t min_lz_size =
+        static_cast<uint32_t>(task_spec::get(msg->local_rpc_code)->rpc_message_compress_min_bytes);
+    if (min_lz_size > 0 && header->body_length >= min_lz_size &&
+        header->body_length <= lz_body_max_raw_size() &&
+        _peer_reads_lz.load(std::memory_order_acquire) &&
+        _peer_reads_compact.load(std::memory_order_acquire)) {
+        // the bodies are compressed one by one, without being copied together first
+        std::vector<blob> bodies;
+        bodies.reserve(buffers.size());
+        unsigned int offset = sizeof(message_header);
+        for (auto &buf : buffers) {
+            if (offset >= buf.length()) {
+                offset -= buf.length();
+                continue;
+            }
+            bodies.push_back(buf.range(offset));
+            offset = 0;
+        }
+
+        if (!dsn::utils::lz_compress(bodies.data(), (int)bodies.size(), lz_body)) {
+            lz_body = blob();
+        }
     }
+
+    // kept on the message, so that it is released with the message if never sent, and the one
+    // compressed for the last sending (if not taken yet) is replaced
+    msg->lz_body = std::move(lz_body);
 }
 
 int dsn_message_parser::get_buffer_count_on_send(message_ex *msg)
 {
-    return (int)msg->buffers.size();
+    // one more for the compact header (and the compressed body is sent instead of the others)
+    return (int)msg->buffers.size() + (_attached ? 1 : 0);
 }
 
 int dsn_message_parser::get_buffers_on_send(message_ex *msg, /*out*/ send_buf *buffers)
 {
-    int i = 0;
-    for (auto &buf : msg->buffers) {
-        buffers[i].buf = (void *)buf.data();
-        buffers[i].sz = buf.length();
+    auto &msg_buffers = msg->buffers;
+
+    blob lz_body = std::move(msg->lz_body);
+
+    if (!_peer_reads_compact.load(std::memory_order_acquire)) {
+        int i = 0;
+        for (auto &buf : msg_buffers) {
+            buffers[i].buf = (void *)buf.data();
+            buffers[i].sz = buf.length();
+            ++i;
+        }
+        return i;
+    }
+
+    // the compact header is built here rather than in prepare_on_send() because rpc codes
+    // must be announced by name in the same order as the messages are sent
+    bool lz = (lz_body.length() > 0);
+    _sending_blobs.emplace_back(build_compact_header(msg, lz ? &lz_body : nullptr));
+
+    blob &header_bb = _sending_blobs.back();
+    buffers[0].buf = (void *)header_bb.data();
+    buffers[0].sz = header_bb.length();
+
+    if (lz) {
+        buffers[1].buf = (void *)lz_body.data();
+        buffers[1].sz = lz_body.length();
+        _sending_blobs.emplace_back(std::move(lz_body));
+        return 2;
+    }
+
+    // skip the full header
+    int i = 1;
+    unsigned int offset = sizeof(message_header);
+    for (auto &buf : msg_buffers) {
+        if (offset >= buf.length()) {
+            offset -= buf.length();
+            continue;
+        }
+        buffers[i].buf = (void *)(buf.data() + offset);
+        buffers[i].sz = buf.length() - offset;
+        offset = 0;
         ++i;
     }
     return i;
 }
 
+void dsn_message_parser::on_buffers_sent() { _sending_blobs.clear(); }
+
 /*static*/ bool dsn_message_parser::is_right_header(char *hdr)
 {
     uint32_t *pcrc = reinterpret_cast<uint32_t *>(hdr + FIELD_OFFSET(message_header, hdr_crc32));
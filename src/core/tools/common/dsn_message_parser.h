@@ -38,16 +38,47 @@
 #include <dsn/tool-api/message_parser.h>
 #include <dsn/tool-api/rpc_message.h>
 #include <dsn/utility/ports.h>
+#include <atomic>
+#include <string>
+#include <vector>
 
 namespace dsn {
+// dsn messages start with the "RDSN" signature and come with one of two headers:
+//
+// - full header: the message_header struct as laid out in memory. its hdr_version is a set of
+//   what the sender can read: 1 for compact headers, 2 for compressed bodies, or 0 for legacy
+//   senders.
+//
+// - compact header (version 2), used on a connection only after the peer has shown that it
+//   reads compact headers, i.e., after a full header of version 1 or a compact header has been
+//   received from it:
+//
+//     "RDSN" <version(u8) = 2> <hdr_length(u8)> <fields> [hdr_crc32(u32)]
+//     <body_length> <id> <rpc_code> <context> [body_crc32(u32)] [trace_id]
+//     [<app_id> <partition_index>] [from_ip(u32) from_port(u16)] [timeout_ms]
+//     [thread_hash(zigzag)] [partition_hash] [rpc_name(u8 length + chars)]
+//     [error_name(u8 length + chars)] [raw_body_length]
+//
+//   <> are varints, and [] parts are present only if their bits are set in <fields>.
+//   rpc_code is the numeric task code of the sender, whose name is sent along only the first
+//   time the code is used on the connection, and the error name is sent only on failure.
+//   the first compact header on a connection also tells whether its sender reads compressed
+//   bodies.
+//
+// a body is compressed by utils::lz_compress() when it is sent in a compact message to a peer
+// which reads compressed bodies, and it is not smaller than rpc_message_compress_min_bytes of
+// its task code. body_length is the size on the wire then, raw_body_length the size before
+// compression, and body_crc32 is always calculated over the raw body.
 class dsn_message_parser : public message_parser
 {
 public:
-    dsn_message_parser() : _header_checked(false) {}
+    dsn_message_parser();
     virtual ~dsn_message_parser() {}
 
     virtual void reset() override;
 
+    virtual void on_attached_to_session() override;
+
     virtual message_ex *get_message_on_receive(message_reader *reader,
                                                /*out*/ int &read_next) override;
 
@@ -57,12 +88,46 @@ public:
 
     virtual int get_buffers_on_send(message_ex *msg, /*out*/ send_buf *buffers) override;
 
+    virtual void on_buffers_sent() override;
+
 private:
     static bool is_right_header(char *hdr);
 
     static bool is_right_body(message_ex *msg);
 
+    message_ex *get_compact_message_on_receive(message_reader *reader, /*out*/ int &read_next);
+
+    // parse the compact header into _compact_header
+    bool parse_compact_header(const char *hdr, unsigned int hdr_length);
+
+    // 'lz_body' is the compressed body to be sent instead, or nullptr
+    blob build_compact_header(message_ex *msg, const blob *lz_body);
+
 private:
     bool _header_checked;
+
+    // whether the parser is dedicated to a connection, see on_attached_to_session()
+    bool _attached;
+    // whether the peer can read compact headers and compressed bodies, set by the receiving side
+    std::atomic<bool> _peer_reads_compact;
+    std::atomic<bool> _peer_reads_lz;
+
+    // sending side, only accessed by get_buffers_on_send() which is called in sending order
+    std::vector<bool> _announced_rpc_codes;
+    bool _lz_capability_announced;
+    // compact headers and compressed bodies being sent, released in on_buffers_sent().
+    // they are kept here rather than in msg->buffers, as a message may be prepared for
+    // resending while the buffers of its last sending are still being written.
+    std::vector<blob> _sending_blobs;
+
+    // receiving side
+    message_header _compact_header;    // parsed header of the compact message being received
+    uint32_t _compact_raw_body_length; // raw body length if the body is compressed, or 0
+    struct remote_rpc_code
+    {
+        std::string name;
+        task_code local_code;
+    };
+    std::vector<remote_rpc_code> _remote_rpc_codes; // indexed by the rpc code of the peer
 };
 }
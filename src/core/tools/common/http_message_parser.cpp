@@ -75,15 +75,31 @@ http_message_parser::http_message_parser()
 
         dinfo("http call %s", url.c_str());
 
+        auto owner = static_cast<http_message_parser *>(parser->data);
+        auto &hdr = owner->_current_message->header;
+
+        // monitor scrapers: /metrics for prometheus text, /metrics/json for json
+        if (args.size() >= 1 && args.size() <= 2 && args[0] == "metrics") {
+            const char *rpc_name = nullptr;
+            if (args.size() == 1)
+                rpc_name = "RPC_HTTP_METRICS";
+            else if (args[1] == "json")
+                rpc_name = "RPC_HTTP_METRICS_JSON";
+            else {
+                derror("invalid metrics format in url %s", url.c_str());
+                return 1;
+            }
+            strcpy(hdr->rpc_name, rpc_name);
+            hdr->context.u.serialize_format = DSF_THRIFT_JSON;
+            return 0;
+        }
+
         if (args.size() != 3) {
             dinfo("skip url parse for %s, could be done in headers if not cross-domain",
                   url.c_str());
             return 0;
         }
 
-        auto owner = static_cast<http_message_parser *>(parser->data);
-        auto &hdr = owner->_current_message->header;
-
         // serialize-type
         dsn_msg_serialize_format fmt = enum_from_string(args[0].c_str(), DSF_INVALID);
         if (fmt == DSF_INVALID) {
@@ -298,6 +314,19 @@ http_message_parser::http_message_parser()
         owner->_received_messages.emplace(std::move(owner->_current_message));
         return 0;
     };
+    _parser_setting.on_message_complete = [](http_parser *parser) -> int {
+        // messages without body are not emitted in on_body, of which only the metrics requests
+        // are served, any other one is dropped as before
+        auto owner = static_cast<http_message_parser *>(parser->data);
+        if (owner->_current_message != nullptr &&
+            owner->_current_message->header->context.u.is_request &&
+            (strcmp(owner->_current_message->header->rpc_name, "RPC_HTTP_METRICS") == 0 ||
+             strcmp(owner->_current_message->header->rpc_name, "RPC_HTTP_METRICS_JSON") == 0)) {
+            owner->_current_message->header->body_length = 0;
+            owner->_received_messages.emplace(std::move(owner->_current_message));
+        }
+        return 0;
+    };
     http_parser_init(&_parser, HTTP_BOTH);
 }
 
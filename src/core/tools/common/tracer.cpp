@@ -36,6 +36,8 @@
 #include <dsn/toollet/tracer.h>
 #include <dsn/utility/filesystem.h>
 #include <dsn/tool-api/command_manager.h>
+#include <fstream>
+#include <iomanip>
 
 namespace dsn {
 namespace tools {
@@ -285,6 +287,348 @@ static std::string tracer_log_flow(const std::vector<std::string> &args)
     return "Not implemented";
 }
 
+// ---------------------- sampled spans ----------------------
+//
+// for one in every `span_sample_ratio` trace ids, the enqueue/dequeue/exec timestamps of all
+// the tasks in the trace, as well as the rpc and aio operations they issue, are recorded into
+// a per-thread ring, so that a slow request can be followed across client, primary and
+// secondaries. "tracer.spans" dumps the rings in chrome trace format (chrome://tracing).
+//
+enum span_event_type
+{
+    SET_TASK_EXEC,
+    SET_AIO,
+    SET_RPC_CALL,
+    SET_RPC_REQUEST_ENQUEUE,
+    SET_RPC_REPLY,
+    SET_RPC_RESPONSE_ENQUEUE,
+};
+
+static const char *s_span_event_phases[] = {"X", "X", "i", "i", "i", "i"};
+static const char *s_span_event_categories[] = {
+    "task", "aio", "rpc.call", "rpc.request.enqueue", "rpc.reply", "rpc.response.enqueue"};
+
+struct span_event
+{
+    span_event_type type;
+    const char *name; // from task_spec, never released
+    const char *node;
+    uint64_t trace_id;
+    uint64_t task_id;
+    uint64_t ts_ns;
+    uint64_t dur_ns;
+    uint64_t queue_ns;
+};
+
+struct span_ring
+{
+    ::dsn::utils::ex_lock_nr_spin lock;
+    std::vector<span_event> events;
+    uint64_t count; // total events ever recorded, events[count % size] is the next slot
+    int tid;
+};
+
+// attached to the tasks of sampled traces only
+struct span_context
+{
+    uint64_t trace_id;
+    uint64_t enqueue_ts_ns;
+    uint64_t begin_ts_ns;
+    uint64_t aio_call_ts_ns;
+};
+
+typedef object_extension_helper<span_context, task> task_ext_for_span;
+
+static uint64_t s_span_sample_ratio = 0;
+static uint32_t s_span_ring_size = 0;
+static ::dsn::utils::ex_lock_nr s_span_rings_lock;
+static std::vector<span_ring *> s_span_rings;
+static __thread span_ring *s_span_ring = nullptr;
+
+static inline bool span_is_sampled(uint64_t trace_id)
+{
+    return trace_id != 0 && trace_id % s_span_sample_ratio == 0;
+}
+
+static void span_record(span_event_type type,
+                        const char *name,
+                        task *tsk,
+                        uint64_t trace_id,
+                        uint64_t ts_ns,
+                        uint64_t dur_ns = 0,
+                        uint64_t queue_ns = 0)
+{
+    span_ring *ring = s_span_ring;
+    if (ring == nullptr) {
+        ring = new span_ring();
+        ring->events.resize(s_span_ring_size);
+        ring->count = 0;
+        ring->tid = ::dsn::utils::get_current_tid();
+
+        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr> l(s_span_rings_lock);
+        s_span_rings.push_back(ring);
+        s_span_ring = ring;
+    }
+
+    ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(ring->lock);
+    span_event &e = ring->events[ring->count++ % ring->events.size()];
+    e.type = type;
+    e.name = name;
+    e.node = task::get_current_node_name();
+    e.trace_id = trace_id;
+    e.task_id = tsk ? tsk->id() : 0;
+    e.ts_ns = ts_ns;
+    e.dur_ns = dur_ns;
+    e.queue_ns = queue_ns;
+}
+
+static void span_attach(task *tsk, uint64_t trace_id)
+{
+    span_context *ctx = task_ext_for_span::get_inited(tsk);
+    ctx->trace_id = trace_id;
+}
+
+static void span_on_task_create(task *caller, task *callee)
+{
+    uint64_t trace_id = 0;
+    switch (callee->spec().type) {
+    case dsn_task_type_t::TASK_TYPE_RPC_REQUEST:
+        trace_id = ((rpc_request_task *)callee)->get_request()->header->trace_id;
+        break;
+    case dsn_task_type_t::TASK_TYPE_RPC_RESPONSE:
+        trace_id = ((rpc_response_task *)callee)->get_request()->header->trace_id;
+        break;
+    default:
+        break;
+    }
+
+    if (span_is_sampled(trace_id)) {
+        span_attach(callee, trace_id);
+    } else if (caller != nullptr) {
+        span_context *ctx = task_ext_for_span::get(caller);
+        if (ctx != nullptr)
+            span_attach(callee, ctx->trace_id);
+    }
+}
+
+static void span_on_task_enqueue(task *caller, task *callee)
+{
+    span_context *ctx = task_ext_for_span::get(callee);
+    if (ctx != nullptr)
+        ctx->enqueue_ts_ns = dsn_now_ns();
+}
+
+static void span_on_task_begin(task *this_)
+{
+    span_context *ctx = task_ext_for_span::get(this_);
+    if (ctx != nullptr)
+        ctx->begin_ts_ns = dsn_now_ns();
+}
+
+static void span_on_task_end(task *this_)
+{
+    span_context *ctx = task_ext_for_span::get(this_);
+    if (ctx == nullptr || ctx->begin_ts_ns == 0)
+        return;
+
+    uint64_t now = dsn_now_ns();
+    span_record(SET_TASK_EXEC,
+                this_->spec().name.c_str(),
+                this_,
+                ctx->trace_id,
+                ctx->begin_ts_ns,
+                now - ctx->begin_ts_ns,
+                ctx->enqueue_ts_ns == 0 ? 0 : ctx->begin_ts_ns - ctx->enqueue_ts_ns);
+}
+
+static void span_on_aio_call(task *caller, aio_task *callee)
+{
+    span_context *ctx = task_ext_for_span::get(callee);
+    if (ctx != nullptr)
+        ctx->aio_call_ts_ns = dsn_now_ns();
+}
+
+static void span_on_aio_enqueue(aio_task *this_)
+{
+    span_context *ctx = task_ext_for_span::get(this_);
+    if (ctx == nullptr || ctx->aio_call_ts_ns == 0)
+        return;
+
+    uint64_t now = dsn_now_ns();
+    ctx->enqueue_ts_ns = now;
+    span_record(SET_AIO,
+                this_->spec().name.c_str(),
+                this_,
+                ctx->trace_id,
+                ctx->aio_call_ts_ns,
+                now - ctx->aio_call_ts_ns);
+}
+
+static void span_on_rpc_call(task *caller, message_ex *req, rpc_response_task *callee)
+{
+    // requests issued from async continuations (e.g., log append callbacks) of a sampled
+    // trace are not covered by rpc_engine::call, so the trace id is carried over here
+    span_context *ctx = caller ? task_ext_for_span::get(caller) : nullptr;
+    if (ctx != nullptr) {
+        req->header->trace_id = ctx->trace_id;
+    } else if (!span_is_sampled(req->header->trace_id)) {
+        return;
+    }
+
+    uint64_t trace_id = req->header->trace_id;
+    if (callee != nullptr && task_ext_for_span::get(callee) == nullptr)
+        span_attach(callee, trace_id);
+
+    span_record(SET_RPC_CALL,
+                task_spec::get(req->local_rpc_code)->name.c_str(),
+                caller != nullptr ? caller : callee,
+                trace_id,
+                dsn_now_ns());
+}
+
+static void span_on_rpc_request_enqueue(rpc_request_task *callee)
+{
+    uint64_t trace_id = callee->get_request()->header->trace_id;
+    if (!span_is_sampled(trace_id))
+        return;
+
+    // intercepted requests (e.g., replication) are not seen by on_task_create
+    uint64_t now = dsn_now_ns();
+    span_attach(callee, trace_id);
+    task_ext_for_span::get(callee)->enqueue_ts_ns = now;
+    span_record(SET_RPC_REQUEST_ENQUEUE, callee->spec().name.c_str(), callee, trace_id, now);
+}
+
+static void span_on_rpc_reply(task *caller, message_ex *msg)
+{
+    if (!span_is_sampled(msg->header->trace_id))
+        return;
+
+    span_record(SET_RPC_REPLY,
+                task_spec::get(msg->local_rpc_code)->name.c_str(),
+                caller,
+                msg->header->trace_id,
+                dsn_now_ns());
+}
+
+static void span_on_rpc_response_enqueue(rpc_response_task *resp)
+{
+    span_context *ctx = task_ext_for_span::get(resp);
+    if (ctx == nullptr)
+        return;
+
+    uint64_t now = dsn_now_ns();
+    ctx->enqueue_ts_ns = now;
+    span_record(SET_RPC_RESPONSE_ENQUEUE, resp->spec().name.c_str(), resp, ctx->trace_id, now);
+}
+
+static std::string tracer_dump_spans(const std::vector<std::string> &args)
+{
+    // tracer.spans [output_file]
+    std::string fpath;
+    if (args.size() > 0) {
+        fpath = args[0];
+    } else {
+        std::stringstream ss;
+        ss << "spans." << dsn_now_ns() << ".json";
+        fpath = utils::filesystem::path_combine(tools::spec().data_dir, ss.str());
+    }
+
+    std::ofstream out(fpath, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        return std::string("open ") + fpath + " failed";
+    }
+
+    std::vector<span_ring *> rings;
+    {
+        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr> l(s_span_rings_lock);
+        rings = s_span_rings;
+    }
+
+    char buffer[64];
+    uint64_t total = 0;
+    out << "{\"traceEvents\":[";
+    for (span_ring *ring : rings) {
+        std::vector<span_event> events;
+        {
+            ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(ring->lock);
+            uint64_t size = ring->events.size();
+            uint64_t begin = ring->count > size ? ring->count - size : 0;
+            for (uint64_t i = begin; i < ring->count; i++)
+                events.push_back(ring->events[i % size]);
+        }
+
+        for (auto &e : events) {
+            out << (total++ == 0 ? "\n" : ",\n");
+            out << "{\"name\":\"" << e.name << "\",\"cat\":\"" << s_span_event_categories[e.type]
+                << "\",\"ph\":\"" << s_span_event_phases[e.type] << "\",\"ts\":"
+                << e.ts_ns / 1000 << "." << std::setw(3) << std::setfill('0') << e.ts_ns % 1000
+                << std::setfill(' ');
+            if (e.type == SET_TASK_EXEC || e.type == SET_AIO)
+                out << ",\"dur\":" << e.dur_ns / 1000;
+            else
+                out << ",\"s\":\"t\"";
+            out << ",\"pid\":\"" << e.node << "\",\"tid\":" << ring->tid;
+            sprintf(buffer, "%016" PRIx64, e.trace_id);
+            out << ",\"args\":{\"trace_id\":\"" << buffer << "\"";
+            sprintf(buffer, "%016" PRIx64, e.task_id);
+            out << ",\"task_id\":\"" << buffer << "\"";
+            if (e.type == SET_TASK_EXEC)
+                out << ",\"queue_us\":" << e.queue_ns / 1000;
+            out << "}}";
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+
+    std::stringstream ss;
+    ss << total << " span events are dumped to " << fpath;
+    return ss.str();
+}
+
+static void install_span_tracer()
+{
+    s_span_sample_ratio =
+        dsn_config_get_value_uint64("tools.tracer",
+                                    "span_sample_ratio",
+                                    0,
+                                    "record spans for one in every this many trace ids, 0 to "
+                                    "disable");
+    if (s_span_sample_ratio == 0)
+        return;
+
+    s_span_ring_size = (uint32_t)dsn_config_get_value_uint64(
+        "tools.tracer", "span_ring_size", 8192, "max span events kept per thread");
+    dassert(s_span_ring_size > 0, "span_ring_size must be positive");
+
+    task_ext_for_span::register_ext([](void *ctx) { delete (span_context *)ctx; });
+
+    for (int i = 0; i <= dsn::task_code::max(); i++) {
+        if (i == TASK_CODE_INVALID)
+            continue;
+
+        task_spec *spec = task_spec::get(i);
+        dassert(spec != nullptr, "task_spec cannot be null");
+
+        spec->on_task_create.put_back(span_on_task_create, "tracer.span");
+        spec->on_task_enqueue.put_back(span_on_task_enqueue, "tracer.span");
+        spec->on_task_begin.put_back(span_on_task_begin, "tracer.span");
+        spec->on_task_end.put_back(span_on_task_end, "tracer.span");
+        spec->on_aio_call.put_back(span_on_aio_call, "tracer.span");
+        spec->on_aio_enqueue.put_back(span_on_aio_enqueue, "tracer.span");
+        spec->on_rpc_call.put_back(span_on_rpc_call, "tracer.span");
+        spec->on_rpc_request_enqueue.put_back(span_on_rpc_request_enqueue, "tracer.span");
+        spec->on_rpc_reply.put_back(span_on_rpc_reply, "tracer.span");
+        spec->on_rpc_response_enqueue.put_back(span_on_rpc_response_enqueue, "tracer.span");
+    }
+
+    command_manager::instance().register_command(
+        {"tracer.spans"},
+        "tracer.spans - dump sampled spans in chrome trace format",
+        "tracer.spans [output_file], default output_file is ${data_dir}/spans.${now_ns}.json",
+        tracer_dump_spans);
+}
+
 void tracer::install(service_spec &spec)
 {
     auto trace = dsn_config_get_value_bool(
@@ -400,6 +744,8 @@ void tracer::install(service_spec &spec)
         "tracer.find forward|f|backward|b rpc|r|task|t trace_id|task_id(e.g., "
         "a023003920302390) log_file_name(log.xx.txt)",
         tracer_log_flow);
+
+    install_span_tracer();
 }
 
 tracer::tracer(const char *name) : toollet(name) {}
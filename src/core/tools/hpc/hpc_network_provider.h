@@ -51,6 +51,7 @@ typedef int socket_t;
 
 #include <dsn/tool_api.h>
 #include "io_looper.h"
+#include <atomic>
 
 namespace dsn {
 namespace tools {
@@ -114,7 +115,16 @@ public:
 #endif
     }
 
+#ifdef _WIN32
     virtual void close_on_fault_injection() override { close(); }
+#else
+    // the shutdown fails the session, which then closes the socket
+    virtual void close_on_fault_injection() override { ::shutdown(_socket, SHUT_RDWR); }
+#endif
+
+#ifndef _WIN32
+    virtual ~hpc_rpc_session();
+#endif
 
     void bind_looper(io_looper *looper, bool delay = false);
     virtual void do_read(int read_next) override;
@@ -144,14 +154,30 @@ protected:
     struct sockaddr_in _peer_addr;
     io_looper *_looper;
 
-    // due to the bad design of EPOLLET, we need to
-    // use locks to avoid concurrent send/recv
-    ::dsn::utils::ex_lock_nr _send_lock;
-    ::dsn::utils::ex_lock_nr _recv_lock;
+    // edge-triggered events of one socket may be delivered to different looper threads
+    // concurrently, so each direction is owned by its own lock: a large outgoing message
+    // never blocks parsing of incoming ones, and vice versa
+    ::dsn::utils::ex_lock_nr _send_lock; // guards the write side
+    ::dsn::utils::ex_lock_nr _recv_lock; // guards the read side, i.e., _reader and _parser
+
+    // preallocated block used as the second iovec of readv, so that one call drains
+    // more of the socket when the tail of the current read buffer is small
+    std::unique_ptr<char[]> _read_spare_block;
+
+    // messages parsed from one read, dispatched with on_recv_messages
+    std::vector<message_ex *> _recv_batch;
+
+    // set by the first on_failure, as both sides may fail concurrently
+    std::atomic<bool> _failed;
+    // set by close() after the socket is shut down, then the handle can be released
+    std::atomic<bool> _closed;
 
     void on_connect_events_ready(uintptr_t lolp_or_events);
     void on_send_recv_events_ready(uintptr_t lolp_or_events);
     void do_safe_write(uint64_t signature);
+    void read_socket(int read_next);
+    bool parse_read_buffer(int &read_next);
+    void release_socket();
 #endif
 };
 }
@@ -36,6 +36,7 @@
 #ifdef __linux__
 
 #include "hpc_network_provider.h"
+#include <sys/uio.h>
 #include "mix_all_io_looper.h"
 #include <netinet/tcp.h>
 
@@ -196,50 +197,97 @@ void hpc_rpc_session::bind_looper(io_looper *looper, bool delay)
     }
 }
 
+bool hpc_rpc_session::parse_read_buffer(int &read_next)
+{
+    if (!_parser) {
+        read_next = prepare_parser();
+    }
+
+    if (_parser) {
+        message_ex *msg = _parser->get_message_on_receive(&_reader, read_next);
+
+        while (msg != nullptr) {
+            _recv_batch.push_back(msg);
+            msg = _parser->get_message_on_receive(&_reader, read_next);
+        }
+
+        // dispatch all the messages parsed from this read in bulk
+        if (!_recv_batch.empty()) {
+            bool ok = on_recv_messages(_recv_batch.data(), (int)_recv_batch.size(), 0);
+            _recv_batch.clear();
+            if (!ok) {
+                on_failure(false);
+                return false;
+            }
+        }
+    }
+
+    if (read_next == -1) {
+        derror("(s = %d) recv failed on %s, parse failed", _socket, _remote_addr.to_string());
+        on_failure();
+        return false;
+    }
+    return true;
+}
+
 void hpc_rpc_session::do_read(int read_next)
 {
-    utils::auto_lock<utils::ex_lock_nr> l(_send_lock);
+    _recv_lock.lock();
+    if (-1 != _socket) {
+        read_socket(read_next);
+    }
+    _recv_lock.unlock();
+
+    // the socket is released by the side leaving last after the session is closed
+    release_socket();
+}
+
+// should always be called with _recv_lock held
+void hpc_rpc_session::read_socket(int read_next)
+{
+    if (_read_spare_block == nullptr) {
+        _read_spare_block.reset(new char[_reader._buffer_block_size]);
+    }
 
     while (true) {
         char *ptr = _reader.read_buffer_ptr(read_next);
         int remaining = _reader.read_buffer_capacity();
 
-        int length = recv(_socket, ptr, remaining, 0);
+        struct iovec iov[2];
+        iov[0].iov_base = ptr;
+        iov[0].iov_len = remaining;
+        iov[1].iov_base = _read_spare_block.get();
+        iov[1].iov_len = _reader._buffer_block_size;
+
+        int length = readv(_socket, iov, 2);
         int err = errno;
-        dinfo("(s = %d) call recv on %s, return %d, err = %s",
+        dinfo("(s = %d) call readv on %s, return %d, err = %s",
               _socket,
               _remote_addr.to_string(),
               length,
               strerror(err));
 
         if (length > 0) {
-            _reader.mark_read(length);
-
-            if (!_parser) {
-                read_next = prepare_parser();
-            }
-
-            if (_parser) {
-                message_ex *msg = _parser->get_message_on_receive(&_reader, read_next);
-
-                while (msg != nullptr) {
-                    this->on_read_completed(msg);
-                    msg = _parser->get_message_on_receive(&_reader, read_next);
-                }
-            }
-
-            if (read_next == -1) {
-                derror(
-                    "(s = %d) recv failed on %s, parse failed", _socket, _remote_addr.to_string());
-                on_failure();
+            int spilled = length > remaining ? length - remaining : 0;
+            _reader.mark_read(length - spilled);
+            if (!parse_read_buffer(read_next))
                 break;
+
+            // the spare block is reused, so what is spilled into it is moved into the
+            // read buffer after the completed messages have been cut off above
+            if (spilled > 0) {
+                ptr = _reader.read_buffer_ptr(spilled);
+                memcpy(ptr, _read_spare_block.get(), spilled);
+                _reader.mark_read(spilled);
+                if (!parse_read_buffer(read_next))
+                    break;
             }
         } else {
-            if (err != EAGAIN && err != EWOULDBLOCK) {
+            if (length == 0 || (err != EAGAIN && err != EWOULDBLOCK)) {
                 derror("(s = %d) recv failed on %s, err = %s",
                        _socket,
                        _remote_addr.to_string(),
-                       strerror(err));
+                       length == 0 ? "closed by peer" : strerror(err));
                 on_failure();
             }
             break;
@@ -249,19 +297,25 @@ void hpc_rpc_session::do_read(int read_next)
 
 void hpc_rpc_session::do_safe_write(uint64_t sig)
 {
-    utils::auto_lock<utils::ex_lock_nr> l(_send_lock);
-
-    if (0 == sig) {
-        if (_sending_signature) {
-            do_write(_sending_signature);
+    {
+        utils::auto_lock<utils::ex_lock_nr> l(_send_lock);
+
+        if (-1 == _socket) {
+            // released after the session is closed
+        } else if (0 == sig) {
+            if (_sending_signature) {
+                do_write(_sending_signature);
+            } else {
+                _send_lock.unlock(); // avoid recursion
+                on_send_completed(); // send next msg if there is.
+                _send_lock.lock();
+            }
         } else {
-            _send_lock.unlock(); // avoid recursion
-            on_send_completed(); // send next msg if there is.
-            _send_lock.lock();
+            do_write(sig);
         }
-    } else {
-        do_write(sig);
     }
+
+    release_socket();
 }
 
 void hpc_rpc_session::do_write(uint64_t sig)
@@ -345,7 +399,41 @@ void hpc_rpc_session::do_write(uint64_t sig)
     }
 }
 
+// only called once by on_failure, so the socket is not released by others till here
 void hpc_rpc_session::close()
+{
+    if (-1 != _socket) {
+        ::shutdown(_socket, SHUT_RDWR);
+        dinfo("(s = %d) shutdown socket %p", _socket, this);
+    }
+
+    _closed = true;
+    release_socket();
+}
+
+void hpc_rpc_session::release_socket()
+{
+    // the read and write sides may still be working on the socket concurrently, so the
+    // handle is released only when neither of them holds its lock, to avoid a reused
+    // handle being touched by the other side; otherwise the one leaving last releases it
+    if (!_closed.load()) {
+        return;
+    }
+
+    if (_recv_lock.try_lock()) {
+        if (_send_lock.try_lock()) {
+            if (-1 != _socket) {
+                ::close(_socket);
+                dinfo("(s = %d) close socket %p", _socket, this);
+                _socket = -1;
+            }
+            _send_lock.unlock();
+        }
+        _recv_lock.unlock();
+    }
+}
+
+hpc_rpc_session::~hpc_rpc_session()
 {
     if (-1 != _socket) {
         ::close(_socket);
@@ -399,6 +487,8 @@ hpc_rpc_session::hpc_rpc_session(socket_t sock,
     _sending_signature = 0;
     _sending_buffer_start_index = 0;
     _looper = nullptr;
+    _failed = false;
+    _closed = false;
 
     memset((void *)&_peer_addr, 0, sizeof(_peer_addr));
     _peer_addr.sin_family = AF_INET;
@@ -477,7 +567,15 @@ void hpc_rpc_session::on_connect_events_ready(uintptr_t lolp_or_events)
 
 void hpc_rpc_session::on_failure(bool is_write)
 {
-    _looper->unbind_io_handle((dsn_handle_t)(intptr_t)_socket, &_ready_event);
+    // the read side (under _recv_lock) and the write side may fail at the same time, and
+    // only the first one unbinds the socket and disconnects the session
+    if (_failed.exchange(true)) {
+        return;
+    }
+
+    if (_socket != -1) {
+        _looper->unbind_io_handle((dsn_handle_t)(intptr_t)_socket, &_ready_event);
+    }
     if (on_disconnected(is_write))
         close();
 }
@@ -35,31 +35,148 @@
 
 #include "hpc_task_queue.h"
 #include <boost/function_output_iterator.hpp>
+#include <algorithm>
 
 namespace dsn {
 namespace tools {
+void adaptive_waiter::init(task_queue *q)
+{
+    const threadpool_spec &spec = q->pool_spec();
+    _max_spin = spec.worker_spin_count;
+    _yield_count = spec.worker_yield_count;
+    _spin_limit.store(_max_spin, std::memory_order_relaxed);
+    if (!enabled())
+        return;
+
+    const char *app = get_service_node_name(q->node());
+    const std::string &name = q->get_name();
+    _spin_hit_count.init_global_counter(app,
+                                        "engine",
+                                        (name + ".spin.hit.count").c_str(),
+                                        COUNTER_TYPE_RATE,
+                                        "idle waits which found work by spinning");
+    _park_count.init_global_counter(app,
+                                    "engine",
+                                    (name + ".park.count").c_str(),
+                                    COUNTER_TYPE_RATE,
+                                    "idle waits which parked the worker");
+    _spin_time_ns.init_global_counter(app,
+                                      "engine",
+                                      (name + ".spin.time(ns)").c_str(),
+                                      COUNTER_TYPE_RATE,
+                                      "cpu time spent on spinning and yielding");
+    _wakeup_latency_ns.init_global_counter(app,
+                                           "engine",
+                                           (name + ".wakeup.latency(ns)").c_str(),
+                                           COUNTER_TYPE_NUMBER_PERCENTILES,
+                                           "latency from waking a parked worker to it running");
+}
+
+/*static*/ int adaptive_waiter::next_spin_limit(bool found,
+                                                 int limit,
+                                                 int max_spin,
+                                                 /*inout*/ std::atomic<int> &park_streak)
+{
+    if (max_spin <= 0)
+        return 0;
+
+    if (found) {
+        park_streak.store(0, std::memory_order_relaxed);
+        return std::min(max_spin, limit * 2 + 1);
+    }
+
+    if (park_streak.fetch_add(1, std::memory_order_relaxed) + 1 >= reprobe_parks) {
+        park_streak.store(0, std::memory_order_relaxed);
+        return max_spin;
+    }
+    return std::max(1, limit / 2);
+}
+
+void adaptive_waiter::on_spin_done(bool found, int limit, uint64_t spin_ns)
+{
+    _spin_limit.store(next_spin_limit(found, limit, _max_spin, _park_streak),
+                      std::memory_order_relaxed);
+    if (found)
+        _spin_hit_count->increment();
+    else
+        _park_count->increment();
+    _spin_time_ns->add(spin_ns);
+}
+
+void adaptive_waiter::on_wakeup()
+{
+    uint64_t notify_ns = _notify_ns.load(std::memory_order_relaxed);
+    uint64_t now_ns = dsn_now_ns();
+    if (notify_ns != 0 && now_ns > notify_ns)
+        _wakeup_latency_ns->set(now_ns - notify_ns);
+}
+
 hpc_task_queue::hpc_task_queue(task_worker_pool *pool, int index, task_queue *inner_provider)
-    : task_queue(pool, index, inner_provider)
+    : task_queue(pool, index, inner_provider), _pending(0), _parked(0)
 {
+    _waiter.init(this);
 }
 
 void hpc_task_queue::enqueue(task *task)
 {
     dassert(task->next == nullptr, "task is not alone");
+    bool wakeup;
     {
         utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(_lock);
         _tasks.add(task);
+        _pending.fetch_add(1, std::memory_order_release);
+        wakeup = (_parked > 0);
+    }
+
+    if (wakeup) {
+        if (_waiter.enabled())
+            _waiter.on_notify();
+        _cond.notify_one();
     }
-    _cond.notify_one();
+}
+
+void hpc_task_queue::enqueue_bulk(task **tasks, int count)
+{
+    int parked;
+    {
+        utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(_lock);
+        for (int i = 0; i < count; i++) {
+            dassert(tasks[i]->next == nullptr, "task is not alone");
+            _tasks.add(tasks[i]);
+        }
+        _pending.fetch_add(count, std::memory_order_release);
+        parked = _parked;
+    }
+
+    if (parked == 0)
+        return;
+
+    if (_waiter.enabled())
+        _waiter.on_notify();
+    if (count == 1 || parked == 1 || !is_shared())
+        _cond.notify_one();
+    else
+        _cond.notify_all();
 }
 
 task *hpc_task_queue::dequeue(/*inout*/ int &batch_size)
 {
     task *t;
 
+    if (_waiter.enabled() && _pending.load(std::memory_order_acquire) == 0) {
+        _waiter.spin([this]() { return _pending.load(std::memory_order_acquire) > 0; });
+    }
+
     _lock.lock();
-    _cond.wait(_lock, [=] { return !_tasks.is_empty(); });
+    if (_tasks.is_empty()) {
+        _parked++;
+        _cond.wait(_lock, [=] { return !_tasks.is_empty(); });
+        _parked--;
+        if (_waiter.enabled())
+            _waiter.on_wakeup();
+    }
     t = _tasks.pop_batch(batch_size);
+    _pending.fetch_sub(batch_size, std::memory_order_relaxed);
     _lock.unlock();
 
     return t;
@@ -84,6 +201,22 @@ void hpc_task_priority_queue::enqueue(task *task)
     _sema.signal();
 }
 
+void hpc_task_priority_queue::enqueue_bulk(task **tasks, int count)
+{
+    // requests in one batch usually share the same priority
+    int i = 0;
+    while (i < count) {
+        auto idx = static_cast<int>(tasks[i]->spec().priority);
+        utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(_lock[idx]);
+        for (; i < count && static_cast<int>(tasks[i]->spec().priority) == idx; i++) {
+            dassert(tasks[i]->next == nullptr, "task is not alone");
+            _tasks[idx].add(tasks[i]);
+        }
+    }
+
+    _sema.signal(count);
+}
+
 task *hpc_task_priority_queue::dequeue(/*inout*/ int &batch_size)
 {
     task *t = nullptr;
@@ -109,6 +242,7 @@ hpc_concurrent_task_queue::hpc_concurrent_task_queue(task_worker_pool *pool,
                                                      task_queue *inner_provider)
     : task_queue(pool, index, inner_provider)
 {
+    _waiter.init(this);
 }
 
 void hpc_concurrent_task_queue::enqueue(task *task)
@@ -116,9 +250,28 @@ void hpc_concurrent_task_queue::enqueue(task *task)
     _queues[task->spec().priority].q.enqueue(task);
     _sema.signal(1);
 }
+
+void hpc_concurrent_task_queue::enqueue_bulk(task **tasks, int count)
+{
+    for (int i = 0; i < count; i++) {
+        _queues[tasks[i]->spec().priority].q.enqueue(tasks[i]);
+    }
+    _sema.signal(count);
+}
+
 task *hpc_concurrent_task_queue::dequeue(int &batch_size)
 {
-    batch_size = _sema.waitMany(batch_size);
+    // the semaphore only issues a futex wake when a worker is parked in it, so
+    // spinning on tryWaitMany keeps enqueuers off the syscall as well
+    long acquired = 0;
+    if (_waiter.enabled()) {
+        int max_count = batch_size;
+        _waiter.spin([&]() {
+            acquired = _sema.tryWaitMany(max_count);
+            return acquired > 0;
+        });
+    }
+    batch_size = acquired > 0 ? static_cast<int>(acquired) : _sema.waitMany(batch_size);
     if (batch_size == 0) {
         return nullptr;
     }
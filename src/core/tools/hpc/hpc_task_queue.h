@@ -36,24 +36,105 @@
 #pragma once
 
 #include <dsn/tool_api.h>
+#include <dsn/cpp/perf_counter_wrapper.h>
 #include <condition_variable>
+#include <thread>
 #include <concurrentqueue/concurrentqueue.h>
 #include <concurrentqueue/blockingconcurrentqueue.h>
 
 namespace dsn {
 namespace tools {
+
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// an idle worker first spins with cpu pause, then yields, and only then parks,
+// as configured by worker_spin_count and worker_yield_count. The spin budget
+// doubles when spinning found work and halves when it did not, so busy pools
+// avoid the futex round trip while idle ones quickly fall back to parking.
+class adaptive_waiter
+{
+public:
+    void init(task_queue *q);
+    bool enabled() const { return _max_spin > 0 || _yield_count > 0; }
+
+    // returns true as soon as ready() does, or false when the budget runs out
+    // and the caller should park
+    template <typename TReady>
+    bool spin(TReady &&ready)
+    {
+        uint64_t start = dsn_now_ns();
+        int limit = _spin_limit.load(std::memory_order_relaxed);
+        bool found = false;
+        for (int i = 0; i < limit && !found; i++) {
+            found = ready();
+            if (!found)
+                cpu_relax();
+        }
+        for (int i = 0; i < _yield_count && !found; i++) {
+            found = ready();
+            if (!found)
+                std::this_thread::yield();
+        }
+        on_spin_done(found, limit, dsn_now_ns() - start);
+        return found;
+    }
+
+    // called by enqueuers right before waking a parked worker, and by that worker
+    // once it runs again
+    void on_notify() { _notify_ns.store(dsn_now_ns(), std::memory_order_relaxed); }
+    void on_wakeup();
+
+    // the spin budget of the next idle wait: doubled (up to max_spin) after a wait which found
+    // work by spinning, and halved after one which parked, but never below 1 so that a hit can
+    // still grow it back. after reprobe_parks parks in a row the full budget is probed again.
+    static const int reprobe_parks = 64;
+    static int
+    next_spin_limit(bool found, int limit, int max_spin, /*inout*/ std::atomic<int> &park_streak);
+
+private:
+    void on_spin_done(bool found, int limit, uint64_t spin_ns);
+
+private:
+    int _max_spin = 0;
+    int _yield_count = 0;
+    std::atomic<int> _spin_limit{0};
+    std::atomic<int> _park_streak{0};
+    std::atomic<uint64_t> _notify_ns{0};
+
+    perf_counter_wrapper _spin_hit_count;
+    perf_counter_wrapper _park_count;
+    perf_counter_wrapper _spin_time_ns;
+    perf_counter_wrapper _wakeup_latency_ns;
+};
+
 class hpc_task_queue : public task_queue
 {
 public:
     hpc_task_queue(task_worker_pool *pool, int index, task_queue *inner_provider);
 
     void enqueue(task *task) override;
+    void enqueue_bulk(task **tasks, int count) override;
     task *dequeue(/*inout*/ int &batch_size) override;
 
 private:
     utils::ex_lock_nr_spin _lock;
     std::condition_variable_any _cond;
     slist<task> _tasks;
+
+    // _pending mirrors the size of _tasks so that spinning workers need not take _lock,
+    // and _parked (under _lock) lets enqueuers skip the wakeup when nobody sleeps
+    std::atomic<int> _pending;
+    int _parked;
+    adaptive_waiter _waiter;
 };
 
 class hpc_task_priority_queue : public task_queue
@@ -62,6 +143,7 @@ public:
     hpc_task_priority_queue(task_worker_pool *pool, int index, task_queue *inner_provider);
 
     void enqueue(task *task) override;
+    void enqueue_bulk(task **tasks, int count) override;
     task *dequeue(/*inout*/ int &batch_size) override;
 
 private:
@@ -73,6 +155,7 @@ private:
 class hpc_concurrent_task_queue : public task_queue
 {
     moodycamel::details::mpmc_sema::LightweightSemaphore _sema;
+    adaptive_waiter _waiter;
     struct queue_t
     {
         moodycamel::ConcurrentQueue<task *> q;
@@ -82,6 +165,7 @@ public:
     hpc_concurrent_task_queue(task_worker_pool *pool, int index, task_queue *inner_provider);
 
     void enqueue(task *task) override;
+    void enqueue_bulk(task **tasks, int count) override;
 
     task *dequeue(/*inout*/ int &batch_size) override;
 };
@@ -36,6 +36,7 @@
 #include <dsn/dist/failure_detector.h>
 #include <chrono>
 #include <ctime>
+#include <algorithm>
 
 using namespace ::dsn::service;
 
@@ -47,6 +48,10 @@ failure_detector::failure_detector()
     dsn::threadpool_code pool = task_spec::get(LPC_BEACON_CHECK.code())->pool_code;
     task_spec::get(RPC_FD_FAILURE_DETECTOR_PING.code())->pool_code = pool;
     task_spec::get(RPC_FD_FAILURE_DETECTOR_PING_ACK.code())->pool_code = pool;
+    task_spec::get(LPC_BEACON_DEFERRED_PING.code())->pool_code = pool;
+    // beacons from alive workers only renew their leases, so run them on network threads;
+    // on_ping defers the rest to the fd pool, see is_running_inline
+    task_spec::get(RPC_FD_FAILURE_DETECTOR_PING.code())->rpc_request_is_non_blocking = true;
 
     _recent_beacon_fail_count.init_app_counter(
         "eon.failure_detector",
@@ -55,6 +60,7 @@ failure_detector::failure_detector()
         "failure detector beacon fail count in the recent period");
 
     _is_started = false;
+    _worker_wheel_tick = 0;
 }
 
 error_code failure_detector::start(uint32_t check_interval_seconds,
@@ -73,6 +79,17 @@ error_code failure_detector::start(uint32_t check_interval_seconds,
 
     _use_allow_list = use_allow_list;
 
+    {
+        zauto_lock l(_lock);
+        uint32_t interval = std::max(_check_interval_milliseconds, 1u);
+        _worker_wheel.clear();
+        _worker_wheel.resize(_grace_milliseconds / interval + 2);
+        _worker_wheel_tick = now_ms() / interval;
+        for (auto &w : _workers) {
+            schedule_worker_check(w.second);
+        }
+    }
+
     open_service();
 
     // start periodically check job
@@ -104,7 +121,7 @@ error_code failure_detector::stop()
         }
 
         _masters.clear();
-        _workers.clear();
+        clear_worker_records();
     }
 
     if (_check_task != nullptr) {
@@ -260,18 +277,7 @@ void failure_detector::check_all_records()
 
     {
         zauto_lock l(_lock);
-        worker_map::iterator itq = _workers.begin();
-        for (; itq != _workers.end(); itq++) {
-            worker_record &record = itq->second;
-
-            if (record.is_alive != false &&
-                now - record.last_beacon_recv_time > _grace_milliseconds) {
-                expire.push_back(record.node);
-                record.is_alive = false;
-
-                report(record.node, false, false);
-            }
-        }
+        check_worker_records(now, expire);
         /*
          * The worker disconnected event also need to be under protection of the _lock
          */
@@ -281,6 +287,146 @@ void failure_detector::check_all_records()
     }
 }
 
+failure_detector::worker_shard &failure_detector::get_worker_shard(::dsn::rpc_address node)
+{
+    return _worker_shards[std::hash<::dsn::rpc_address>()(node) % WORKER_SHARD_COUNT];
+}
+
+failure_detector::worker_record &failure_detector::add_worker_record(const worker_record &record)
+{
+    auto ret = _workers.insert(std::make_pair(record.node, record));
+    if (ret.second) {
+        worker_shard &shard = get_worker_shard(record.node);
+        utils::auto_write_lock l(shard.lock);
+        shard.records[record.node] = &ret.first->second;
+    }
+    if (ret.first->second.is_alive) {
+        schedule_worker_check(ret.first->second);
+    }
+    return ret.first->second;
+}
+
+void failure_detector::remove_worker_record(::dsn::rpc_address node)
+{
+    worker_shard &shard = get_worker_shard(node);
+    {
+        utils::auto_write_lock l(shard.lock);
+        shard.records.erase(node);
+    }
+    _workers.erase(node);
+}
+
+void failure_detector::clear_worker_records()
+{
+    for (auto &shard : _worker_shards) {
+        utils::auto_write_lock l(shard.lock);
+        shard.records.clear();
+    }
+    _workers.clear();
+    for (auto &slot : _worker_wheel) {
+        slot.clear();
+    }
+}
+
+void failure_detector::schedule_worker_check(worker_record &record)
+{
+    if (_worker_wheel.empty()) {
+        // not started yet, scheduled in start()
+        return;
+    }
+
+    // the lease expires once now > deadline, which is checked at the tick holding the deadline
+    uint64_t interval = std::max(_check_interval_milliseconds, 1u);
+    uint64_t deadline = record.last_beacon_recv_time.load() + _grace_milliseconds;
+    uint64_t tick = std::max(deadline / interval, _worker_wheel_tick + 1);
+    if (record.wheel_tick == tick) {
+        return;
+    }
+
+    record.wheel_tick = tick;
+    _worker_wheel[tick % _worker_wheel.size()].emplace_back(record.node, tick);
+}
+
+void failure_detector::check_worker_records(uint64_t now,
+                                            /*out*/ std::vector<::dsn::rpc_address> &expire)
+{
+    if (_worker_wheel.empty()) {
+        return;
+    }
+
+    uint64_t interval = std::max(_check_interval_milliseconds, 1u);
+    uint64_t current = now / interval;
+    uint64_t first = _worker_wheel_tick + 1;
+    if (current - _worker_wheel_tick > _worker_wheel.size()) {
+        // visit every slot once when checks have been delayed for a whole round
+        first = current - _worker_wheel.size() + 1;
+    }
+
+    std::vector<std::pair<::dsn::rpc_address, uint64_t>> due;
+    for (uint64_t tick = first; tick <= current; tick++) {
+        auto &slot = _worker_wheel[tick % _worker_wheel.size()];
+        for (size_t i = 0; i < slot.size();) {
+            if (slot[i].second <= current) {
+                due.push_back(slot[i]);
+                slot[i] = slot.back();
+                slot.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+    _worker_wheel_tick = std::max(_worker_wheel_tick, current);
+
+    for (auto &entry : due) {
+        auto it = _workers.find(entry.first);
+        if (it == _workers.end() || it->second.wheel_tick != entry.second) {
+            // removed, or re-scheduled at another tick
+            continue;
+        }
+
+        worker_record &record = it->second;
+        record.wheel_tick = 0;
+        if (!record.is_alive) {
+            // re-scheduled when it connects again
+            continue;
+        }
+
+        uint64_t last = record.last_beacon_recv_time.load();
+        if (now > last && now - last > _grace_milliseconds) {
+            // pairs with renew_worker_lease: either the concurrent renewal is seen here,
+            // or the renewing beacon sees the record dead and takes the slow path
+            record.is_alive.store(false);
+            last = record.last_beacon_recv_time.load();
+            if (now > last && now - last > _grace_milliseconds) {
+                expire.push_back(record.node);
+                report(record.node, false, false);
+                continue;
+            }
+            record.is_alive.store(true);
+        }
+
+        schedule_worker_check(record);
+    }
+}
+
+bool failure_detector::renew_worker_lease(::dsn::rpc_address node, uint64_t now)
+{
+    worker_shard &shard = get_worker_shard(node);
+    utils::auto_read_lock l(shard.lock);
+
+    auto it = shard.records.find(node);
+    if (it == shard.records.end() || !it->second->is_alive.load()) {
+        return false;
+    }
+
+    worker_record &record = *it->second;
+    uint64_t last = record.last_beacon_recv_time.load();
+    while (is_time_greater_than(now, last) &&
+           !record.last_beacon_recv_time.compare_exchange_weak(last, now)) {
+    }
+    return record.is_alive.load();
+}
+
 void failure_detector::add_allow_list(::dsn::rpc_address node)
 {
     zauto_lock l(_lock);
@@ -293,7 +439,7 @@ bool failure_detector::remove_from_allow_list(::dsn::rpc_address node)
     return _allow_list.erase(node) > 0;
 }
 
-void failure_detector::on_ping_internal(const beacon_msg &beacon, /*out*/ beacon_ack &ack)
+bool failure_detector::on_ping_fast(const beacon_msg &beacon, /*out*/ beacon_ack &ack)
 {
     ack.time = beacon.time;
     ack.this_node = beacon.to_addr;
@@ -301,11 +447,20 @@ void failure_detector::on_ping_internal(const beacon_msg &beacon, /*out*/ beacon
     ack.is_master = true;
     ack.allowed = true;
 
-    zauto_lock l(_lock);
+    return renew_worker_lease(beacon.from_addr, now_ms());
+}
+
+void failure_detector::on_ping_internal(const beacon_msg &beacon, /*out*/ beacon_ack &ack)
+{
+    if (on_ping_fast(beacon, ack)) {
+        return;
+    }
 
     uint64_t now = now_ms();
     auto node = beacon.from_addr;
 
+    zauto_lock l(_lock);
+
     worker_map::iterator itr = _workers.find(node);
     if (itr == _workers.end()) {
         // if is a new worker, check allow list first if need
@@ -318,16 +473,22 @@ void failure_detector::on_ping_internal(const beacon_msg &beacon, /*out*/ beacon
         // create new entry for node
         worker_record record(node, now);
         record.is_alive = true;
-        _workers.insert(std::make_pair(node, record));
+        add_worker_record(record);
 
         report(node, false, true);
         on_worker_connected(node);
-    } else if (is_time_greater_than(now, itr->second.last_beacon_recv_time)) {
+    } else {
         // update last_beacon_recv_time
-        itr->second.last_beacon_recv_time = now;
+        worker_record &record = itr->second;
+        if (is_time_greater_than(now, record.last_beacon_recv_time)) {
+            record.last_beacon_recv_time = now;
+        }
 
-        if (itr->second.is_alive == false) {
-            itr->second.is_alive = true;
+        // the lease may have been renewed right before the worker is declared dead
+        // in check_all_records, so reconnect it regardless of the timestamp
+        if (record.is_alive == false) {
+            record.is_alive = true;
+            schedule_worker_check(record);
 
             report(node, false, true);
             on_worker_connected(node);
@@ -338,10 +499,29 @@ void failure_detector::on_ping_internal(const beacon_msg &beacon, /*out*/ beacon
 void failure_detector::on_ping(const beacon_msg &beacon, ::dsn::rpc_replier<beacon_ack> &reply)
 {
     beacon_ack ack;
-    on_ping_internal(beacon, ack);
+    if (!is_running_inline()) {
+        on_ping_internal(beacon, ack);
+    } else if (!on_ping_fast(beacon, ack)) {
+        defer_ping(beacon, reply);
+        return;
+    }
     reply(ack);
 }
 
+/*static*/ bool failure_detector::is_running_inline()
+{
+    // requests run inline are executed by network threads, which are not task workers
+    return task::get_current_worker() == nullptr;
+}
+
+void failure_detector::defer_ping(const beacon_msg &beacon, ::dsn::rpc_replier<beacon_ack> &reply)
+{
+    // rpc_replier is move-only while task callbacks are copied
+    auto r = std::make_shared<::dsn::rpc_replier<beacon_ack>>(std::move(reply));
+    tasking::enqueue(
+        LPC_BEACON_DEFERRED_PING, this, [this, beacon, r]() { on_ping(beacon, *r); });
+}
+
 void failure_detector::end_ping(::dsn::error_code err, const beacon_ack &ack, void *)
 {
     end_ping_internal(err, ack);
@@ -447,15 +627,15 @@ void failure_detector::register_worker(::dsn::rpc_address target, bool is_connec
     /*
      * callers should use the fd::_lock necessarily
      */
-    worker_record record(target, now);
-    record.is_alive = is_connected ? true : false;
-
-    auto ret = _workers.insert(std::make_pair(target, record));
-    if (ret.second) {
-        dinfo("register worker[%s] successfully", target.to_string());
-    } else {
+    if (_workers.find(target) != _workers.end()) {
         dinfo("worker[%s] already registered", target.to_string());
+        return;
     }
+
+    worker_record record(target, now);
+    record.is_alive = is_connected ? true : false;
+    add_worker_record(record);
+    dinfo("register worker[%s] successfully", target.to_string());
 }
 
 bool failure_detector::unregister_worker(::dsn::rpc_address node)
@@ -465,7 +645,8 @@ bool failure_detector::unregister_worker(::dsn::rpc_address node)
      */
     bool ret;
 
-    size_t count = _workers.erase(node);
+    size_t count = _workers.count(node);
+    remove_worker_record(node);
 
     if (count == 0) {
         ret = false;
@@ -483,7 +664,7 @@ bool failure_detector::unregister_worker(::dsn::rpc_address node)
 void failure_detector::clear_workers()
 {
     zauto_lock l(_lock);
-    _workers.clear();
+    clear_worker_records();
 }
 
 bool failure_detector::is_worker_connected(::dsn::rpc_address node) const
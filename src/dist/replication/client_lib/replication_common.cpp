@@ -91,6 +91,7 @@ replication_options::replication_options()
     log_shared_file_count_limit = 100;
     log_shared_batch_buffer_kb = 0;
     log_shared_force_flush = false;
+    log_shared_salvage_enabled = true;
 
     config_sync_disabled = false;
     config_sync_interval_ms = 30000;
@@ -100,6 +101,7 @@ replication_options::replication_options()
     learn_app_max_concurrent_count = 1;
 
     max_concurrent_uploading_file_count = 10;
+    cold_backup_link_checkpoint_enabled = false;
 
     manual_compact_min_interval_seconds = 3600;
 }
@@ -436,6 +438,12 @@ void replication_options::initialize()
                                   "log_shared_force_flush",
                                   log_shared_force_flush,
                                   "when write shared log, whether to flush file after write done");
+    log_shared_salvage_enabled = dsn_config_get_value_bool(
+        "replication",
+        "log_shared_salvage_enabled",
+        log_shared_salvage_enabled,
+        "when the shared log fails to be replayed, whether to keep the replicas whose "
+        "private logs cover the lost part, instead of removing all the replicas");
 
     config_sync_disabled = dsn_config_get_value_bool(
         "replication",
@@ -468,6 +476,12 @@ void replication_options::initialize()
                                              "max_concurrent_uploading_file_count",
                                              max_concurrent_uploading_file_count,
                                              "concurrent uploading file count");
+    cold_backup_link_checkpoint_enabled =
+        dsn_config_get_value_bool("replication",
+                                  "cold_backup_link_checkpoint_enabled",
+                                  cold_backup_link_checkpoint_enabled,
+                                  "whether to hard link the files of the latest app checkpoint as "
+                                  "the backup checkpoint, instead of copying them");
 
     manual_compact_min_interval_seconds = (int32_t)dsn_config_get_value_uint64(
         "replication",
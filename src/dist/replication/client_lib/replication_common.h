@@ -107,6 +107,7 @@ public:
     int32_t log_shared_file_count_limit;
     int32_t log_shared_batch_buffer_kb;
     bool log_shared_force_flush;
+    bool log_shared_salvage_enabled;
 
     bool config_sync_disabled;
     int32_t config_sync_interval_ms;
@@ -117,6 +118,7 @@ public:
 
     std::string cold_backup_root;
     int32_t max_concurrent_uploading_file_count;
+    bool cold_backup_link_checkpoint_enabled;
 
     int32_t manual_compact_min_interval_seconds;
 
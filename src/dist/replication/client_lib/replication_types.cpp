@@ -6198,6 +6198,31 @@ void replica_info::__set_disk_tag(const std::string& val) {
   this->disk_tag = val;
 }
 
+void replica_info::__set_read_qps(const int64_t val) {
+  this->read_qps = val;
+__isset.read_qps = true;
+}
+
+void replica_info::__set_write_qps(const int64_t val) {
+  this->write_qps = val;
+__isset.write_qps = true;
+}
+
+void replica_info::__set_read_bytes_per_second(const int64_t val) {
+  this->read_bytes_per_second = val;
+__isset.read_bytes_per_second = true;
+}
+
+void replica_info::__set_write_bytes_per_second(const int64_t val) {
+  this->write_bytes_per_second = val;
+__isset.write_bytes_per_second = true;
+}
+
+void replica_info::__set_storage_mb(const int64_t val) {
+  this->storage_mb = val;
+__isset.storage_mb = true;
+}
+
 uint32_t replica_info::read(::apache::thrift::protocol::TProtocol* iprot) {
 
   apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
@@ -6285,6 +6310,46 @@ uint32_t replica_info::read(::apache::thrift::protocol::TProtocol* iprot) {
           xfer += iprot->skip(ftype);
         }
         break;
+      case 9:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->read_qps);
+          this->__isset.read_qps = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 10:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->write_qps);
+          this->__isset.write_qps = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 11:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->read_bytes_per_second);
+          this->__isset.read_bytes_per_second = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 12:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->write_bytes_per_second);
+          this->__isset.write_bytes_per_second = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 13:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->storage_mb);
+          this->__isset.storage_mb = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
       default:
         xfer += iprot->skip(ftype);
         break;
@@ -6334,6 +6399,31 @@ uint32_t replica_info::write(::apache::thrift::protocol::TProtocol* oprot) const
   xfer += oprot->writeString(this->disk_tag);
   xfer += oprot->writeFieldEnd();
 
+  if (this->__isset.read_qps) {
+    xfer += oprot->writeFieldBegin("read_qps", ::apache::thrift::protocol::T_I64, 9);
+    xfer += oprot->writeI64(this->read_qps);
+    xfer += oprot->writeFieldEnd();
+  }
+  if (this->__isset.write_qps) {
+    xfer += oprot->writeFieldBegin("write_qps", ::apache::thrift::protocol::T_I64, 10);
+    xfer += oprot->writeI64(this->write_qps);
+    xfer += oprot->writeFieldEnd();
+  }
+  if (this->__isset.read_bytes_per_second) {
+    xfer += oprot->writeFieldBegin("read_bytes_per_second", ::apache::thrift::protocol::T_I64, 11);
+    xfer += oprot->writeI64(this->read_bytes_per_second);
+    xfer += oprot->writeFieldEnd();
+  }
+  if (this->__isset.write_bytes_per_second) {
+    xfer += oprot->writeFieldBegin("write_bytes_per_second", ::apache::thrift::protocol::T_I64, 12);
+    xfer += oprot->writeI64(this->write_bytes_per_second);
+    xfer += oprot->writeFieldEnd();
+  }
+  if (this->__isset.storage_mb) {
+    xfer += oprot->writeFieldBegin("storage_mb", ::apache::thrift::protocol::T_I64, 13);
+    xfer += oprot->writeI64(this->storage_mb);
+    xfer += oprot->writeFieldEnd();
+  }
   xfer += oprot->writeFieldStop();
   xfer += oprot->writeStructEnd();
   return xfer;
@@ -6349,6 +6439,11 @@ void swap(replica_info &a, replica_info &b) {
   swap(a.last_durable_decree, b.last_durable_decree);
   swap(a.app_type, b.app_type);
   swap(a.disk_tag, b.disk_tag);
+  swap(a.read_qps, b.read_qps);
+  swap(a.write_qps, b.write_qps);
+  swap(a.read_bytes_per_second, b.read_bytes_per_second);
+  swap(a.write_bytes_per_second, b.write_bytes_per_second);
+  swap(a.storage_mb, b.storage_mb);
   swap(a.__isset, b.__isset);
 }
 
@@ -6361,6 +6456,11 @@ replica_info::replica_info(const replica_info& other256) {
   last_durable_decree = other256.last_durable_decree;
   app_type = other256.app_type;
   disk_tag = other256.disk_tag;
+  read_qps = other256.read_qps;
+  write_qps = other256.write_qps;
+  read_bytes_per_second = other256.read_bytes_per_second;
+  write_bytes_per_second = other256.write_bytes_per_second;
+  storage_mb = other256.storage_mb;
   __isset = other256.__isset;
 }
 replica_info::replica_info( replica_info&& other257) {
@@ -6372,6 +6472,11 @@ replica_info::replica_info( replica_info&& other257) {
   last_durable_decree = std::move(other257.last_durable_decree);
   app_type = std::move(other257.app_type);
   disk_tag = std::move(other257.disk_tag);
+  read_qps = std::move(other257.read_qps);
+  write_qps = std::move(other257.write_qps);
+  read_bytes_per_second = std::move(other257.read_bytes_per_second);
+  write_bytes_per_second = std::move(other257.write_bytes_per_second);
+  storage_mb = std::move(other257.storage_mb);
   __isset = std::move(other257.__isset);
 }
 replica_info& replica_info::operator=(const replica_info& other258) {
@@ -6383,6 +6488,11 @@ replica_info& replica_info::operator=(const replica_info& other258) {
   last_durable_decree = other258.last_durable_decree;
   app_type = other258.app_type;
   disk_tag = other258.disk_tag;
+  read_qps = other258.read_qps;
+  write_qps = other258.write_qps;
+  read_bytes_per_second = other258.read_bytes_per_second;
+  write_bytes_per_second = other258.write_bytes_per_second;
+  storage_mb = other258.storage_mb;
   __isset = other258.__isset;
   return *this;
 }
@@ -6395,6 +6505,11 @@ replica_info& replica_info::operator=(replica_info&& other259) {
   last_durable_decree = std::move(other259.last_durable_decree);
   app_type = std::move(other259.app_type);
   disk_tag = std::move(other259.disk_tag);
+  read_qps = std::move(other259.read_qps);
+  write_qps = std::move(other259.write_qps);
+  read_bytes_per_second = std::move(other259.read_bytes_per_second);
+  write_bytes_per_second = std::move(other259.write_bytes_per_second);
+  storage_mb = std::move(other259.storage_mb);
   __isset = std::move(other259.__isset);
   return *this;
 }
@@ -6409,6 +6524,11 @@ void replica_info::printTo(std::ostream& out) const {
   out << ", " << "last_durable_decree=" << to_string(last_durable_decree);
   out << ", " << "app_type=" << to_string(app_type);
   out << ", " << "disk_tag=" << to_string(disk_tag);
+  out << ", " << "read_qps="; (__isset.read_qps ? (out << to_string(read_qps)) : (out << "<null>"));
+  out << ", " << "write_qps="; (__isset.write_qps ? (out << to_string(write_qps)) : (out << "<null>"));
+  out << ", " << "read_bytes_per_second="; (__isset.read_bytes_per_second ? (out << to_string(read_bytes_per_second)) : (out << "<null>"));
+  out << ", " << "write_bytes_per_second="; (__isset.write_bytes_per_second ? (out << to_string(write_bytes_per_second)) : (out << "<null>"));
+  out << ", " << "storage_mb="; (__isset.storage_mb ? (out << to_string(storage_mb)) : (out << "<null>"));
   out << ")";
 }
 
@@ -36,14 +36,23 @@
 #include "mutation_log.h"
 #ifdef _WIN32
 #include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 #include "replica.h"
 #include <dsn/utility/filesystem.h>
+#include <dsn/utility/compression.h>
 #include <dsn/utility/crc.h>
+#include <fstream>
 
 namespace dsn {
 namespace replication {
 
+// sub dir of the private log dir holding the partial log files written for learning
+static const char *learn_segment_dir_name = "learn_segments";
+
 using namespace ::dsn::service;
 
 ::dsn::task_ptr mutation_log_shared::append(mutation_ptr &mu,
@@ -159,7 +168,9 @@ void mutation_log_shared::write_pending_mutations(bool release_lock_required)
             dassert(_is_writing.load(std::memory_order_relaxed), "");
 
             auto hdr = (log_block_header *)block->front().data();
-            dassert(hdr->magic == 0xdeadbeef, "header magic is changed: 0x%x", hdr->magic);
+            dassert(hdr->magic == 0xdeadbeef || hdr->magic == log_block_lz_magic,
+                    "header magic is changed: 0x%x",
+                    hdr->magic);
 
             if (err == ERR_OK) {
                 dassert(sz == block->size(),
@@ -345,6 +356,7 @@ void mutation_log_private::write_pending_mutations(bool release_lock_required)
 
     _is_writing.store(true, std::memory_order_release);
 
+    decree max_decree_before = max_decree(_private_gpid);
     update_max_decree(_private_gpid, _pending_write_max_decree);
 
     // move or reset pending variables
@@ -361,6 +373,7 @@ void mutation_log_private::write_pending_mutations(bool release_lock_required)
     // seperate commit_log_block from within the lock
     _plock.unlock();
 
+    pr.first->add_decree_index(max_decree_before, start_offset - pr.first->start_offset());
     pr.first->commit_log_block(
         *blk,
         start_offset,
@@ -371,7 +384,9 @@ void mutation_log_private::write_pending_mutations(bool release_lock_required)
             dassert(_is_writing.load(std::memory_order_relaxed), "");
 
             auto hdr = (log_block_header *)block->front().data();
-            dassert(hdr->magic == 0xdeadbeef, "header magic is changed: 0x%x", hdr->magic);
+            dassert(hdr->magic == 0xdeadbeef || hdr->magic == log_block_lz_magic,
+                    "header magic is changed: 0x%x",
+                    hdr->magic);
 
             if (err == ERR_OK) {
                 dassert(sz == block->size(),
@@ -427,12 +442,41 @@ void mutation_log_private::write_pending_mutations(bool release_lock_required)
 
 ///////////////////////////////////////////////////////////////
 
+static uint32_t mutation_log_compress_min_bytes()
+{
+    static uint32_t min_bytes = static_cast<uint32_t>(
+        dsn_config_get_value_uint64("replication",
+                                    "mutation_log_compress_min_bytes",
+                                    0,
+                                    "compress the data of a mutation log block when it is not "
+                                    "smaller than this size, 0 for never; log file size limits "
+                                    "and log sizes still count the raw bytes"));
+    return min_bytes;
+}
+
+// compressed blocks are decompressed into buffers of their raw size, which is read from the
+// file, so it is capped before allocating; larger blocks are written uncompressed
+static uint32_t mutation_log_compress_max_bytes()
+{
+    static uint32_t max_bytes = static_cast<uint32_t>(
+        std::min<uint64_t>(dsn_config_get_value_uint64("replication",
+                                                       "mutation_log_compress_max_block_mb",
+                                                       64,
+                                                       "max raw size of a compressed mutation "
+                                                       "log block in MB, larger ones are "
+                                                       "written uncompressed") *
+                               1024 * 1024,
+                           UINT32_MAX));
+    return max_bytes;
+}
+
 mutation_log::mutation_log(const std::string &dir, int32_t max_log_file_mb, gpid gpid, replica *r)
 {
     _dir = dir;
     _is_private = (gpid.value() != 0);
     _max_log_file_size_in_bytes = static_cast<int64_t>(max_log_file_mb) * 1024L * 1024L;
     _min_log_file_size_in_bytes = _max_log_file_size_in_bytes / 10;
+    _compress_min_bytes = mutation_log_compress_min_bytes();
     _owner_replica = r;
     _private_gpid = gpid;
 
@@ -464,6 +508,10 @@ void mutation_log::init_states()
     _shared_log_info_map.clear();
     _private_log_info = {0, 0};
     _private_max_commit_on_disk = 0;
+
+    // learn segments
+    _learn_segment_seq = 0;
+    _learn_segments.clear();
 }
 
 mutation_log::~mutation_log() { close(); }
@@ -494,6 +542,12 @@ error_code mutation_log::open(replay_callback read_callback,
     _log_files.clear();
     _io_error_callback = write_error_callback;
 
+    if (_is_private) {
+        // learn segments left by the last run are useless
+        dsn::utils::filesystem::remove_path(
+            utils::filesystem::path_combine(_dir, learn_segment_dir_name));
+    }
+
     std::vector<std::string> file_list;
     if (!dsn::utils::filesystem::get_subfiles(_dir, file_list, false)) {
         derror("open mutation_log: get subfiles failed.");
@@ -646,6 +700,15 @@ error_code mutation_log::open(replay_callback read_callback,
         end_offset);
 
     if (ERR_OK == err) {
+        // the end offsets got from the file sizes are less than the real ones if some blocks
+        // are compressed, so they are corrected by the start offsets of the next files, and the
+        // end offset of replaying for the last file
+        for (auto it = _log_files.begin(); it != _log_files.end(); ++it) {
+            auto next = std::next(it);
+            it->second->set_end_offset(next != _log_files.end() ? next->second->start_offset()
+                                                                : end_offset);
+        }
+
         _global_start_offset =
             _log_files.size() > 0 ? _log_files.begin()->second->start_offset() : 0;
         _global_end_offset = end_offset;
@@ -702,6 +765,7 @@ error_code mutation_log::create_new_log_file()
         derror("cannot create log file with index %d", _last_file_index + 1);
         return ERR_FILE_OPERATION_FAILED;
     }
+    logf->set_compress_min_bytes(_compress_min_bytes);
     dassert(logf->end_offset() == logf->start_offset(),
             "%" PRId64 " VS %" PRId64 "",
             logf->end_offset(),
@@ -848,12 +912,19 @@ std::pair<log_file_ptr, int64_t> mutation_log::mark_new_offset(size_t size,
         return ERR_INVALID_DATA;
     }
 
+    // rebuild the decree index along the way
+    decree max_decree = 0;
+    for (auto &kv : log->previous_log_max_decrees()) {
+        max_decree = std::max(max_decree, kv.second.max_decree);
+    }
+
     while (true) {
         while (!reader->is_eof()) {
             auto old_size = reader->get_remaining_size();
             mutation_ptr mu = mutation::read_from(*reader, nullptr);
             dassert(nullptr != mu, "");
             mu->set_logged();
+            max_decree = std::max(max_decree, mu->data.header.decree);
 
             if (mu->data.header.log_offset != end_offset) {
                 derror("offset mismatch in log entry and mutation %" PRId64 " vs %" PRId64,
@@ -870,6 +941,7 @@ std::pair<log_file_ptr, int64_t> mutation_log::mark_new_offset(size_t size,
             end_offset += log_length;
         }
 
+        log->add_decree_index(max_decree, end_offset - log->start_offset());
         err = log->read_next_log_block(bb);
         if (err != ERR_OK) {
             // if an error occurs in an log mutation block, then the replay log is stopped
@@ -981,6 +1053,118 @@ std::pair<log_file_ptr, int64_t> mutation_log::mark_new_offset(size_t size,
     return err;
 }
 
+/*static*/ bool mutation_log::salvage(const std::string &dir,
+                                      /*out*/ std::map<gpid, decree> &lost_decrees)
+{
+    lost_decrees.clear();
+
+    std::vector<std::string> file_list;
+    if (!dsn::utils::filesystem::get_subfiles(dir, file_list, false)) {
+        derror("salvage mutation_log: get subfiles of %s failed", dir.c_str());
+        return false;
+    }
+
+    std::map<int, log_file_ptr> logs;
+    for (auto &fpath : file_list) {
+        error_code err;
+        log_file_ptr log = log_file::open_read(fpath.c_str(), err);
+        if (log == nullptr) {
+            dwarn("salvage mutation_log: skip file %s, err = %s", fpath.c_str(), err.to_string());
+            continue;
+        }
+        logs[log->index()] = log;
+    }
+    if (logs.empty()) {
+        return true;
+    }
+
+    // "replayable" is true before the first invalid block, and "scanned" means that
+    // all the dropped part till now are scanned or covered
+    bool replayable = true;
+    bool scanned = true;
+    int expected_index = logs.begin()->first;
+    int64_t end_offset = logs.begin()->second->start_offset();
+    for (auto &kv : logs) {
+        log_file_ptr &log = kv.second;
+        if (kv.first != expected_index || (replayable && log->start_offset() != end_offset)) {
+            derror("salvage mutation_log: log file missing or broken before %s",
+                   log->path().c_str());
+            replayable = false;
+        }
+        expected_index = kv.first + 1;
+
+        if (!replayable) {
+            // the header records the max decrees of all the previous log files
+            for (auto &d : log->previous_log_max_decrees()) {
+                decree &lost = lost_decrees[d.first];
+                lost = std::max(lost, d.second.max_decree);
+            }
+            scanned = true;
+        }
+
+        if (replayable) {
+            error_code err = replay(log,
+                                    [](int log_length, mutation_ptr &mu) { return true; },
+                                    end_offset);
+            if (err != ERR_OK && err != ERR_HANDLE_EOF && err != ERR_INCOMPLETE_DATA) {
+                dwarn("salvage mutation_log: cut the log at %s, offset = %" PRId64 ", err = %s",
+                      log->path().c_str(),
+                      end_offset,
+                      err.to_string());
+                replayable = false;
+                scanned = scan_max_decrees(log, false, lost_decrees);
+            }
+        } else {
+            log->reset_stream();
+            scanned = scan_max_decrees(log, true, lost_decrees);
+        }
+        log->close();
+    }
+
+    if (!scanned) {
+        derror("salvage mutation_log: the tail of the last log file can't be scanned");
+    }
+    return scanned;
+}
+
+/*static*/ bool mutation_log::scan_max_decrees(log_file_ptr log,
+                                               bool from_start,
+                                               /*inout*/ std::map<gpid, decree> &max_decrees)
+{
+    ::dsn::blob bb;
+    while (true) {
+        error_code err = log->read_next_log_block(bb);
+        if (err == ERR_HANDLE_EOF || err == ERR_INCOMPLETE_DATA) {
+            // an incomplete block is only possible at the end of a log file
+            return true;
+        } else if (err == ERR_WRONG_CHECKSUM) {
+            // the corrupted block may hold the max decree of any replica, so the max decrees
+            // are unknown even if the remaining blocks are scanned
+            dwarn("stop scanning %s at a corrupted block", log->path().c_str());
+            return false;
+        } else if (err != ERR_OK) {
+            dwarn("stop scanning %s, err = %s", log->path().c_str(), err.to_string());
+            return false;
+        }
+
+        binary_reader reader(std::move(bb));
+        if (from_start) {
+            log->read_file_header(reader);
+            if (!log->is_right_header()) {
+                return false;
+            }
+            from_start = false;
+        }
+
+        while (!reader.is_eof()) {
+            mutation_ptr mu = mutation::read_from(reader, nullptr);
+            dassert(nullptr != mu, "");
+            decree &d = max_decrees[mu->data.header.pid];
+            d = std::max(d, mu->data.header.decree);
+        }
+    }
+}
+
 decree mutation_log::max_decree(gpid gpid) const
 {
     zauto_lock l(_lock);
@@ -1145,7 +1329,10 @@ void mutation_log::update_max_commit_on_disk_no_lock(decree d)
     }
 }
 
-bool mutation_log::get_learn_state(gpid gpid, decree start, /*out*/ learn_state &state) const
+bool mutation_log::get_learn_state(gpid gpid,
+                                   decree start,
+                                   /*out*/ learn_state &state,
+                                   /*out*/ log_file_ptr *segment_source) const
 {
     dassert(_is_private, "this method is only valid for private logs");
     dassert(_private_gpid == gpid,
@@ -1177,6 +1364,7 @@ bool mutation_log::get_learn_state(gpid gpid, decree start, /*out*/ learn_state
     std::list<std::string> learn_files;
     log_file_ptr log;
     decree last_max_decree = 0;
+    log_file_ptr learned_file_head;
     int learned_file_head_index = 0;
     int learned_file_tail_index = 0;
     int64_t learned_file_start_offset = 0;
@@ -1195,6 +1383,7 @@ bool mutation_log::get_learn_state(gpid gpid, decree start, /*out*/ learn_state
             learn_files.push_back(log->path());
             if (learned_file_tail_index == 0)
                 learned_file_tail_index = log->index();
+            learned_file_head = log;
             learned_file_head_index = log->index();
             learned_file_start_offset = log->start_offset();
         }
@@ -1222,6 +1411,12 @@ bool mutation_log::get_learn_state(gpid gpid, decree start, /*out*/ learn_state
 
     bool ret = (learned_file_start_offset >= _private_log_info.valid_start_offset &&
                 last_max_decree > 0 && last_max_decree < start);
+
+    // the head file may start long before the learn start decree, so the caller may learn only
+    // its tail when the decree index allows
+    if (ret && learned_file_head != nullptr && segment_source != nullptr) {
+        *segment_source = learned_file_head;
+    }
     ddebug("gpid(%d.%d) get_learn_state returns %s, "
            "private logs count %d (%d => %d), learned files count %d (%d => %d): "
            "learned_file_start_offset(%" PRId64 ") >= valid_start_offset(%" PRId64 ") && "
@@ -1245,7 +1440,80 @@ bool mutation_log::get_learn_state(gpid gpid, decree start, /*out*/ learn_state
     return ret;
 }
 
+std::string
+mutation_log::write_learn_segment(log_file_ptr file, decree start, int64_t learner_signature)
+{
+    dassert(_is_private, "this method is only valid for private logs");
+
+    uint64_t seq;
+    {
+        zauto_lock l(_learn_segments_lock);
+        seq = ++_learn_segment_seq;
+    }
+
+    std::string dir = utils::filesystem::path_combine(
+        utils::filesystem::path_combine(_dir, learn_segment_dir_name),
+        std::to_string(learner_signature) + "." + std::to_string(seq));
+    std::string segment = file->write_learn_segment(start, dir);
+    if (segment.empty()) {
+        dsn::utils::filesystem::remove_path(dir);
+        return segment;
+    }
+
+    std::string obsolete_dir;
+    {
+        zauto_lock l(_learn_segments_lock);
+        auto &owned = _learn_segments[learner_signature];
+        if (owned.first > seq) {
+            // the learner has moved on to a newer round while this segment was being written
+            obsolete_dir = dir;
+            segment.clear();
+        } else {
+            if (!owned.second.empty()) {
+                obsolete_dir = utils::filesystem::remove_file_name(owned.second);
+            }
+            owned = std::make_pair(seq, segment);
+        }
+    }
+
+    if (!obsolete_dir.empty()) {
+        dsn::utils::filesystem::remove_path(obsolete_dir);
+    }
+    return segment;
+}
+
+void mutation_log::gc_learn_segments(const std::set<int64_t> &alive_learner_signatures)
+{
+    std::vector<std::string> obsolete_dirs;
+    {
+        zauto_lock l(_learn_segments_lock);
+        for (auto it = _learn_segments.begin(); it != _learn_segments.end();) {
+            if (alive_learner_signatures.count(it->first) == 0) {
+                obsolete_dirs.push_back(utils::filesystem::remove_file_name(it->second.second));
+                it = _learn_segments.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (auto &dir : obsolete_dirs) {
+        ddebug("remove learn segments in %s", dir.c_str());
+        dsn::utils::filesystem::remove_path(dir);
+    }
+}
+
+void mutation_log::set_compress_min_bytes(uint32_t min_bytes)
+{
+    zauto_lock l(_lock);
+    _compress_min_bytes = min_bytes;
+    if (_current_log_file != nullptr) {
+        _current_log_file->set_compress_min_bytes(min_bytes);
+    }
+}
+
 // return true if the file is covered by both reserve_max_size and reserve_max_time
+// the sizes are raw ones in the global space, even when blocks are compressed
 static bool should_reserve_file(log_file_ptr log,
                                 int64_t already_reserved_size,
                                 int64_t reserve_max_size,
@@ -1882,6 +2150,92 @@ private:
     dsn_handle_t _file_handle;
 };
 
+// log_file::mapped_file_streamer
+// reads a sealed log file through a read-only memory mapping, so the kernel reads ahead over
+// the whole file instead of the two aio buffers of file_streamer being refilled.
+// the blobs returned alias the mapping, and are only valid until the next read;
+// log_file::read_next_log_block copies out the blocks it returns, so that replayed or learned
+// mutations don't pin the mapping, nor the disk space of a log file removed meanwhile.
+class log_file::mapped_file_streamer
+{
+public:
+    // map the first 'size' bytes of the file, return nullptr if the mapping is unavailable
+    static mapped_file_streamer *create(const std::string &path, size_t size)
+    {
+#ifdef _WIN32
+        return nullptr;
+#else
+        if (size == 0)
+            return nullptr;
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            dwarn("open %s for mmap failed, err = %s", path.c_str(), strerror(errno));
+            return nullptr;
+        }
+#if defined(POSIX_FADV_SEQUENTIAL)
+        ::posix_fadvise(fd, 0, size, POSIX_FADV_SEQUENTIAL);
+#endif
+        void *addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        // the mapping holds its own reference to the file
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            dwarn("mmap %s failed, size = %" PRIu64 ", err = %s",
+                  path.c_str(),
+                  static_cast<uint64_t>(size),
+                  strerror(errno));
+            return nullptr;
+        }
+
+        // replay scans the whole file once from head to tail, so let the kernel read ahead
+        // aggressively and drop the pages behind the cursor early
+        ::madvise(addr, size, MADV_SEQUENTIAL);
+        ::madvise(addr, size, MADV_WILLNEED);
+
+        // released with the streamer, as the blobs handed out don't outlive it
+        std::shared_ptr<char> mapping(static_cast<char *>(addr),
+                                      [size](char *p) { ::munmap(p, size); });
+        return new mapped_file_streamer(std::move(mapping), size);
+#endif
+    }
+
+    void reset(size_t file_offset) { _offset = std::min(file_offset, _size); }
+
+    // same contract as file_streamer::read_next
+    error_code read_next(size_t size, /*out*/ blob &result)
+    {
+        size_t len = std::min(size, _size - _offset);
+        if (len == 0) {
+            result = blob();
+        } else {
+            result.assign(_mapping, static_cast<int>(_offset), static_cast<unsigned int>(len));
+        }
+        _offset += len;
+        return len == size ? ERR_OK : ERR_HANDLE_EOF;
+    }
+
+private:
+    mapped_file_streamer(std::shared_ptr<char> &&mapping, size_t size)
+        : _mapping(std::move(mapping)), _size(size), _offset(0)
+    {
+    }
+
+    std::shared_ptr<char> _mapping;
+    size_t _size;
+    size_t _offset;
+};
+
+static bool mutation_log_mmap_read_enabled()
+{
+    static bool enabled =
+        dsn_config_get_value_bool("replication",
+                                  "mutation_log_mmap_read",
+                                  true,
+                                  "whether to read sealed mutation log files through mmap when "
+                                  "replaying or learning, instead of the aio file streamer");
+    return enabled;
+}
+
 //------------------- log_file --------------------------
 log_file::~log_file() { close(); }
 /*static */ log_file_ptr log_file::open_read(const char *path, /*out*/ error_code &err)
@@ -1939,6 +2293,9 @@ log_file::~log_file() { close(); }
     lf->reset_stream();
     blob hdr_blob;
     err = lf->read_next_log_block(hdr_blob);
+    if (err == ERR_WRONG_CHECKSUM) {
+        err = ERR_INVALID_DATA;
+    }
     if (err == ERR_INVALID_DATA || err == ERR_INCOMPLETE_DATA || err == ERR_HANDLE_EOF ||
         err == ERR_FILE_OPERATION_FAILED) {
         std::string removed = std::string(path) + ".removed";
@@ -2003,7 +2360,10 @@ log_file::log_file(
     _path = path;
     _index = index;
     _crc32 = 0;
+    _block_offset = 0;
     _last_write_time = 0;
+    _compress_min_bytes = mutation_log_compress_min_bytes();
+    _mmap_read_enabled = mutation_log_mmap_read_enabled();
     memset(&_header, 0, sizeof(_header));
 
     if (is_read) {
@@ -2020,6 +2380,7 @@ void log_file::close()
     //_stream implicitly refer to _handle so it needs to be cleaned up first.
     // TODO: We need better abstraction to avoid those manual stuffs..
     _stream.reset(nullptr);
+    _mapped_stream.reset(nullptr);
     if (_handle) {
         error_code err = dsn_file_close(_handle);
         dassert(err == ERR_OK, "dsn_file_close failed, err = %s", err.to_string());
@@ -2041,7 +2402,7 @@ void log_file::flush() const
 error_code log_file::read_next_log_block(/*out*/ ::dsn::blob &bb)
 {
     dassert(_is_read, "log file must be of read mode");
-    auto err = _stream->read_next(sizeof(log_block_header), bb);
+    auto err = read_next(sizeof(log_block_header), bb);
     if (err != ERR_OK || bb.length() != sizeof(log_block_header)) {
         if (err == ERR_OK || err == ERR_HANDLE_EOF) {
             // if read_count is 0, then we meet the end of file
@@ -2057,12 +2418,12 @@ error_code log_file::read_next_log_block(/*out*/ ::dsn::blob &bb)
     }
     log_block_header hdr = *reinterpret_cast<const log_block_header *>(bb.data());
 
-    if (hdr.magic != 0xdeadbeef) {
+    if (hdr.magic != 0xdeadbeef && hdr.magic != log_block_lz_magic) {
         derror("invalid data header magic: 0x%x", hdr.magic);
         return ERR_INVALID_DATA;
     }
 
-    err = _stream->read_next(hdr.length, bb);
+    err = read_next(hdr.length, bb);
     if (err != ERR_OK || hdr.length != bb.length()) {
         derror("read data block body failed, size = %d vs %d, err = %s",
                bb.length(),
@@ -2077,14 +2438,47 @@ error_code log_file::read_next_log_block(/*out*/ ::dsn::blob &bb)
         return err;
     }
 
+    _block_offset += sizeof(log_block_header) + hdr.length;
+
     auto crc = dsn::utils::crc32_calc(
         static_cast<const void *>(bb.data()), static_cast<size_t>(hdr.length), _crc32);
     if (crc != hdr.body_crc) {
         derror("crc checking failed");
-        return ERR_INVALID_DATA;
+        // the crc of the next block is chained on the one recorded in the header,
+        // so the following blocks can still be verified if the caller goes on reading
+        _crc32 = hdr.body_crc;
+        return ERR_WRONG_CHECKSUM;
     }
     _crc32 = crc;
 
+    if (hdr.magic == log_block_lz_magic) {
+        uint32_t raw_length = 0;
+        if (bb.length() > sizeof(raw_length)) {
+            memcpy(&raw_length, bb.data(), sizeof(raw_length));
+        }
+        if (raw_length == 0 || raw_length > mutation_log_compress_max_bytes()) {
+            derror("invalid raw size %u of compressed data block, size = %d",
+                   raw_length,
+                   hdr.length);
+            return ERR_INVALID_DATA;
+        }
+        std::shared_ptr<char> raw(dsn::utils::make_shared_array<char>(raw_length));
+        if (!dsn::utils::lz_decompress(bb.data() + sizeof(raw_length),
+                                       bb.length() - sizeof(raw_length),
+                                       raw.get(),
+                                       raw_length)) {
+            derror("decompress data block failed, size = %d", hdr.length);
+            return ERR_INVALID_DATA;
+        }
+        bb.assign(std::move(raw), 0, raw_length);
+    } else if (_mapped_stream != nullptr) {
+        // the block aliases the mapping, copy it out as the updates parsed from it may be
+        // kept by the caller long after the file is closed
+        std::shared_ptr<char> body(dsn::utils::make_shared_array<char>(bb.length()));
+        memcpy(body.get(), bb.data(), bb.length());
+        bb.assign(std::move(body), 0, bb.length());
+    }
+
     return ERR_OK;
 }
 
@@ -2111,12 +2505,31 @@ log_block *log_file::prepare_log_block()
     dassert(!_is_read, "log file must be of write mode");
     dassert(block.size() > 0, "log_block can not be empty");
 
+    // the size and offset in the global space are of the raw block
     auto size = (long long)block.size();
     int64_t local_offset = offset - start_offset();
     auto hdr = reinterpret_cast<log_block_header *>(const_cast<char *>(block.front().data()));
 
     dassert(hdr->magic == 0xdeadbeef, "");
-    hdr->local_offset = local_offset;
+
+    // the first block holding the file header is never compressed, so that the file can be
+    // opened by readers without any knowledge of compression
+    uint32_t raw_length = static_cast<uint32_t>(block.size() - sizeof(log_block_header));
+    uint32_t min_compress_size = _compress_min_bytes.load();
+    blob lz_data;
+    if (local_offset > 0 && min_compress_size > 0 && raw_length >= min_compress_size &&
+        raw_length <= mutation_log_compress_max_bytes() &&
+        dsn::utils::lz_compress(&block.data()[1], (int)block.data().size() - 1, lz_data) &&
+        lz_data.length() + sizeof(raw_length) < raw_length) {
+        binary_writer writer;
+        writer.write_pod(raw_length);
+        block.clear_data();
+        block.add(writer.get_buffer());
+        block.add(lz_data);
+        hdr->magic = log_block_lz_magic;
+    }
+
+    hdr->local_offset = static_cast<uint32_t>(_block_offset);
     hdr->length = static_cast<int32_t>(block.size() - sizeof(log_block_header));
     hdr->body_crc = _crc32;
 
@@ -2137,12 +2550,15 @@ log_block *log_file::prepare_log_block()
     }
     _crc32 = hdr->body_crc;
 
+    uint64_t file_offset = static_cast<uint64_t>(_block_offset);
+    _block_offset += block.size();
+
     task_ptr tsk;
     if (callback) {
         tsk = file::write_vector(_handle,
                                  buffer_vector,
                                  vec_size,
-                                 static_cast<uint64_t>(local_offset),
+                                 file_offset,
                                  evt,
                                  callback_host,
                                  std::forward<aio_handler>(callback),
@@ -2151,7 +2567,7 @@ log_block *log_file::prepare_log_block()
         tsk = file::write_vector(_handle,
                                  buffer_vector,
                                  vec_size,
-                                 static_cast<uint64_t>(local_offset),
+                                 file_offset,
                                  evt,
                                  callback_host,
                                  dsn::empty_callback,
@@ -2164,12 +2580,184 @@ log_block *log_file::prepare_log_block()
 
 void log_file::reset_stream()
 {
-    if (_stream == nullptr) {
-        _stream.reset(new file_streamer(_handle, 0));
-    } else {
+    if (_mapped_stream != nullptr) {
+        _mapped_stream->reset(0);
+    } else if (_stream != nullptr) {
         _stream->reset(0);
+    } else {
+        // files opened for read are never appended, so the size got at open time is stable
+        if (_is_read && _mmap_read_enabled) {
+            size_t size = static_cast<size_t>(_end_offset - _start_offset);
+            _mapped_stream.reset(mapped_file_streamer::create(_path, size));
+        }
+        if (_mapped_stream == nullptr) {
+            _stream.reset(new file_streamer(_handle, 0));
+        }
     }
     _crc32 = 0;
+    _block_offset = 0;
+}
+
+error_code log_file::read_next(size_t size, /*out*/ ::dsn::blob &result)
+{
+    return _mapped_stream != nullptr ? _mapped_stream->read_next(size, result)
+                                     : _stream->read_next(size, result);
+}
+
+void log_file::seek_stream(int64_t block_offset, uint32_t crc)
+{
+    if (_mapped_stream != nullptr) {
+        _mapped_stream->reset(static_cast<size_t>(block_offset));
+    } else {
+        _stream->reset(static_cast<size_t>(block_offset));
+    }
+    _crc32 = crc;
+    _block_offset = block_offset;
+}
+
+static int64_t mutation_log_decree_index_interval_bytes()
+{
+    static int64_t interval =
+        static_cast<int64_t>(dsn_config_get_value_uint64(
+            "replication",
+            "mutation_log_decree_index_interval_kb",
+            1024,
+            "min distance in KB between two block boundaries remembered in the decree index "
+            "of a mutation log file, 0 to remember every boundary")) *
+        1024;
+    return interval;
+}
+
+void log_file::add_decree_index(decree max_decree_before, int64_t local_offset)
+{
+    zauto_lock l(_decree_index_lock);
+    int64_t last_offset = _decree_index.empty() ? 0 : _decree_index.back().local_offset;
+    if (local_offset - last_offset < std::max(mutation_log_decree_index_interval_bytes(),
+                                              static_cast<int64_t>(1))) {
+        return;
+    }
+
+    decree_index_entry entry;
+    entry.max_decree_before = max_decree_before;
+    entry.local_offset = static_cast<uint32_t>(local_offset);
+    entry.block_offset = static_cast<uint32_t>(_block_offset);
+    entry.crc_seed = _crc32;
+    _decree_index.push_back(entry);
+}
+
+std::string log_file::write_learn_segment(decree start_decree, const std::string &dir)
+{
+    decree_index_entry entry;
+    {
+        zauto_lock l(_decree_index_lock);
+        // max_decree_before is non-decreasing, so find the last boundary before which
+        // no mutation is needed
+        auto it = std::partition_point(_decree_index.begin(),
+                                       _decree_index.end(),
+                                       [start_decree](const decree_index_entry &e) {
+                                           return e.max_decree_before < start_decree;
+                                       });
+        if (it == _decree_index.begin()) {
+            return std::string();
+        }
+        entry = *(it - 1);
+    }
+
+    // not through open_read(), which renames the file on failure, as this file may be in use
+    dsn_handle_t hfile = dsn_file_open(_path.c_str(), O_RDONLY | O_BINARY, 0);
+    if (!hfile) {
+        dwarn("open log file %s for learning failed", _path.c_str());
+        return std::string();
+    }
+    log_file_ptr src = new log_file(_path.c_str(), hfile, _index, _start_offset, true);
+    src->reset_stream();
+    blob bb;
+    error_code err = src->read_next_log_block(bb);
+    if (err != ERR_OK) {
+        dwarn("read header of log file %s for learning failed, err = %s",
+              _path.c_str(),
+              err.to_string());
+        return std::string();
+    }
+    binary_reader reader(std::move(bb));
+    src->read_file_header(reader);
+
+    int64_t header_block_size = sizeof(log_block_header) + src->get_file_header_size();
+    if (entry.local_offset <= header_block_size) {
+        return std::string();
+    }
+    int64_t start_offset = _start_offset + entry.local_offset - header_block_size;
+
+    if (!dsn::utils::filesystem::directory_exists(dir) &&
+        !dsn::utils::filesystem::create_directory(dir)) {
+        derror("create learn segment dir %s failed", dir.c_str());
+        return std::string();
+    }
+
+    char path[512];
+    sprintf(path, "%s/log.%d.%" PRId64, dir.c_str(), _index, start_offset);
+    std::string tmp_path = std::string(path) + ".tmp";
+    std::ofstream os(tmp_path.c_str(),
+                     (std::ofstream::out | std::ios::binary | std::ofstream::trunc));
+    if (!os.is_open()) {
+        derror("open file %s failed", tmp_path.c_str());
+        return std::string();
+    }
+
+    // the copied blocks are re-chained on the crc of the rewritten file header, and their
+    // local offsets are shifted as well
+    auto write_block = [&os](const blob &body, uint32_t &crc) {
+        log_block_header hdr;
+        hdr.magic = 0xdeadbeef;
+        hdr.length = static_cast<int32_t>(body.length());
+        hdr.body_crc = dsn::utils::crc32_calc(
+            static_cast<const void *>(body.data()), static_cast<size_t>(body.length()), crc);
+        hdr.local_offset = static_cast<uint32_t>(os.tellp());
+        crc = hdr.body_crc;
+        os.write(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+        os.write(body.data(), body.length());
+    };
+
+    uint32_t crc = 0;
+    log_file_header header = src->header();
+    header.start_global_offset = start_offset;
+    binary_writer writer;
+    writer.write_pod(header);
+    writer.write(static_cast<int>(src->previous_log_max_decrees().size()));
+    for (auto &kv : src->previous_log_max_decrees()) {
+        writer.write_pod(kv.first);
+        writer.write_pod(kv.second);
+    }
+    write_block(writer.get_buffer(), crc);
+
+    src->seek_stream(entry.block_offset, entry.crc_seed);
+    int block_count = 0;
+    while ((err = src->read_next_log_block(bb)) == ERR_OK) {
+        write_block(bb, crc);
+        ++block_count;
+    }
+    src->close();
+    os.close();
+
+    // a block still being written ends the copy, as the mutations in it are learned from memory
+    if (err != ERR_HANDLE_EOF && err != ERR_INCOMPLETE_DATA) {
+        derror("read log file %s for learning failed, err = %s", _path.c_str(), err.to_string());
+        dsn::utils::filesystem::remove_path(tmp_path);
+        return std::string();
+    }
+    if (!dsn::utils::filesystem::rename_path(tmp_path, path)) {
+        derror("move file from %s to %s failed", tmp_path.c_str(), path);
+        dsn::utils::filesystem::remove_path(tmp_path);
+        return std::string();
+    }
+
+    ddebug("write learn segment %s from %s succeed, skipped_size = %" PRId64
+           ", block_count = %d",
+           path,
+           _path.c_str(),
+           static_cast<int64_t>(entry.local_offset) - header_block_size,
+           block_count);
+    return std::string(path);
 }
 
 decree log_file::previous_log_max_decree(const dsn::gpid &pid)
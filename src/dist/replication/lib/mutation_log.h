@@ -71,13 +71,19 @@ typedef std::unordered_map<gpid, replica_log_info> replica_log_info_map;
 // each block in log file has a log_block_header
 struct log_block_header
 {
-    int32_t magic;    // 0xdeadbeef
+    int32_t magic;    // 0xdeadbeef, or log_block_lz_magic
     int32_t length;   // block data length (not including log_block_header)
     int32_t body_crc; // block data crc (not including log_block_header)
     uint32_t
         local_offset; // start offset of the block (including log_block_header) in this log file
 };
 
+// magic of the blocks whose data is compressed: the data is the raw data length (uint32_t)
+// followed by the raw data compressed by utils::lz_compress().
+// offsets in the global space always count the raw size of blocks, so a log file with
+// compressed blocks is smaller than its range in the global space.
+static const uint32_t log_block_lz_magic = 0xdeadbeee;
+
 // each log file has a log_file_header stored at the beginning of the first block's data content
 struct log_file_header
 {
@@ -111,6 +117,12 @@ public:
     }
     // return total data size in the block
     size_t size() const { return _size; }
+    // remove all blobs but the first one
+    void clear_data()
+    {
+        _data.resize(1);
+        _size = _data.front().length();
+    }
 };
 
 //
@@ -185,6 +197,13 @@ public:
                              replay_callback callback,
                              /*out*/ int64_t &end_offset);
 
+    // salvage the logs in "dir" which fail to be replayed: the logs are cut at the first
+    // invalid block, and the dropped part is scanned to collect the max decree of every
+    // replica in it (a part which can't be scanned, including the blocks failing in crc
+    // checking, is covered by the header of the next log file).
+    // returns false if the max decrees of the dropped part can't be determined
+    static bool salvage(const std::string &dir, /*out*/ std::map<gpid, decree> &lost_decrees);
+
     //
     // maintain max_decree & valid_start_offset
     //
@@ -249,8 +268,35 @@ public:
     //
     // when this is a private log, log files are learned by remote replicas
     // return true if private log surely covers the learning range
+    // if the head file of state.files is only needed from its middle and 'segment_source' is
+    // not nullptr, it is set to that file, so that the caller may replace the head file with
+    // the result of write_learn_segment()
+    //
+    bool get_learn_state(gpid gpid,
+                         decree start,
+                         /*out*/ learn_state &state,
+                         /*out*/ log_file_ptr *segment_source = nullptr) const;
+
+    //
+    // copy the part of 'file' needed for learning from 'start' into a learn segment owned by
+    // the learner with 'learner_signature', i.e.,
+    // '{dir}/learn_segments/{learner_signature}.{seq}/log.{index}.{start_offset}'.
+    // a learner owns one segment at a time: the segment of its previous round is removed once
+    // the new one is written, as the learner has finished copying it before asking for more.
+    // returns the segment path, or an empty string if no block can be skipped, or a newer
+    // segment of the learner has been written meanwhile.
+    // the file is read and written synchronously, so it should not be called in the replica
+    // thread.
+    // thread safe
     //
-    bool get_learn_state(gpid gpid, decree start, /*out*/ learn_state &state) const;
+    std::string write_learn_segment(log_file_ptr file, decree start, int64_t learner_signature);
+
+    //
+    // remove the learn segments of the learners not in 'alive_learner_signatures', e.g., those
+    // who have completed learning or have been removed.
+    // thread safe
+    //
+    void gc_learn_segments(const std::set<int64_t> &alive_learner_signatures);
 
     //
     //  other inquiry routines
@@ -280,8 +326,15 @@ public:
     // thread safe
     void check_valid_start_offset(gpid gpid, int64_t valid_start_offset) const;
 
+    // total size of the log files in the global space, i.e., the raw size before compression,
+    // which is larger than the size on disk if some blocks are compressed
     int64_t size() const { return _global_end_offset - _global_start_offset; }
 
+    // compress the blocks written from now on when their data is not smaller than 'min_bytes',
+    // 0 for never; [replication] mutation_log_compress_min_bytes by default
+    // thread safe
+    void set_compress_min_bytes(uint32_t min_bytes);
+
     void hint_switch_file() { _switch_file_hint = true; }
     void demand_switch_file() { _switch_file_demand = true; }
 
@@ -314,6 +367,14 @@ private:
                              replay_callback callback,
                              /*out*/ int64_t &end_offset);
 
+    // scan the mutations from the current position of the log, and merge the max decree
+    // of every replica into "max_decrees".
+    // returns false if the scanning stops before the end of the log, e.g., at a block
+    // failing in crc checking
+    static bool scan_max_decrees(log_file_ptr log,
+                                 bool from_start,
+                                 /*inout*/ std::map<gpid, decree> &max_decrees);
+
     // update max decree without lock
     void update_max_decree_no_lock(gpid gpid, decree d);
 
@@ -335,9 +396,12 @@ protected:
     io_failure_callback _io_error_callback;
 
     // options
+    // the file size limits count raw bytes in the global space, so files with compressed
+    // blocks are smaller on disk
     int64_t _max_log_file_size_in_bytes;
     int64_t _min_log_file_size_in_bytes;
     bool _force_flush;
+    uint32_t _compress_min_bytes;
 
 private:
     ///////////////////////////////////////////////
@@ -368,6 +432,11 @@ private:
         _private_max_commit_on_disk; // the max last_committed_decree of written mutations up to now
                                      // used for limiting garbage collection of shared log, because
                                      // the ending of private log should be covered by shared log
+
+    // learn segments of private log, learner signature -> (seq, segment path)
+    zlock _learn_segments_lock;
+    uint64_t _learn_segment_seq;
+    std::map<int64_t, std::pair<uint64_t, std::string>> _learn_segments;
 };
 typedef dsn::ref_ptr<mutation_log> mutation_log_ptr;
 
@@ -532,10 +601,35 @@ public:
     //  - ERR_OK
     //  - ERR_HANDLE_EOF
     //  - ERR_INCOMPLETE_DATA
-    //  - ERR_INVALID_DATA
+    //  - ERR_INVALID_DATA: including a compressed block which fails to be decompressed, or
+    //    whose raw size is 0 or larger than mutation_log_compress_max_block_mb (checked before
+    //    the raw data is allocated)
+    //  - ERR_WRONG_CHECKSUM: the crc of the block body mismatches; the file position has been
+    //    moved past the block, and the crc chain is re-seeded with the crc recorded in the block
+    //    header, so the caller may skip the block and go on verifying the following blocks
     //  - other io errors caused by file read operator
+    // when the file is memory mapped, 'bb' references the mapping instead of a copy
+    // compressed blocks are decompressed, so 'bb' is always the raw data
     error_code read_next_log_block(/*out*/ ::dsn::blob &bb);
 
+    //
+    // decree index routines
+    //
+
+    // remember that all the mutations before the block at 'local_offset' (in the global space,
+    // relative to the start offset) have decrees not larger than 'max_decree_before'; must be
+    // called right before the block is committed or read, so that the current crc and block
+    // offset are those of the block.
+    // the index is sparse: a boundary too close to the last remembered one is ignored.
+    // thread safe
+    void add_decree_index(decree max_decree_before, int64_t local_offset);
+
+    // copy the file header and the blocks starting from the last indexed boundary before
+    // which all decrees are less than 'start_decree' into '{dir}/log.{index}.{start_offset}',
+    // where the start offset is shifted so that the copy can be replayed like a full file.
+    // returns the path of the copy, or an empty string if no block can be skipped.
+    std::string write_learn_segment(decree start_decree, const std::string &dir);
+
     //
     // write routines
     //
@@ -545,7 +639,8 @@ public:
     static log_block *prepare_log_block();
 
     // async write log entry into the file
-    // 'block' is the date to be writen
+    // 'block' is the date to be writen, which is compressed in place when its data is not
+    // smaller than the compress_min_bytes of the file
     // 'offset' is start offset of the entry in the global space
     // 'evt' is to indicate which thread pool to execute the callback
     // 'callback_host' is used to get tracer
@@ -566,8 +661,11 @@ public:
     //
     // reset file_streamer to point to the start of this log file.
     void reset_stream();
-    // end offset in the global space: end_offset = start_offset + file_size
+    // end offset in the global space: end_offset = start_offset + file_size, if no blocks are
+    // compressed
     int64_t end_offset() const { return _end_offset.load(); }
+    // correct the end offset got from the file size when the file is opened for read
+    void set_end_offset(int64_t end_offset) { _end_offset.store(end_offset); }
     // start offset in the global space
     int64_t start_offset() const { return _start_offset; }
     // file index
@@ -590,6 +688,18 @@ public:
     // if the file header is valid
     bool is_right_header() const;
 
+    // blocks with data not smaller than this size are compressed on commit, 0 for never;
+    // [replication] mutation_log_compress_min_bytes by default;
+    // thread safe, the blocks prepared from now on are affected
+    void set_compress_min_bytes(uint32_t min_bytes) { _compress_min_bytes.store(min_bytes); }
+    uint32_t compress_min_bytes() const { return _compress_min_bytes.load(); }
+
+    // whether the file for read is read through mmap, set before the first reset_stream();
+    // [replication] mutation_log_mmap_read by default
+    void set_mmap_read_enabled(bool enabled) { _mmap_read_enabled = enabled; }
+    // if the file is being read through mmap
+    bool is_mapped() const { return _mapped_stream != nullptr; }
+
     // set & get last write time, used for gc
     void set_last_write_time(uint64_t last_write_time) { _last_write_time = last_write_time; }
     uint64_t last_write_time() const { return _last_write_time; }
@@ -598,24 +708,49 @@ private:
     // make private, user should create log_file through open_read() or open_write()
     log_file(const char *path, dsn_handle_t handle, int index, int64_t start_offset, bool is_read);
 
+    // read from whichever streamer reset_stream() has created
+    error_code read_next(size_t size, /*out*/ ::dsn::blob &result);
+    // move the streamer to 'block_offset', with 'crc' as the crc seed of the next block
+    void seek_stream(int64_t block_offset, uint32_t crc);
+
 private:
     uint32_t _crc32;
+    int64_t _block_offset; // physical offset in this file of the next block to read or write
     int64_t _start_offset; // start offset in the global space
     std::atomic<int64_t>
         _end_offset; // end offset in the global space: end_offset = start_offset + file_size
     class file_streamer;
     std::unique_ptr<file_streamer> _stream;
+    // used instead of _stream when the (sealed) file for read can be memory mapped, the
+    // blocks read through it are copied out, so the mapping never outlives the log_file
+    class mapped_file_streamer;
+    std::unique_ptr<mapped_file_streamer> _mapped_stream;
     dsn_handle_t _handle;      // file handle
     bool _is_read;             // if opened for read or write
     std::string _path;         // file path
     int _index;                // file index
     log_file_header _header;   // file header
     uint64_t _last_write_time; // seconds from epoch time
+    // set under the lock of mutation_log, but read without it when blocks are prepared
+    std::atomic<uint32_t> _compress_min_bytes;
+    bool _mmap_read_enabled;
 
     // this data is used for garbage collection, and is part of file header.
     // for read, the value is read from file header.
     // for write, the value is set by write_file_header().
     replica_log_info_map _previous_log_max_decrees;
+
+    // a sparse index from decrees to block boundaries, built when the blocks are written
+    // or replayed, used to learn only the tail of the file.
+    struct decree_index_entry
+    {
+        decree max_decree_before; // max decree of the mutations before the block
+        uint32_t local_offset;    // start offset of the block in the global space - _start_offset
+        uint32_t block_offset;    // start offset of the block in the file, see _block_offset
+        uint32_t crc_seed;        // crc of the previous block, which the block is chained on
+    };
+    mutable zlock _decree_index_lock;
+    std::vector<decree_index_entry> _decree_index;
 };
 }
 } // namespace
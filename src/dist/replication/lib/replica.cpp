@@ -59,7 +59,19 @@ replica::replica(
       _chkpt_total_size(0),
       _cur_download_size(0),
       _restore_progress(0),
-      _restore_status(ERR_OK)
+      _restore_status(ERR_OK),
+      _recent_read_count(0),
+      _recent_read_bytes(0),
+      _recent_write_count(0),
+      _recent_write_bytes(0),
+      _last_load_collect_time_ms(0),
+      _read_qps(0),
+      _write_qps(0),
+      _read_bytes_per_second(0),
+      _write_bytes_per_second(0),
+      _storage_mb(-1),
+      _app_data_size(0),
+      _app_data_size_decree(-1)
 {
     dassert(_app_info.app_type != "", "");
     dassert(stub != nullptr, "");
@@ -97,6 +109,39 @@ void replica::update_commit_statistics(int count)
     _stub->_counter_replicas_total_commit_throught->add((uint64_t)count);
 }
 
+void replica::collect_load_stat()
+{
+    uint64_t now = dsn_now_ms();
+    uint64_t read_count = _recent_read_count.exchange(0);
+    uint64_t read_bytes = _recent_read_bytes.exchange(0);
+    uint64_t write_count = _recent_write_count.exchange(0);
+    uint64_t write_bytes = _recent_write_bytes.exchange(0);
+
+    // the first sample only resets the counters
+    if (_last_load_collect_time_ms != 0 && now > _last_load_collect_time_ms) {
+        uint64_t interval_ms = now - _last_load_collect_time_ms;
+        _read_qps.store(read_count * 1000 / interval_ms);
+        _read_bytes_per_second.store(read_bytes * 1000 / interval_ms);
+        _write_qps.store(write_count * 1000 / interval_ms);
+        _write_bytes_per_second.store(write_bytes * 1000 / interval_ms);
+    }
+    _last_load_collect_time_ms = now;
+}
+
+void replica::get_load_stat(/*out*/ replica_info &info) const
+{
+    info.__set_read_qps(_read_qps.load());
+    info.__set_write_qps(_write_qps.load());
+    info.__set_read_bytes_per_second(_read_bytes_per_second.load());
+    info.__set_write_bytes_per_second(_write_bytes_per_second.load());
+
+    // storage size is unknown until the first garbage collection finishes
+    int64_t storage_mb = _storage_mb.load();
+    if (storage_mb >= 0) {
+        info.__set_storage_mb(storage_mb);
+    }
+}
+
 void replica::init_state()
 {
     _inactive_is_transient = false;
@@ -160,6 +205,8 @@ void replica::on_client_read(task_code code, dsn_message_t request)
     }
 
     dassert(_app != nullptr, "");
+    _recent_read_count.fetch_add(1, std::memory_order_relaxed);
+    _recent_read_bytes.fetch_add(dsn_msg_body_size(request), std::memory_order_relaxed);
     _app->on_request(request);
 }
 
@@ -334,6 +381,13 @@ void replica::execute_mutation(mutation_ptr &mu)
 
     if (err != ERR_OK) {
         handle_local_failure(err);
+    } else if (_app->last_committed_decree() == d) {
+        uint64_t bytes = 0;
+        for (const mutation_update &update : mu->data.updates) {
+            bytes += update.data.length();
+        }
+        _recent_write_count.fetch_add(mu->data.updates.size(), std::memory_order_relaxed);
+        _recent_write_bytes.fetch_add(bytes, std::memory_order_relaxed);
     }
 
     if (status() == partition_status::PS_PRIMARY) {
@@ -50,6 +50,8 @@
 #include "prepare_list.h"
 #include "replica_context.h"
 
+class replication_service_test_app;
+
 namespace dsn {
 namespace replication {
 
@@ -150,6 +152,9 @@ public:
     // void json_state(std::stringstream& out) const;
     void update_commit_statistics(int count);
 
+    // fill the load statistics (qps, throughput, storage) sampled by collect_load_stat()
+    void get_load_stat(/*out*/ replica_info &info) const;
+
     // routine for get extra envs from replica
     const std::map<std::string, std::string> &get_replica_extra_envs() const { return _extra_envs; }
 
@@ -260,6 +265,11 @@ private:
     void trigger_async_checkpoint_for_backup(cold_backup_context_ptr backup_context);
     void wait_async_checkpoint_for_backup(cold_backup_context_ptr backup_context);
     void local_create_backup_checkpoint(cold_backup_context_ptr backup_context);
+    // link the latest app checkpoint into 'dir' if cold_backup_link_checkpoint_enabled, and copy
+    // the app state into it if not enabled or the linking fails
+    error_code create_backup_checkpoint_dir(const cold_backup_context_ptr &backup_context,
+                                            const std::string &dir,
+                                            /*out*/ int64_t *last_decree);
     void send_backup_request_to_secondary(const backup_request &request);
     // set all cold_backup_state cancel/pause
     void set_backup_context_cancel();
@@ -268,6 +278,12 @@ private:
 
     void collect_backup_info();
 
+    /////////////////////////////////////////////////////////////////
+    // load statistics
+    void collect_load_stat();
+    // total size in bytes of the files under the app data dir
+    int64_t get_app_data_size() const;
+
     /////////////////////////////////////////////////////////////////
     // replica restore from backup
     bool read_cold_backup_metadata(const std::string &file, cold_backup_metadata &backup_metadata);
@@ -302,6 +318,7 @@ private:
     friend class ::dsn::replication::test::test_checker;
     friend class ::dsn::replication::mutation_queue;
     friend class ::dsn::replication::replica_stub;
+    friend class ::replication_service_test_app;
 
     // replica configuration, updated by update_local_configuration ONLY
     replica_configuration _config;
@@ -360,6 +377,22 @@ private:
     //                                data, so skip the damaged partition
     dsn::error_code _restore_status;
 
+    // load statistics, accumulated by client read/commit path and sampled
+    // by collect_load_stat() on _collect_info_timer
+    std::atomic<uint64_t> _recent_read_count;
+    std::atomic<uint64_t> _recent_read_bytes;
+    std::atomic<uint64_t> _recent_write_count;
+    std::atomic<uint64_t> _recent_write_bytes;
+    uint64_t _last_load_collect_time_ms;
+    std::atomic<int64_t> _read_qps;
+    std::atomic<int64_t> _write_qps;
+    std::atomic<int64_t> _read_bytes_per_second;
+    std::atomic<int64_t> _write_bytes_per_second;
+    std::atomic<int64_t> _storage_mb;
+    // size of the app data dir, which is only rescanned when a new checkpoint is durable
+    std::atomic<int64_t> _app_data_size;
+    std::atomic<decree> _app_data_size_decree;
+
     bool _inactive_is_transient; // upgrade to P/S is allowed only iff true
     bool _is_initializing;       // when initializing, switching to primary need to update ballot
 
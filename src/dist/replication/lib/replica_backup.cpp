@@ -558,12 +558,94 @@ void replica::wait_async_checkpoint_for_backup(cold_backup_context_ptr backup_co
     }
 }
 
+// hard link the files of the latest app checkpoint into 'dir', so that the backup checkpoint costs
+// neither disk io nor disk space, and its files stay even if the app removes the checkpoint later.
+// fails if the app checkpoint is not made up of plain files only.
+static error_code link_app_checkpoint_to_dir(replication_app_base *app,
+                                             const cold_backup_context_ptr &backup_context,
+                                             const std::string &dir,
+                                             /*out*/ int64_t *last_decree)
+{
+    blob learn_request;
+    learn_state state;
+    error_code err = app->prepare_get_checkpoint(learn_request);
+    if (err == ERR_OK) {
+        err = app->get_checkpoint(0, learn_request, state);
+    }
+    if (err != ERR_OK) {
+        return err;
+    }
+    if (state.meta.length() > 0) {
+        ddebug("%s: app checkpoint has meta data, which can not be linked", backup_context->name);
+        return ERR_NOT_IMPLEMENTED;
+    }
+    if (state.to_decree_included < backup_context->checkpoint_decree) {
+        ddebug("%s: app checkpoint is behind, to_decree_included = %" PRId64
+               ", checkpoint_decree = %" PRId64,
+               backup_context->name,
+               state.to_decree_included,
+               backup_context->checkpoint_decree);
+        return ERR_WRONG_TIMING;
+    }
+    // the files are linked flat into the dir, so a checkpoint spanning several dirs is copied
+    if (!state.files.empty()) {
+        std::string file_dir = dsn::utils::filesystem::remove_file_name(state.files.front());
+        for (const std::string &file : state.files) {
+            if (dsn::utils::filesystem::remove_file_name(file) != file_dir) {
+                ddebug("%s: app checkpoint has nested file(%s), which can not be linked",
+                       backup_context->name,
+                       file.c_str());
+                return ERR_NOT_IMPLEMENTED;
+            }
+        }
+    }
+
+    if (!dsn::utils::filesystem::create_directory(dir)) {
+        derror("%s: create dir(%s) failed", backup_context->name, dir.c_str());
+        return ERR_FILE_OPERATION_FAILED;
+    }
+    for (const std::string &file : state.files) {
+        std::string target =
+            dsn::utils::filesystem::path_combine(dir, dsn::utils::filesystem::get_file_name(file));
+        if (!dsn::utils::filesystem::link_file(file, target)) {
+            derror("%s: link file(%s) to %s failed",
+                   backup_context->name,
+                   file.c_str(),
+                   target.c_str());
+            return ERR_FILE_OPERATION_FAILED;
+        }
+    }
+
+    *last_decree = state.to_decree_included;
+    return ERR_OK;
+}
+
+error_code replica::create_backup_checkpoint_dir(const cold_backup_context_ptr &backup_context,
+                                                 const std::string &dir,
+                                                 /*out*/ int64_t *last_decree)
+{
+    error_code err = ERR_NOT_IMPLEMENTED;
+    if (_options->cold_backup_link_checkpoint_enabled) {
+        err = link_app_checkpoint_to_dir(_app.get(), backup_context, dir, last_decree);
+        if (err != ERR_OK) {
+            dwarn("%s: link app checkpoint failed with err = %s, copy it instead",
+                  backup_context->name,
+                  err.to_string());
+            dsn::utils::filesystem::remove_path(dir);
+        }
+    }
+    if (err != ERR_OK) {
+        err = _app->copy_checkpoint_to_dir(dir.c_str(), last_decree);
+    }
+    return err;
+}
+
 // run in REPLICATION_LONG thread
 // Effection:
 // - may ignore_checkpoint() if in invalid status
 // - may fail_checkpoint() if some error occurs
 // - may complete_checkpoint() and schedule on_cold_backup() if checkpoint dir is successfully
-// copied
+// linked or copied
 void replica::local_create_backup_checkpoint(cold_backup_context_ptr backup_context)
 {
     if (backup_context->status() != ColdBackupCheckpointing) {
@@ -583,7 +665,7 @@ void replica::local_create_backup_checkpoint(cold_backup_context_ptr backup_cont
                                 backup_context->checkpoint_timestamp));
     int64_t last_decree = 0;
     dsn::error_code err =
-        _app->copy_checkpoint_to_dir(backup_checkpoint_tmp_dir_path.c_str(), &last_decree);
+        create_backup_checkpoint_dir(backup_context, backup_checkpoint_tmp_dir_path, &last_decree);
     if (err != ERR_OK) {
         // try local_create_backup_checkpoint 10s later
         ddebug("%s: create backup checkpoint failed with err = %s, try call "
@@ -63,11 +63,18 @@ void replica::on_checkpoint_timer()
         mutation_log_ptr plog = _private_log;
         decree durable_decree = _app->last_durable_decree();
         int64_t valid_start_offset = _app->init_info().init_offset_in_private_log;
+        std::set<int64_t> alive_learners;
+        if (status() == partition_status::PS_PRIMARY) {
+            for (auto &kv : _primary_states.learners) {
+                alive_learners.insert(kv.second.signature);
+            }
+        }
         tasking::enqueue(LPC_GARBAGE_COLLECT_LOGS_AND_REPLICAS,
                          this,
-                         [this, plog, durable_decree, valid_start_offset] {
+                         [this, plog, durable_decree, valid_start_offset, alive_learners] {
                              // run in background thread to avoid file deletion operation blocking
                              // replication thread.
+                             plog->gc_learn_segments(alive_learners);
                              if (status() == partition_status::PS_ERROR ||
                                  status() == partition_status::PS_INACTIVE)
                                  return;
@@ -79,10 +86,33 @@ void replica::on_checkpoint_timer()
                                  (int64_t)_options->log_private_reserve_max_time_seconds);
                              if (status() == partition_status::PS_PRIMARY)
                                  _counter_private_log_size->set(_private_log->size() / 1000000);
+
+                             // storage size reported to meta server for load balancing.
+                             // the private log is the only dir cleaned here and its size is
+                             // known, while the app data dir only changes much by checkpoints
+                             if (_app_data_size_decree.exchange(durable_decree) != durable_decree)
+                                 _app_data_size.store(get_app_data_size());
+                             _storage_mb.store((plog->size() + _app_data_size.load()) >> 20);
                          });
     }
 }
 
+// run in background thread
+int64_t replica::get_app_data_size() const
+{
+    int64_t size = 0;
+    std::vector<std::string> files;
+    if (utils::filesystem::get_subfiles(_app->data_dir(), files, true)) {
+        for (const std::string &file : files) {
+            int64_t sz = 0;
+            if (utils::filesystem::file_size(file, sz)) {
+                size += sz;
+            }
+        }
+    }
+    return size;
+}
+
 // run in replica thread
 void replica::init_checkpoint(bool is_emergency)
 {
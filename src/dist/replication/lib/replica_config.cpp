@@ -190,6 +190,7 @@ void replica::add_potential_secondary(configuration_update_request &proposal)
     remote_learner_state state;
     state.prepare_start_decree = invalid_decree;
     state.timeout_task = nullptr; // TODO: add timer for learner task
+    state.last_learn_log_file_index = 0;
 
     auto it = _primary_states.learners.find(proposal.node);
     if (it != _primary_states.learners.end()) {
@@ -821,23 +821,45 @@ void cold_backup_context::prepare_upload()
         std::string &file = checkpoint_files[idx];
         file_meta f_meta;
         f_meta.name = file;
-        std::string file_full_path = ::dsn::utils::filesystem::path_combine(checkpoint_dir, file);
         int64_t file_size = checkpoint_file_sizes[idx];
-        std::string file_md5;
-        if (::dsn::utils::filesystem::md5sum(file_full_path, file_md5) != ERR_OK) {
-            derror("%s: get local file size or md5 fail, file = %s", name, file_full_path.c_str());
-            fail_upload("compute local file size or md5 failed");
-            return;
-        }
-        f_meta.md5 = file_md5;
+        // md5 is filled in when the file is uploaded, see on_upload()
         f_meta.size = file_size;
         _metadata.files.emplace_back(f_meta);
         _file_status.insert(std::make_pair(file, FileUploadUncomplete));
-        _file_infos.insert(std::make_pair(file, std::make_pair(file_size, file_md5)));
+        _file_infos.insert(std::make_pair(file, std::make_pair(file_size, std::string())));
     }
     _upload_file_size.store(0);
 }
 
+bool cold_backup_context::prepare_file_md5(const std::string &local_filename)
+{
+    {
+        zauto_lock l(_lock);
+        if (!_file_infos.at(local_filename).second.empty()) {
+            return true;
+        }
+    }
+
+    std::string file_full_path =
+        ::dsn::utils::filesystem::path_combine(checkpoint_dir, local_filename);
+    std::string file_md5;
+    if (::dsn::utils::filesystem::md5sum(file_full_path, file_md5) != ERR_OK) {
+        derror("%s: get local file md5 fail, file = %s", name, file_full_path.c_str());
+        fail_upload("compute local file md5 failed");
+        return false;
+    }
+
+    zauto_lock l(_lock);
+    _file_infos.at(local_filename).second = file_md5;
+    return true;
+}
+
+std::string cold_backup_context::get_file_md5(const std::string &local_filename)
+{
+    zauto_lock l(_lock);
+    return _file_infos.at(local_filename).second;
+}
+
 void cold_backup_context::upload_file(const std::string &local_filename)
 {
     std::string remote_chkpt_dir = cold_backup::get_remote_chkpt_dir(
@@ -856,11 +878,20 @@ void cold_backup_context::upload_file(const std::string &local_filename)
                 const dist::block_service::block_file_ptr &file_handle = resp.file_handle;
                 dassert(file_handle != nullptr, "");
                 int64_t local_file_size = _file_infos.at(local_filename).first;
-                std::string md5 = _file_infos.at(local_filename).second;
                 std::string full_path_local_file =
                     ::dsn::utils::filesystem::path_combine(checkpoint_dir, local_filename);
-                if (md5 == file_handle->get_md5sum() &&
-                    local_file_size == file_handle->get_size()) {
+                // the local md5 is only needed to tell whether a remote file of the same size is
+                // left by a previous uploading, so the file is not read for it otherwise; this
+                // runs in the callback of LPC_BACKGROUND_COLD_BACKUP rather than on the loop
+                // which starts the uploading of files
+                if (local_file_size != file_handle->get_size()) {
+                    ddebug("%s: start upload checkpoint file to remote, file = %s",
+                           name,
+                           full_path_local_file.c_str());
+                    on_upload(file_handle, full_path_local_file);
+                } else if (!prepare_file_md5(local_filename)) {
+                    // fail_upload() is done by prepare_file_md5()
+                } else if (get_file_md5(local_filename) == file_handle->get_md5sum()) {
                     ddebug("%s: checkpoint file already exist on remote, file = %s",
                            name,
                            full_path_local_file.c_str());
@@ -941,10 +972,31 @@ void cold_backup_context::on_upload(const dist::block_service::block_file_ptr &f
                 dassert(_file_infos.at(local_filename).first ==
                             static_cast<int64_t>(resp.uploaded_size),
                         "");
-                ddebug("%s: upload checkpoint file complete, file = %s",
-                       name,
-                       full_path_local_file.c_str());
-                on_upload_file_complete(local_filename);
+                // the block service checksums the bytes as they are uploaded, so take its md5
+                // instead of reading the file once more, and only compute it locally when the
+                // block service gives none
+                const std::string &uploaded_md5 = file_handle->get_md5sum();
+                std::string local_md5 = get_file_md5(local_filename);
+                if (local_md5.empty() && !uploaded_md5.empty()) {
+                    zauto_lock l(_lock);
+                    _file_infos.at(local_filename).second = uploaded_md5;
+                }
+                if (!local_md5.empty() && !uploaded_md5.empty() && local_md5 != uploaded_md5) {
+                    derror("%s: md5 of uploaded checkpoint file mismatch, file = %s, "
+                           "local md5 = %s, remote md5 = %s",
+                           name,
+                           full_path_local_file.c_str(),
+                           local_md5.c_str(),
+                           uploaded_md5.c_str());
+                    fail_upload("md5 of uploaded checkpoint file mismatch");
+                } else if (uploaded_md5.empty() && !prepare_file_md5(local_filename)) {
+                    // fail_upload() is done by prepare_file_md5()
+                } else {
+                    ddebug("%s: upload checkpoint file complete, file = %s",
+                           name,
+                           full_path_local_file.c_str());
+                    on_upload_file_complete(local_filename);
+                }
             } else if (resp.err == ERR_TIMEOUT) {
                 derror("%s: upload checkpoint file timeout, retry after 10s, file = %s",
                        name,
@@ -1007,6 +1059,15 @@ void cold_backup_context::write_backup_metadata()
         [this, metadata](const dist::block_service::create_file_response &resp) {
             if (resp.err == ERR_OK) {
                 dassert(resp.file_handle != nullptr, "");
+                {
+                    zauto_lock l(_lock);
+                    for (file_meta &f_meta : _metadata.files) {
+                        auto iter = _file_infos.find(f_meta.name);
+                        if (iter != _file_infos.end() && !iter->second.second.empty()) {
+                            f_meta.md5 = iter->second.second;
+                        }
+                    }
+                }
                 blob buffer = json::json_forwarder<cold_backup_metadata>::encode(_metadata);
                 // hold itself until callback is executed
                 add_ref();
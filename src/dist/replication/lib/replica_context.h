@@ -52,7 +52,7 @@ struct remote_learner_state
     int64_t signature;
     ::dsn::task_ptr timeout_task;
     decree prepare_start_decree;
-    std::string last_learn_log_file;
+    int last_learn_log_file_index;
 };
 
 typedef std::unordered_map<::dsn::rpc_address, remote_learner_state> learner_map;
@@ -438,6 +438,10 @@ private:
                   const blob &value,
                   const std::function<void(bool)> &callback);
     void prepare_upload();
+    // compute the md5 of the local file if not yet, returns false and fails the uploading on error
+    bool prepare_file_md5(const std::string &local_filename);
+    // returns empty if the md5 is not known yet
+    std::string get_file_md5(const std::string &local_filename);
     void on_upload_chkpt_dir();
     void upload_file(const std::string &local_filename);
     void on_upload(const dist::block_service::block_file_ptr &file_handle,
@@ -503,7 +507,7 @@ private:
     std::atomic_int _upload_status;
 
     int32_t _max_concurrent_uploading_file_cnt;
-    // filename -> <filesize, md5>
+    // filename -> <filesize, md5>, md5 is empty until the file is going to be uploaded
     std::map<std::string, std::pair<int64_t, std::string>> _file_infos;
 
     zlock _lock; // lock the structure below
@@ -349,7 +349,10 @@ error_code replica::init_app_and_prepare_list(bool create_new)
             _collect_info_timer =
                 tasking::enqueue_timer(LPC_PER_REPLICA_COLLECT_INFO_TIMER,
                                        this,
-                                       [this]() { collect_backup_info(); },
+                                       [this]() {
+                                           collect_backup_info();
+                                           collect_load_stat();
+                                       },
                                        std::chrono::milliseconds(_options->gc_interval_ms),
                                        get_gpid().thread_hash());
         }
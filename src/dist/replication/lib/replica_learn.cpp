@@ -228,6 +228,18 @@ void replica::init_learn(uint64_t signature)
                   });
 }
 
+// the index of a log file named 'log.{index}.{start_offset}', or -1 if the name is invalid
+static int get_log_file_index(const std::string &path)
+{
+    char splitters[] = {'\\', '/', 0};
+    std::string name = utils::get_last_component(path, splitters);
+    int index;
+    if (sscanf(name.c_str(), "log.%d.", &index) != 1) {
+        return -1;
+    }
+    return index;
+}
+
 void replica::on_learn(dsn_message_t msg, const learn_request &request)
 {
     check_hashed_access();
@@ -322,6 +334,7 @@ void replica::on_learn(dsn_message_t msg, const learn_request &request)
             learn_start_decree,
             local_committed_decree + 1);
     bool delayed_replay_prepare_list = false;
+    log_file_ptr segment_source;
 
     ddebug("%s: on_learn[%016" PRIx64 "]: learner = %s, remote_committed_decree = %" PRId64 ", "
            "remote_app_committed_decree = %" PRId64 ", local_committed_decree = %" PRId64 ", "
@@ -410,9 +423,11 @@ void replica::on_learn(dsn_message_t msg, const learn_request &request)
                    request.learner.to_string(),
                    learn_start_decree,
                    _app->last_durable_decree());
-            _private_log->get_learn_state(get_gpid(), learn_start_decree, response.state);
+            _private_log->get_learn_state(
+                get_gpid(), learn_start_decree, response.state, &segment_source);
             response.type = learn_type::LT_LOG;
-        } else if (_private_log->get_learn_state(get_gpid(), learn_start_decree, response.state)) {
+        } else if (_private_log->get_learn_state(
+                       get_gpid(), learn_start_decree, response.state, &segment_source)) {
             ddebug("%s: on_learn[%016" PRIx64 "]: learner = %s, choose to learn private logs, "
                    "because mutation_log::get_learn_state() returns true",
                    name(),
@@ -436,8 +451,10 @@ void replica::on_learn(dsn_message_t msg, const learn_request &request)
         if (response.type == learn_type::LT_LOG) {
             response.base_local_dir = _private_log->dir();
             if (response.state.files.size() > 0) {
+                // compare by index, as the file may be replaced by a learn segment later
                 auto &last_file = response.state.files.back();
-                if (last_file == learner_state.last_learn_log_file) {
+                int last_file_index = get_log_file_index(last_file);
+                if (last_file_index == learner_state.last_learn_log_file_index) {
                     ddebug(
                         "%s: on_learn[%016" PRIx64
                         "]: learner = %s, learn the same file %s repeatedly, hint to switch file",
@@ -447,7 +464,7 @@ void replica::on_learn(dsn_message_t msg, const learn_request &request)
                         last_file.c_str());
                     _private_log->hint_switch_file();
                 } else {
-                    learner_state.last_learn_log_file = last_file;
+                    learner_state.last_learn_log_file_index = last_file_index;
                 }
             }
             // it is safe to commit to last_committed_decree() now
@@ -488,6 +505,32 @@ void replica::on_learn(dsn_message_t msg, const learn_request &request)
         }
     }
 
+    if (response.type == learn_type::LT_LOG && segment_source != nullptr) {
+        dassert(!delayed_replay_prepare_list, "prepare list is not replayed when learning logs");
+
+        // copying the tail of the head file may take long, so it is done off the replica thread,
+        // and the response is sent after that; the whole file is learned if no segment is got
+        mutation_log_ptr plog = _private_log;
+        int64_t signature = request.signature;
+        dsn_msg_add_ref(msg); // released after replied
+        tasking::enqueue(
+            LPC_WRITE_LEARN_SEGMENT,
+            this,
+            [this, plog, msg, segment_source, learn_start_decree, signature, response]() mutable {
+                std::string segment =
+                    plog->write_learn_segment(segment_source, learn_start_decree, signature);
+                if (!segment.empty()) {
+                    response.state.files.front() = segment;
+                }
+                for (auto &file : response.state.files) {
+                    file = file.substr(response.base_local_dir.length() + 1);
+                }
+                reply(msg, response);
+                dsn_msg_release_ref(msg);
+            });
+        return;
+    }
+
     for (auto &file : response.state.files) {
         file = file.substr(response.base_local_dir.length() + 1);
     }
@@ -264,6 +264,23 @@ void replica_stub::install_perf_counters()
                                                          "current manual compact in queue count");
 }
 
+/*static*/ bool replica_stub::can_keep_salvaged_replica(bool salvaged,
+                                                       const std::map<gpid, decree> &lost_decrees,
+                                                       gpid pid,
+                                                       decree max_prepared_decree,
+                                                       decree max_decree_in_plog)
+{
+    if (!salvaged) {
+        return false;
+    }
+    decree required = max_prepared_decree;
+    auto find = lost_decrees.find(pid);
+    if (find != lost_decrees.end()) {
+        required = std::max(required, find->second);
+    }
+    return max_decree_in_plog >= required;
+}
+
 void replica_stub::initialize(bool clear /* = false*/)
 {
     replication_options opts;
@@ -436,9 +453,37 @@ void replica_stub::initialize(const replication_options &opts, bool clear /* = f
         // otherwise, the next process restart may consider the replicas'
         // state complete
 
-        // delete all replicas
+        // in salvage mode, the replicas whose private logs cover all the mutations
+        // which may be lost in the shared log are kept, and the others are deleted
+        std::map<gpid, decree> lost_decrees;
+        bool salvaged = false;
+        if (_options.log_shared_salvage_enabled) {
+            salvaged = mutation_log::salvage(_options.slog_dir, lost_decrees);
+            if (!salvaged) {
+                derror("salvage shared log failed, delete all replicas");
+            }
+        }
+
         // TODO: checkpoint latest state and update on meta server so learning is cheaper
-        for (auto it = rps.begin(); it != rps.end(); ++it) {
+        for (auto it = rps.begin(); it != rps.end();) {
+            if (salvaged && it->second->private_log() != nullptr) {
+                decree pmax = it->second->private_log()->max_decree(it->first);
+                if (can_keep_salvaged_replica(salvaged,
+                                              lost_decrees,
+                                              it->first,
+                                              it->second->max_prepared_decree(),
+                                              pmax)) {
+                    ddebug("%s: salvage replica succeed, max_decree_in_plog = %" PRId64,
+                           it->second->name(),
+                           pmax);
+                    ++it;
+                    continue;
+                }
+                dwarn("%s: salvage replica failed, max_decree_in_plog = %" PRId64,
+                      it->second->name(),
+                      pmax);
+            }
+
             it->second->close();
             // move to '.err' directory
             const char *dir = it->second->dir().c_str();
@@ -450,8 +495,8 @@ void replica_stub::initialize(const replication_options &opts, bool clear /* = f
                   dir,
                   rename_dir);
             _counter_replicas_recent_replica_move_error_count->increment();
+            it = rps.erase(it);
         }
-        rps.clear();
 
         // restart log service
         _log->close();
@@ -465,10 +510,37 @@ void replica_stub::initialize(const replication_options &opts, bool clear /* = f
         dassert(lerr == ERR_OK, "restart log service must succeed");
     }
 
+    // checkpoint the replayed state, the replicas on different disks are done in parallel
+    std::map<std::string, std::vector<replica_ptr>> disk_replicas;
+    for (auto it = rps.begin(); it != rps.end(); ++it) {
+        disk_replicas[utils::filesystem::remove_file_name(it->second->dir())].push_back(
+            it->second);
+    }
+    start_time = dsn_now_ms();
+    for (auto &kv : disk_replicas) {
+        const std::vector<replica_ptr> &replicas_on_disk = kv.second;
+        load_tasks.push_back(tasking::create_task(LPC_REPLICATION_INIT_CHECKPOINT,
+                                                  this,
+                                                  [&replicas_on_disk] {
+                                                      for (auto &r : replicas_on_disk) {
+                                                          r->sync_checkpoint();
+                                                          r->reset_prepare_list_after_replay();
+                                                      }
+                                                  },
+                                                  load_tasks.size()));
+        load_tasks.back()->enqueue();
+    }
+    for (auto &tsk : load_tasks) {
+        tsk->wait();
+    }
+    finish_time = dsn_now_ms();
+    load_tasks.clear();
+    ddebug("checkpoint replicas succeed, disk_count = %d, time_used = %" PRIu64 " ms",
+           static_cast<int>(disk_replicas.size()),
+           finish_time - start_time);
+
     bool is_log_complete = true;
     for (auto it = rps.begin(); it != rps.end(); ++it) {
-        it->second->sync_checkpoint();
-        it->second->reset_prepare_list_after_replay();
 
         decree smax = _log->max_decree(it->first);
         decree pmax = invalid_decree;
@@ -995,6 +1067,7 @@ void replica_stub::get_replica_info(replica_info &info, replica_ptr r)
     info.last_committed_decree = r->last_committed_decree();
     info.last_prepared_decree = r->last_prepared_decree();
     info.last_durable_decree = r->last_durable_decree();
+    r->get_load_stat(info);
 
     dsn::error_code err = _fs_manager.get_disk_tag(r->dir(), info.disk_tag);
     if (dsn::ERR_OK != err) {
@@ -84,6 +84,15 @@ public:
     void open_service();
     void close();
 
+    // whether a replica can be kept after the shared log fails to be replayed: the salvage
+    // must succeed, and the private log must cover both the max prepared decree of the
+    // replica and the max decree of it which is lost in the shared log
+    static bool can_keep_salvaged_replica(bool salvaged,
+                                          const std::map<gpid, decree> &lost_decrees,
+                                          gpid pid,
+                                          decree max_prepared_decree,
+                                          decree max_decree_in_plog);
+
     //
     //    requests from clients
     //
@@ -463,6 +463,30 @@ int replication_app_base::on_batched_write_requests(int64_t decree,
     return storage_error;
 }
 
+int replication_app_base::on_batched_write_updates(int64_t decree,
+                                                   int64_t timestamp,
+                                                   const mutation_update *updates,
+                                                   int update_count)
+{
+    dsn_message_t *faked_requests = (dsn_message_t *)alloca(sizeof(dsn_message_t) * update_count);
+    for (int i = 0; i < update_count; i++) {
+        const mutation_update &update = updates[i];
+        faked_requests[i] =
+            dsn_msg_create_received_request(update.code,
+                                            (dsn_msg_serialize_format)update.serialization_type,
+                                            (void *)update.data.data(),
+                                            update.data.length());
+    }
+
+    int storage_error = on_batched_write_requests(decree, timestamp, faked_requests, update_count);
+
+    // release faked requests
+    for (int i = 0; i < update_count; i++) {
+        dsn_msg_release_ref(faked_requests[i]);
+    }
+    return storage_error;
+}
+
 ::dsn::error_code replication_app_base::apply_mutation(const mutation *mu)
 {
     dassert(mu->data.header.decree == last_committed_decree() + 1,
@@ -476,47 +500,83 @@ int replication_app_base::on_batched_write_requests(int64_t decree,
     dassert(mu->data.updates.size() > 0, "");
 
     int request_count = static_cast<int>(mu->client_requests.size());
-    dsn_message_t *batched_requests =
-        (dsn_message_t *)alloca(sizeof(dsn_message_t) * request_count);
-    dsn_message_t *faked_requests = (dsn_message_t *)alloca(sizeof(dsn_message_t) * request_count);
-    int batched_count = 0;
-    int faked_count = 0;
+    bool has_client_request = false;
+    bool has_empty_write = false;
     for (int i = 0; i < request_count; i++) {
-        const mutation_update &update = mu->data.updates[i];
-        dsn_message_t req = mu->client_requests[i];
-        if (update.code != RPC_REPLICATION_WRITE_EMPTY) {
-            dinfo("%s: mutation %s #%d: dispatch rpc call %s",
-                  _replica->name(),
-                  mu->name(),
-                  i,
-                  update.code.to_string());
-
-            if (req == nullptr) {
-                req = dsn_msg_create_received_request(
-                    update.code,
-                    (dsn_msg_serialize_format)update.serialization_type,
-                    (void *)update.data.data(),
-                    update.data.length());
-                faked_requests[faked_count++] = req;
-            }
+        if (mu->client_requests[i] != nullptr)
+            has_client_request = true;
+        if (mu->data.updates[i].code == RPC_REPLICATION_WRITE_EMPTY)
+            has_empty_write = true;
+    }
 
-            batched_requests[batched_count++] = req;
+    int perror;
+    int batched_count = 0;
+    if (!has_client_request) {
+        // on secondaries and during log replay: hand the updates to the storage engine as they
+        // are, without faking request messages
+        dinfo("%s: mutation %s: dispatch %d updates", _replica->name(), mu->name(), request_count);
+
+        if (!has_empty_write) {
+            batched_count = request_count;
+            perror = on_batched_write_updates(mu->data.header.decree,
+                                              mu->data.header.timestamp,
+                                              mu->data.updates.data(),
+                                              batched_count);
         } else {
-            // empty mutation write
-            dinfo("%s: mutation %s #%d: dispatch rpc call %s",
-                  _replica->name(),
-                  mu->name(),
-                  i,
-                  update.code.to_string());
+            std::vector<mutation_update> updates;
+            for (const mutation_update &update : mu->data.updates) {
+                if (update.code != RPC_REPLICATION_WRITE_EMPTY)
+                    updates.push_back(update);
+            }
+            batched_count = static_cast<int>(updates.size());
+            perror = on_batched_write_updates(mu->data.header.decree,
+                                              mu->data.header.timestamp,
+                                              updates.data(),
+                                              batched_count);
+        }
+    } else {
+        dsn_message_t *batched_requests =
+            (dsn_message_t *)alloca(sizeof(dsn_message_t) * request_count);
+        dsn_message_t *faked_requests =
+            (dsn_message_t *)alloca(sizeof(dsn_message_t) * request_count);
+        int faked_count = 0;
+        for (int i = 0; i < request_count; i++) {
+            const mutation_update &update = mu->data.updates[i];
+            dsn_message_t req = mu->client_requests[i];
+            if (update.code != RPC_REPLICATION_WRITE_EMPTY) {
+                dinfo("%s: mutation %s #%d: dispatch rpc call %s",
+                      _replica->name(),
+                      mu->name(),
+                      i,
+                      update.code.to_string());
+
+                if (req == nullptr) {
+                    req = dsn_msg_create_received_request(
+                        update.code,
+                        (dsn_msg_serialize_format)update.serialization_type,
+                        (void *)update.data.data(),
+                        update.data.length());
+                    faked_requests[faked_count++] = req;
+                }
+
+                batched_requests[batched_count++] = req;
+            } else {
+                // empty mutation write
+                dinfo("%s: mutation %s #%d: dispatch rpc call %s",
+                      _replica->name(),
+                      mu->name(),
+                      i,
+                      update.code.to_string());
+            }
         }
-    }
 
-    int perror = on_batched_write_requests(
-        mu->data.header.decree, mu->data.header.timestamp, batched_requests, batched_count);
+        perror = on_batched_write_requests(
+            mu->data.header.decree, mu->data.header.timestamp, batched_requests, batched_count);
 
-    // release faked requests
-    for (int i = 0; i < faked_count; i++) {
-        dsn_msg_release_ref(faked_requests[i]);
+        // release faked requests
+        for (int i = 0; i < faked_count; i++) {
+            dsn_msg_release_ref(faked_requests[i]);
+        }
     }
 
     if (perror != 0) {
@@ -35,6 +35,7 @@
  */
 
 #include <algorithm>
+#include <climits>
 #include <iostream>
 #include <queue>
 #include <dsn/tool-api/command_manager.h>
@@ -486,94 +487,122 @@ bool greedy_load_balancer::calc_disk_load(app_id id,
 }
 
 bool greedy_load_balancer::move_primary_based_on_flow_per_app(const std::shared_ptr<app_state> &app,
-                                                              const std::vector<int> &prev,
-                                                              const std::vector<int> &flow)
+                                                              const flow_network &network)
 {
-    int graph_nodes = prev.size();
-    int current = prev[graph_nodes - 1];
+    int sink = network.size() - 1;
 
     // used to calculate the primary disk loads of each server.
-    // disk_load[disk_tag] means how many primaies on this "disk_tag".
-    // IF disk_load.find(disk_tag) == disk_load.end(), means 0
-    disk_load loads[2];
-    disk_load *prev_load = &loads[0];
-    disk_load *current_load = &loads[1];
-
-    if (!calc_disk_load(app->app_id, address_vec[current], true, *current_load)) {
-        dwarn("stop move primary as some replica infos aren't collected, node(%s), app(%s)",
-              address_vec[current].to_string(),
-              app->get_logname());
-        return false;
-    }
+    // loads[id][disk_tag] means how many primaies on this "disk_tag" of node "id".
+    // IF loads[id].find(disk_tag) == loads[id].end(), means 0
+    std::vector<disk_load> loads(network.size());
+    std::vector<bool> load_calculated(network.size(), false);
+    auto get_load = [&, this](int id) -> disk_load * {
+        if (!load_calculated[id]) {
+            if (!calc_disk_load(app->app_id, address_vec[id], true, loads[id])) {
+                dwarn("stop move primary as some replica infos aren't collected, node(%s), app(%s)",
+                      address_vec[id].to_string(),
+                      app->get_logname());
+                return nullptr;
+            }
+            load_calculated[id] = true;
+        }
+        return &loads[id];
+    };
 
     migration_list ml_this_turn;
-    while (prev[current] != 0) {
-        rpc_address from = address_vec[prev[current]];
-        rpc_address to = address_vec[current];
+    for (int from_id = 1; from_id < sink; ++from_id) {
+        // every unit of flow from "from_id" to another node is a slot,
+        // which should be filled by a primary on "from_id"
+        std::vector<int> slots;
+        for (int e : network.adjacent[from_id]) {
+            const flow_edge &edge = network.edges[e];
+            if (edge.to != sink && edge.flow > 0)
+                slots.insert(slots.end(), edge.flow, edge.to);
+        }
+        if (slots.empty())
+            continue;
 
-        if (!calc_disk_load(app->app_id, from, true, *prev_load)) {
-            dwarn("stop move primary as some replica infos aren't collected, node(%s), app(%s)",
-                  from.to_string(),
-                  app->get_logname());
+        disk_load *from_load = get_load(from_id);
+        if (from_load == nullptr)
             return false;
-        }
 
+        rpc_address from = address_vec[from_id];
         const node_state &ns = t_global_view->nodes->find(from)->second;
-        std::list<dsn::gpid> potential_moving;
-        int potential_moving_size = 0;
-        ns.for_each_primary(app->app_id, [&, this](const gpid &pid) {
-            const partition_configuration &pc = app->partitions[pid.get_partition_index()];
-            if (is_secondary(pc, to)) {
-                potential_moving.push_back(pid);
-                potential_moving_size++;
-            }
+        std::vector<dsn::gpid> potential_moving;
+        ns.for_each_primary(app->app_id, [&potential_moving](const gpid &pid) {
+            potential_moving.push_back(pid);
             return true;
         });
 
-        int plan_moving = flow[graph_nodes - 1];
-        dassert(plan_moving <= potential_moving_size,
-                "from(%s) to(%s) plan(%d), can_move(%d)",
-                from.to_string(),
-                to.to_string(),
-                plan_moving,
-                potential_moving_size);
-
-        while (plan_moving > 0) {
-            std::list<dsn::gpid>::iterator selected = potential_moving.end();
-            int selected_score = std::numeric_limits<int>::min();
-
-            for (std::list<dsn::gpid>::iterator it = potential_moving.begin();
-                 it != potential_moving.end();
-                 ++it) {
-                const config_context &cc = app->helpers->contexts[it->get_partition_index()];
-                int score =
-                    (*prev_load)[get_disk_tag(from, *it)] - (*current_load)[get_disk_tag(to, *it)];
-                if (score > selected_score) {
-                    selected_score = score;
-                    selected = it;
+        // the candidates of every target, the ones which make the disk loads
+        // more balanced are preferred
+        std::map<int, std::vector<int>> candidates;
+        for (int to_id : slots) {
+            if (candidates.find(to_id) != candidates.end())
+                continue;
+            disk_load *to_load = get_load(to_id);
+            if (to_load == nullptr)
+                return false;
+
+            rpc_address to = address_vec[to_id];
+            std::vector<std::pair<int, int>> scored;
+            for (int i = 0; i < potential_moving.size(); ++i) {
+                const gpid &pid = potential_moving[i];
+                if (is_secondary(app->partitions[pid.get_partition_index()], to)) {
+                    int score = (*from_load)[get_disk_tag(from, pid)] -
+                                (*to_load)[get_disk_tag(to, pid)];
+                    scored.emplace_back(-score, i);
                 }
             }
+            std::sort(scored.begin(), scored.end());
 
-            dassert(selected != potential_moving.end(),
-                    "can't find gpid to move from(%s) to(%s)",
-                    from.to_string(),
-                    to.to_string());
-            const partition_configuration &pc = app->partitions[selected->get_partition_index()];
+            std::vector<int> &c = candidates[to_id];
+            for (const auto &p : scored)
+                c.push_back(p.second);
+        }
+
+        // a primary may be a candidate of several targets, so the slots are
+        // filled by bipartite matching to make sure that no primary is moved twice
+        std::vector<int> slot_of(potential_moving.size(), -1);
+        std::vector<bool> visit;
+        std::function<bool(int)> fill_slot = [&](int slot) {
+            for (int i : candidates[slots[slot]]) {
+                if (visit[i])
+                    continue;
+                visit[i] = true;
+                if (slot_of[i] == -1 || fill_slot(slot_of[i])) {
+                    slot_of[i] = slot;
+                    return true;
+                }
+            }
+            return false;
+        };
+        for (int slot = 0; slot < slots.size(); ++slot) {
+            visit.assign(potential_moving.size(), false);
+            if (!fill_slot(slot)) {
+                dinfo("%s: can't find primary to move from %s to %s",
+                      app->get_logname(),
+                      from.to_string(),
+                      address_vec[slots[slot]].to_string());
+            }
+        }
+
+        for (int i = 0; i < potential_moving.size(); ++i) {
+            if (slot_of[i] == -1)
+                continue;
+            const gpid &pid = potential_moving[i];
+            rpc_address to = address_vec[slots[slot_of[i]]];
+            const partition_configuration &pc = app->partitions[pid.get_partition_index()];
             auto balancer_result = ml_this_turn.emplace(
-                *selected, generate_balancer_request(pc, balance_type::move_primary, from, to));
+                pid, generate_balancer_request(pc, balance_type::move_primary, from, to));
             dassert(balancer_result.second,
                     "gpid(%d.%d) already inserted as an action",
-                    (*selected).get_app_id(),
-                    (*selected).get_partition_index());
+                    pid.get_app_id(),
+                    pid.get_partition_index());
 
-            --(*prev_load)[get_disk_tag(from, *selected)];
-            ++(*current_load)[get_disk_tag(to, *selected)];
-            potential_moving.erase(selected);
-            --plan_moving;
+            --(*from_load)[get_disk_tag(from, pid)];
+            ++loads[slots[slot_of[i]]][get_disk_tag(to, pid)];
         }
-
-        current = prev[current];
-        std::swap(current_load, prev_load);
     }
 
     for (auto &kv : ml_this_turn) {
@@ -586,39 +615,81 @@ bool greedy_load_balancer::move_primary_based_on_flow_per_app(const std::shared_
     return true;
 }
 
-// shortest path based on dijstra, to find an augmenting path
-void greedy_load_balancer::shortest_path(std::vector<bool> &visit,
-                                         std::vector<int> &flow,
-                                         std::vector<int> &prev,
-                                         std::vector<std::vector<int>> &network)
+void greedy_load_balancer::flow_network::add_edge(int from, int to, int capacity, int cost)
 {
-    int pos, max_value;
-    flow[0] = INT_MAX;
+    adjacent[from].push_back(edges.size());
+    edges.push_back({to, capacity, cost, 0});
+    adjacent[to].push_back(edges.size());
+    edges.push_back({from, 0, -cost, 0});
+}
+
+// successive shortest paths based on dijkstra with a binary heap. the node potentials
+// keep the reduced costs of the residual edges non-negative
+int greedy_load_balancer::min_cost_max_flow(flow_network &network)
+{
+    typedef std::pair<int, int> distance_node;
 
     int graph_nodes = network.size();
-    while (!visit[graph_nodes - 1]) {
-        pos = -1, max_value = 0;
-        for (int i = 0; i != graph_nodes; ++i) {
-            if (visit[i] == false && flow[i] > max_value) {
-                pos = i;
-                max_value = flow[i];
+    int sink = graph_nodes - 1;
+    std::vector<int> potential(graph_nodes, 0);
+    std::vector<int> distance(graph_nodes);
+    std::vector<int> prev_edge(graph_nodes);
+    int total_flow = 0, total_cost = 0;
+
+    while (true) {
+        std::fill(distance.begin(), distance.end(), INT_MAX);
+        std::fill(prev_edge.begin(), prev_edge.end(), -1);
+        std::priority_queue<distance_node, std::vector<distance_node>, std::greater<distance_node>>
+            pq;
+        distance[0] = 0;
+        pq.emplace(0, 0);
+        while (!pq.empty()) {
+            distance_node top = pq.top();
+            pq.pop();
+            int u = top.second;
+            if (top.first > distance[u])
+                continue;
+            for (int e : network.adjacent[u]) {
+                const flow_edge &edge = network.edges[e];
+                if (edge.capacity <= edge.flow)
+                    continue;
+                int d = distance[u] + edge.cost + potential[u] - potential[edge.to];
+                if (d < distance[edge.to]) {
+                    distance[edge.to] = d;
+                    prev_edge[edge.to] = e;
+                    pq.emplace(d, edge.to);
+                }
             }
         }
 
-        if (pos == -1)
+        // no augmenting path
+        if (distance[sink] == INT_MAX)
             break;
-
-        visit[pos] = true;
         for (int i = 0; i != graph_nodes; ++i) {
-            if (!visit[i] && std::min(flow[pos], network[pos][i]) > flow[i]) {
-                flow[i] = std::min(flow[pos], network[pos][i]);
-                prev[i] = pos;
-            }
+            if (distance[i] != INT_MAX)
+                potential[i] += distance[i];
+        }
+
+        int augment = INT_MAX;
+        for (int v = sink; v != 0; v = network.edges[prev_edge[v] ^ 1].to) {
+            const flow_edge &edge = network.edges[prev_edge[v]];
+            augment = std::min(augment, edge.capacity - edge.flow);
+        }
+        for (int v = sink; v != 0; v = network.edges[prev_edge[v] ^ 1].to) {
+            network.edges[prev_edge[v]].flow += augment;
+            network.edges[prev_edge[v] ^ 1].flow -= augment;
         }
+        total_flow += augment;
+        total_cost += augment * (potential[sink] - potential[0]);
     }
+
+    dinfo("min cost max flow: flow(%d), cost(%d)", total_flow, total_cost);
+    return total_flow;
 }
 
-// load balancer based on ford-fulkerson
+// the primaries are moved to the secondaries by a min-cost max-flow: a unit of flow
+// from node A to node B means a primary on A is switched to its secondary on B, which
+// costs one. so the whole plan is calculated in one pass with the fewest moves
 bool greedy_load_balancer::primary_balancer_per_app(const std::shared_ptr<app_state> &app)
 {
     dassert(t_alive_nodes > 2, "too few alive nodes will lead to freeze");
@@ -641,19 +712,36 @@ bool greedy_load_balancer::primary_balancer_per_app(const std::shared_ptr<app_st
         return true;
     }
 
-    size_t graph_nodes = t_alive_nodes + 2;
-    std::vector<std::vector<int>> network(graph_nodes, std::vector<int>(graph_nodes, 0));
+    int graph_nodes = t_alive_nodes + 2;
+    int sink = graph_nodes - 1;
+    flow_network network(graph_nodes);
 
     // make graph
+    std::vector<int> links(graph_nodes, 0);
+    std::vector<int> linked_nodes;
     for (auto iter = nodes.begin(); iter != nodes.end(); ++iter) {
         int from = address_id[iter->first];
         const node_state &ns = iter->second;
         int c = ns.primary_count(app->app_id);
+
+        int source_capacity = 0, sink_capacity = 0;
         if (c > replicas_low)
-            network[0][from] = c - replicas_low;
+            source_capacity = c - replicas_low;
         else
-            network[from][graph_nodes - 1] = replicas_low - c;
+            sink_capacity = replicas_low - c;
+        // all nodes are no less than replicas_low, so the target is replicas_high
+        if (higher_count > 0 && lower_count == 0) {
+            if (source_capacity > 0)
+                --source_capacity;
+            else
+                ++sink_capacity;
+        }
+        if (source_capacity > 0)
+            network.add_edge(0, from, source_capacity, 0);
+        if (sink_capacity > 0)
+            network.add_edge(from, sink, sink_capacity, 0);
 
+        linked_nodes.clear();
         ns.for_each_primary(app->app_id, [&, this](const gpid &pid) {
             const partition_configuration &pc = app->partitions[pid.get_partition_index()];
             for (auto &target : pc.secondaries) {
@@ -661,29 +749,22 @@ bool greedy_load_balancer::primary_balancer_per_app(const std::shared_ptr<app_st
                 dassert(i != address_id.end(),
                         "invalid secondary address, address = %s",
                         target.to_string());
-                network[from][i->second]++;
+                if (links[i->second]++ == 0)
+                    linked_nodes.push_back(i->second);
             }
             return true;
         });
-    }
-
-    if (higher_count > 0 && lower_count == 0) {
-        for (int i = 0; i != graph_nodes; ++i) {
-            if (network[0][i] > 0)
-                --network[0][i];
-            else
-                ++network[i][graph_nodes - 1];
+        for (int to : linked_nodes) {
+            network.add_edge(from, to, links[to], 1);
+            links[to] = 0;
         }
     }
-    dinfo("%s: start to move primary", app->get_logname());
-    std::vector<bool> visit(graph_nodes, false);
-    std::vector<int> flow(graph_nodes, 0);
-    std::vector<int> prev(graph_nodes, -1);
 
-    shortest_path(visit, flow, prev, network);
+    dinfo("%s: start to move primary", app->get_logname());
+    int total_flow = min_cost_max_flow(network);
     // we can't make the server load more balanced
     // by moving primaries to secondaries
-    if (!visit[graph_nodes - 1] || flow[graph_nodes - 1] == 0) {
+    if (total_flow == 0) {
         if (!_only_move_primary) {
             return copy_primary_per_app(app, lower_count != 0, replicas_low);
         } else {
@@ -692,8 +773,8 @@ bool greedy_load_balancer::primary_balancer_per_app(const std::shared_ptr<app_st
         }
     }
 
-    dinfo("%u primaries are flew", flow[graph_nodes - 1]);
-    return move_primary_based_on_flow_per_app(app, prev, flow);
+    dinfo("%d primaries are flew", total_flow);
+    return move_primary_based_on_flow_per_app(app, network);
 }
 
 bool greedy_load_balancer::primary_balancer_globally()
@@ -26,7 +26,7 @@
 
 /*
  * Description:
- *     A greedy load balancer based on Dijkstra & Ford-Fulkerson
+ *     A greedy load balancer based on min-cost max-flow
  *
  * Revision history:
  *     2016-02-03, Weijie Sun, first version
@@ -51,6 +51,9 @@ public:
     void unregister_ctrl_commands() override;
 
 private:
+    // reuses the node numbering, options and request generation of this balancer
+    friend class load_aware_balancer;
+
     enum class balance_type
     {
         move_primary,
@@ -81,12 +84,30 @@ private:
     dsn_handle_t _ctrl_only_primary_balancer;
     dsn_handle_t _ctrl_only_move_primary;
 
+    // a sparse flow network, node 0 is the source and the last node is the sink.
+    // edges are stored in pairs, so the reverse edge of edges[i] is edges[i^1]
+    struct flow_edge
+    {
+        int to;
+        int capacity;
+        int cost;
+        int flow;
+    };
+    struct flow_network
+    {
+        std::vector<flow_edge> edges;
+        std::vector<std::vector<int>> adjacent;
+
+        explicit flow_network(int graph_nodes) : adjacent(graph_nodes) {}
+        int size() const { return adjacent.size(); }
+        void add_edge(int from, int to, int capacity, int cost);
+    };
+
 private:
     void number_nodes(const node_mapper &nodes);
-    void shortest_path(std::vector<bool> &visit,
-                       std::vector<int> &flow,
-                       std::vector<int> &prev,
-                       std::vector<std::vector<int>> &network);
+    // successive shortest paths with node potentials, return the max flow.
+    // the flow of each edge is stored in "network"
+    int min_cost_max_flow(flow_network &network);
 
     // balance decision generators. All these functions try to make balance decisions
     // and store them to t_migration_result.
@@ -97,8 +118,7 @@ private:
     // when return false, it means generators refuse to make decision coz
     // they think they need more informations.
     bool move_primary_based_on_flow_per_app(const std::shared_ptr<app_state> &app,
-                                            const std::vector<int> &prev,
-                                            const std::vector<int> &flow);
+                                            const flow_network &network);
     bool copy_primary_per_app(const std::shared_ptr<app_state> &app,
                               bool still_have_less_than_average,
                               int replicas_low);
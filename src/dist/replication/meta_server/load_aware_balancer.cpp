@@ -0,0 +1,335 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include "load_aware_balancer.h"
+#include "meta_data.h"
+
+namespace dsn {
+namespace replication {
+
+load_aware_balancer::load_aware_balancer(meta_service *svc) : greedy_load_balancer(svc)
+{
+    if (svc != nullptr) {
+        const lb_suboptions &opts = svc->get_meta_options()._lb_opts;
+        _imbalance_threshold = opts.load_imbalance_threshold;
+        _min_gain = opts.load_balance_min_gain;
+        _max_moves_per_round = opts.load_balance_max_moves_per_round;
+        _max_copy_mb_per_round = opts.load_balance_max_copy_mb_per_round;
+        _move_cooldown_ms = opts.load_balance_move_cooldown_seconds * 1000;
+    } else {
+        _imbalance_threshold = 0.2;
+        _min_gain = 0.05;
+        _max_moves_per_round = 4;
+        _max_copy_mb_per_round = 10240;
+        _move_cooldown_ms = 0;
+    }
+}
+
+load_aware_balancer::~load_aware_balancer() {}
+
+void load_aware_balancer::add_load(load_vector &target, const load_vector &delta, double factor)
+{
+    for (int i = 0; i < LD_COUNT; ++i) {
+        target[i] += delta[i] * factor;
+    }
+}
+
+bool load_aware_balancer::collect_partition_loads()
+{
+    t_partition_loads.clear();
+    bool reported = false;
+    for (const auto &kv : *(t_global_view->apps)) {
+        const std::shared_ptr<app_state> &app = kv.second;
+        if (app->status != app_status::AS_AVAILABLE)
+            continue;
+
+        for (int i = 0; i < app->partition_count; ++i) {
+            const partition_configuration &pc = app->partitions[i];
+            const config_context &cc = app->helpers->contexts[i];
+
+            int64_t read_qps = 0, read_bytes = 0;
+            int64_t write_qps = 0, write_bytes = 0, storage_mb = 0;
+            for (const serving_replica &r : cc.serving) {
+                if (r.read_qps >= 0 || r.write_qps >= 0 || r.storage_mb >= 0)
+                    reported = true;
+                // reads are only served by the primary, while writes are
+                // applied on all the members
+                if (r.node == pc.primary) {
+                    read_qps = std::max(read_qps, r.read_qps);
+                    read_bytes = std::max(read_bytes, r.read_bytes_per_second);
+                }
+                write_qps = std::max(write_qps, r.write_qps);
+                write_bytes = std::max(write_bytes, r.write_bytes_per_second);
+                storage_mb = std::max(storage_mb, r.storage_mb);
+            }
+
+            partition_load &load = t_partition_loads[pc.pid];
+            load.as_secondary[LD_QPS] = write_qps;
+            load.as_secondary[LD_BYTES] = write_bytes;
+            load.as_secondary[LD_STORAGE] = storage_mb;
+            load.as_secondary[LD_REPLICAS] = 1;
+            load.as_primary = load.as_secondary;
+            load.as_primary[LD_QPS] += read_qps;
+            load.as_primary[LD_BYTES] += read_bytes;
+        }
+    }
+    return reported;
+}
+
+void load_aware_balancer::calc_node_loads()
+{
+    load_vector zero;
+    zero.fill(0);
+    t_node_loads.assign(address_vec.size(), zero);
+    t_average_load = zero;
+
+    for (const auto &kv : *(t_global_view->nodes)) {
+        const node_state &ns = kv.second;
+        load_vector &load = t_node_loads[address_id[kv.first]];
+        ns.for_each_partition([&, this](const dsn::gpid &pid) {
+            auto iter = t_partition_loads.find(pid);
+            if (iter != t_partition_loads.end()) {
+                bool is_primary = (ns.served_as(pid) == partition_status::PS_PRIMARY);
+                add_load(load, is_primary ? iter->second.as_primary : iter->second.as_secondary, 1);
+            }
+            return true;
+        });
+        add_load(t_average_load, load, 1.0 / t_alive_nodes);
+    }
+}
+
+// the load of a node is represented by the max ratio to the average value
+// among all the dimensions
+double load_aware_balancer::load_ratio(const load_vector &load) const
+{
+    double ratio = 0;
+    for (int i = 0; i < LD_COUNT; ++i) {
+        if (t_average_load[i] > 0) {
+            ratio = std::max(ratio, load[i] / t_average_load[i]);
+        }
+    }
+    return ratio;
+}
+
+int load_aware_balancer::hottest_node() const
+{
+    int hot = 1;
+    for (int i = 2; i <= t_alive_nodes; ++i) {
+        if (load_ratio(t_node_loads[i]) > load_ratio(t_node_loads[hot]))
+            hot = i;
+    }
+    return hot;
+}
+
+bool load_aware_balancer::in_cooldown(const dsn::gpid &pid, uint64_t now_ms) const
+{
+    auto iter = _last_move_time_ms.find(pid);
+    return iter != _last_move_time_ms.end() && now_ms - iter->second < _move_cooldown_ms;
+}
+
+bool load_aware_balancer::move_load_from(int hot, uint64_t &copied_mb)
+{
+    const node_state &hot_ns = t_global_view->nodes->find(address_vec[hot])->second;
+    const load_vector &hot_load = t_node_loads[hot];
+    uint64_t now = dsn_now_ms();
+
+    // candidates for copying, from the coldest to the hottest
+    std::vector<int> targets;
+    for (int i = 1; i <= t_alive_nodes; ++i) {
+        if (i != hot)
+            targets.push_back(i);
+    }
+    std::sort(targets.begin(), targets.end(), [this](int n1, int n2) {
+        double r1 = load_ratio(t_node_loads[n1]);
+        double r2 = load_ratio(t_node_loads[n2]);
+        return r1 != r2 ? r1 < r2 : n1 < n2;
+    });
+
+    // a proposal is accepted only if it reduces the max load ratio of the
+    // involved nodes by at least _min_gain, which prevents ping-pong moves.
+    // copying data is more expensive than switching primary, so the copy
+    // proposals are penalized by another _min_gain.
+    double best_score = load_ratio(hot_load) - _min_gain;
+    const partition_configuration *best_pc = nullptr;
+    balance_type best_type = balance_type::move_primary;
+    int best_target = -1;
+    load_vector best_hot_load, best_target_load;
+
+    auto consider = [&](const partition_configuration &pc,
+                        balance_type type,
+                        int target,
+                        const load_vector &new_hot_load,
+                        const load_vector &new_target_load,
+                        double penalty) {
+        double score =
+            std::max(load_ratio(new_hot_load), load_ratio(new_target_load)) + penalty;
+        if (score < best_score) {
+            best_score = score;
+            best_pc = &pc;
+            best_type = type;
+            best_target = target;
+            best_hot_load = new_hot_load;
+            best_target_load = new_target_load;
+        }
+    };
+
+    hot_ns.for_each_partition([&, this](const dsn::gpid &pid) {
+        if (t_migration_result->find(pid) != t_migration_result->end() || in_cooldown(pid, now))
+            return true;
+        auto iter = t_partition_loads.find(pid);
+        if (iter == t_partition_loads.end())
+            return true;
+
+        // unhealthy partitions are left to cure
+        const partition_configuration &pc = *get_config(*(t_global_view->apps), pid);
+        if (pc.primary.is_invalid() || (int)pc.secondaries.size() + 1 < pc.max_replica_count)
+            return true;
+
+        const partition_load &pl = iter->second;
+        bool can_copy = copied_mb + pl.as_primary[LD_STORAGE] <= _max_copy_mb_per_round;
+        if (pc.primary == hot_ns.addr()) {
+            for (const dsn::rpc_address &addr : pc.secondaries) {
+                int target = address_id[addr];
+                load_vector new_hot_load = hot_load, new_target_load = t_node_loads[target];
+                add_load(new_hot_load, pl.as_primary, -1);
+                add_load(new_hot_load, pl.as_secondary, 1);
+                add_load(new_target_load, pl.as_secondary, -1);
+                add_load(new_target_load, pl.as_primary, 1);
+                consider(pc, balance_type::move_primary, target, new_hot_load, new_target_load, 0);
+            }
+            if (!_only_move_primary && can_copy) {
+                for (int target : targets) {
+                    if (is_member(pc, address_vec[target]))
+                        continue;
+                    load_vector new_hot_load = hot_load, new_target_load = t_node_loads[target];
+                    add_load(new_hot_load, pl.as_primary, -1);
+                    add_load(new_target_load, pl.as_primary, 1);
+                    consider(pc,
+                             balance_type::copy_primary,
+                             target,
+                             new_hot_load,
+                             new_target_load,
+                             _min_gain);
+                    break;
+                }
+            }
+        } else if (!_only_primary_balancer && !_only_move_primary && can_copy) {
+            for (int target : targets) {
+                if (is_member(pc, address_vec[target]))
+                    continue;
+                load_vector new_hot_load = hot_load, new_target_load = t_node_loads[target];
+                add_load(new_hot_load, pl.as_secondary, -1);
+                add_load(new_target_load, pl.as_secondary, 1);
+                consider(pc,
+                         balance_type::copy_secondary,
+                         target,
+                         new_hot_load,
+                         new_target_load,
+                         _min_gain);
+                break;
+            }
+        }
+        return true;
+    });
+
+    if (best_pc == nullptr)
+        return false;
+
+    ddebug("move load of gpid(%d.%d) from %s (ratio %.3f) to %s (ratio %.3f)",
+           best_pc->pid.get_app_id(),
+           best_pc->pid.get_partition_index(),
+           address_vec[hot].to_string(),
+           load_ratio(hot_load),
+           address_vec[best_target].to_string(),
+           load_ratio(t_node_loads[best_target]));
+    t_migration_result->emplace(
+        best_pc->pid,
+        generate_balancer_request(*best_pc, best_type, address_vec[hot], address_vec[best_target]));
+    if (best_type != balance_type::move_primary) {
+        copied_mb += t_partition_loads[best_pc->pid].as_primary[LD_STORAGE];
+    }
+    t_node_loads[hot] = best_hot_load;
+    t_node_loads[best_target] = best_target_load;
+    _last_move_time_ms[best_pc->pid] = now;
+    return true;
+}
+
+bool load_aware_balancer::balance(meta_view view, migration_list &list)
+{
+    ddebug("load aware balancer round");
+    list.clear();
+
+    t_total_partitions = count_partitions(*(view.apps));
+    t_alive_nodes = view.nodes->size();
+    t_global_view = &view;
+    t_migration_result = &list;
+
+    dassert(t_alive_nodes > 2, "too few nodes will be freezed");
+    number_nodes(*t_global_view->nodes);
+
+    for (auto &kv : *(t_global_view->nodes)) {
+        if (!all_replica_infos_collected(kv.second)) {
+            return false;
+        }
+    }
+
+    if (!collect_partition_loads()) {
+        ddebug("no replica server reports its load, balance by replica count");
+        return greedy_load_balancer::balance(view, list);
+    }
+    calc_node_loads();
+
+    uint64_t now = dsn_now_ms();
+    for (auto iter = _last_move_time_ms.begin(); iter != _last_move_time_ms.end();) {
+        if (now - iter->second >= _move_cooldown_ms)
+            iter = _last_move_time_ms.erase(iter);
+        else
+            ++iter;
+    }
+
+    uint64_t copied_mb = 0;
+    for (int i = 0; i < _max_moves_per_round; ++i) {
+        int hot = hottest_node();
+        double ratio = load_ratio(t_node_loads[hot]);
+        if (ratio <= 1.0 + _imbalance_threshold) {
+            ddebug("stop load balance coz the max load ratio(%.3f) of %s is under threshold",
+                   ratio,
+                   address_vec[hot].to_string());
+            break;
+        }
+        if (!move_load_from(hot, copied_mb)) {
+            ddebug("stop load balance coz no proposal can reduce the load of %s, ratio(%.3f)",
+                   address_vec[hot].to_string(),
+                   ratio);
+            break;
+        }
+    }
+
+    return !t_migration_result->empty();
+}
+}
+}
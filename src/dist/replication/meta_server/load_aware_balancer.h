@@ -0,0 +1,98 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     A load balancer which balances the replicas by the load reported from
+ *     replica servers (qps, throughput and storage size), on top of the
+ *     greedy balancer which only balances the replica counts.
+ */
+
+#pragma once
+
+#include <array>
+#include "greedy_load_balancer.h"
+
+namespace dsn {
+namespace replication {
+
+class load_aware_balancer : public greedy_load_balancer
+{
+public:
+    load_aware_balancer(meta_service *svc);
+    virtual ~load_aware_balancer();
+    bool balance(meta_view view, migration_list &list) override;
+
+private:
+    enum load_dimension
+    {
+        LD_QPS = 0,
+        LD_BYTES,
+        LD_STORAGE,
+        LD_REPLICAS,
+        LD_COUNT
+    };
+    typedef std::array<double, LD_COUNT> load_vector;
+
+    // the load a partition brings to the node serving it as primary/secondary
+    struct partition_load
+    {
+        load_vector as_primary;
+        load_vector as_secondary;
+    };
+
+    // options
+    double _imbalance_threshold;
+    double _min_gain;
+    int32_t _max_moves_per_round;
+    uint64_t _max_copy_mb_per_round;
+    uint64_t _move_cooldown_ms;
+
+    // gpid -> the last time it is moved by this balancer
+    std::map<dsn::gpid, uint64_t> _last_move_time_ms;
+
+    // these variables are temporarily assigned by interface "balance"
+    std::map<dsn::gpid, partition_load> t_partition_loads;
+    std::vector<load_vector> t_node_loads;
+    load_vector t_average_load;
+
+private:
+    // return false if no replica server reports its load
+    bool collect_partition_loads();
+    void calc_node_loads();
+    double load_ratio(const load_vector &load) const;
+    int hottest_node() const;
+
+    // try to find a proposal which reduces the load of node "hot" most,
+    // and apply it to the temporary loads.
+    // return false if no such proposal is found
+    bool move_load_from(int hot, uint64_t &copied_mb);
+    bool in_cooldown(const dsn::gpid &pid, uint64_t now_ms) const;
+
+    static void add_load(load_vector &target, const load_vector &delta, double factor);
+};
+}
+}
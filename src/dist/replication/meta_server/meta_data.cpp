@@ -346,10 +346,18 @@ void config_context::collect_serving_replica(const rpc_address &node, const repl
     auto iter = find_from_serving(node);
     if (iter != serving.end()) {
         iter->disk_tag = info.disk_tag;
-        iter->storage_mb = 0;
     } else {
-        serving.emplace_back(serving_replica{node, 0, info.disk_tag});
+        serving.emplace_back(serving_replica{node, -1, info.disk_tag, -1, -1, -1, -1});
+        iter = serving.end() - 1;
     }
+
+    iter->storage_mb = info.__isset.storage_mb ? info.storage_mb : -1;
+    iter->read_qps = info.__isset.read_qps ? info.read_qps : -1;
+    iter->write_qps = info.__isset.write_qps ? info.write_qps : -1;
+    iter->read_bytes_per_second =
+        info.__isset.read_bytes_per_second ? info.read_bytes_per_second : -1;
+    iter->write_bytes_per_second =
+        info.__isset.write_bytes_per_second ? info.write_bytes_per_second : -1;
 }
 
 void config_context::adjust_proposal(const rpc_address &node, const replica_info &info)
@@ -363,6 +371,7 @@ void app_state_helper::on_init_partitions()
     context.stage = config_status::not_pending;
     context.pending_sync_task = nullptr;
     context.msg = nullptr;
+    context.change_version = 0;
 
     context.prefered_dropped = -1;
     contexts.assign(owner->partition_count, context);
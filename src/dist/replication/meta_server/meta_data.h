@@ -177,9 +177,14 @@ inline int dropped_cmp(const dropped_replica &d1, const dropped_replica &d2)
 struct serving_replica
 {
     dsn::rpc_address node;
-    // TODO: report the storage size of replica
+    // -1 means the replica server hasn't reported the value
     int64_t storage_mb;
     std::string disk_tag;
+    // load statistics of the replica, -1 means not reported
+    int64_t read_qps;
+    int64_t write_qps;
+    int64_t read_bytes_per_second;
+    int64_t write_bytes_per_second;
 };
 
 class config_context
@@ -194,6 +199,10 @@ public:
     dsn_message_t msg;
     //]
 
+    // app_state_helper::config_version at which the partition was last updated,
+    // used to compute deltas for configuration subscribers
+    int64_t change_version;
+
     // for load balancer's decision
     //[
     proposal_actions lb_actions;
@@ -282,6 +291,16 @@ struct restore_state
     restore_state() : restore_status(dsn::ERR_OK), progress(0), reason() {}
 };
 
+// a parked RPC_CM_SUBSCRIBE_PARTITION_CONFIG request, which is replied when
+// the app's configuration changes or when hold_ms expires
+struct config_subscriber
+{
+    dsn_message_t msg;
+    int64_t epoch;
+    int64_t known_version;
+    task_ptr timeout_task;
+};
+
 class app_state;
 class app_state_helper
 {
@@ -292,8 +311,26 @@ public:
     dsn_message_t pending_response;
     std::vector<restore_state> restore_states;
 
+    // bumped each time a partition configuration of this app is committed
+    int64_t config_version;
+    uint64_t next_subscriber_id;
+    std::map<uint64_t, config_subscriber> subscribers;
+
+    // encoded dsn::dist::partition_routing_table at routing_table_version, rebuilt
+    // by the first routing query after a configuration change and shared by others
+    //[
+    ::dsn::service::zlock routing_table_lock;
+    int64_t routing_table_version;
+    dsn::blob routing_table;
+    //]
+
 public:
-    app_state_helper() : owner(nullptr), partitions_in_progress(0)
+    app_state_helper()
+        : owner(nullptr),
+          partitions_in_progress(0),
+          config_version(0),
+          next_subscriber_id(0),
+          routing_table_version(-1)
     {
         contexts.clear();
         pending_response = nullptr;
@@ -161,6 +161,34 @@ void meta_options::initialize()
     _lb_opts.only_move_primary = dsn_config_get_value_bool(
         "meta_server", "only_move_primary", false, "only try to make the primary balanced by move");
 
+    _lb_opts.load_imbalance_threshold =
+        dsn_config_get_value_double("meta_server",
+                                    "load_imbalance_threshold",
+                                    0.2,
+                                    "load_aware_balancer starts to move replicas only if the "
+                                    "hottest node exceeds the average load by this ratio");
+    _lb_opts.load_balance_min_gain =
+        dsn_config_get_value_double("meta_server",
+                                    "load_balance_min_gain",
+                                    0.05,
+                                    "a move is proposed by load_aware_balancer only if it reduces "
+                                    "the max node load ratio by at least this value");
+    _lb_opts.load_balance_max_moves_per_round =
+        (int32_t)dsn_config_get_value_uint64("meta_server",
+                                             "load_balance_max_moves_per_round",
+                                             4,
+                                             "max proposals of load_aware_balancer in one round");
+    _lb_opts.load_balance_max_copy_mb_per_round =
+        dsn_config_get_value_uint64("meta_server",
+                                    "load_balance_max_copy_mb_per_round",
+                                    10240,
+                                    "max replica data(MB) copied by load_aware_balancer in one round");
+    _lb_opts.load_balance_move_cooldown_seconds = dsn_config_get_value_uint64(
+        "meta_server",
+        "load_balance_move_cooldown_seconds",
+        600,
+        "a partition moved by load_aware_balancer won't be moved again in this period");
+
     cold_backup_disabled = dsn_config_get_value_bool(
         "meta_server", "cold_backup_disabled", true, "whether to disable cold backup");
 }
@@ -61,6 +61,13 @@ public:
     bool balancer_in_turn;
     bool only_primary_balancer;
     bool only_move_primary;
+
+    // options for load_aware_balancer
+    double load_imbalance_threshold;
+    double load_balance_min_gain;
+    int32_t load_balance_max_moves_per_round;
+    uint64_t load_balance_max_copy_mb_per_round;
+    uint64_t load_balance_move_cooldown_seconds;
 };
 
 class meta_options
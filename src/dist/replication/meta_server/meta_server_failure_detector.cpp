@@ -158,11 +158,18 @@ void meta_server_failure_detector::acquire_leader_lock()
     }
 }
 
+meta_server_failure_detector::stability_shard &
+meta_server_failure_detector::get_stability_shard(const rpc_address &node)
+{
+    return _stability_shards[std::hash<rpc_address>()(node) % STABILITY_SHARD_COUNT];
+}
+
 void meta_server_failure_detector::reset_stability_stat(const rpc_address &node)
 {
-    zauto_lock l(_map_lock);
-    auto iter = _stablity.find(node);
-    if (iter == _stablity.end())
+    stability_shard &shard = get_stability_shard(node);
+    utils::auto_write_lock l(shard.lock);
+    auto iter = shard.workers.find(node);
+    if (iter == shard.workers.end())
         return;
     else {
         ddebug("old stability stat: node(%s), start_time(%lld), unstable_count(%d), will reset "
@@ -188,12 +195,22 @@ void meta_server_failure_detector::leader_initialize(const std::string &lock_ser
     _election_moment.store(dsn_now_ms());
 }
 
+bool meta_server_failure_detector::is_stability_stat_unchanged(const fd::beacon_msg &beacon)
+{
+    stability_shard &shard = get_stability_shard(beacon.from_addr);
+    utils::auto_read_lock l(shard.lock);
+    auto iter = shard.workers.find(beacon.from_addr);
+    return iter != shard.workers.end() && beacon.start_time == iter->second.last_start_time_ms &&
+           iter->second.unstable_restart_count == 0;
+}
+
 bool meta_server_failure_detector::update_stability_stat(const fd::beacon_msg &beacon)
 {
-    zauto_lock l(_map_lock);
-    auto iter = _stablity.find(beacon.from_addr);
-    if (iter == _stablity.end()) {
-        _stablity.emplace(beacon.from_addr, worker_stability{beacon.start_time, 0});
+    stability_shard &shard = get_stability_shard(beacon.from_addr);
+    utils::auto_write_lock l(shard.lock);
+    auto iter = shard.workers.find(beacon.from_addr);
+    if (iter == shard.workers.end()) {
+        shard.workers.emplace(beacon.from_addr, worker_stability{beacon.start_time, 0});
         return true;
     } else {
         worker_stability &w = iter->second;
@@ -242,6 +259,19 @@ void meta_server_failure_detector::on_ping(const fd::beacon_msg &beacon,
                                            rpc_replier<fd::beacon_ack> &reply)
 {
     fd::beacon_ack ack;
+    if (is_running_inline()) {
+        // querying the lock service for the leader, updating the stability stat and connecting
+        // a worker all block, so they are deferred to the fd pool
+        if (_is_leader.load() &&
+            (!beacon.__isset.start_time || is_stability_stat_unchanged(beacon)) &&
+            on_ping_fast(beacon, ack)) {
+            reply(ack);
+        } else {
+            defer_ping(beacon, reply);
+        }
+        return;
+    }
+
     ack.time = beacon.time;
     ack.this_node = beacon.to_addr;
     ack.allowed = true;
@@ -286,9 +316,9 @@ void meta_server_failure_detector::set_leader_for_test(rpc_address leader_addres
 }
 
 meta_server_failure_detector::stability_map *
-meta_server_failure_detector::get_stability_map_for_test()
+meta_server_failure_detector::get_stability_map_for_test(const rpc_address &node)
 {
-    return &_stablity;
+    return &get_stability_shard(node).workers;
 }
 }
 }
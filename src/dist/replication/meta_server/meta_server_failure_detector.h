@@ -109,11 +109,24 @@ public:
         }
         return failure_detector::is_worker_connected(node);
     }
+    // served inline only for a leader renewing the lease of a stable and alive worker,
+    // see failure_detector::is_running_inline
     virtual void on_ping(const fd::beacon_msg &beacon, rpc_replier<fd::beacon_ack> &reply) override;
 
 private:
+    struct stability_shard
+    {
+        ::dsn::utils::rw_lock_nr lock;
+        stability_map workers;
+    };
+    static const int STABILITY_SHARD_COUNT = 16;
+
+    stability_shard &get_stability_shard(const dsn::rpc_address &node);
+
     // return value: return true if beacon.from_addr is stable; or-else, false
     bool update_stability_stat(const fd::beacon_msg &beacon);
+    // return true if beacon.from_addr is stable and update_stability_stat has nothing to change
+    bool is_stability_stat_unchanged(const fd::beacon_msg &beacon);
     void leader_initialize(const std::string &lock_service_owner);
 
 private:
@@ -135,15 +148,16 @@ private:
     std::atomic_bool _is_leader;
     std::atomic<uint64_t> _election_moment;
 
-    // record the start time of a replica-server, check if it crashed frequently
-    mutable service::zlock _map_lock;
-    stability_map _stablity;
+    // record the start time of a replica-server, check if it crashed frequently;
+    // sharded by address, so that beacons of stable workers only share a shard read lock
+    stability_shard _stability_shards[STABILITY_SHARD_COUNT];
 
 public:
     /* these two functions are for test */
     meta_server_failure_detector(rpc_address leader_address, bool is_myself_leader);
     void set_leader_for_test(rpc_address leader_address, bool is_myself_leader);
-    stability_map *get_stability_map_for_test();
+    // the map of the shard which 'node' belongs to
+    stability_map *get_stability_map_for_test(const dsn::rpc_address &node);
 };
 }
 }
@@ -282,6 +282,12 @@ void meta_service::register_rpc_handlers()
     register_rpc_handler(RPC_CM_QUERY_PARTITION_CONFIG_BY_INDEX,
                          "query_configuration_by_index",
                          &meta_service::on_query_configuration_by_index);
+    register_rpc_handler(RPC_CM_QUERY_ROUTING_TABLE,
+                         "query_routing_table",
+                         &meta_service::on_query_routing_table);
+    register_rpc_handler(RPC_CM_SUBSCRIBE_PARTITION_CONFIG,
+                         "subscribe_configuration",
+                         &meta_service::on_subscribe_configuration);
     register_rpc_handler(RPC_CM_UPDATE_PARTITION_CONFIGURATION,
                          "update_configuration",
                          &meta_service::on_update_configuration);
@@ -486,6 +492,27 @@ void meta_service::on_query_configuration_by_index(dsn_message_t msg)
     reply(msg, response);
 }
 
+void meta_service::on_query_routing_table(dsn_message_t msg)
+{
+    configuration_query_routing_response response;
+    RPC_CHECK_STATUS(msg, response);
+
+    configuration_query_routing_request request;
+    dsn::unmarshall(msg, request);
+    _state->query_routing_table(request, response);
+    reply(msg, response);
+}
+
+void meta_service::on_subscribe_configuration(dsn_message_t msg)
+{
+    configuration_subscribe_response response;
+    RPC_CHECK_STATUS(msg, response);
+
+    // the request is held by server_state until the app's configuration changes
+    dsn_msg_add_ref(msg);
+    _state->subscribe_configuration(msg);
+}
+
 // partition sever => meta sever
 // as get stale configuration is not allowed for partition server, we need to dispatch it to the
 // meta state thread pool
@@ -116,6 +116,8 @@ private:
     // query partition configuration
     void on_query_configuration_by_node(dsn_message_t req);
     void on_query_configuration_by_index(dsn_message_t req);
+    void on_query_routing_table(dsn_message_t req);
+    void on_subscribe_configuration(dsn_message_t req);
 
     // partition server => meta server
     void on_config_sync(dsn_message_t req);
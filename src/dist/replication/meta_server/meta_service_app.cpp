@@ -45,6 +45,7 @@
 
 #include "server_load_balancer.h"
 #include "greedy_load_balancer.h"
+#include "load_aware_balancer.h"
 
 #include "meta_service.h"
 
@@ -90,6 +91,9 @@ void dsn_meta_sever_register_providers()
     register_component_provider(
         "greedy_load_balancer",
         dsn::replication::server_load_balancer::create<dsn::replication::greedy_load_balancer>);
+    register_component_provider(
+        "load_aware_balancer",
+        dsn::replication::server_load_balancer::create<dsn::replication::load_aware_balancer>);
 }
 
 dsn::error_code dsn_meta_server_bridge(int argc, char **argv)
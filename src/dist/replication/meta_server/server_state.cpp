@@ -38,6 +38,7 @@
 #include <dsn/cpp/clientlet.h>
 #include <dsn/tool-api/task.h>
 #include <dsn/tool-api/command_manager.h>
+#include <dsn/dist/partition_routing_table.h>
 #include <sstream>
 #include <cinttypes>
 #include <string>
@@ -59,6 +60,7 @@ static const char *unlock_state = "unlock";
 
 server_state::server_state()
     : _meta_svc(nullptr),
+      _config_epoch(0),
       _add_secondary_enable_flow_control(false),
       _add_secondary_max_count_for_one_node(0),
       _cli_dump_handle(nullptr),
@@ -152,6 +154,7 @@ void server_state::initialize(meta_service *meta_svc, const std::string &apps_ro
 {
     _meta_svc = meta_svc;
     _apps_root = apps_root;
+    _config_epoch = static_cast<int64_t>(dsn_random64(1, INT64_MAX));
     _add_secondary_enable_flow_control =
         _meta_svc->get_meta_options().add_secondary_enable_flow_control;
     _add_secondary_max_count_for_one_node =
@@ -394,6 +397,7 @@ error_code server_state::restore_from_local_storage(const char *local_path)
                     app->app_id,
                     i,
                     app->app_name.c_str());
+            mark_partition_changed(*app, i);
         }
     }
 
@@ -576,6 +580,7 @@ dsn::error_code server_state::sync_apps_from_remote_storage()
                     {
                         zauto_write_lock l(_lock);
                         app->partitions[partition_id] = pc;
+                        mark_partition_changed(*app, partition_id);
                         for (const dsn::rpc_address &addr : pc.last_drops) {
                             app->helpers->contexts[partition_id].record_drop_history(addr);
                         }
@@ -965,6 +970,149 @@ void server_state::query_configuration_by_index(
         response.partitions = app->partitions;
 }
 
+void server_state::query_routing_table(const configuration_query_routing_request &request,
+                                       /*out*/ configuration_query_routing_response &response)
+{
+    zauto_read_lock l(_lock);
+    auto iter = _exist_apps.find(request.app_name);
+    if (iter == _exist_apps.end()) {
+        response.err = ERR_OBJECT_NOT_FOUND;
+        return;
+    }
+
+    std::shared_ptr<app_state> &app = iter->second;
+    if (app->status != app_status::AS_AVAILABLE) {
+        response.err =
+            (app->status == app_status::AS_CREATING ? ERR_BUSY_CREATING : ERR_BUSY_DROPPING);
+        return;
+    }
+
+    response.err = ERR_OK;
+    response.app_id = app->app_id;
+    response.partition_count = app->partition_count;
+    response.is_stateful = app->is_stateful;
+    response.epoch = _config_epoch;
+    response.version = app->helpers->config_version;
+    if (request.epoch == _config_epoch && request.known_version == response.version)
+        return;
+
+    // config_version can't move as we hold the read lock
+    app_state_helper &helpers = *app->helpers;
+    zauto_lock l2(helpers.routing_table_lock);
+    if (helpers.routing_table_version != helpers.config_version) {
+        helpers.routing_table = dsn::dist::partition_routing_table::encode(app->partitions);
+        helpers.routing_table_version = helpers.config_version;
+    }
+    response.routes = helpers.routing_table;
+}
+
+void server_state::subscribe_configuration(dsn_message_t msg)
+{
+    configuration_subscribe_request request;
+    ::dsn::unmarshall(msg, request);
+
+    configuration_subscribe_response response;
+    zauto_write_lock l(_lock);
+    auto iter = _exist_apps.find(request.app_name);
+    if (iter == _exist_apps.end()) {
+        response.err = ERR_OBJECT_NOT_FOUND;
+    } else if (iter->second->status != app_status::AS_AVAILABLE) {
+        response.err = (iter->second->status == app_status::AS_CREATING ? ERR_BUSY_CREATING
+                                                                         : ERR_BUSY_DROPPING);
+    } else {
+        std::shared_ptr<app_state> &app = iter->second;
+        if (!get_configuration_changes(*app, request.epoch, request.known_version, response) &&
+            request.hold_ms > 0) {
+            uint64_t id = ++app->helpers->next_subscriber_id;
+            config_subscriber &sub = app->helpers->subscribers[id];
+            sub.msg = msg;
+            sub.epoch = request.epoch;
+            sub.known_version = request.known_version;
+            sub.timeout_task = tasking::enqueue(
+                LPC_META_STATE_NORMAL,
+                nullptr,
+                std::bind(&server_state::on_config_subscriber_timeout, this, app, id),
+                server_state::sStateHash,
+                std::chrono::milliseconds(request.hold_ms));
+            dinfo("%s: park configuration subscriber %" PRIu64 " at version %" PRId64,
+                  app->get_logname(),
+                  id,
+                  request.known_version);
+            return;
+        }
+    }
+
+    _meta_svc->reply_data(msg, response);
+    dsn_msg_release_ref(msg);
+}
+
+bool server_state::get_configuration_changes(const app_state &app,
+                                             int64_t epoch,
+                                             int64_t known_version,
+                                             /*out*/ configuration_subscribe_response &response)
+{
+    response.err = ERR_OK;
+    response.app_id = app.app_id;
+    response.partition_count = app.partition_count;
+    response.is_stateful = app.is_stateful;
+    response.epoch = _config_epoch;
+    response.version = app.helpers->config_version;
+    response.partitions.clear();
+
+    // a subscriber from a former meta server incarnation gets the full table
+    if (epoch != _config_epoch) {
+        response.partitions = app.partitions;
+        return true;
+    }
+    for (int i = 0; i < app.partition_count; ++i) {
+        if (app.helpers->contexts[i].change_version > known_version)
+            response.partitions.push_back(app.partitions[i]);
+    }
+    return !response.partitions.empty();
+}
+
+void server_state::mark_partition_changed(app_state &app, int pidx)
+{
+    app.helpers->contexts[pidx].change_version = ++app.helpers->config_version;
+}
+
+void server_state::notify_config_subscribers(app_state &app)
+{
+    if (app.helpers->subscribers.empty())
+        return;
+
+    std::map<uint64_t, config_subscriber> subscribers;
+    subscribers.swap(app.helpers->subscribers);
+    for (auto &kv : subscribers) {
+        config_subscriber &sub = kv.second;
+        sub.timeout_task->cancel(false);
+
+        configuration_subscribe_response response;
+        get_configuration_changes(app, sub.epoch, sub.known_version, response);
+        _meta_svc->reply_data(sub.msg, response);
+        dsn_msg_release_ref(sub.msg);
+    }
+}
+
+void server_state::on_config_subscriber_timeout(std::shared_ptr<app_state> app, uint64_t id)
+{
+    zauto_write_lock l(_lock);
+    auto iter = app->helpers->subscribers.find(id);
+    // already notified
+    if (iter == app->helpers->subscribers.end())
+        return;
+
+    configuration_subscribe_response response;
+    if (app->status != app_status::AS_AVAILABLE) {
+        response.err = ERR_OBJECT_NOT_FOUND;
+    } else {
+        get_configuration_changes(*app, iter->second.epoch, iter->second.known_version, response);
+    }
+    _meta_svc->reply_data(iter->second.msg, response);
+    dsn_msg_release_ref(iter->second.msg);
+    app->helpers->subscribers.erase(iter);
+}
+
 void server_state::init_app_partition_node(std::shared_ptr<app_state> &app,
                                            int pidx,
                                            task_ptr callback)
@@ -1463,6 +1611,7 @@ void server_state::update_configuration_locally(
     // as we sync to remote storage according to it
     std::string old_config_str = boost::lexical_cast<std::string>(old_cfg);
     old_cfg = config_request->config;
+    mark_partition_changed(app, gpid.get_partition_index());
     auto find_name = _config_type_VALUES_TO_NAMES.find(config_request->type);
     if (find_name != _config_type_VALUES_TO_NAMES.end()) {
         ddebug("meta update config ok: type(%s), old_config=%s, %s",
@@ -1479,6 +1628,7 @@ void server_state::update_configuration_locally(
 #ifndef NDEBUG
     check_consistency(gpid);
 #endif
+    notify_config_subscribers(app);
     if (_config_change_subscriber) {
         _config_change_subscriber(_all_apps);
     }
@@ -1592,6 +1742,8 @@ void server_state::recall_partition(std::shared_ptr<app_state> &app, int pidx)
         if (error == dsn::ERR_OK) {
             zauto_write_lock l(_lock);
             app->partitions[pidx].partition_flags &= (~pc_flags::dropped);
+            mark_partition_changed(*app, pidx);
+            notify_config_subscribers(*app);
             process_one_partition(app);
         } else if (error == dsn::ERR_TIMEOUT) {
             tasking::enqueue(LPC_META_STATE_HIGH,
@@ -2054,6 +2206,7 @@ error_code server_state::construct_partitions(
                 bool is_succeed = _meta_svc->get_balancer()->construct_replica(
                     {&_all_apps, &_nodes}, pc.pid, app->max_replica_count);
                 if (is_succeed) {
+                    mark_partition_changed(*app, pc.pid.get_partition_index());
                     ddebug("construct partition(%d.%d) succeed: %s",
                            app->app_id,
                            pc.pid.get_partition_index(),
@@ -143,6 +143,13 @@ public:
     void query_configuration_by_index(const configuration_query_by_index_request &request,
                                       /*out*/ configuration_query_by_index_response &response);
     bool query_configuration_by_gpid(const dsn::gpid id, /*out*/ partition_configuration &config);
+    // the whole table as a compact routing snapshot, empty if the client is up to date
+    void query_routing_table(const configuration_query_routing_request &request,
+                             /*out*/ configuration_query_routing_response &response);
+    // long-poll for the configuration changes of an app: replied at once if the
+    // subscriber is behind, otherwise parked until the next committed update or
+    // until request.hold_ms expires
+    void subscribe_configuration(dsn_message_t msg);
 
     // table options
     void create_app(dsn_message_t msg);
@@ -233,6 +240,17 @@ private:
                                  std::shared_ptr<configuration_update_request> &config_request);
     void request_check(const partition_configuration &old,
                        const configuration_update_request &request);
+    // fill the partitions changed since (epoch, known_version), return false if none
+    bool get_configuration_changes(const app_state &app,
+                                   int64_t epoch,
+                                   int64_t known_version,
+                                   /*out*/ configuration_subscribe_response &response);
+    // every path changing the configuration of a partition must call this in the write lock,
+    // so that the change is delivered to the configuration subscribers
+    void mark_partition_changed(app_state &app, int pidx);
+    void notify_config_subscribers(app_state &app);
+    void on_config_subscriber_timeout(std::shared_ptr<app_state> app, uint64_t id);
+
     void recall_partition(std::shared_ptr<app_state> &app, int pidx);
     void drop_partition(std::shared_ptr<app_state> &app, int pidx);
     void downgrade_primary_to_inactive(std::shared_ptr<app_state> &app, int pidx);
@@ -295,6 +313,10 @@ private:
     //_exist_apps + dropped apps: app_id -> app_state
     app_mapper _all_apps;
 
+    // a new epoch for each meta server incarnation, so that configuration
+    // subscribers won't apply versions from a former leader
+    int64_t _config_epoch;
+
     // for load balancer
     migration_list _temporary_list;
 
@@ -397,6 +397,14 @@ struct replica_info
     6:i64                    last_durable_decree;
     7:string                 app_type;
     8:string                 disk_tag;
+
+    // load statistics sampled on the replica server, used by load_aware_balancer.
+    // rates are averaged over the last sampling interval of the replica.
+    9:optional i64           read_qps;
+    10:optional i64          write_qps;
+    11:optional i64          read_bytes_per_second;
+    12:optional i64          write_bytes_per_second;
+    13:optional i64          storage_mb;
 }
 
 struct query_replica_info_request
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <iostream>
 #include <gtest/gtest.h>
 
 #include "dist/replication/meta_server/meta_data.h"
@@ -53,13 +54,13 @@ private:
 
 void generate_balanced_apps(/*out*/ app_mapper &apps,
                             node_mapper &nodes,
-                            const std::vector<dsn::rpc_address> &node_list)
+                            const std::vector<dsn::rpc_address> &node_list,
+                            int partitions_per_node)
 {
     nodes.clear();
     for (const auto &node : node_list)
         nodes[node].set_alive(true);
 
-    int partitions_per_node = random32(20, 100);
     dsn::app_info info;
     info.status = dsn::app_status::AS_AVAILABLE;
     info.is_stateful = true;
@@ -115,6 +116,7 @@ void generate_balanced_apps(/*out*/ app_mapper &apps,
             part_min = kv.second.partition_count();
     }
 
+    generate_app_serving_replica_info(the_app, 8);
     apps.emplace(the_app->app_id, the_app);
 
     ASSERT_TRUE(pri_max - pri_min <= 1);
@@ -123,11 +125,9 @@ void generate_balanced_apps(/*out*/ app_mapper &apps,
 
 void random_move_primary(app_mapper &apps, node_mapper &nodes, int primary_move_ratio)
 {
-    app_state &the_app = *(apps[0]);
-    int space_size = the_app.partition_count * 100;
+    app_state &the_app = *(apps.begin()->second);
     for (dsn::partition_configuration &pc : the_app.partitions) {
-        int n = random32(1, space_size) / 100;
-        if (n < primary_move_ratio) {
+        if (random32(1, 100) <= primary_move_ratio) {
             int indice = random32(0, 1);
             nodes[pc.primary].remove_partition(pc.pid, true);
             std::swap(pc.primary, pc.secondaries[indice]);
@@ -136,6 +136,17 @@ void random_move_primary(app_mapper &apps, node_mapper &nodes, int primary_move_
     }
 }
 
+static int primary_spread(const node_mapper &nodes)
+{
+    int pri_min = std::numeric_limits<int>::max();
+    int pri_max = -1;
+    for (const auto &kv : nodes) {
+        pri_min = std::min(pri_min, (int)kv.second.primary_count());
+        pri_max = std::max(pri_max, (int)kv.second.primary_count());
+    }
+    return pri_max - pri_min;
+}
+
 void greedy_balancer_perfect_move_primary()
 {
     app_mapper apps;
@@ -143,7 +154,7 @@ void greedy_balancer_perfect_move_primary()
     std::vector<dsn::rpc_address> node_list;
 
     generate_node_list(node_list, 20, 100);
-    generate_balanced_apps(apps, nodes, node_list);
+    generate_balanced_apps(apps, nodes, node_list, random32(20, 100));
 
     random_move_primary(apps, nodes, 70);
     // test the greedy balancer's move primary
@@ -157,12 +168,60 @@ void greedy_balancer_perfect_move_primary()
                 ASSERT_TRUE(act.type != config_type::CT_ADD_SECONDARY_FOR_LB);
             }
         }
+        migration_check_and_apply(apps, nodes, ml, nullptr);
+    }
+    ASSERT_TRUE(primary_spread(nodes) <= 1);
+}
+
+// measure the time to make the primary balancing plans, and the quality of them
+// (how many rounds and moves it takes to balance the primaries)
+void primary_balancer_benchmark(int node_count, int partitions_per_node, int primary_move_ratio)
+{
+    app_mapper apps;
+    node_mapper nodes;
+    std::vector<dsn::rpc_address> node_list;
+
+    generate_node_list(node_list, node_count, node_count);
+    generate_balanced_apps(apps, nodes, node_list, partitions_per_node);
+    random_move_primary(apps, nodes, primary_move_ratio);
+    int spread_before = primary_spread(nodes);
+
+    greedy_load_balancer glb(nullptr);
+    migration_list ml;
+
+    int rounds = 0;
+    int moves = 0;
+    uint64_t plan_ns = 0;
+    uint64_t max_round_ns = 0;
+    while (true) {
+        uint64_t start = dsn_now_ns();
+        bool has_plan = glb.balance({&apps, &nodes}, ml);
+        uint64_t elapsed = dsn_now_ns() - start;
+        plan_ns += elapsed;
+        max_round_ns = std::max(max_round_ns, elapsed);
+        if (!has_plan)
+            break;
+
+        ++rounds;
+        moves += ml.size();
+        migration_check_and_apply(apps, nodes, ml, nullptr);
     }
+    ASSERT_TRUE(primary_spread(nodes) <= 1);
+
+    std::cout << "nodes(" << node_count << "), partitions(" << node_count * partitions_per_node
+              << "), moved ratio(" << primary_move_ratio << "%): spread " << spread_before
+              << " -> " << primary_spread(nodes) << ", rounds(" << rounds << "), moves(" << moves
+              << "), total plan time(" << plan_ns / 1000000 << "ms), max round time("
+              << max_round_ns / 1000000 << "ms)" << std::endl;
 }
 
 int main(int, char **)
 {
     dsn_run_config("config.ini", false);
     greedy_balancer_perfect_move_primary();
+
+    primary_balancer_benchmark(100, 100, 30);
+    primary_balancer_benchmark(1000, 20, 30);
+    primary_balancer_benchmark(1000, 100, 70);
     return 0;
 }
@@ -10,6 +10,7 @@
 #include "dist/replication/meta_server/meta_data.h"
 #include "dist/replication/meta_server/server_load_balancer.h"
 #include "dist/replication/meta_server/greedy_load_balancer.h"
+#include "dist/replication/meta_server/load_aware_balancer.h"
 
 #include "dist/replication/test/meta_test/misc/misc.h"
 
@@ -208,7 +209,8 @@ void meta_service_test_app::balancer_validator()
     meta_service svc;
     simple_load_balancer slb(&svc);
     greedy_load_balancer glb(&svc);
-    std::vector<server_load_balancer *> lbs = {&slb, &glb};
+    load_aware_balancer lalb(&svc);
+    std::vector<server_load_balancer *> lbs = {&slb, &glb, &lalb};
 
     for (int i = 0; i < lbs.size(); ++i) {
         std::cerr << "the " << i << "th balancer" << std::endl;
@@ -259,6 +261,99 @@ void meta_service_test_app::balancer_validator()
     }
 }
 
+// simulate the load reported by the replica servers: reads are served by the primary,
+// writes are applied on all the members
+static void refresh_load_stat(app_mapper &apps, const std::map<dsn::gpid, int64_t> &read_qps)
+{
+    for (auto &kv : apps) {
+        std::shared_ptr<app_state> &app = kv.second;
+        for (int i = 0; i < app->partition_count; ++i) {
+            const partition_configuration &pc = app->partitions[i];
+            for (serving_replica &r : app->helpers->contexts[i].serving) {
+                auto iter = read_qps.find(pc.pid);
+                r.read_qps = (r.node == pc.primary && iter != read_qps.end()) ? iter->second : 0;
+                r.read_bytes_per_second = r.read_qps * 1024;
+                r.write_qps = 10;
+                r.write_bytes_per_second = 10240;
+                r.storage_mb = 100;
+            }
+        }
+    }
+}
+
+static int64_t max_node_read_qps(const node_mapper &nodes,
+                                 const std::map<dsn::gpid, int64_t> &read_qps)
+{
+    int64_t result = 0;
+    for (const auto &kv : nodes) {
+        int64_t qps = 0;
+        const node_state &ns = kv.second;
+        ns.for_each_partition([&](const dsn::gpid &pid) {
+            auto iter = read_qps.find(pid);
+            if (ns.served_as(pid) == partition_status::PS_PRIMARY && iter != read_qps.end())
+                qps += iter->second;
+            return true;
+        });
+        result = std::max(result, qps);
+    }
+    return result;
+}
+
+void meta_service_test_app::load_aware_balancer_test()
+{
+    std::vector<dsn::rpc_address> node_list;
+    generate_node_list(node_list, 10, 10);
+
+    app_mapper apps;
+    node_mapper nodes;
+    nodes_fs_manager manager;
+    int disk_on_node = 4;
+
+    generate_apps(apps, node_list, 2, disk_on_node, std::pair<uint32_t, uint32_t>(64, 128), true);
+    generate_node_mapper(nodes, apps, node_list);
+    generate_node_fs_manager(apps, nodes, manager, disk_on_node);
+
+    meta_service svc;
+    migration_list ml;
+
+    // balance the replica count first
+    greedy_load_balancer glb(&svc);
+    for (int i = 0; i < 1000000 && glb.balance({&apps, &nodes}, ml); ++i) {
+        migration_check_and_apply(apps, nodes, ml, &manager);
+    }
+
+    // make all the primaries on the first node hot
+    std::map<dsn::gpid, int64_t> read_qps;
+    for (auto &kv : apps) {
+        for (const partition_configuration &pc : kv.second->partitions) {
+            read_qps[pc.pid] = (pc.primary == node_list[0]) ? 1000 : 10;
+        }
+    }
+    refresh_load_stat(apps, read_qps);
+    int64_t hot_qps_before = max_node_read_qps(nodes, read_qps);
+
+    load_aware_balancer lalb(&svc);
+    int rounds = 0;
+    for (; rounds < 1000 && lalb.balance({&apps, &nodes}, ml); ++rounds) {
+        dinfo("the %dth round of load aware balancer", rounds);
+        migration_check_and_apply(apps, nodes, ml, &manager);
+        refresh_load_stat(apps, read_qps);
+    }
+    ASSERT_TRUE(rounds > 0);
+    ASSERT_TRUE(rounds < 1000);
+
+    int64_t hot_qps_after = max_node_read_qps(nodes, read_qps);
+    ddebug("max read qps of a node: %" PRId64 " -> %" PRId64, hot_qps_before, hot_qps_after);
+    ASSERT_TRUE(hot_qps_after < hot_qps_before);
+
+    for (auto &kv : apps) {
+        for (const partition_configuration &pc : kv.second->partitions) {
+            ASSERT_FALSE(pc.primary.is_invalid());
+            ASSERT_TRUE(pc.secondaries.size() + 1 == pc.max_replica_count);
+        }
+    }
+}
+
 dsn::rpc_address get_rpc_address(const std::string &ip_port)
 {
     int splitter = ip_port.find_first_of(':');
@@ -33,8 +33,12 @@ TEST(meta, data_definition) { g_app->data_definition_op_test(); }
 
 TEST(meta, update_configuration) { g_app->update_configuration_test(); }
 
+TEST(meta, subscribe_configuration) { g_app->subscribe_configuration_test(); }
+
 TEST(meta, balancer_validator) { g_app->balancer_validator(); }
 
+TEST(meta, load_aware_balancer) { g_app->load_aware_balancer_test(); }
+
 TEST(meta, apply_balancer) { g_app->apply_balancer_test(); }
 
 TEST(meta, cannot_run_balancer_test) { g_app->cannot_run_balancer_test(); }
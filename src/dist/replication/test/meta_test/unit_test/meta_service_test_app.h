@@ -76,7 +76,9 @@ public:
     void state_sync_test();
     void data_definition_op_test();
     void update_configuration_test();
+    void subscribe_configuration_test();
     void balancer_validator();
+    void load_aware_balancer_test();
     void balance_config_file();
     void apply_balancer_test();
     void cannot_run_balancer_test();
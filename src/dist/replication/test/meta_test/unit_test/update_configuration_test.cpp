@@ -324,6 +324,161 @@ void meta_service_test_app::adjust_dropped_size()
     spin_wait_condition(status_check, 10);
 }
 
+void meta_service_test_app::subscribe_configuration_test()
+{
+    dsn::error_code ec;
+    std::shared_ptr<fake_receiver_meta_service> svc(new fake_receiver_meta_service());
+    svc->_failure_detector.reset(new dsn::replication::meta_server_failure_detector(svc.get()));
+    ec = svc->remote_storage_initialize();
+    ASSERT_EQ(ec, dsn::ERR_OK);
+    svc->_balancer.reset(new dummy_balancer(svc.get()));
+
+    server_state *ss = svc->_state.get();
+    ss->initialize(svc.get(), meta_options::concat_path_unix_style(svc->_cluster_root, "apps"));
+    dsn::app_info info;
+    info.is_stateful = true;
+    info.status = dsn::app_status::AS_CREATING;
+    info.app_id = 1;
+    info.app_name = "simple_kv.instance0";
+    info.app_type = "simple_kv";
+    info.max_replica_count = 3;
+    info.partition_count = 2;
+    std::shared_ptr<app_state> app = app_state::create(info);
+
+    ss->_all_apps.emplace(1, app);
+
+    std::vector<dsn::rpc_address> nodes;
+    generate_node_list(nodes, 10, 10);
+
+    for (dsn::partition_configuration &pc : app->partitions) {
+        pc.primary = nodes[0];
+        pc.secondaries = {nodes[1], nodes[2]};
+        pc.ballot = 10;
+    }
+    // the partitions are also synced to remote storage to be recalled below
+    ASSERT_EQ(dsn::ERR_OK, ss->sync_apps_to_remote_storage());
+    ASSERT_TRUE(ss->spin_wait_staging(30));
+    generate_node_mapper(ss->_nodes, ss->_all_apps, nodes);
+
+    // a new subscriber gets the whole table at once
+    dsn::configuration_subscribe_request request;
+    request.app_name = info.app_name;
+    request.epoch = 0;
+    request.known_version = 0;
+    request.hold_ms = 0;
+
+    dsn::configuration_subscribe_response response;
+    auto result = fake_rpc_call(RPC_CM_SUBSCRIBE_PARTITION_CONFIG,
+                                LPC_META_STATE_NORMAL,
+                                ss,
+                                &server_state::subscribe_configuration,
+                                request);
+    fake_wait_rpc(result, response);
+    ASSERT_EQ(dsn::ERR_OK, response.err);
+    ASSERT_EQ(ss->_config_epoch, response.epoch);
+    ASSERT_EQ(0, response.version);
+    ASSERT_EQ(2, response.partitions.size());
+
+    // an up-to-date subscriber is parked until the next configuration update
+    request.epoch = response.epoch;
+    request.known_version = response.version;
+    request.hold_ms = 10000;
+    result = fake_rpc_call(RPC_CM_SUBSCRIBE_PARTITION_CONFIG,
+                           LPC_META_STATE_NORMAL,
+                           ss,
+                           &server_state::subscribe_configuration,
+                           request);
+    ASSERT_TRUE(spin_wait_condition(
+        [ss, &app]() {
+            zauto_read_lock l(ss->_lock);
+            return app->helpers->subscribers.size() == 1;
+        },
+        10));
+
+    std::shared_ptr<configuration_update_request> req =
+        std::make_shared<configuration_update_request>();
+    req->config = app->partitions[1];
+    req->config.ballot++;
+    req->config.secondaries.push_back(nodes[5]);
+    req->info = info;
+    req->node = nodes[5];
+    req->type = config_type::CT_UPGRADE_TO_SECONDARY;
+    {
+        zauto_write_lock l(ss->_lock);
+        ss->update_configuration_locally(*app, req);
+    }
+
+    fake_wait_rpc(result, response);
+    ASSERT_EQ(dsn::ERR_OK, response.err);
+    ASSERT_EQ(1, response.version);
+    ASSERT_EQ(1, response.partitions.size());
+    ASSERT_EQ(1, response.partitions[0].pid.get_partition_index());
+    ASSERT_EQ(11, response.partitions[0].ballot);
+    ASSERT_EQ(3, response.partitions[0].secondaries.size());
+
+    // nothing changed until hold_ms expires
+    request.known_version = response.version;
+    request.hold_ms = 100;
+    result = fake_rpc_call(RPC_CM_SUBSCRIBE_PARTITION_CONFIG,
+                           LPC_META_STATE_NORMAL,
+                           ss,
+                           &server_state::subscribe_configuration,
+                           request);
+    fake_wait_rpc(result, response);
+    ASSERT_EQ(dsn::ERR_OK, response.err);
+    ASSERT_EQ(1, response.version);
+    ASSERT_TRUE(response.partitions.empty());
+
+    // a subscriber of a former meta server incarnation gets the whole table again
+    request.epoch = ss->_config_epoch + 1;
+    request.hold_ms = 0;
+    result = fake_rpc_call(RPC_CM_SUBSCRIBE_PARTITION_CONFIG,
+                           LPC_META_STATE_NORMAL,
+                           ss,
+                           &server_state::subscribe_configuration,
+                           request);
+    fake_wait_rpc(result, response);
+    ASSERT_EQ(dsn::ERR_OK, response.err);
+    ASSERT_EQ(2, response.partitions.size());
+
+    // a configuration changed out of update_configuration_locally is delivered as well,
+    // e.g., a partition recalled with its app
+    request.epoch = response.epoch;
+    request.known_version = response.version;
+    request.hold_ms = 10000;
+    result = fake_rpc_call(RPC_CM_SUBSCRIBE_PARTITION_CONFIG,
+                           LPC_META_STATE_NORMAL,
+                           ss,
+                           &server_state::subscribe_configuration,
+                           request);
+    ASSERT_TRUE(spin_wait_condition(
+        [ss, &app]() {
+            zauto_read_lock l(ss->_lock);
+            return app->helpers->subscribers.size() == 1;
+        },
+        10));
+    {
+        zauto_write_lock l(ss->_lock);
+        app->status = dsn::app_status::AS_RECALLING;
+        app->helpers->partitions_in_progress.store(1);
+        app->partitions[0].partition_flags |= pc_flags::dropped;
+        ss->recall_partition(app, 0);
+    }
+
+    fake_wait_rpc(result, response);
+    ASSERT_EQ(dsn::ERR_OK, response.err);
+    ASSERT_EQ(2, response.version);
+    ASSERT_EQ(1, response.partitions.size());
+    ASSERT_EQ(0, response.partitions[0].pid.get_partition_index());
+    ASSERT_EQ(0, response.partitions[0].partition_flags);
+    ASSERT_TRUE(spin_wait_condition(
+        [ss, &app]() {
+            zauto_read_lock l(ss->_lock);
+            return app->status == dsn::app_status::AS_AVAILABLE;
+        },
+        10));
+}
+
 static void clone_app_mapper(app_mapper &output, const app_mapper &input)
 {
     output.clear();
@@ -83,6 +83,14 @@ public:
             resp.err = ERR_MOCK_INTERNAL;
         } else {
             resp.err = ERR_OK;
+            // like the real block services, the remote file takes the size and md5 of the
+            // uploaded local file if it exists
+            int64_t local_size = 0;
+            if (utils::filesystem::file_size(req.input_local_name, local_size)) {
+                size = local_size;
+                md5.clear();
+                utils::filesystem::md5sum(req.input_local_name, md5);
+            }
             // just return the file size
             resp.uploaded_size = size;
         }
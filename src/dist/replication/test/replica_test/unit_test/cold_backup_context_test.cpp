@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <fstream>
 #include "block_service_mock.h"
 
 ref_ptr<block_file_mock> current_chkpt_file = new block_file_mock("", 0, "");
@@ -263,6 +264,146 @@ void replication_service_test_app::read_backup_metadata_test()
     ASSERT_TRUE(regular_file->get_count() == 1);
 }
 
+void replication_service_test_app::prepare_file_md5_test()
+{
+    cold_backup_context_ptr backup_context =
+        new cold_backup_context(nullptr, request, concurrent_uploading_file_cnt);
+
+    backup_context->start_check();
+    backup_context->block_service = block_service.get();
+    backup_context->backup_root = backup_root;
+    backup_context->_status.store(cold_backup_status::ColdBackupUploading);
+    backup_context->checkpoint_dir = "./prepare_file_md5_test";
+    utils::filesystem::remove_path(backup_context->checkpoint_dir);
+    ASSERT_TRUE(utils::filesystem::create_directory(backup_context->checkpoint_dir));
+
+    std::string test_file = "test_file";
+    std::string full_path =
+        utils::filesystem::path_combine(backup_context->checkpoint_dir, test_file);
+    {
+        std::ofstream out(full_path);
+        out << "prepare_file_md5_test";
+    }
+    std::string expected_md5;
+    ASSERT_EQ(ERR_OK, utils::filesystem::md5sum(full_path, expected_md5));
+
+    // case1: md5 is computed on the first call, and is kept
+    {
+        std::cout << "testing prepare_file_md5 with an existing file..." << std::endl;
+        backup_context->_file_infos.insert(
+            std::make_pair(test_file, std::make_pair(21, std::string())));
+        ASSERT_TRUE(backup_context->prepare_file_md5(test_file));
+        ASSERT_EQ(expected_md5, backup_context->_file_infos.at(test_file).second);
+
+        utils::filesystem::remove_path(full_path);
+        ASSERT_TRUE(backup_context->prepare_file_md5(test_file));
+        ASSERT_EQ(expected_md5, backup_context->_file_infos.at(test_file).second);
+        ASSERT_TRUE(backup_context->status() == cold_backup_status::ColdBackupUploading);
+    }
+
+    // case2: file is missing, which fails the uploading
+    {
+        std::cout << "testing prepare_file_md5 with a missing file..." << std::endl;
+        std::string missing_file = "missing_file";
+        backup_context->_file_infos.insert(
+            std::make_pair(missing_file, std::make_pair(10, std::string())));
+        ASSERT_FALSE(backup_context->prepare_file_md5(missing_file));
+        ASSERT_TRUE(backup_context->status() == cold_backup_status::ColdBackupFailed);
+    }
+
+    utils::filesystem::remove_path(backup_context->checkpoint_dir);
+    ASSERT_TRUE(backup_context->get_count() == 1);
+}
+
+void replication_service_test_app::upload_file_test()
+{
+    cold_backup_context_ptr backup_context =
+        new cold_backup_context(nullptr, request, concurrent_uploading_file_cnt);
+
+    backup_context->start_check();
+    backup_context->block_service = block_service.get();
+    backup_context->backup_root = backup_root;
+    backup_context->_status.store(cold_backup_status::ColdBackupUploading);
+    backup_context->checkpoint_dir = "./upload_file_test";
+    utils::filesystem::remove_path(backup_context->checkpoint_dir);
+    ASSERT_TRUE(utils::filesystem::create_directory(backup_context->checkpoint_dir));
+
+    std::string test_file = "test_file";
+    std::string full_path =
+        utils::filesystem::path_combine(backup_context->checkpoint_dir, test_file);
+    {
+        std::ofstream out(full_path);
+        out << "upload_file_test";
+    }
+    int64_t file_size = 16;
+    std::string expected_md5;
+    ASSERT_EQ(ERR_OK, utils::filesystem::md5sum(full_path, expected_md5));
+
+    // the file is the only one, and the other half of total size is left to upload, so that
+    // uploading it completes the file but not the checkpoint
+    backup_context->checkpoint_file_total_size = file_size * 2;
+    backup_context->_file_infos.insert(
+        std::make_pair(test_file, std::make_pair(file_size, std::string())));
+    auto start_upload = [&backup_context, &test_file](const std::string &md5) {
+        backup_context->_file_infos.at(test_file).second = md5;
+        backup_context->_file_status[test_file] =
+            cold_backup_context::file_status::FileUploading;
+        backup_context->_cur_upload_file_cnt = 1;
+        backup_context->_upload_file_size.store(0);
+        backup_context->upload_file(test_file);
+    };
+
+    // case1: remote file is not exist, md5 is taken from the uploaded file
+    {
+        std::cout << "testing upload_file with remote file not exist..." << std::endl;
+        regular_file->clear_file_exist();
+        start_upload(std::string());
+        ASSERT_TRUE(backup_context->status() == cold_backup_status::ColdBackupUploading);
+        ASSERT_TRUE(backup_context->_file_status.at(test_file) ==
+                    cold_backup_context::file_status::FileUploadComplete);
+        ASSERT_EQ(file_size, backup_context->_upload_file_size.load());
+        ASSERT_EQ(expected_md5, backup_context->_file_infos.at(test_file).second);
+    }
+
+    // case2: remote file is the same as the local one, which is not uploaded again
+    {
+        std::cout << "testing upload_file with remote file already uploaded..." << std::endl;
+        regular_file->file_exist(expected_md5, file_size);
+        regular_file->enable_upload_fail = true;
+        start_upload(std::string());
+        ASSERT_TRUE(backup_context->status() == cold_backup_status::ColdBackupUploading);
+        ASSERT_TRUE(backup_context->_file_status.at(test_file) ==
+                    cold_backup_context::file_status::FileUploadComplete);
+        ASSERT_EQ(expected_md5, backup_context->_file_infos.at(test_file).second);
+        regular_file->enable_upload_fail = false;
+    }
+
+    // case3: remote file has the same size but different md5, which is uploaded again
+    {
+        std::cout << "testing upload_file with remote file of different md5..." << std::endl;
+        regular_file->file_exist("remote_md5", file_size);
+        start_upload(std::string());
+        ASSERT_TRUE(backup_context->status() == cold_backup_status::ColdBackupUploading);
+        ASSERT_TRUE(backup_context->_file_status.at(test_file) ==
+                    cold_backup_context::file_status::FileUploadComplete);
+        ASSERT_EQ(expected_md5, regular_file->md5);
+        ASSERT_EQ(expected_md5, backup_context->_file_infos.at(test_file).second);
+    }
+
+    // case4: md5 of the uploaded file differs from the local one, which fails the uploading
+    {
+        std::cout << "testing upload_file with md5 mismatch..." << std::endl;
+        regular_file->clear_file_exist();
+        start_upload("local_md5");
+        ASSERT_TRUE(backup_context->status() == cold_backup_status::ColdBackupFailed);
+    }
+
+    regular_file->clear_file_exist();
+    utils::filesystem::remove_path(backup_context->checkpoint_dir);
+    ASSERT_TRUE(backup_context->get_count() == 1);
+    ASSERT_TRUE(regular_file->get_count() == 1);
+}
+
 void replication_service_test_app::on_upload_chkpt_dir_test()
 {
     cold_backup_context_ptr backup_context =
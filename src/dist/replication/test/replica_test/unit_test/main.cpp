@@ -5,6 +5,9 @@
 
 #include <gtest/gtest.h>
 #include <dsn/dist/replication/replication_service_app.h>
+#include <apps/skv/simple_kv.server.impl.h>
+#include "dist/replication/lib/replica.h"
+#include "dist/replication/lib/replica_stub.h"
 
 #include "replication_service_test_app.h"
 
@@ -22,12 +25,42 @@ TEST(cold_backup_context, upload_checkpoint_to_remote) { app->upload_checkpoint_
 
 TEST(cold_backup_context, read_backup_metadata) { app->read_backup_metadata_test(); }
 
+TEST(cold_backup_context, prepare_file_md5) { app->prepare_file_md5_test(); }
+
+TEST(cold_backup_context, upload_file) { app->upload_file_test(); }
+
 TEST(cold_backup_context, on_upload_chkpt_dir) { app->on_upload_chkpt_dir_test(); }
 
 TEST(cold_backup_context, write_metadata_file) { app->write_backup_metadata_test(); }
 
 TEST(cold_backup_context, write_current_chkpt_file) { app->write_current_chkpt_file_test(); }
 
+TEST(simple_kv_sharded, shard) { app->simple_kv_sharded_shard_test(); }
+
+TEST(simple_kv_sharded, snapshot) { app->simple_kv_sharded_snapshot_test(); }
+
+TEST(simple_kv_sharded, checkpoint) { app->simple_kv_sharded_checkpoint_test(); }
+
+TEST(simple_kv_sharded, gc) { app->simple_kv_sharded_gc_test(); }
+
+TEST(simple_kv_sharded, backup_checkpoint) { app->simple_kv_sharded_backup_checkpoint_test(); }
+
+TEST(simple_kv_sharded, batched_updates) { app->simple_kv_sharded_batched_updates_test(); }
+
+dsn::replication::replica *replication_service_test_app::create_test_replica(
+    dsn::gpid pid, const char *app_type, const std::string &dir)
+{
+    if (_stub == nullptr)
+        _stub = new dsn::replication::replica_stub();
+
+    dsn::app_info info;
+    info.app_type = app_type;
+    info.app_id = pid.get_app_id();
+    info.partition_count = 1;
+    info.is_stateful = true;
+    return new dsn::replication::replica(_stub, pid, info, dir.c_str(), false);
+}
+
 error_code replication_service_test_app::start(const std::vector<std::string> &args)
 {
     int argc = args.size();
@@ -46,6 +79,7 @@ error_code replication_service_test_app::start(const std::vector<std::string> &a
 GTEST_API_ int main(int argc, char **argv)
 {
     dsn::service_app::register_factory<replication_service_test_app>("replica");
+    dsn::replication::application::simple_kv_service_impl::register_service();
     if (argc < 2)
         dassert(dsn_run_config("config-test.ini", false), "");
     else
@@ -4,6 +4,13 @@
 using ::dsn::replication::replication_service_app;
 using ::dsn::error_code;
 
+namespace dsn {
+namespace replication {
+class replica;
+class replica_stub;
+}
+}
+
 class replication_service_test_app : public replication_service_app
 {
 public:
@@ -19,8 +26,26 @@ public:
     void remote_chkpt_dir_exist_test();
 
     void upload_checkpoint_to_remote_test();
+    void prepare_file_md5_test();
+    void upload_file_test();
     void read_backup_metadata_test();
     void on_upload_chkpt_dir_test();
     void write_backup_metadata_test();
     void write_current_chkpt_file_test();
+
+    // test for simple_kv_sharded_service_impl
+    void simple_kv_sharded_shard_test();
+    void simple_kv_sharded_snapshot_test();
+    void simple_kv_sharded_checkpoint_test();
+    void simple_kv_sharded_gc_test();
+    void simple_kv_sharded_backup_checkpoint_test();
+    void simple_kv_sharded_batched_updates_test();
+
+private:
+    // an inactive replica with its files under 'dir', for testing the routines of the replica
+    // and its app without starting the replica_stub
+    dsn::replication::replica *
+    create_test_replica(dsn::gpid pid, const char *app_type, const std::string &dir);
+
+    dsn::replication::replica_stub *_stub = nullptr;
 };
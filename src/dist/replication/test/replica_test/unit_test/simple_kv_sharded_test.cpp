@@ -0,0 +1,559 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sys/stat.h>
+#include <dsn/utility/filesystem.h>
+#include <apps/skv/simple_kv.server.sharded_impl.h>
+
+#include "dist/replication/lib/replica.h"
+#include "replication_service_test_app.h"
+
+using namespace ::dsn::replication;
+using namespace ::dsn::replication::application;
+
+static std::string make_key(int i) { return "key." + std::to_string(i); }
+
+static void shard_put(kv_shard &s, const std::string &key, const std::string &value)
+{
+    s.put(kv_shard::hash(key), key, value);
+}
+
+static void shard_append(kv_shard &s, const std::string &key, const std::string &value)
+{
+    s.append(kv_shard::hash(key), key, value);
+}
+
+static bool shard_get(kv_shard &s, const std::string &key, std::string &value)
+{
+    return s.get(kv_shard::hash(key), key, value);
+}
+
+static std::map<std::string, std::string> dump_table(const kv_shard::table &t)
+{
+    std::map<std::string, std::string> kvs;
+    for (const kv_shard::slot &s : t.slots) {
+        if (s.hash != 0)
+            kvs[std::string(s.data, s.key_length)] =
+                std::string(s.data + s.key_length, s.value_length);
+    }
+    return kvs;
+}
+
+static int count_checkpoints(const std::string &dir, std::vector<std::string> *names = nullptr)
+{
+    std::vector<std::string> files;
+    dsn::utils::filesystem::get_subfiles(dir, files, false);
+    int count = 0;
+    for (auto &f : files) {
+        std::string name = dsn::utils::filesystem::get_file_name(f);
+        if (name.compare(0, strlen("checkpoint."), "checkpoint.") == 0) {
+            count++;
+            if (names != nullptr)
+                names->push_back(name);
+        }
+    }
+    return count;
+}
+
+static mutation_update
+make_update(dsn::task_code code, const std::string &key, const std::string &value)
+{
+    kv_pair pr;
+    pr.key = key;
+    pr.value = value;
+    dsn::binary_writer writer;
+    dsn::marshall(writer, pr, DSF_THRIFT_BINARY);
+
+    mutation_update update;
+    update.code = code;
+    update.serialization_type = DSF_THRIFT_BINARY;
+    update.data = writer.get_buffer();
+    return update;
+}
+
+static void write_update(simple_kv_sharded_service_impl *app,
+                         int64_t decree,
+                         dsn::task_code code,
+                         const std::string &key,
+                         const std::string &value)
+{
+    mutation_update update = make_update(code, key, value);
+    ASSERT_EQ(0, app->on_batched_write_updates(decree, 0, &update, 1));
+}
+
+void replication_service_test_app::simple_kv_sharded_shard_test()
+{
+    kv_shard s;
+    std::string value;
+
+    // case1 : put and get across growth of the table
+    {
+        std::cout << "testing put and get across table growth..." << std::endl;
+        ASSERT_FALSE(shard_get(s, make_key(0), value));
+        for (int i = 0; i < 1000; i++) {
+            shard_put(s, make_key(i), "value." + std::to_string(i));
+        }
+        auto t = s.snapshot();
+        ASSERT_EQ(1000u, t->count);
+        // the load factor is kept under 3/4
+        ASSERT_EQ(2048u, t->slots.size());
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_TRUE(shard_get(s, make_key(i), value));
+            ASSERT_EQ("value." + std::to_string(i), value);
+        }
+        ASSERT_FALSE(shard_get(s, make_key(1000), value));
+    }
+
+    // case2 : append to existing and missing keys
+    {
+        std::cout << "testing append..." << std::endl;
+        for (int i = 0; i < 1000; i += 2) {
+            shard_append(s, make_key(i), ".appended");
+        }
+        shard_append(s, "new", "first");
+        shard_append(s, "new", ".second");
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_TRUE(shard_get(s, make_key(i), value));
+            ASSERT_EQ("value." + std::to_string(i) + (i % 2 == 0 ? ".appended" : ""), value);
+        }
+        ASSERT_TRUE(shard_get(s, "new", value));
+        ASSERT_EQ("first.second", value);
+        ASSERT_EQ(1001u, s.snapshot()->count);
+    }
+
+    // case3 : overwritten values are compacted once they take most of the arena
+    {
+        std::cout << "testing compaction..." << std::endl;
+        auto before = s.snapshot();
+        std::string big(64 * 1024, 'x');
+        for (int i = 0; i < 40; i++) {
+            big[0] = static_cast<char>('a' + i % 26);
+            shard_put(s, "big", big);
+        }
+        auto after = s.snapshot();
+        ASSERT_NE(before->arena.get(), after->arena.get());
+        // compaction alone doesn't change the capacity
+        ASSERT_EQ(before->slots.size(), after->slots.size());
+        ASSERT_EQ(1002u, after->count);
+
+        ASSERT_TRUE(shard_get(s, "big", value));
+        ASSERT_EQ(big, value);
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_TRUE(shard_get(s, make_key(i), value));
+            ASSERT_EQ("value." + std::to_string(i) + (i % 2 == 0 ? ".appended" : ""), value);
+        }
+        ASSERT_TRUE(shard_get(s, "new", value));
+        ASSERT_EQ("first.second", value);
+    }
+
+    // case4 : clear
+    {
+        std::cout << "testing clear..." << std::endl;
+        s.clear();
+        ASSERT_FALSE(shard_get(s, make_key(0), value));
+        ASSERT_EQ(0u, s.snapshot()->count);
+        shard_put(s, make_key(0), "v");
+        ASSERT_TRUE(shard_get(s, make_key(0), value));
+        ASSERT_EQ("v", value);
+    }
+}
+
+void replication_service_test_app::simple_kv_sharded_snapshot_test()
+{
+    kv_shard s;
+    std::map<std::string, std::string> expected;
+    for (int i = 0; i < 100; i++) {
+        shard_put(s, make_key(i), "value." + std::to_string(i));
+        expected[make_key(i)] = "value." + std::to_string(i);
+    }
+
+    auto snapshot = s.snapshot();
+    ASSERT_EQ(expected, dump_table(*snapshot));
+
+    // overwrites, appends, inserts which grow the table, and compaction
+    for (int i = 0; i < 50; i++) {
+        shard_put(s, make_key(i), "overwritten");
+    }
+    for (int i = 50; i < 100; i++) {
+        shard_append(s, make_key(i), ".appended");
+    }
+    for (int i = 100; i < 1000; i++) {
+        shard_put(s, make_key(i), "value." + std::to_string(i));
+    }
+    std::string big(64 * 1024, 'x');
+    for (int i = 0; i < 40; i++) {
+        shard_put(s, make_key(0), big);
+    }
+    ASSERT_EQ(100u, snapshot->count);
+    ASSERT_EQ(expected, dump_table(*snapshot));
+
+    // a snapshot taken in the middle, then cleared
+    auto snapshot2 = s.snapshot();
+    ASSERT_EQ(1000u, snapshot2->count);
+    s.clear();
+    shard_put(s, make_key(1), "after clear");
+    ASSERT_EQ(expected, dump_table(*snapshot));
+    auto kvs = dump_table(*snapshot2);
+    ASSERT_EQ(1000u, kvs.size());
+    ASSERT_EQ(big, kvs[make_key(0)]);
+    ASSERT_EQ("overwritten", kvs[make_key(1)]);
+    ASSERT_EQ("value.50.appended", kvs[make_key(50)]);
+    ASSERT_EQ("value.999", kvs[make_key(999)]);
+
+    std::string value;
+    ASSERT_TRUE(shard_get(s, make_key(1), value));
+    ASSERT_EQ("after clear", value);
+    ASSERT_FALSE(shard_get(s, make_key(0), value));
+}
+
+void replication_service_test_app::simple_kv_sharded_checkpoint_test()
+{
+    std::string dir = "./test-simple-kv-sharded";
+    std::string learner_dir = "./test-simple-kv-sharded-learner";
+    dsn::utils::filesystem::remove_path(dir);
+    dsn::utils::filesystem::remove_path(learner_dir);
+    ASSERT_TRUE(dsn::utils::filesystem::create_directory(dir + "/data"));
+    ASSERT_TRUE(dsn::utils::filesystem::create_directory(learner_dir + "/data"));
+
+    replica_ptr r = create_test_replica(dsn::gpid(1, 0), "simple_kv_sharded", dir);
+    std::unique_ptr<simple_kv_sharded_service_impl> app(new simple_kv_sharded_service_impl(r));
+    ASSERT_EQ(dsn::ERR_OK, app->start(0, nullptr));
+    ASSERT_EQ(0, app->last_durable_decree());
+
+    auto get = [](simple_kv_sharded_service_impl *a, const std::string &key, std::string &value) {
+        uint64_t h = kv_shard::hash(key);
+        return a->shard_of(h).get(h, key, value);
+    };
+    std::string value;
+
+    // case1 : checkpoint and recover
+    {
+        std::cout << "testing checkpoint and recover..." << std::endl;
+        for (int i = 1; i <= 10; i++) {
+            write_update(
+                app.get(), i, RPC_SIMPLE_KV_SIMPLE_KV_WRITE, make_key(i), std::to_string(i));
+        }
+        write_update(app.get(), 11, RPC_SIMPLE_KV_SIMPLE_KV_APPEND, make_key(1), ".appended");
+
+        ASSERT_EQ(dsn::ERR_OK, app->sync_checkpoint());
+        ASSERT_EQ(11, app->last_durable_decree());
+        ASSERT_TRUE(dsn::utils::filesystem::file_exists(dir + "/data/checkpoint.11"));
+        // nothing new to checkpoint
+        ASSERT_EQ(dsn::ERR_OK, app->sync_checkpoint());
+        ASSERT_EQ(dsn::ERR_NO_NEED_OPERATE, app->async_checkpoint(false));
+
+        // not in the checkpoint
+        write_update(app.get(), 12, RPC_SIMPLE_KV_SIMPLE_KV_WRITE, make_key(12), "12");
+        ASSERT_EQ(dsn::ERR_OK, app->stop(false));
+
+        app.reset(new simple_kv_sharded_service_impl(r));
+        ASSERT_EQ(dsn::ERR_OK, app->start(0, nullptr));
+        ASSERT_EQ(11, app->last_durable_decree());
+        ASSERT_EQ(11, app->_applied_decree);
+        ASSERT_TRUE(get(app.get(), make_key(1), value));
+        ASSERT_EQ("1.appended", value);
+        for (int i = 2; i <= 10; i++) {
+            ASSERT_TRUE(get(app.get(), make_key(i), value));
+            ASSERT_EQ(std::to_string(i), value);
+        }
+        ASSERT_FALSE(get(app.get(), make_key(12), value));
+    }
+
+    // case2 : learn the checkpoint by another replica
+    {
+        std::cout << "testing learn checkpoint..." << std::endl;
+        learn_state state;
+        ASSERT_EQ(dsn::ERR_OK, app->get_checkpoint(0, dsn::blob(), state));
+        ASSERT_EQ(11, state.to_decree_included);
+        ASSERT_EQ(1u, state.files.size());
+
+        replica_ptr learner =
+            create_test_replica(dsn::gpid(1, 1), "simple_kv_sharded", learner_dir);
+        std::unique_ptr<simple_kv_sharded_service_impl> learner_app(
+            new simple_kv_sharded_service_impl(learner));
+        ASSERT_EQ(dsn::ERR_OK, learner_app->start(0, nullptr));
+        ASSERT_EQ(dsn::ERR_OK,
+                  learner_app->storage_apply_checkpoint(replication_app_base::learn, state));
+        ASSERT_EQ(11, learner_app->last_durable_decree());
+        ASSERT_TRUE(dsn::utils::filesystem::file_exists(learner_dir + "/data/checkpoint.11"));
+        for (int i = 1; i <= 10; i++) {
+            std::string expected;
+            ASSERT_TRUE(get(app.get(), make_key(i), expected));
+            ASSERT_TRUE(get(learner_app.get(), make_key(i), value));
+            ASSERT_EQ(expected, value);
+        }
+        ASSERT_EQ(dsn::ERR_OK, learner_app->stop(true));
+        ASSERT_FALSE(dsn::utils::filesystem::directory_exists(learner_dir + "/data"));
+    }
+
+    // case3 : copy the current state out, which includes the writes after the last checkpoint
+    {
+        std::cout << "testing copy checkpoint to dir..." << std::endl;
+        write_update(app.get(), 12, RPC_SIMPLE_KV_SIMPLE_KV_WRITE, make_key(12), "12");
+        int64_t last_decree = 0;
+        ASSERT_EQ(dsn::ERR_OK, app->copy_checkpoint_to_dir((dir + "/copy").c_str(), &last_decree));
+        ASSERT_EQ(12, last_decree);
+        ASSERT_TRUE(dsn::utils::filesystem::file_exists(dir + "/copy/checkpoint.12"));
+        // the durable checkpoint is unchanged
+        ASSERT_EQ(11, app->last_durable_decree());
+
+        ASSERT_EQ(dsn::ERR_OK, app->recover(dir + "/copy/checkpoint.12"));
+        ASSERT_TRUE(get(app.get(), make_key(12), value));
+        ASSERT_EQ("12", value);
+    }
+
+    // case4 : truncated checkpoint file
+    {
+        std::cout << "testing truncated checkpoint..." << std::endl;
+        std::string name = dir + "/copy/checkpoint.12";
+        int64_t size = 0;
+        ASSERT_TRUE(dsn::utils::filesystem::file_size(name, size));
+        std::string content(static_cast<size_t>(size), '\0');
+        {
+            std::ifstream is(name.c_str(), std::ios::binary);
+            is.read(&content[0], size);
+        }
+        {
+            std::ofstream os(name.c_str(), std::ios::binary | std::ios::trunc);
+            os.write(content.data(), size - 1);
+        }
+        ASSERT_EQ(dsn::ERR_INVALID_DATA, app->recover(name));
+        ASSERT_FALSE(get(app.get(), make_key(1), value));
+    }
+
+    ASSERT_EQ(dsn::ERR_OK, app->stop(true));
+    app.reset();
+    dsn::utils::filesystem::remove_path(dir);
+    dsn::utils::filesystem::remove_path(learner_dir);
+}
+
+void replication_service_test_app::simple_kv_sharded_gc_test()
+{
+    std::string dir = "./test-simple-kv-sharded-gc";
+    std::string data_dir = dir + "/data";
+    dsn::utils::filesystem::remove_path(dir);
+    ASSERT_TRUE(dsn::utils::filesystem::create_directory(data_dir));
+
+    // left by an unfinished checkpoint
+    {
+        std::ofstream os((data_dir + "/checkpoint.100.tmp").c_str(), std::ios::binary);
+        os << "unfinished";
+    }
+
+    replica_ptr r = create_test_replica(dsn::gpid(1, 2), "simple_kv_sharded", dir);
+    std::unique_ptr<simple_kv_sharded_service_impl> app(new simple_kv_sharded_service_impl(r));
+    ASSERT_EQ(dsn::ERR_OK, app->start(0, nullptr));
+    ASSERT_FALSE(dsn::utils::filesystem::file_exists(data_dir + "/checkpoint.100.tmp"));
+    ASSERT_EQ(0, count_checkpoints(data_dir));
+
+    // the last two checkpoints are kept
+    for (int i = 1; i <= 5; i++) {
+        write_update(app.get(), i, RPC_SIMPLE_KV_SIMPLE_KV_WRITE, make_key(i), std::to_string(i));
+        ASSERT_EQ(dsn::ERR_OK, app->async_checkpoint(false));
+        ASSERT_EQ(i, app->last_durable_decree());
+
+        std::vector<std::string> names;
+        ASSERT_EQ(std::min(i, 2), count_checkpoints(data_dir, &names));
+        std::sort(names.begin(), names.end());
+        ASSERT_EQ("checkpoint." + std::to_string(i), names.back());
+        if (i > 1)
+            ASSERT_EQ("checkpoint." + std::to_string(i - 1), names.front());
+    }
+
+    // the latest one is recovered from
+    ASSERT_EQ(dsn::ERR_OK, app->stop(false));
+    app.reset(new simple_kv_sharded_service_impl(r));
+    ASSERT_EQ(dsn::ERR_OK, app->start(0, nullptr));
+    ASSERT_EQ(5, app->last_durable_decree());
+
+    ASSERT_EQ(dsn::ERR_OK, app->stop(true));
+    app.reset();
+    dsn::utils::filesystem::remove_path(dir);
+}
+
+static bool is_same_file(const std::string &a, const std::string &b)
+{
+    struct stat sa, sb;
+    return ::stat(a.c_str(), &sa) == 0 && ::stat(b.c_str(), &sb) == 0 && sa.st_dev == sb.st_dev &&
+           sa.st_ino == sb.st_ino;
+}
+
+// an app whose checkpoint may also have a file in a sub dir of the data dir
+class nested_checkpoint_kv_service : public simple_kv_sharded_service_impl
+{
+public:
+    nested_checkpoint_kv_service(replica *r) : simple_kv_sharded_service_impl(r), nested(false)
+    {
+    }
+
+    virtual ::dsn::error_code get_checkpoint(int64_t learn_start,
+                                             const dsn::blob &learn_request,
+                                             /*out*/ learn_state &state) override
+    {
+        ::dsn::error_code err =
+            simple_kv_sharded_service_impl::get_checkpoint(learn_start, learn_request, state);
+        if (err == dsn::ERR_OK && nested) {
+            std::string sub_dir = dsn::utils::filesystem::path_combine(data_dir(), "nested");
+            dsn::utils::filesystem::create_directory(sub_dir);
+            std::string file = dsn::utils::filesystem::path_combine(sub_dir, "extra");
+            std::ofstream os(file.c_str(), std::ios::binary);
+            os << "extra";
+            state.files.push_back(file);
+        }
+        return err;
+    }
+
+    bool nested;
+};
+
+void replication_service_test_app::simple_kv_sharded_backup_checkpoint_test()
+{
+    std::string dir = "./test-simple-kv-sharded-backup";
+    dsn::utils::filesystem::remove_path(dir);
+    ASSERT_TRUE(dsn::utils::filesystem::create_directory(dir + "/data"));
+
+    replica_ptr r = create_test_replica(dsn::gpid(2, 0), "simple_kv_sharded", dir);
+    r->_app.reset(new nested_checkpoint_kv_service(r));
+    auto app = static_cast<nested_checkpoint_kv_service *>(r->_app.get());
+    ASSERT_EQ(dsn::ERR_OK, app->start(0, nullptr));
+    for (int i = 1; i <= 10; i++) {
+        write_update(app, i, RPC_SIMPLE_KV_SIMPLE_KV_WRITE, make_key(i), std::to_string(i));
+    }
+    ASSERT_EQ(dsn::ERR_OK, app->sync_checkpoint());
+    std::string app_checkpoint = dir + "/data/checkpoint.10";
+    ASSERT_TRUE(dsn::utils::filesystem::file_exists(app_checkpoint));
+
+    backup_request request;
+    request.__set_pid(dsn::gpid(2, 0));
+    cold_backup_context_ptr backup_context = new cold_backup_context(r, request, 1);
+    bool link_enabled = r->_options->cold_backup_link_checkpoint_enabled;
+    r->_options->cold_backup_link_checkpoint_enabled = true;
+    int64_t last_decree = 0;
+
+    // case1 : the files of the app checkpoint are linked
+    {
+        std::cout << "testing link app checkpoint..." << std::endl;
+        backup_context->checkpoint_decree = 10;
+        std::string backup_dir = dir + "/backup.1";
+        ASSERT_EQ(dsn::ERR_OK,
+                  r->create_backup_checkpoint_dir(backup_context, backup_dir, &last_decree));
+        ASSERT_EQ(10, last_decree);
+        ASSERT_TRUE(is_same_file(app_checkpoint, backup_dir + "/checkpoint.10"));
+    }
+
+    // case2 : app checkpoint is behind the backup decree, so the app state is copied
+    {
+        std::cout << "testing copy when app checkpoint is behind..." << std::endl;
+        write_update(app, 11, RPC_SIMPLE_KV_SIMPLE_KV_WRITE, make_key(11), "11");
+        backup_context->checkpoint_decree = 11;
+        std::string backup_dir = dir + "/backup.2";
+        ASSERT_EQ(dsn::ERR_OK,
+                  r->create_backup_checkpoint_dir(backup_context, backup_dir, &last_decree));
+        ASSERT_EQ(11, last_decree);
+        ASSERT_TRUE(dsn::utils::filesystem::file_exists(backup_dir + "/checkpoint.11"));
+        ASSERT_FALSE(dsn::utils::filesystem::file_exists(backup_dir + "/checkpoint.10"));
+        ASSERT_EQ(10, app->last_durable_decree());
+    }
+
+    // case3 : linking fails, so the partly linked dir is removed and the app state is copied
+    {
+        std::cout << "testing copy when link fails..." << std::endl;
+        backup_context->checkpoint_decree = 10;
+        std::string backup_dir = dir + "/backup.3";
+        ASSERT_TRUE(dsn::utils::filesystem::create_directory(backup_dir));
+        {
+            std::ofstream os((backup_dir + "/checkpoint.10").c_str(), std::ios::binary);
+            os << "occupied";
+        }
+        ASSERT_EQ(dsn::ERR_OK,
+                  r->create_backup_checkpoint_dir(backup_context, backup_dir, &last_decree));
+        ASSERT_EQ(11, last_decree);
+        ASSERT_TRUE(dsn::utils::filesystem::file_exists(backup_dir + "/checkpoint.11"));
+        ASSERT_FALSE(dsn::utils::filesystem::file_exists(backup_dir + "/checkpoint.10"));
+    }
+
+    // case4 : linking is disabled, so the app state is copied
+    {
+        std::cout << "testing copy when link is disabled..." << std::endl;
+        r->_options->cold_backup_link_checkpoint_enabled = false;
+        backup_context->checkpoint_decree = 10;
+        std::string backup_dir = dir + "/backup.4";
+        ASSERT_EQ(dsn::ERR_OK,
+                  r->create_backup_checkpoint_dir(backup_context, backup_dir, &last_decree));
+        ASSERT_EQ(11, last_decree);
+        ASSERT_TRUE(dsn::utils::filesystem::file_exists(backup_dir + "/checkpoint.11"));
+    }
+
+    // case5 : the app checkpoint has a nested file, so the app state is copied
+    {
+        std::cout << "testing copy when app checkpoint is nested..." << std::endl;
+        r->_options->cold_backup_link_checkpoint_enabled = true;
+        app->nested = true;
+        backup_context->checkpoint_decree = 10;
+        std::string backup_dir = dir + "/backup.5";
+        ASSERT_EQ(dsn::ERR_OK,
+                  r->create_backup_checkpoint_dir(backup_context, backup_dir, &last_decree));
+        ASSERT_EQ(11, last_decree);
+        ASSERT_TRUE(dsn::utils::filesystem::file_exists(backup_dir + "/checkpoint.11"));
+        ASSERT_FALSE(dsn::utils::filesystem::file_exists(backup_dir + "/extra"));
+        app->nested = false;
+    }
+
+    r->_options->cold_backup_link_checkpoint_enabled = link_enabled;
+    ASSERT_EQ(dsn::ERR_OK, app->stop(true));
+    r->_app.reset();
+    dsn::utils::filesystem::remove_path(dir);
+}
+
+void replication_service_test_app::simple_kv_sharded_batched_updates_test()
+{
+    std::string dir = "./test-simple-kv-sharded-updates";
+    dsn::utils::filesystem::remove_path(dir);
+    ASSERT_TRUE(dsn::utils::filesystem::create_directory(dir + "/data"));
+
+    replica_ptr r = create_test_replica(dsn::gpid(1, 0), "simple_kv_sharded", dir);
+    std::unique_ptr<simple_kv_sharded_service_impl> app(new simple_kv_sharded_service_impl(r));
+    ASSERT_EQ(dsn::ERR_OK, app->start(0, nullptr));
+
+    auto get = [](simple_kv_sharded_service_impl *a, const std::string &key, std::string &value) {
+        uint64_t h = kv_shard::hash(key);
+        return a->shard_of(h).get(h, key, value);
+    };
+    std::string value;
+
+    // case1 : a single update is unmarshalled in place by its typed handler
+    {
+        std::cout << "testing handle update..." << std::endl;
+        mutation_update update = make_update(RPC_SIMPLE_KV_SIMPLE_KV_WRITE, "single", "1");
+        ASSERT_EQ(0,
+                  app->handle_update(update.code,
+                                     (dsn_msg_serialize_format)update.serialization_type,
+                                     update.data));
+        ASSERT_TRUE(get(app.get(), "single", value));
+        ASSERT_EQ("1", value);
+    }
+
+    // case2 : all updates of a batch are applied in order, under the decree of the batch
+    {
+        std::cout << "testing batched updates..." << std::endl;
+        std::vector<mutation_update> updates;
+        updates.push_back(make_update(RPC_SIMPLE_KV_SIMPLE_KV_WRITE, make_key(1), "1"));
+        updates.push_back(make_update(RPC_SIMPLE_KV_SIMPLE_KV_APPEND, make_key(1), ".appended"));
+        updates.push_back(make_update(RPC_SIMPLE_KV_SIMPLE_KV_WRITE, make_key(2), "2"));
+        updates.push_back(make_update(RPC_SIMPLE_KV_SIMPLE_KV_APPEND, make_key(3), "3"));
+        ASSERT_EQ(0, app->on_batched_write_updates(1, 0, updates.data(), (int)updates.size()));
+        ASSERT_EQ(1, app->_applied_decree);
+
+        ASSERT_TRUE(get(app.get(), make_key(1), value));
+        ASSERT_EQ("1.appended", value);
+        ASSERT_TRUE(get(app.get(), make_key(2), value));
+        ASSERT_EQ("2", value);
+        ASSERT_TRUE(get(app.get(), make_key(3), value));
+        ASSERT_EQ("3", value);
+    }
+
+    ASSERT_EQ(dsn::ERR_OK, app->stop(true));
+    dsn::utils::filesystem::remove_path(dir);
+}
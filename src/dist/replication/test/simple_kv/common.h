@@ -47,6 +47,10 @@ extern gpid g_default_gpid;
 extern bool g_done;
 extern bool g_fail;
 
+// register the sharded storage engine of apps/skv as "simple_kv_sharded", for the cases
+// which set app_type to it
+void register_sharded_engine();
+
 const char *partition_status_to_short_string(partition_status::type s);
 partition_status::type partition_status_from_short_string(const std::string &str);
 
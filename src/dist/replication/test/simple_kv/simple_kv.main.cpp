@@ -42,6 +42,7 @@
 void dsn_app_registration_simple_kv()
 {
     dsn::replication::test::simple_kv_service_impl::register_service();
+    dsn::replication::test::register_sharded_engine();
 
     dsn_meta_server_bridge(0, nullptr);
     dsn_layer2_stateful_type1_bridge(0, nullptr);
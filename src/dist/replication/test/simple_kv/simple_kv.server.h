@@ -52,6 +52,26 @@ public:
     virtual ~simple_kv_service() {}
 
     virtual int on_request(dsn_message_t request) override { return handle_request(request); }
+    virtual int on_batched_write_updates(int64_t decree,
+                                         int64_t timestamp,
+                                         const mutation_update *updates,
+                                         int update_count) override
+    {
+        int storage_error = 0;
+        for (int i = 0; i < update_count; i++) {
+            int e = handle_update(updates[i].code,
+                                  (dsn_msg_serialize_format)updates[i].serialization_type,
+                                  updates[i].data);
+            if (e != 0) {
+                derror("%s: got storage error when handle update(%s)",
+                       replica_name(),
+                       updates[i].code.to_string());
+                storage_error = e;
+            }
+        }
+        return storage_error;
+    }
+
 protected:
     // all service handlers to be implemented further
     // RPC_SIMPLE_KV_SIMPLE_KV_READ
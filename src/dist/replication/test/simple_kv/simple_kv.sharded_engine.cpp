@@ -0,0 +1,61 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Microsoft Corporation
+ *
+ * -=- Robust Distributed System Nucleus (rDSN) -=-
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Description:
+ *     Replication testing framework, running the cases on the sharded engine of apps/skv.
+ *
+ * Revision history:
+ *     xxxx-xx-xx, author, first version
+ *     xxxx-xx-xx, author, fix bug about xxx
+ */
+
+// the engine comes with its own simple_kv types, whose include guards are the same as the ones
+// of this test, so it must not be included together with the other headers here
+#include <apps/skv/simple_kv.server.sharded_impl.h>
+#include "common.h"
+
+namespace dsn {
+namespace replication {
+namespace test {
+
+namespace {
+// the rpc handlers are registered by simple_kv_service_impl of apps/skv, which can not be
+// registered here as its engine name "simple_kv" is taken by the test engine
+struct sharded_engine_registry : public application::simple_kv_sharded_service_impl
+{
+    static void register_service()
+    {
+        simple_kv_service::register_rpc_handlers();
+        simple_kv_sharded_service_impl::register_service();
+    }
+};
+}
+
+void register_sharded_engine() { sharded_engine_registry::register_service(); }
+}
+}
+}
@@ -31,6 +31,46 @@ struct configuration_query_by_index_response
     5:list<partition_configuration> partitions;    
 }
 
+// long-poll subscription to the configuration changes of an app, see
+// server_state::subscribe_configuration
+struct configuration_subscribe_request
+{
+    1:string           app_name;
+    2:i64              epoch;         // 0 if not known yet
+    3:i64              known_version; // the version the client has already applied
+    4:i32              hold_ms;       // how long the meta server may park the request
+}
+
+struct configuration_subscribe_response
+{
+    1:dsn.error_code                err;
+    2:i32                           app_id;
+    3:i32                           partition_count;
+    4:bool                          is_stateful;
+    5:i64                           epoch;
+    6:i64                           version;
+    7:list<partition_configuration> partitions; // changed since known_version
+}
+
+// compact whole-table routing snapshot, see dsn::dist::partition_routing_table
+struct configuration_query_routing_request
+{
+    1:string           app_name;
+    2:i64              epoch;         // 0 if not known yet
+    3:i64              known_version; // the version of the client's cached table
+}
+
+struct configuration_query_routing_response
+{
+    1:dsn.error_code                err;
+    2:i32                           app_id;
+    3:i32                           partition_count;
+    4:bool                          is_stateful;
+    5:i64                           epoch;
+    6:i64                           version;
+    7:dsn.blob                      routes; // empty if the client is up to date
+}
+
 enum app_status
 {
     AS_INVALID,
@@ -665,6 +665,780 @@ void configuration_query_by_index_response::printTo(std::ostream& out) const {
 }
 
 
+configuration_subscribe_request::~configuration_subscribe_request() throw() {
+}
+
+
+void configuration_subscribe_request::__set_app_name(const std::string& val) {
+  this->app_name = val;
+}
+
+void configuration_subscribe_request::__set_epoch(const int64_t val) {
+  this->epoch = val;
+}
+
+void configuration_subscribe_request::__set_known_version(const int64_t val) {
+  this->known_version = val;
+}
+
+void configuration_subscribe_request::__set_hold_ms(const int32_t val) {
+  this->hold_ms = val;
+}
+
+uint32_t configuration_subscribe_request::read(::apache::thrift::protocol::TProtocol* iprot) {
+
+  apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_STRING) {
+          xfer += iprot->readString(this->app_name);
+          this->__isset.app_name = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 2:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->epoch);
+          this->__isset.epoch = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 3:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->known_version);
+          this->__isset.known_version = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 4:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->hold_ms);
+          this->__isset.hold_ms = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+uint32_t configuration_subscribe_request::write(::apache::thrift::protocol::TProtocol* oprot) const {
+  uint32_t xfer = 0;
+  apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("configuration_subscribe_request");
+
+  xfer += oprot->writeFieldBegin("app_name", ::apache::thrift::protocol::T_STRING, 1);
+  xfer += oprot->writeString(this->app_name);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("epoch", ::apache::thrift::protocol::T_I64, 2);
+  xfer += oprot->writeI64(this->epoch);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("known_version", ::apache::thrift::protocol::T_I64, 3);
+  xfer += oprot->writeI64(this->known_version);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("hold_ms", ::apache::thrift::protocol::T_I32, 4);
+  xfer += oprot->writeI32(this->hold_ms);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+void swap(configuration_subscribe_request &a, configuration_subscribe_request &b) {
+  using ::std::swap;
+  swap(a.app_name, b.app_name);
+  swap(a.epoch, b.epoch);
+  swap(a.known_version, b.known_version);
+  swap(a.hold_ms, b.hold_ms);
+  swap(a.__isset, b.__isset);
+}
+
+configuration_subscribe_request::configuration_subscribe_request(const configuration_subscribe_request& other49) {
+  app_name = other49.app_name;
+  epoch = other49.epoch;
+  known_version = other49.known_version;
+  hold_ms = other49.hold_ms;
+  __isset = other49.__isset;
+}
+configuration_subscribe_request::configuration_subscribe_request( configuration_subscribe_request&& other50) {
+  app_name = std::move(other50.app_name);
+  epoch = std::move(other50.epoch);
+  known_version = std::move(other50.known_version);
+  hold_ms = std::move(other50.hold_ms);
+  __isset = std::move(other50.__isset);
+}
+configuration_subscribe_request& configuration_subscribe_request::operator=(const configuration_subscribe_request& other51) {
+  app_name = other51.app_name;
+  epoch = other51.epoch;
+  known_version = other51.known_version;
+  hold_ms = other51.hold_ms;
+  __isset = other51.__isset;
+  return *this;
+}
+configuration_subscribe_request& configuration_subscribe_request::operator=(configuration_subscribe_request&& other52) {
+  app_name = std::move(other52.app_name);
+  epoch = std::move(other52.epoch);
+  known_version = std::move(other52.known_version);
+  hold_ms = std::move(other52.hold_ms);
+  __isset = std::move(other52.__isset);
+  return *this;
+}
+void configuration_subscribe_request::printTo(std::ostream& out) const {
+  using ::apache::thrift::to_string;
+  out << "configuration_subscribe_request(";
+  out << "app_name=" << to_string(app_name);
+  out << ", " << "epoch=" << to_string(epoch);
+  out << ", " << "known_version=" << to_string(known_version);
+  out << ", " << "hold_ms=" << to_string(hold_ms);
+  out << ")";
+}
+
+
+configuration_subscribe_response::~configuration_subscribe_response() throw() {
+}
+
+
+void configuration_subscribe_response::__set_err(const  ::dsn::error_code& val) {
+  this->err = val;
+}
+
+void configuration_subscribe_response::__set_app_id(const int32_t val) {
+  this->app_id = val;
+}
+
+void configuration_subscribe_response::__set_partition_count(const int32_t val) {
+  this->partition_count = val;
+}
+
+void configuration_subscribe_response::__set_is_stateful(const bool val) {
+  this->is_stateful = val;
+}
+
+void configuration_subscribe_response::__set_epoch(const int64_t val) {
+  this->epoch = val;
+}
+
+void configuration_subscribe_response::__set_version(const int64_t val) {
+  this->version = val;
+}
+
+void configuration_subscribe_response::__set_partitions(const std::vector<partition_configuration> & val) {
+  this->partitions = val;
+}
+
+uint32_t configuration_subscribe_response::read(::apache::thrift::protocol::TProtocol* iprot) {
+
+  apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_STRUCT) {
+          xfer += this->err.read(iprot);
+          this->__isset.err = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 2:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->app_id);
+          this->__isset.app_id = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 3:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->partition_count);
+          this->__isset.partition_count = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 4:
+        if (ftype == ::apache::thrift::protocol::T_BOOL) {
+          xfer += iprot->readBool(this->is_stateful);
+          this->__isset.is_stateful = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 5:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->epoch);
+          this->__isset.epoch = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 6:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->version);
+          this->__isset.version = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 7:
+        if (ftype == ::apache::thrift::protocol::T_LIST) {
+          {
+            this->partitions.clear();
+            uint32_t _size53;
+            ::apache::thrift::protocol::TType _etype56;
+            xfer += iprot->readListBegin(_etype56, _size53);
+            this->partitions.resize(_size53);
+            uint32_t _i57;
+            for (_i57 = 0; _i57 < _size53; ++_i57)
+            {
+              xfer += this->partitions[_i57].read(iprot);
+            }
+            xfer += iprot->readListEnd();
+          }
+          this->__isset.partitions = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+uint32_t configuration_subscribe_response::write(::apache::thrift::protocol::TProtocol* oprot) const {
+  uint32_t xfer = 0;
+  apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("configuration_subscribe_response");
+
+  xfer += oprot->writeFieldBegin("err", ::apache::thrift::protocol::T_STRUCT, 1);
+  xfer += this->err.write(oprot);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("app_id", ::apache::thrift::protocol::T_I32, 2);
+  xfer += oprot->writeI32(this->app_id);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("partition_count", ::apache::thrift::protocol::T_I32, 3);
+  xfer += oprot->writeI32(this->partition_count);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("is_stateful", ::apache::thrift::protocol::T_BOOL, 4);
+  xfer += oprot->writeBool(this->is_stateful);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("epoch", ::apache::thrift::protocol::T_I64, 5);
+  xfer += oprot->writeI64(this->epoch);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("version", ::apache::thrift::protocol::T_I64, 6);
+  xfer += oprot->writeI64(this->version);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("partitions", ::apache::thrift::protocol::T_LIST, 7);
+  {
+    xfer += oprot->writeListBegin(::apache::thrift::protocol::T_STRUCT, static_cast<uint32_t>(this->partitions.size()));
+    std::vector<partition_configuration> ::const_iterator _iter58;
+    for (_iter58 = this->partitions.begin(); _iter58 != this->partitions.end(); ++_iter58)
+    {
+      xfer += (*_iter58).write(oprot);
+    }
+    xfer += oprot->writeListEnd();
+  }
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+void swap(configuration_subscribe_response &a, configuration_subscribe_response &b) {
+  using ::std::swap;
+  swap(a.err, b.err);
+  swap(a.app_id, b.app_id);
+  swap(a.partition_count, b.partition_count);
+  swap(a.is_stateful, b.is_stateful);
+  swap(a.epoch, b.epoch);
+  swap(a.version, b.version);
+  swap(a.partitions, b.partitions);
+  swap(a.__isset, b.__isset);
+}
+
+configuration_subscribe_response::configuration_subscribe_response(const configuration_subscribe_response& other59) {
+  err = other59.err;
+  app_id = other59.app_id;
+  partition_count = other59.partition_count;
+  is_stateful = other59.is_stateful;
+  epoch = other59.epoch;
+  version = other59.version;
+  partitions = other59.partitions;
+  __isset = other59.__isset;
+}
+configuration_subscribe_response::configuration_subscribe_response( configuration_subscribe_response&& other60) {
+  err = std::move(other60.err);
+  app_id = std::move(other60.app_id);
+  partition_count = std::move(other60.partition_count);
+  is_stateful = std::move(other60.is_stateful);
+  epoch = std::move(other60.epoch);
+  version = std::move(other60.version);
+  partitions = std::move(other60.partitions);
+  __isset = std::move(other60.__isset);
+}
+configuration_subscribe_response& configuration_subscribe_response::operator=(const configuration_subscribe_response& other61) {
+  err = other61.err;
+  app_id = other61.app_id;
+  partition_count = other61.partition_count;
+  is_stateful = other61.is_stateful;
+  epoch = other61.epoch;
+  version = other61.version;
+  partitions = other61.partitions;
+  __isset = other61.__isset;
+  return *this;
+}
+configuration_subscribe_response& configuration_subscribe_response::operator=(configuration_subscribe_response&& other62) {
+  err = std::move(other62.err);
+  app_id = std::move(other62.app_id);
+  partition_count = std::move(other62.partition_count);
+  is_stateful = std::move(other62.is_stateful);
+  epoch = std::move(other62.epoch);
+  version = std::move(other62.version);
+  partitions = std::move(other62.partitions);
+  __isset = std::move(other62.__isset);
+  return *this;
+}
+void configuration_subscribe_response::printTo(std::ostream& out) const {
+  using ::apache::thrift::to_string;
+  out << "configuration_subscribe_response(";
+  out << "err=" << to_string(err);
+  out << ", " << "app_id=" << to_string(app_id);
+  out << ", " << "partition_count=" << to_string(partition_count);
+  out << ", " << "is_stateful=" << to_string(is_stateful);
+  out << ", " << "epoch=" << to_string(epoch);
+  out << ", " << "version=" << to_string(version);
+  out << ", " << "partitions=" << to_string(partitions);
+  out << ")";
+}
+
+
+configuration_query_routing_request::~configuration_query_routing_request() throw() {
+}
+
+
+void configuration_query_routing_request::__set_app_name(const std::string& val) {
+  this->app_name = val;
+}
+
+void configuration_query_routing_request::__set_epoch(const int64_t val) {
+  this->epoch = val;
+}
+
+void configuration_query_routing_request::__set_known_version(const int64_t val) {
+  this->known_version = val;
+}
+
+uint32_t configuration_query_routing_request::read(::apache::thrift::protocol::TProtocol* iprot) {
+
+  apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_STRING) {
+          xfer += iprot->readString(this->app_name);
+          this->__isset.app_name = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 2:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->epoch);
+          this->__isset.epoch = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 3:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->known_version);
+          this->__isset.known_version = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+uint32_t configuration_query_routing_request::write(::apache::thrift::protocol::TProtocol* oprot) const {
+  uint32_t xfer = 0;
+  apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("configuration_query_routing_request");
+
+  xfer += oprot->writeFieldBegin("app_name", ::apache::thrift::protocol::T_STRING, 1);
+  xfer += oprot->writeString(this->app_name);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("epoch", ::apache::thrift::protocol::T_I64, 2);
+  xfer += oprot->writeI64(this->epoch);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("known_version", ::apache::thrift::protocol::T_I64, 3);
+  xfer += oprot->writeI64(this->known_version);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+void swap(configuration_query_routing_request &a, configuration_query_routing_request &b) {
+  using ::std::swap;
+  swap(a.app_name, b.app_name);
+  swap(a.epoch, b.epoch);
+  swap(a.known_version, b.known_version);
+  swap(a.__isset, b.__isset);
+}
+
+configuration_query_routing_request::configuration_query_routing_request(const configuration_query_routing_request& other63) {
+  app_name = other63.app_name;
+  epoch = other63.epoch;
+  known_version = other63.known_version;
+  __isset = other63.__isset;
+}
+configuration_query_routing_request::configuration_query_routing_request( configuration_query_routing_request&& other64) {
+  app_name = std::move(other64.app_name);
+  epoch = std::move(other64.epoch);
+  known_version = std::move(other64.known_version);
+  __isset = std::move(other64.__isset);
+}
+configuration_query_routing_request& configuration_query_routing_request::operator=(const configuration_query_routing_request& other65) {
+  app_name = other65.app_name;
+  epoch = other65.epoch;
+  known_version = other65.known_version;
+  __isset = other65.__isset;
+  return *this;
+}
+configuration_query_routing_request& configuration_query_routing_request::operator=(configuration_query_routing_request&& other66) {
+  app_name = std::move(other66.app_name);
+  epoch = std::move(other66.epoch);
+  known_version = std::move(other66.known_version);
+  __isset = std::move(other66.__isset);
+  return *this;
+}
+void configuration_query_routing_request::printTo(std::ostream& out) const {
+  using ::apache::thrift::to_string;
+  out << "configuration_query_routing_request(";
+  out << "app_name=" << to_string(app_name);
+  out << ", " << "epoch=" << to_string(epoch);
+  out << ", " << "known_version=" << to_string(known_version);
+  out << ")";
+}
+
+
+configuration_query_routing_response::~configuration_query_routing_response() throw() {
+}
+
+
+void configuration_query_routing_response::__set_err(const  ::dsn::error_code& val) {
+  this->err = val;
+}
+
+void configuration_query_routing_response::__set_app_id(const int32_t val) {
+  this->app_id = val;
+}
+
+void configuration_query_routing_response::__set_partition_count(const int32_t val) {
+  this->partition_count = val;
+}
+
+void configuration_query_routing_response::__set_is_stateful(const bool val) {
+  this->is_stateful = val;
+}
+
+void configuration_query_routing_response::__set_epoch(const int64_t val) {
+  this->epoch = val;
+}
+
+void configuration_query_routing_response::__set_version(const int64_t val) {
+  this->version = val;
+}
+
+void configuration_query_routing_response::__set_routes(const  ::dsn::blob& val) {
+  this->routes = val;
+}
+
+uint32_t configuration_query_routing_response::read(::apache::thrift::protocol::TProtocol* iprot) {
+
+  apache::thrift::protocol::TInputRecursionTracker tracker(*iprot);
+  uint32_t xfer = 0;
+  std::string fname;
+  ::apache::thrift::protocol::TType ftype;
+  int16_t fid;
+
+  xfer += iprot->readStructBegin(fname);
+
+  using ::apache::thrift::protocol::TProtocolException;
+
+
+  while (true)
+  {
+    xfer += iprot->readFieldBegin(fname, ftype, fid);
+    if (ftype == ::apache::thrift::protocol::T_STOP) {
+      break;
+    }
+    switch (fid)
+    {
+      case 1:
+        if (ftype == ::apache::thrift::protocol::T_STRUCT) {
+          xfer += this->err.read(iprot);
+          this->__isset.err = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 2:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->app_id);
+          this->__isset.app_id = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 3:
+        if (ftype == ::apache::thrift::protocol::T_I32) {
+          xfer += iprot->readI32(this->partition_count);
+          this->__isset.partition_count = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 4:
+        if (ftype == ::apache::thrift::protocol::T_BOOL) {
+          xfer += iprot->readBool(this->is_stateful);
+          this->__isset.is_stateful = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 5:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->epoch);
+          this->__isset.epoch = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 6:
+        if (ftype == ::apache::thrift::protocol::T_I64) {
+          xfer += iprot->readI64(this->version);
+          this->__isset.version = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      case 7:
+        if (ftype == ::apache::thrift::protocol::T_STRUCT) {
+          xfer += this->routes.read(iprot);
+          this->__isset.routes = true;
+        } else {
+          xfer += iprot->skip(ftype);
+        }
+        break;
+      default:
+        xfer += iprot->skip(ftype);
+        break;
+    }
+    xfer += iprot->readFieldEnd();
+  }
+
+  xfer += iprot->readStructEnd();
+
+  return xfer;
+}
+
+uint32_t configuration_query_routing_response::write(::apache::thrift::protocol::TProtocol* oprot) const {
+  uint32_t xfer = 0;
+  apache::thrift::protocol::TOutputRecursionTracker tracker(*oprot);
+  xfer += oprot->writeStructBegin("configuration_query_routing_response");
+
+  xfer += oprot->writeFieldBegin("err", ::apache::thrift::protocol::T_STRUCT, 1);
+  xfer += this->err.write(oprot);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("app_id", ::apache::thrift::protocol::T_I32, 2);
+  xfer += oprot->writeI32(this->app_id);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("partition_count", ::apache::thrift::protocol::T_I32, 3);
+  xfer += oprot->writeI32(this->partition_count);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("is_stateful", ::apache::thrift::protocol::T_BOOL, 4);
+  xfer += oprot->writeBool(this->is_stateful);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("epoch", ::apache::thrift::protocol::T_I64, 5);
+  xfer += oprot->writeI64(this->epoch);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("version", ::apache::thrift::protocol::T_I64, 6);
+  xfer += oprot->writeI64(this->version);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldBegin("routes", ::apache::thrift::protocol::T_STRUCT, 7);
+  xfer += this->routes.write(oprot);
+  xfer += oprot->writeFieldEnd();
+
+  xfer += oprot->writeFieldStop();
+  xfer += oprot->writeStructEnd();
+  return xfer;
+}
+
+void swap(configuration_query_routing_response &a, configuration_query_routing_response &b) {
+  using ::std::swap;
+  swap(a.err, b.err);
+  swap(a.app_id, b.app_id);
+  swap(a.partition_count, b.partition_count);
+  swap(a.is_stateful, b.is_stateful);
+  swap(a.epoch, b.epoch);
+  swap(a.version, b.version);
+  swap(a.routes, b.routes);
+  swap(a.__isset, b.__isset);
+}
+
+configuration_query_routing_response::configuration_query_routing_response(const configuration_query_routing_response& other67) {
+  err = other67.err;
+  app_id = other67.app_id;
+  partition_count = other67.partition_count;
+  is_stateful = other67.is_stateful;
+  epoch = other67.epoch;
+  version = other67.version;
+  routes = other67.routes;
+  __isset = other67.__isset;
+}
+configuration_query_routing_response::configuration_query_routing_response( configuration_query_routing_response&& other68) {
+  err = std::move(other68.err);
+  app_id = std::move(other68.app_id);
+  partition_count = std::move(other68.partition_count);
+  is_stateful = std::move(other68.is_stateful);
+  epoch = std::move(other68.epoch);
+  version = std::move(other68.version);
+  routes = std::move(other68.routes);
+  __isset = std::move(other68.__isset);
+}
+configuration_query_routing_response& configuration_query_routing_response::operator=(const configuration_query_routing_response& other69) {
+  err = other69.err;
+  app_id = other69.app_id;
+  partition_count = other69.partition_count;
+  is_stateful = other69.is_stateful;
+  epoch = other69.epoch;
+  version = other69.version;
+  routes = other69.routes;
+  __isset = other69.__isset;
+  return *this;
+}
+configuration_query_routing_response& configuration_query_routing_response::operator=(configuration_query_routing_response&& other70) {
+  err = std::move(other70.err);
+  app_id = std::move(other70.app_id);
+  partition_count = std::move(other70.partition_count);
+  is_stateful = std::move(other70.is_stateful);
+  epoch = std::move(other70.epoch);
+  version = std::move(other70.version);
+  routes = std::move(other70.routes);
+  __isset = std::move(other70.__isset);
+  return *this;
+}
+void configuration_query_routing_response::printTo(std::ostream& out) const {
+  using ::apache::thrift::to_string;
+  out << "configuration_query_routing_response(";
+  out << "err=" << to_string(err);
+  out << ", " << "app_id=" << to_string(app_id);
+  out << ", " << "partition_count=" << to_string(partition_count);
+  out << ", " << "is_stateful=" << to_string(is_stateful);
+  out << ", " << "epoch=" << to_string(epoch);
+  out << ", " << "version=" << to_string(version);
+  out << ", " << "routes=" << to_string(routes);
+  out << ")";
+}
+
+
 app_info::~app_info() throw() {
 }
 
@@ -4,6 +4,7 @@
 
 #include <gtest/gtest.h>
 #include <dsn/service_api_cpp.h>
+#include <dsn/tool/node_scoper.h>
 #include <vector>
 
 using namespace dsn;
@@ -571,13 +572,14 @@ TEST(fd, update_stability)
     opts.max_succssive_unstable_restart = 2;
     fd->set_options(&opts);
 
-    replication::meta_server_failure_detector::stability_map *smap =
-        fd->get_stability_map_for_test();
-    smap->clear();
-
     dsn::rpc_replier<beacon_ack> r(create_fake_rpc_response());
     beacon_msg msg;
     msg.from_addr = rpc_address("localhost", 123);
+
+    replication::meta_server_failure_detector::stability_map *smap =
+        fd->get_stability_map_for_test(msg.from_addr);
+    smap->clear();
+
     msg.to_addr = rpc_address("localhost", MPORT_START);
     msg.time = dsn_now_ms();
     msg.__isset.start_time = true;
@@ -661,3 +663,134 @@ TEST(fd, update_stability)
     ASSERT_EQ(msg.start_time, ws.last_start_time_ms);
     ASSERT_EQ(0, ws.unstable_restart_count);
 }
+
+TEST(fd, inline_ping)
+{
+    test_worker *worker;
+    std::vector<test_master *> masters;
+    ASSERT_TRUE(get_worker_and_master(worker, masters));
+    clear(worker, masters);
+
+    master_group_set_leader(masters, 0);
+    master_fd_test *fd = masters[0]->fd();
+
+    replication::fd_suboptions opts;
+    opts.stable_rs_min_running_seconds = 5;
+    opts.max_succssive_unstable_restart = 2;
+    fd->set_options(&opts);
+
+    std::atomic_int connected_count(0);
+    std::atomic_bool connected_on_worker(false);
+    fd->when_connected([&](rpc_address) {
+        connected_on_worker = (task::get_current_worker() != nullptr);
+        ++connected_count;
+    });
+
+    beacon_msg msg;
+    msg.from_addr = rpc_address("localhost", 30000);
+    msg.to_addr = rpc_address("localhost", MPORT_START);
+    msg.__isset.start_time = true;
+    msg.start_time = 1000;
+
+    // run on_ping as a network thread does for inline requests, which is not a task worker
+    service_node *node = task::get_current_node2();
+    auto inline_ping = [&]() {
+        std::thread t([&]() {
+            tools::node_scoper ns(node);
+            ASSERT_TRUE(task::get_current_worker() == nullptr);
+            msg.time = dsn_now_ms();
+            dsn::rpc_replier<beacon_ack> r(create_fake_rpc_response());
+            fd->on_ping(msg, r);
+            ASSERT_TRUE(r.is_empty());
+        });
+        t.join();
+    };
+
+    // a new worker takes the locked slow path and connects, so it is deferred to the fd pool
+    inline_ping();
+    ASSERT_TRUE(spin_wait_condition([&]() { return connected_count.load() == 1; }, 5));
+    ASSERT_TRUE(connected_on_worker.load());
+    ASSERT_TRUE(fd->get_stability_map_for_test(msg.from_addr)->count(msg.from_addr) == 1);
+
+    // an alive and stable worker only renews its lease inline
+    for (int i = 0; i < 10; i++) {
+        inline_ping();
+    }
+    ASSERT_EQ(1, connected_count.load());
+
+    // a restarted worker updates the stability stat, which is deferred again
+    msg.start_time += 10000;
+    inline_ping();
+    ASSERT_TRUE(spin_wait_condition(
+        [&]() {
+            auto smap = fd->get_stability_map_for_test(msg.from_addr);
+            auto it = smap->find(msg.from_addr);
+            return it != smap->end() && it->second.last_start_time_ms == msg.start_time;
+        },
+        5));
+
+    fd->clear();
+    fd->clear_workers();
+}
+
+TEST(fd, many_workers_lease)
+{
+    test_worker *worker;
+    std::vector<test_master *> masters;
+    ASSERT_TRUE(get_worker_and_master(worker, masters));
+    clear(worker, masters);
+
+    master_group_set_leader(masters, 0);
+    master_fd_test *fd = masters[0]->fd();
+
+    // restart with the shortest grace period to keep the test short, which is restored at last
+    fd->stop();
+    fd->start(1, 1, 1, 2);
+
+    // workers [0, count/2) keep sending beacons, while the others go silent
+    const int count = 1000;
+    const uint16_t first_port = 20000;
+    std::atomic_int expired_count(0);
+    std::atomic_int wrong_count(0);
+    fd->when_connected(nullptr);
+    fd->when_disconnected([&](const std::vector<rpc_address> &nodes) {
+        for (const rpc_address &node : nodes) {
+            if (node.port() - first_port < count / 2)
+                ++wrong_count;
+            else
+                ++expired_count;
+        }
+    });
+
+    auto ping = [&](int index) {
+        beacon_msg msg;
+        msg.from_addr = rpc_address("localhost", first_port + index);
+        msg.to_addr = rpc_address("localhost", MPORT_START);
+        msg.time = dsn_now_ms();
+        dsn::rpc_replier<beacon_ack> r(create_fake_rpc_response());
+        fd->on_ping(msg, r);
+    };
+
+    for (int i = 0; i < count; i++) {
+        ping(i);
+    }
+
+    // grace period is 2 seconds and records are checked every second
+    for (int round = 0; round < 8; round++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        for (int i = 0; i < count / 2; i++) {
+            ping(i);
+        }
+    }
+
+    ASSERT_EQ(count / 2, expired_count.load());
+    ASSERT_EQ(0, wrong_count.load());
+    for (int i = 0; i < count; i++) {
+        ASSERT_EQ(i < count / 2, fd->is_worker_connected(rpc_address("localhost", first_port + i)));
+    }
+
+    fd->clear();
+    fd->clear_workers();
+    fd->stop();
+    fd->start(1, 1, 4, 5);
+}
@@ -33,9 +33,14 @@
  *     xxxx-xx-xx, author, fix bug about xxx
  */
 #include "dist/replication/lib/mutation_log.h"
+#include "dist/replication/lib/replica_stub.h"
+#include <dsn/utility/crc.h>
 #include <dsn/utility/filesystem.h>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cstdio>
+#include <set>
+#include <vector>
 
 using namespace ::dsn;
 using namespace ::dsn::replication;
@@ -225,47 +230,73 @@ TEST(replication, log_file)
     ASSERT_TRUE(dsn::utils::filesystem::file_exists("log.1.4.removed"));
     ASSERT_TRUE(dsn::utils::filesystem::rename_path("log.1.4.removed", "log.1.4"));
 
-    // read the file for test
-    offset = 100;
-    lf = log_file::open_read(fpath.c_str(), err);
-    ASSERT_NE(nullptr, lf);
-    EXPECT_EQ(ERR_OK, err);
-    ASSERT_EQ(1, lf->index());
-    ASSERT_EQ(100, lf->start_offset());
-    int64_t sz;
-    ASSERT_TRUE(dsn::utils::filesystem::file_size(fpath, sz));
-    ASSERT_EQ(lf->start_offset() + sz, lf->end_offset());
-
-    // read data
-    lf->reset_stream();
-    for (int i = 0; i < 100; i++) {
-        blob bb;
-        auto err = lf->read_next_log_block(bb);
-        ASSERT_EQ(ERR_OK, err);
+    // read the file for test, through mmap and through the aio file streamer
+    std::string removed_fpath = fpath + ".copy";
+    for (bool mmap_read : {true, false}) {
+        offset = 100;
+        lf = log_file::open_read(fpath.c_str(), err);
+        ASSERT_NE(nullptr, lf);
+        EXPECT_EQ(ERR_OK, err);
+        ASSERT_EQ(1, lf->index());
+        ASSERT_EQ(100, lf->start_offset());
+        int64_t sz;
+        ASSERT_TRUE(dsn::utils::filesystem::file_size(fpath, sz));
+        ASSERT_EQ(lf->start_offset() + sz, lf->end_offset());
+
+        // read data
+        lf->set_mmap_read_enabled(mmap_read);
+        lf->reset_stream();
+#ifndef _WIN32
+        ASSERT_EQ(mmap_read, lf->is_mapped());
+#endif
+        std::vector<blob> blocks;
+        for (int i = 0; i < 100; i++) {
+            blob bb;
+            auto err = lf->read_next_log_block(bb);
+            ASSERT_EQ(ERR_OK, err);
+
+            binary_reader reader(bb);
+
+            if (i == 0) {
+                lf->read_file_header(reader);
+                ASSERT_TRUE(lf->is_right_header());
+                ASSERT_EQ(100, lf->header().start_global_offset);
+            }
+
+            std::string ss;
+            reader.read(ss);
+            ASSERT_TRUE(ss == str);
+
+            offset += bb.length() + sizeof(log_block_header);
+            blocks.push_back(bb);
+        }
 
-        binary_reader reader(bb);
+        ASSERT_TRUE(offset == lf->end_offset());
 
-        if (i == 0) {
-            lf->read_file_header(reader);
-            ASSERT_TRUE(lf->is_right_header());
-            ASSERT_EQ(100, lf->header().start_global_offset);
+        blob bb;
+        err = lf->read_next_log_block(bb);
+        ASSERT_TRUE(err == ERR_HANDLE_EOF);
+
+        if (lf->is_mapped()) {
+            // blocks are copied out of the mapping rather than aliasing it
+            for (int i = 1; i < 100; i++) {
+                ASSERT_NE(blocks[i - 1].buffer_ptr(), blocks[i].buffer_ptr());
+            }
         }
 
-        std::string ss;
-        reader.read(ss);
-        ASSERT_TRUE(ss == str);
-
-        offset += bb.length() + sizeof(log_block_header);
+        // blocks stay valid after the file is closed and removed
+        lf = nullptr;
+        copy_file(fpath.c_str(), removed_fpath.c_str());
+        utils::filesystem::remove_path(fpath);
+        for (int i = 1; i < 100; i++) {
+            binary_reader reader(blocks[i]);
+            std::string ss;
+            reader.read(ss);
+            ASSERT_EQ(str, ss);
+        }
+        ASSERT_TRUE(utils::filesystem::rename_path(removed_fpath, fpath));
     }
 
-    ASSERT_TRUE(offset == lf->end_offset());
-
-    blob bb;
-    err = lf->read_next_log_block(bb);
-    ASSERT_TRUE(err == ERR_HANDLE_EOF);
-
-    lf = nullptr;
-
     utils::filesystem::remove_path(fpath);
 }
 
@@ -341,3 +372,396 @@ TEST(replication, mutation_log)
     // clear all
     utils::filesystem::remove_path(logp);
 }
+
+// returns the start offsets of the blocks in the log file
+static std::vector<int64_t> get_block_offsets(const std::string &fpath)
+{
+    std::vector<int64_t> offsets;
+    int64_t size;
+    EXPECT_TRUE(dsn::utils::filesystem::file_size(fpath, size));
+    FILE *f = fopen(fpath.c_str(), "rb");
+    EXPECT_TRUE(f != nullptr);
+    int64_t offset = 0;
+    while (offset + (int64_t)sizeof(log_block_header) <= size) {
+        log_block_header hdr;
+        EXPECT_EQ(0, fseek(f, offset, SEEK_SET));
+        EXPECT_EQ(1, fread(&hdr, sizeof(hdr), 1, f));
+        offsets.push_back(offset);
+        offset += sizeof(hdr) + hdr.length;
+    }
+    fclose(f);
+    return offsets;
+}
+
+TEST(replication, mutation_log_salvage)
+{
+    std::string str = "hello, world!";
+    std::string logp = "./test-slog";
+    std::map<gpid, decree> max_decrees;
+
+    // prepare
+    utils::filesystem::remove_path(logp);
+    utils::filesystem::create_directory(logp);
+
+    // writing logs of 4 replicas into several log files
+    mutation_log_ptr mlog = new mutation_log_shared(logp, 1, false);
+    auto err = mlog->open(nullptr, nullptr);
+    EXPECT_EQ(err, ERR_OK);
+
+    for (int i = 0; i < 3000; i++) {
+        mutation_ptr mu(new mutation());
+        mu->data.header.ballot = 1;
+        mu->data.header.decree = 2 + i / 4;
+        mu->data.header.pid = gpid(1, i % 4);
+        mu->data.header.last_committed_decree = i / 4;
+        mu->data.header.log_offset = 0;
+
+        binary_writer writer;
+        for (int j = 0; j < 100; j++) {
+            writer.write(str);
+        }
+        mu->data.updates.push_back(mutation_update());
+        mu->data.updates.back().code = RPC_REPLICATION_WRITE_EMPTY;
+        mu->data.updates.back().data = writer.get_buffer();
+        mu->client_requests.push_back(nullptr);
+
+        max_decrees[mu->data.header.pid] = mu->data.header.decree;
+        mlog->append(mu, LPC_AIO_IMMEDIATE_CALLBACK, nullptr, nullptr, 0);
+        if (i % 50 == 49) {
+            mlog->flush();
+        }
+    }
+    mlog->close();
+
+    std::vector<std::string> files;
+    ASSERT_TRUE(utils::filesystem::get_subfiles(logp, files, false));
+    ASSERT_LE(2u, files.size());
+    // the log file name is "log.<index>.<start_offset>"
+    std::sort(files.begin(), files.end(), [](const std::string &l, const std::string &r) {
+        return atoi(l.substr(l.find("log.") + 4).c_str()) <
+               atoi(r.substr(r.find("log.") + 4).c_str());
+    });
+
+    // the log can be salvaged without loss if no block is corrupted
+    std::map<gpid, decree> lost_decrees;
+    ASSERT_TRUE(mutation_log::salvage(logp, lost_decrees));
+
+    // corrupt the body of the second block in the first log file
+    std::vector<int64_t> offsets = get_block_offsets(files.front());
+    ASSERT_LE(2u, offsets.size());
+    char bad_byte = 0x5a;
+    overwrite_file(files.front().c_str(),
+                   offsets[1] + sizeof(log_block_header) + 1,
+                   &bad_byte,
+                   sizeof(bad_byte));
+
+    mlog = new mutation_log_shared(logp, 1, false);
+    err = mlog->open([](int log_length, mutation_ptr &mu) { return true; }, nullptr);
+    ASSERT_NE(ERR_OK, err);
+    mlog = nullptr;
+
+    // the rest of the first log file is covered by the header of the next one
+    bool salvaged = mutation_log::salvage(logp, lost_decrees);
+    ASSERT_TRUE(salvaged);
+    for (auto &kv : max_decrees) {
+        ASSERT_EQ(kv.second, lost_decrees[kv.first]);
+    }
+
+    // a replica is kept only if its private log covers the lost decrees
+    gpid pid(1, 0);
+    decree lost = max_decrees[pid];
+    ASSERT_TRUE(replica_stub::can_keep_salvaged_replica(salvaged, lost_decrees, pid, 1, lost));
+    ASSERT_FALSE(
+        replica_stub::can_keep_salvaged_replica(salvaged, lost_decrees, pid, 1, lost - 1));
+    ASSERT_FALSE(
+        replica_stub::can_keep_salvaged_replica(salvaged, lost_decrees, pid, lost + 1, lost));
+    ASSERT_TRUE(replica_stub::can_keep_salvaged_replica(salvaged, lost_decrees, gpid(2, 0), 5, 5));
+
+    // the lost decrees are unknown if a block of the last log file fails in crc checking,
+    // as nothing after it can cover the mutations in it
+    offsets = get_block_offsets(files.back());
+    ASSERT_LE(1u, offsets.size());
+    overwrite_file(files.back().c_str(),
+                   offsets.back() + sizeof(log_block_header) + 1,
+                   &bad_byte,
+                   sizeof(bad_byte));
+    salvaged = mutation_log::salvage(logp, lost_decrees);
+    ASSERT_FALSE(salvaged);
+
+    // and then all the replicas are removed
+    ASSERT_FALSE(
+        replica_stub::can_keep_salvaged_replica(salvaged, lost_decrees, pid, 1, lost + 100));
+
+    // clear all
+    utils::filesystem::remove_path(logp);
+}
+
+TEST(replication, log_file_compressed)
+{
+    replica_log_info_map mdecrees;
+    gpid gpid(1, 0);
+
+    mdecrees[gpid] = replica_log_info(3, 0);
+    std::string fpath = "./log.2.100";
+    std::string str = "hello, world!";
+    int64_t offset = 100;
+    error_code err;
+
+    // write large compressible blocks and small ones, with compression toggled on and off
+    utils::filesystem::remove_path(fpath);
+    log_file_ptr lf = log_file::create_write(".", 2, offset);
+    ASSERT_TRUE(lf != nullptr);
+    for (int i = 0; i < 100; i++) {
+        lf->set_compress_min_bytes(i % 4 < 2 ? 1024 : 0);
+        auto writer = lf->prepare_log_block();
+
+        if (i == 0) {
+            binary_writer temp_writer;
+            lf->write_file_header(temp_writer, mdecrees);
+            writer->add(temp_writer.get_buffer());
+        }
+
+        binary_writer temp_writer;
+        int count = (i % 2 == 1) ? 300 : 1;
+        for (int j = 0; j < count; j++) {
+            temp_writer.write(str);
+        }
+        writer->add(temp_writer.get_buffer());
+
+        // the offsets in the global space are of the raw blocks
+        int64_t raw_size = writer->size();
+        task_ptr task =
+            lf->commit_log_block(*writer, offset, LPC_AIO_IMMEDIATE_CALLBACK, nullptr, nullptr, 0);
+        task->wait();
+        ASSERT_EQ(ERR_OK, task->error());
+        offset += raw_size;
+        ASSERT_EQ(offset, lf->end_offset());
+
+        delete writer;
+    }
+    lf->flush();
+    lf->close();
+    lf = nullptr;
+
+    // only the large blocks written with compression on are compressed
+    int64_t sz;
+    ASSERT_TRUE(dsn::utils::filesystem::file_size(fpath, sz));
+    ASSERT_LT(sz, offset - 100);
+    int lz_count = 0;
+    FILE *f = fopen(fpath.c_str(), "rb");
+    ASSERT_TRUE(f != nullptr);
+    for (int64_t block_offset : get_block_offsets(fpath)) {
+        log_block_header hdr;
+        ASSERT_EQ(0, fseek(f, block_offset, SEEK_SET));
+        ASSERT_EQ(1, fread(&hdr, sizeof(hdr), 1, f));
+        if ((uint32_t)hdr.magic == log_block_lz_magic) {
+            ++lz_count;
+        }
+    }
+    fclose(f);
+    ASSERT_EQ(25, lz_count);
+
+    // read back: the raw blocks are the same, and their sizes sum up to the raw end offset
+    lf = log_file::open_read(fpath.c_str(), err);
+    ASSERT_NE(nullptr, lf);
+    ASSERT_EQ(ERR_OK, err);
+    ASSERT_EQ(lf->start_offset() + sz, lf->end_offset());
+    int64_t read_offset = 100;
+    lf->reset_stream();
+    for (int i = 0; i < 100; i++) {
+        blob bb;
+        ASSERT_EQ(ERR_OK, lf->read_next_log_block(bb));
+        binary_reader reader(bb);
+        if (i == 0) {
+            lf->read_file_header(reader);
+            ASSERT_TRUE(lf->is_right_header());
+        }
+
+        int count = (i % 2 == 1) ? 300 : 1;
+        for (int j = 0; j < count; j++) {
+            std::string ss;
+            reader.read(ss);
+            ASSERT_EQ(str, ss);
+        }
+        ASSERT_TRUE(reader.is_eof());
+        read_offset += bb.length() + sizeof(log_block_header);
+    }
+    ASSERT_EQ(offset, read_offset);
+    blob bb;
+    ASSERT_EQ(ERR_HANDLE_EOF, lf->read_next_log_block(bb));
+    lf = nullptr;
+
+    // a compressed block claiming a huge raw size is rejected before the raw data is allocated,
+    // even with a right crc, which is chained on the crc of the previous block
+    std::vector<int64_t> block_offsets = get_block_offsets(fpath);
+    ASSERT_LE(2u, block_offsets.size());
+    log_block_header prev_hdr, hdr;
+    f = fopen(fpath.c_str(), "rb");
+    ASSERT_TRUE(f != nullptr);
+    ASSERT_EQ(0, fseek(f, block_offsets[0], SEEK_SET));
+    ASSERT_EQ(1, fread(&prev_hdr, sizeof(prev_hdr), 1, f));
+    ASSERT_EQ(0, fseek(f, block_offsets[1], SEEK_SET));
+    ASSERT_EQ(1, fread(&hdr, sizeof(hdr), 1, f));
+    std::string body(hdr.length, '\0');
+    ASSERT_EQ(1, fread(&body[0], body.size(), 1, f));
+    fclose(f);
+    ASSERT_EQ(log_block_lz_magic, (uint32_t)hdr.magic);
+
+    uint32_t huge_raw_length = 0xfffffff0;
+    memcpy(&body[0], &huge_raw_length, sizeof(huge_raw_length));
+    hdr.body_crc = dsn::utils::crc32_calc(body.data(), body.size(), prev_hdr.body_crc);
+    overwrite_file(fpath.c_str(), block_offsets[1], &hdr, sizeof(hdr));
+    overwrite_file(fpath.c_str(), block_offsets[1] + sizeof(hdr), body.data(), body.size());
+
+    lf = log_file::open_read(fpath.c_str(), err);
+    ASSERT_NE(nullptr, lf);
+    lf->reset_stream();
+    ASSERT_EQ(ERR_OK, lf->read_next_log_block(bb));
+    ASSERT_EQ(ERR_INVALID_DATA, lf->read_next_log_block(bb));
+    lf = nullptr;
+
+    utils::filesystem::remove_path(fpath);
+}
+
+static void append_mutations(mutation_log_ptr mlog, gpid pid, decree first, int count)
+{
+    std::string str = "hello, world!";
+    for (int i = 0; i < count; i++) {
+        mutation_ptr mu(new mutation());
+        mu->data.header.ballot = 1;
+        mu->data.header.decree = first + i;
+        mu->data.header.pid = pid;
+        mu->data.header.last_committed_decree = first + i - 2;
+        mu->data.header.log_offset = 0;
+
+        binary_writer writer;
+        for (int j = 0; j < 300; j++) {
+            writer.write(str);
+        }
+        mu->data.updates.push_back(mutation_update());
+        mu->data.updates.back().code = RPC_REPLICATION_WRITE_EMPTY;
+        mu->data.updates.back().data = writer.get_buffer();
+        mu->client_requests.push_back(nullptr);
+
+        mlog->append(mu, LPC_AIO_IMMEDIATE_CALLBACK, nullptr, nullptr, 0);
+    }
+    mlog->flush();
+}
+
+static std::set<decree> replay_mutation_log(const std::string &logp, gpid pid, error_code &err)
+{
+    std::set<decree> decrees;
+    mutation_log_ptr mlog = new mutation_log_private(logp, 1, pid, nullptr, 4096, 512, 10000);
+    err = mlog->open(
+        [&decrees](int log_length, mutation_ptr &mu) -> bool {
+            decrees.insert(mu->data.header.decree);
+            return true;
+        },
+        nullptr);
+    mlog->close();
+    return decrees;
+}
+
+// returns the sorted start offsets of the log files, which are named "log.<index>.<offset>"
+static std::vector<int64_t> get_file_start_offsets(const std::string &logp, int64_t &disk_size)
+{
+    std::vector<std::string> files;
+    EXPECT_TRUE(utils::filesystem::get_subfiles(logp, files, false));
+    std::vector<int64_t> offsets;
+    disk_size = 0;
+    for (auto &fpath : files) {
+        int index;
+        int64_t start_offset, sz;
+        std::string name = utils::filesystem::get_file_name(fpath);
+        if (sscanf(name.c_str(), "log.%d.%" PRId64, &index, &start_offset) == 2) {
+            offsets.push_back(start_offset);
+            EXPECT_TRUE(utils::filesystem::file_size(fpath, sz));
+            disk_size += sz;
+        }
+    }
+    std::sort(offsets.begin(), offsets.end());
+    return offsets;
+}
+
+TEST(replication, mutation_log_compressed)
+{
+    gpid pid(1, 0);
+    std::string logp = "./test-log-lz";
+    utils::filesystem::remove_path(logp);
+    utils::filesystem::create_directory(logp);
+
+    // ~3.6MB of raw mutations in 1MB files, with an uncompressed stretch in the middle
+    mutation_log_ptr mlog = new mutation_log_private(logp, 1, pid, nullptr, 4096, 512, 10000);
+    ASSERT_EQ(ERR_OK, mlog->open(nullptr, nullptr));
+    mlog->set_compress_min_bytes(1024);
+    append_mutations(mlog, pid, 2, 300);
+    mlog->set_compress_min_bytes(0);
+    append_mutations(mlog, pid, 302, 300);
+    mlog->set_compress_min_bytes(1024);
+    append_mutations(mlog, pid, 602, 300);
+
+    // the file size limit counts raw bytes, so the files are switched as if uncompressed
+    int64_t raw_size = mlog->size();
+    int64_t disk_size = 0;
+    std::vector<int64_t> offsets = get_file_start_offsets(logp, disk_size);
+    ASSERT_LE(3u, offsets.size());
+    ASSERT_LT(disk_size, raw_size);
+
+    // a learn segment over the compressed tail replays like a full file
+    decree start = 880;
+    learn_state state;
+    log_file_ptr source;
+    ASSERT_TRUE(mlog->get_learn_state(pid, start, state, &source));
+    ASSERT_TRUE(source != nullptr);
+    int64_t source_size = 0;
+    ASSERT_TRUE(utils::filesystem::file_size(source->path(), source_size));
+    ASSERT_LT(source_size, source->end_offset() - source->start_offset());
+
+    std::string segment = mlog->write_learn_segment(source, start, 1);
+    ASSERT_FALSE(segment.empty());
+    std::set<decree> decrees;
+    std::vector<std::string> segment_files = {segment};
+    int64_t segment_end_offset = 0;
+    error_code err = mutation_log::replay(segment_files,
+                                          [&decrees](int log_length, mutation_ptr &mu) -> bool {
+                                              decrees.insert(mu->data.header.decree);
+                                              return true;
+                                          },
+                                          segment_end_offset);
+    ASSERT_TRUE(err == ERR_OK || err == ERR_HANDLE_EOF) << err.to_string();
+    for (decree d = start; d <= 901; d++) {
+        ASSERT_TRUE(decrees.find(d) != decrees.end()) << d;
+    }
+    ASSERT_EQ(source->end_offset(), segment_end_offset);
+    mlog->close();
+    mlog = nullptr;
+    utils::filesystem::remove_path(utils::filesystem::path_combine(logp, "learn_segments"));
+
+    // reopen and replay: all the mutations are back, and the end offsets are corrected to the
+    // raw ones
+    decrees = replay_mutation_log(logp, pid, err);
+    ASSERT_EQ(ERR_OK, err);
+    ASSERT_EQ(900u, decrees.size());
+    ASSERT_EQ(2, *decrees.begin());
+    ASSERT_EQ(901, *decrees.rbegin());
+
+    mlog = new mutation_log_private(logp, 1, pid, nullptr, 4096, 512, 10000);
+    ASSERT_EQ(ERR_OK, mlog->open(nullptr, nullptr));
+    ASSERT_EQ(raw_size, mlog->size());
+
+    // appending after reopen starts a new file at the raw end offset, which can be replayed
+    // together with the old ones
+    append_mutations(mlog, pid, 902, 10);
+    mlog->close();
+    mlog = nullptr;
+    std::vector<int64_t> new_offsets = get_file_start_offsets(logp, disk_size);
+    ASSERT_EQ(offsets.size() + 1, new_offsets.size());
+    ASSERT_EQ(offsets.front() + raw_size, new_offsets.back());
+
+    decrees = replay_mutation_log(logp, pid, err);
+    ASSERT_EQ(ERR_OK, err);
+    ASSERT_EQ(910u, decrees.size());
+    ASSERT_EQ(911, *decrees.rbegin());
+
+    utils::filesystem::remove_path(logp);
+}
@@ -37,6 +37,7 @@
 #include <gtest/gtest.h>
 #include <chrono>
 #include <condition_variable>
+#include <thread>
 
 using namespace ::dsn;
 using namespace ::dsn::replication;
@@ -188,3 +189,139 @@ TEST(replication, mutation_log_learn)
         utils::filesystem::remove_path(logp);
     }
 }
+
+static void write_learn_segment_mutations(mutation_log_ptr mlog, gpid pid, int count)
+{
+    std::string str = "hello, world!";
+    for (int i = 0; i < count; i++) {
+        mutation_ptr mu(new mutation());
+        mu->data.header.ballot = 1;
+        mu->data.header.decree = i + 2;
+        mu->data.header.pid = pid;
+        mu->data.header.last_committed_decree = i;
+        mu->data.header.log_offset = 0;
+
+        binary_writer writer;
+        for (int j = 0; j < 300; j++) {
+            writer.write(str);
+        }
+        mu->data.updates.push_back(mutation_update());
+        mu->data.updates.back().code = RPC_REPLICATION_WRITE_EMPTY;
+        mu->data.updates.back().data = writer.get_buffer();
+        mu->client_requests.push_back(nullptr);
+
+        mlog->append(mu, LPC_AIO_IMMEDIATE_CALLBACK, nullptr, nullptr, 0);
+    }
+    mlog->flush();
+}
+
+static std::set<decree> replay_learn_segment(const std::string &segment)
+{
+    std::set<decree> decrees;
+    std::vector<std::string> files = {segment};
+    int64_t offset = 0;
+    error_code err = mutation_log::replay(files,
+                                          [&decrees](int log_length, mutation_ptr &mu) -> bool {
+                                              decrees.insert(mu->data.header.decree);
+                                              return true;
+                                          },
+                                          offset);
+    EXPECT_TRUE(err == ERR_OK || err == ERR_HANDLE_EOF) << err.to_string();
+    return decrees;
+}
+
+TEST(replication, mutation_log_learn_segment)
+{
+    gpid pid(1, 1);
+    std::string logp = "./test-log-segment";
+    utils::filesystem::remove_path(logp);
+    utils::filesystem::create_directory(logp);
+
+    // ~4MB in a single file, so that the decree index has several boundaries
+    mutation_log_ptr mlog = new mutation_log_private(logp, 32, pid, nullptr, 4096, 512, 10000);
+    ASSERT_EQ(ERR_OK, mlog->open(nullptr, nullptr));
+    write_learn_segment_mutations(mlog, pid, 1000);
+
+    decree start = 900;
+    learn_state state;
+    log_file_ptr source;
+    ASSERT_TRUE(mlog->get_learn_state(pid, start, state, &source));
+    ASSERT_TRUE(source != nullptr);
+    ASSERT_EQ(1u, state.files.size());
+    ASSERT_EQ(source->path(), state.files.front());
+
+    // segment contents: only the tail is copied, and it replays like a full file
+    std::string segment1 = mlog->write_learn_segment(source, start, 1);
+    ASSERT_FALSE(segment1.empty());
+    ASSERT_NE(source->path(), segment1);
+    int64_t source_size = 0, segment_size = 0;
+    ASSERT_TRUE(utils::filesystem::file_size(source->path(), source_size));
+    ASSERT_TRUE(utils::filesystem::file_size(segment1, segment_size));
+    ASSERT_LT(segment_size, source_size);
+
+    std::set<decree> decrees = replay_learn_segment(segment1);
+    ASSERT_FALSE(decrees.empty());
+    ASSERT_GT(*decrees.begin(), 2);
+    for (decree d = start; d <= 1001; d++) {
+        ASSERT_TRUE(decrees.find(d) != decrees.end()) << d;
+    }
+
+    // crc chaining: every block of the segment verifies against the re-chained crc
+    error_code err;
+    log_file_ptr lf = log_file::open_read(segment1.c_str(), err);
+    ASSERT_EQ(ERR_OK, err);
+    lf->reset_stream();
+    blob bb;
+    int block_count = 0;
+    while ((err = lf->read_next_log_block(bb)) == ERR_OK) {
+        ++block_count;
+    }
+    ASSERT_EQ(ERR_HANDLE_EOF, err);
+    ASSERT_GT(block_count, 1);
+    lf->close();
+
+    // concurrent learners own their own segments
+    std::string segment2 = mlog->write_learn_segment(source, start, 2);
+    ASSERT_FALSE(segment2.empty());
+    ASSERT_NE(segment1, segment2);
+    ASSERT_TRUE(utils::filesystem::file_exists(segment1));
+    ASSERT_EQ(decrees, replay_learn_segment(segment2));
+
+    // a new round of a learner replaces its previous segment only
+    std::string segment1_next = mlog->write_learn_segment(source, start + 50, 1);
+    ASSERT_FALSE(segment1_next.empty());
+    ASSERT_FALSE(utils::filesystem::file_exists(segment1));
+    ASSERT_TRUE(utils::filesystem::file_exists(segment1_next));
+    ASSERT_TRUE(utils::filesystem::file_exists(segment2));
+
+    // learners asking at the same time do not disturb each other
+    std::vector<std::string> segments(4);
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 4; i++) {
+        writers.emplace_back([&mlog, &segments, &source, start, i]() {
+            segments[i] = mlog->write_learn_segment(source, start, 10 + i);
+        });
+    }
+    for (auto &t : writers) {
+        t.join();
+    }
+    for (int i = 0; i < 4; i++) {
+        ASSERT_FALSE(segments[i].empty());
+        ASSERT_EQ(decrees, replay_learn_segment(segments[i]));
+    }
+
+    // cleanup: segments of learners no longer alive are removed
+    mlog->gc_learn_segments({2});
+    ASSERT_FALSE(utils::filesystem::file_exists(segment1_next));
+    ASSERT_TRUE(utils::filesystem::file_exists(segment2));
+    ASSERT_FALSE(utils::filesystem::file_exists(segments[0]));
+    mlog->gc_learn_segments({});
+    ASSERT_FALSE(utils::filesystem::file_exists(segment2));
+
+    // a learn start before the first index boundary gets no segment
+    ASSERT_TRUE(mlog->write_learn_segment(source, 3, 3).empty());
+
+    mlog->close();
+    mlog = nullptr;
+    utils::filesystem::remove_path(logp);
+}
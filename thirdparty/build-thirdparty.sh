@@ -199,6 +199,29 @@ else
     echo "skip build Poco"
 fi
 
+# build lz4
+if [ ! -f $TP_OUTPUT/include/lz4.h ]; then
+    mkdir -p $TP_BUILD/lz4-1.9.2
+    cd $TP_BUILD/lz4-1.9.2
+    CMAKE_FLAGS="-DCMAKE_BUILD_TYPE=release\
+    -DBUILD_SHARED_LIBS=OFF\
+    -DBUILD_STATIC_LIBS=ON\
+    -DLZ4_BUILD_CLI=OFF\
+    -DLZ4_BUILD_LEGACY_LZ4C=OFF\
+    -DCMAKE_INSTALL_PREFIX=$TP_OUTPUT\
+    -DCMAKE_INSTALL_LIBDIR=lib\
+    -DCMAKE_POSITION_INDEPENDENT_CODE=ON"
+
+    echo $CMAKE_FLAGS
+    cmake $TP_SRC/lz4-1.9.2/build/cmake $CMAKE_FLAGS
+    make -j8 && make install
+    res=$?
+    cd $TP_DIR
+    exit_if_fail "lz4" $res
+else
+    echo "skip build lz4"
+fi
+
 # build fds
 if [ ! -d $TP_OUTPUT/include/fds ]; then
     if [ ! -d $TP_OUTPUT/include/Poco -o ! -d $TP_OUTPUT/include/gtest ]; then
@@ -93,6 +93,10 @@ exit_if_fail $?
 check_and_download "poco-1.7.8.tar.gz" "https://codeload.github.com/pocoproject/poco/tar.gz/poco-1.7.8-release"
 exit_if_fail $?
 
+# lz4 for compressing messages and log blocks
+check_and_download "lz4-1.9.2.tar.gz" "https://codeload.github.com/lz4/lz4/tar.gz/v1.9.2"
+exit_if_fail $?
+
 # fds
 if [ ! -d $TP_SRC/fds ]; then
     git clone https://github.com/XiaoMi/galaxy-fds-sdk-cpp.git